@@ -49,6 +49,14 @@ struct JLMDBIterator
 	gboolean first;
 	gchar* prefix;
 	gsize namespace_len;
+
+	/**
+	 * The first and the end key as well as the maximum number of entries when iterating over a range.
+	 **/
+	gchar* start;
+	gchar* end;
+	guint32 limit;
+	guint32 count;
 };
 
 typedef struct JLMDBIterator JLMDBIterator;
@@ -195,6 +203,10 @@ backend_get_all(gpointer backend_data, gchar const* namespace, gpointer* data)
 	iterator->first = TRUE;
 	iterator->prefix = g_strdup_printf("%s:", namespace);
 	iterator->namespace_len = strlen(namespace) + 1;
+	iterator->start = NULL;
+	iterator->end = NULL;
+	iterator->limit = 0;
+	iterator->count = 0;
 
 	mdb_txn_begin(bd->env, NULL, 0, &(iterator->txn));
 	mdb_cursor_open(iterator->txn, bd->dbi, &(iterator->cursor));
@@ -218,6 +230,37 @@ backend_get_by_prefix(gpointer backend_data, gchar const* namespace, gchar const
 	iterator->first = TRUE;
 	iterator->prefix = g_strdup_printf("%s:%s", namespace, prefix);
 	iterator->namespace_len = strlen(namespace) + 1;
+	iterator->start = NULL;
+	iterator->end = NULL;
+	iterator->limit = 0;
+	iterator->count = 0;
+
+	mdb_txn_begin(bd->env, NULL, 0, &(iterator->txn));
+	mdb_cursor_open(iterator->txn, bd->dbi, &(iterator->cursor));
+
+	*data = iterator;
+
+	return (iterator != NULL);
+}
+
+static gboolean
+backend_get_range(gpointer backend_data, gchar const* namespace, gchar const* start, gchar const* end, guint32 limit, gpointer* data)
+{
+	JLMDBData* bd = backend_data;
+	JLMDBIterator* iterator = NULL;
+
+	g_return_val_if_fail(namespace != NULL, FALSE);
+	g_return_val_if_fail(start != NULL, FALSE);
+	g_return_val_if_fail(data != NULL, FALSE);
+
+	iterator = g_new(JLMDBIterator, 1);
+	iterator->first = TRUE;
+	iterator->prefix = g_strdup_printf("%s:", namespace);
+	iterator->namespace_len = strlen(namespace) + 1;
+	iterator->start = g_strdup_printf("%s:%s", namespace, start);
+	iterator->end = (end != NULL) ? g_strdup_printf("%s:%s", namespace, end) : NULL;
+	iterator->limit = limit;
+	iterator->count = 0;
 
 	mdb_txn_begin(bd->env, NULL, 0, &(iterator->txn));
 	mdb_cursor_open(iterator->txn, bd->dbi, &(iterator->cursor));
@@ -243,9 +286,11 @@ backend_iterate(gpointer backend_data, gpointer data, gchar const** key, gconstp
 
 	if (iterator->first)
 	{
+		gchar* seek = (iterator->start != NULL) ? iterator->start : iterator->prefix;
+
 		/// \todo check +1
-		m_key.mv_size = strlen(iterator->prefix) + 1;
-		m_key.mv_data = iterator->prefix;
+		m_key.mv_size = strlen(seek) + 1;
+		m_key.mv_data = seek;
 
 		cursor_op = MDB_SET_RANGE;
 
@@ -260,6 +305,14 @@ backend_iterate(gpointer backend_data, gpointer data, gchar const** key, gconstp
 			goto out;
 		}
 
+		// Keys are sorted, so the range ends at the first key that is not part of it
+		if ((iterator->end != NULL && strcmp(m_key.mv_data, iterator->end) >= 0) || (iterator->limit > 0 && iterator->count >= iterator->limit))
+		{
+			goto out;
+		}
+
+		iterator->count++;
+
 		*key = (gchar const*)m_key.mv_data + iterator->namespace_len;
 		*value = m_value.mv_data;
 		*len = m_value.mv_size;
@@ -271,6 +324,8 @@ out:
 	mdb_txn_commit(iterator->txn);
 
 	g_free(iterator->prefix);
+	g_free(iterator->start);
+	g_free(iterator->end);
 	g_free(iterator);
 
 	return FALSE;
@@ -355,6 +410,7 @@ static JBackend lmdb_backend = {
 		.backend_get = backend_get,
 		.backend_get_all = backend_get_all,
 		.backend_get_by_prefix = backend_get_by_prefix,
+		.backend_get_range = backend_get_range,
 		.backend_iterate = backend_iterate }
 };
 
@@ -51,6 +51,14 @@ struct JRocksDBIterator
 	gboolean first;
 	gchar* prefix;
 	gsize namespace_len;
+
+	/**
+	 * The first and the end key as well as the maximum number of entries when iterating over a range.
+	 **/
+	gchar* start;
+	gchar* end;
+	guint32 limit;
+	guint32 count;
 };
 
 typedef struct JRocksDBIterator JRocksDBIterator;
@@ -187,6 +195,10 @@ backend_get_all(gpointer backend_data, gchar const* namespace, gpointer* backend
 		iterator->first = TRUE;
 		iterator->prefix = g_strdup_printf("%s:", namespace);
 		iterator->namespace_len = strlen(namespace) + 1;
+		iterator->start = NULL;
+		iterator->end = NULL;
+		iterator->limit = 0;
+		iterator->count = 0;
 
 		*backend_iterator = iterator;
 	}
@@ -214,6 +226,41 @@ backend_get_by_prefix(gpointer backend_data, gchar const* namespace, gchar const
 		iterator->first = TRUE;
 		iterator->prefix = g_strdup_printf("%s:%s", namespace, prefix);
 		iterator->namespace_len = strlen(namespace) + 1;
+		iterator->start = NULL;
+		iterator->end = NULL;
+		iterator->limit = 0;
+		iterator->count = 0;
+
+		*backend_iterator = iterator;
+	}
+
+	return (iterator != NULL);
+}
+
+static gboolean
+backend_get_range(gpointer backend_data, gchar const* namespace, gchar const* start, gchar const* end, guint32 limit, gpointer* backend_iterator)
+{
+	JRocksDBData* bd = backend_data;
+	JRocksDBIterator* iterator = NULL;
+	rocksdb_iterator_t* it;
+
+	g_return_val_if_fail(namespace != NULL, FALSE);
+	g_return_val_if_fail(start != NULL, FALSE);
+	g_return_val_if_fail(backend_iterator != NULL, FALSE);
+
+	it = rocksdb_create_iterator(bd->db, bd->read_options);
+
+	if (it != NULL)
+	{
+		iterator = g_new(JRocksDBIterator, 1);
+		iterator->iterator = it;
+		iterator->first = TRUE;
+		iterator->prefix = g_strdup_printf("%s:", namespace);
+		iterator->namespace_len = strlen(namespace) + 1;
+		iterator->start = g_strdup_printf("%s:%s", namespace, start);
+		iterator->end = (end != NULL) ? g_strdup_printf("%s:%s", namespace, end) : NULL;
+		iterator->limit = limit;
+		iterator->count = 0;
 
 		*backend_iterator = iterator;
 	}
@@ -235,7 +282,9 @@ backend_iterate(gpointer backend_data, gpointer backend_iterator, gchar const**
 
 	if (iterator->first)
 	{
-		rocksdb_iter_seek(iterator->iterator, iterator->prefix, strlen(iterator->prefix));
+		gchar const* seek = (iterator->start != NULL) ? iterator->start : iterator->prefix;
+
+		rocksdb_iter_seek(iterator->iterator, seek, strlen(seek));
 		iterator->first = FALSE;
 	}
 	else
@@ -255,6 +304,14 @@ backend_iterate(gpointer backend_data, gpointer backend_iterator, gchar const**
 			goto out;
 		}
 
+		// Keys are sorted, so the range ends at the first key that is not part of it
+		if ((iterator->end != NULL && strcmp(key_, iterator->end) >= 0) || (iterator->limit > 0 && iterator->count >= iterator->limit))
+		{
+			goto out;
+		}
+
+		iterator->count++;
+
 		*key = key_ + iterator->namespace_len;
 		*value = rocksdb_iter_value(iterator->iterator, &tmp);
 		*len = tmp;
@@ -264,6 +321,8 @@ backend_iterate(gpointer backend_data, gpointer backend_iterator, gchar const**
 
 out:
 	g_free(iterator->prefix);
+	g_free(iterator->start);
+	g_free(iterator->end);
 	rocksdb_iter_destroy(iterator->iterator);
 	g_free(iterator);
 
@@ -343,6 +402,7 @@ static JBackend rocksdb_backend = {
 		.backend_get = backend_get,
 		.backend_get_all = backend_get_all,
 		.backend_get_by_prefix = backend_get_by_prefix,
+		.backend_get_range = backend_get_range,
 		.backend_iterate = backend_iterate }
 };
 
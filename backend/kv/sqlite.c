@@ -220,6 +220,33 @@ backend_get_by_prefix(gpointer backend_data, gchar const* namespace, gchar const
 	return (stmt != NULL);
 }
 
+static gboolean
+backend_get_range(gpointer backend_data, gchar const* namespace, gchar const* start, gchar const* end, guint32 limit, gpointer* backend_iterator)
+{
+	JSQLiteData* bd = backend_data;
+	sqlite3_stmt* stmt = NULL;
+
+	g_return_val_if_fail(namespace != NULL, FALSE);
+	g_return_val_if_fail(start != NULL, FALSE);
+	g_return_val_if_fail(backend_iterator != NULL, FALSE);
+
+	g_mutex_lock(bd->mutex);
+
+	// A negative limit returns all rows, keys are compared bytewise like in the other backends
+	if (sqlite3_prepare_v2(bd->db, "SELECT key, value FROM julea WHERE namespace = ? AND key >= ? AND (? IS NULL OR key < ?) ORDER BY key LIMIT ?;", -1, &stmt, NULL) == SQLITE_OK)
+	{
+		sqlite3_bind_text(stmt, 1, namespace, -1, SQLITE_TRANSIENT);
+		sqlite3_bind_text(stmt, 2, start, -1, SQLITE_TRANSIENT);
+		sqlite3_bind_text(stmt, 3, end, -1, SQLITE_TRANSIENT);
+		sqlite3_bind_text(stmt, 4, end, -1, SQLITE_TRANSIENT);
+		sqlite3_bind_int64(stmt, 5, (limit > 0) ? (gint64)limit : -1);
+	}
+
+	*backend_iterator = stmt;
+
+	return (stmt != NULL);
+}
+
 static gboolean
 backend_iterate(gpointer backend_data, gpointer backend_iterator, gchar const** key, gconstpointer* value, guint32* len)
 {
@@ -316,6 +343,7 @@ static JBackend sqlite_backend = {
 		.backend_get = backend_get,
 		.backend_get_all = backend_get_all,
 		.backend_get_by_prefix = backend_get_by_prefix,
+		.backend_get_range = backend_get_range,
 		.backend_iterate = backend_iterate }
 };
 
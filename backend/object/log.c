@@ -0,0 +1,1458 @@
+/*
+ * JULEA - Flexible storage framework
+ * Copyright (C) 2026 Michael Kuhn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * A log-structured object backend.
+ *
+ * Every namespace is stored in its own directory, which contains segment files and an index.
+ * Written data is appended to the current segment, so random writes become sequential ones.
+ * Each object has an extent map that translates object offsets into segment locations.
+ * All changes are appended to the index as records, which are replayed when the namespace is loaded.
+ * Segments that mostly contain overwritten data are compacted in the background.
+ */
+
+#include <julea-config.h>
+
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <gmodule.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <julea.h>
+
+/**
+ * Segments are rotated once they have reached this size.
+ **/
+#define BACKEND_SEGMENT_SIZE (64 * 1024 * 1024)
+
+/**
+ * Segments with less live data than this fraction are compacted.
+ **/
+#define BACKEND_SEGMENT_LIVE_RATIO 0.5
+
+enum BackendRecordType
+{
+	BACKEND_RECORD_CREATE = 1,
+	BACKEND_RECORD_DELETE = 2,
+	BACKEND_RECORD_WRITE = 3
+};
+
+typedef enum BackendRecordType BackendRecordType;
+
+/**
+ * An index record, which is followed by the object's name.
+ **/
+struct BackendRecord
+{
+	guint32 type;
+	guint32 name_length;
+	guint64 offset;
+	guint64 length;
+	guint64 segment;
+	guint64 segment_offset;
+	gint64 modification_time;
+};
+
+typedef struct BackendRecord BackendRecord;
+
+G_STATIC_ASSERT(sizeof(BackendRecord) == 48);
+
+struct BackendSegment
+{
+	guint64 id;
+	gint fd;
+
+	/**
+	 * The number of bytes appended to the segment.
+	 **/
+	guint64 size;
+
+	/**
+	 * The number of bytes that are still referenced by extents.
+	 **/
+	guint64 live;
+};
+
+typedef struct BackendSegment BackendSegment;
+
+/**
+ * A contiguous part of an object that is stored in a segment.
+ **/
+struct BackendExtent
+{
+	guint64 offset;
+	guint64 length;
+	BackendSegment* segment;
+	guint64 segment_offset;
+};
+
+typedef struct BackendExtent BackendExtent;
+
+struct BackendFile
+{
+	gchar* name;
+
+	/**
+	 * The extents, sorted by offset and not overlapping.
+	 **/
+	GSequence* extents;
+
+	gint64 modification_time;
+	gboolean deleted;
+
+	gint ref_count;
+};
+
+typedef struct BackendFile BackendFile;
+
+struct BackendNamespace
+{
+	gchar* name;
+	gchar* path;
+
+	/**
+	 * Protects all members below.
+	 * Reads only need the reader lock, all modifications need the writer lock.
+	 **/
+	GRWLock lock[1];
+
+	GHashTable* files;
+	GHashTable* segments;
+
+	BackendSegment* current;
+	guint64 next_segment;
+
+	gint index_fd;
+
+	gboolean compacting;
+	JBackgroundOperation* compaction;
+};
+
+typedef struct BackendNamespace BackendNamespace;
+
+struct JBackendData
+{
+	gchar* path;
+
+	GMutex mutex[1];
+	GHashTable* namespaces;
+};
+
+typedef struct JBackendData JBackendData;
+
+struct JBackendIterator
+{
+	GPtrArray* names;
+	guint index;
+};
+
+typedef struct JBackendIterator JBackendIterator;
+
+struct JBackendObject
+{
+	BackendNamespace* namespace;
+	BackendFile* file;
+};
+
+typedef struct JBackendObject JBackendObject;
+
+static gint
+backend_extent_compare(gconstpointer a, gconstpointer b, gpointer data)
+{
+	BackendExtent const* extent_a = a;
+	BackendExtent const* extent_b = b;
+
+	(void)data;
+
+	if (extent_a->offset < extent_b->offset)
+	{
+		return -1;
+	}
+
+	return (extent_a->offset > extent_b->offset) ? 1 : 0;
+}
+
+static BackendFile*
+backend_file_new(gchar const* name)
+{
+	BackendFile* file;
+
+	file = g_new(BackendFile, 1);
+	file->name = g_strdup(name);
+	file->extents = g_sequence_new(g_free);
+	file->modification_time = g_get_real_time();
+	file->deleted = FALSE;
+	file->ref_count = 1;
+
+	return file;
+}
+
+static BackendFile*
+backend_file_ref(BackendFile* file)
+{
+	g_atomic_int_inc(&(file->ref_count));
+
+	return file;
+}
+
+static void
+backend_file_unref(gpointer data)
+{
+	BackendFile* file = data;
+
+	if (g_atomic_int_dec_and_test(&(file->ref_count)))
+	{
+		g_sequence_free(file->extents);
+		g_free(file->name);
+		g_free(file);
+	}
+}
+
+static guint64
+backend_file_get_size(BackendFile* file)
+{
+	GSequenceIter* last;
+	BackendExtent* extent;
+
+	if (g_sequence_is_empty(file->extents))
+	{
+		return 0;
+	}
+
+	last = g_sequence_iter_prev(g_sequence_get_end_iter(file->extents));
+	extent = g_sequence_get(last);
+
+	return extent->offset + extent->length;
+}
+
+/**
+ * Returns the first extent that ends after offset.
+ **/
+static GSequenceIter*
+backend_file_lookup(BackendFile* file, guint64 offset)
+{
+	BackendExtent probe = { offset, 0, NULL, 0 };
+	GSequenceIter* iter;
+
+	iter = g_sequence_search(file->extents, &probe, backend_extent_compare, NULL);
+
+	if (!g_sequence_iter_is_begin(iter))
+	{
+		GSequenceIter* prev = g_sequence_iter_prev(iter);
+		BackendExtent* extent = g_sequence_get(prev);
+
+		if (extent->offset + extent->length > offset)
+		{
+			iter = prev;
+		}
+	}
+
+	return iter;
+}
+
+/**
+ * Maps a range of the file to a segment location, replacing previous mappings of the range.
+ **/
+static void
+backend_file_map(BackendFile* file, guint64 offset, guint64 length, BackendSegment* segment, guint64 segment_offset)
+{
+	GSequenceIter* iter;
+	BackendExtent* new_extent;
+	guint64 end = offset + length;
+
+	iter = backend_file_lookup(file, offset);
+
+	while (!g_sequence_iter_is_end(iter))
+	{
+		BackendExtent* extent = g_sequence_get(iter);
+		guint64 extent_end = extent->offset + extent->length;
+
+		if (extent->offset >= end)
+		{
+			break;
+		}
+
+		if (extent->offset < offset)
+		{
+			if (extent_end > end)
+			{
+				// The new extent is contained in the old one, which has to be split
+				BackendExtent* tail;
+
+				tail = g_new(BackendExtent, 1);
+				tail->offset = end;
+				tail->length = extent_end - end;
+				tail->segment = extent->segment;
+				tail->segment_offset = extent->segment_offset + (end - extent->offset);
+
+				g_sequence_insert_sorted(file->extents, tail, backend_extent_compare, NULL);
+			}
+
+			extent->segment->live -= MIN(extent_end, end) - offset;
+			extent->length = offset - extent->offset;
+			iter = g_sequence_iter_next(iter);
+		}
+		else if (extent_end <= end)
+		{
+			GSequenceIter* next = g_sequence_iter_next(iter);
+
+			extent->segment->live -= extent->length;
+			g_sequence_remove(iter);
+			iter = next;
+		}
+		else
+		{
+			guint64 overlap = end - extent->offset;
+
+			extent->segment->live -= overlap;
+			extent->offset += overlap;
+			extent->length -= overlap;
+			extent->segment_offset += overlap;
+			break;
+		}
+	}
+
+	new_extent = g_new(BackendExtent, 1);
+	new_extent->offset = offset;
+	new_extent->length = length;
+	new_extent->segment = segment;
+	new_extent->segment_offset = segment_offset;
+
+	g_sequence_insert_sorted(file->extents, new_extent, backend_extent_compare, NULL);
+
+	segment->live += length;
+}
+
+static void
+backend_file_unmap(BackendFile* file)
+{
+	GSequenceIter* iter;
+
+	for (iter = g_sequence_get_begin_iter(file->extents); !g_sequence_iter_is_end(iter); iter = g_sequence_iter_next(iter))
+	{
+		BackendExtent* extent = g_sequence_get(iter);
+
+		extent->segment->live -= extent->length;
+	}
+
+	g_sequence_remove_range(g_sequence_get_begin_iter(file->extents), g_sequence_get_end_iter(file->extents));
+}
+
+static void
+backend_record_append(GByteArray* records, BackendRecordType type, BackendFile* file, BackendExtent const* extent)
+{
+	BackendRecord record;
+
+	memset(&record, 0, sizeof(record));
+	record.type = type;
+	record.name_length = strlen(file->name);
+	record.modification_time = file->modification_time;
+
+	if (extent != NULL)
+	{
+		record.offset = extent->offset;
+		record.length = extent->length;
+		record.segment = extent->segment->id;
+		record.segment_offset = extent->segment_offset;
+	}
+
+	g_byte_array_append(records, (guint8 const*)&record, sizeof(record));
+	g_byte_array_append(records, (guint8 const*)file->name, record.name_length);
+}
+
+static gboolean
+backend_write_full(gint fd, gconstpointer buffer, guint64 length, guint64 offset, gboolean append)
+{
+	guint64 nbytes_total = 0;
+
+	while (nbytes_total < length)
+	{
+		gssize nbytes;
+
+		if (append)
+		{
+			nbytes = write(fd, (gchar const*)buffer + nbytes_total, length - nbytes_total);
+		}
+		else
+		{
+			nbytes = pwrite(fd, (gchar const*)buffer + nbytes_total, length - nbytes_total, offset + nbytes_total);
+		}
+
+		if (nbytes < 0 && errno == EINTR)
+		{
+			continue;
+		}
+		else if (nbytes <= 0)
+		{
+			break;
+		}
+
+		nbytes_total += nbytes;
+	}
+
+	return (nbytes_total == length);
+}
+
+static guint64
+backend_read_full(gint fd, gpointer buffer, guint64 length, guint64 offset)
+{
+	guint64 nbytes_total = 0;
+
+	while (nbytes_total < length)
+	{
+		gssize nbytes;
+
+		nbytes = pread(fd, (gchar*)buffer + nbytes_total, length - nbytes_total, offset + nbytes_total);
+
+		if (nbytes < 0 && errno == EINTR)
+		{
+			continue;
+		}
+		else if (nbytes <= 0)
+		{
+			break;
+		}
+
+		nbytes_total += nbytes;
+	}
+
+	return nbytes_total;
+}
+
+static gboolean
+backend_namespace_write_records(BackendNamespace* ns, GByteArray* records)
+{
+	if (records->len == 0)
+	{
+		return TRUE;
+	}
+
+	// The index is opened with O_APPEND, so records are never interleaved
+	return backend_write_full(ns->index_fd, records->data, records->len, 0, TRUE);
+}
+
+static void
+backend_segment_free(gpointer data)
+{
+	BackendSegment* segment = data;
+
+	close(segment->fd);
+	g_free(segment);
+}
+
+static BackendSegment*
+backend_segment_open(BackendNamespace* ns, guint64 id)
+{
+	BackendSegment* segment;
+	g_autofree gchar* name = NULL;
+	g_autofree gchar* path = NULL;
+	struct stat buf;
+	gint fd;
+
+	name = g_strdup_printf("%016" G_GINT64_MODIFIER "x.segment", id);
+	path = g_build_filename(ns->path, name, NULL);
+
+	if ((fd = open(path, O_RDWR | O_CREAT, 0600)) == -1)
+	{
+		return NULL;
+	}
+
+	segment = g_new(BackendSegment, 1);
+	segment->id = id;
+	segment->fd = fd;
+	segment->size = (fstat(fd, &buf) == 0) ? (guint64)buf.st_size : 0;
+	segment->live = 0;
+
+	g_hash_table_insert(ns->segments, &(segment->id), segment);
+
+	return segment;
+}
+
+static void
+backend_segment_remove(BackendNamespace* ns, BackendSegment* segment)
+{
+	g_autofree gchar* name = NULL;
+	g_autofree gchar* path = NULL;
+
+	name = g_strdup_printf("%016" G_GINT64_MODIFIER "x.segment", segment->id);
+	path = g_build_filename(ns->path, name, NULL);
+
+	g_unlink(path);
+	g_hash_table_remove(ns->segments, &(segment->id));
+}
+
+static gboolean
+backend_segment_compactable(BackendNamespace* ns, BackendSegment* segment)
+{
+	return (segment != ns->current && segment->live < segment->size * BACKEND_SEGMENT_LIVE_RATIO);
+}
+
+static gpointer backend_namespace_compact(gpointer data);
+
+/**
+ * Starts a new segment, the previous one is synced because backend_sync() only syncs the current one.
+ * Needs the writer lock.
+ **/
+static gboolean
+backend_namespace_rotate(BackendNamespace* ns)
+{
+	BackendSegment* segment;
+	GHashTableIter iter;
+	gpointer value;
+
+	if ((segment = backend_segment_open(ns, ns->next_segment)) == NULL)
+	{
+		return FALSE;
+	}
+
+	ns->next_segment++;
+
+	if (ns->current != NULL)
+	{
+		fsync(ns->current->fd);
+	}
+
+	ns->current = segment;
+
+	if (ns->compacting)
+	{
+		return TRUE;
+	}
+
+	g_hash_table_iter_init(&iter, ns->segments);
+
+	while (g_hash_table_iter_next(&iter, NULL, &value))
+	{
+		if (backend_segment_compactable(ns, value))
+		{
+			if (ns->compaction != NULL)
+			{
+				j_background_operation_unref(ns->compaction);
+			}
+
+			ns->compacting = TRUE;
+			ns->compaction = j_background_operation_new(backend_namespace_compact, ns);
+
+			break;
+		}
+	}
+
+	return TRUE;
+}
+
+/**
+ * Appends data to the current segment and maps it into the file.
+ * Needs the writer lock.
+ *
+ * \return The number of bytes written.
+ **/
+static guint64
+backend_namespace_append(BackendNamespace* ns, BackendFile* file, gconstpointer buffer, guint64 length, guint64 offset, GByteArray* records)
+{
+	BackendExtent extent;
+
+	if (length == 0)
+	{
+		return 0;
+	}
+
+	if (ns->current->size >= BACKEND_SEGMENT_SIZE && !backend_namespace_rotate(ns))
+	{
+		return 0;
+	}
+
+	if (!backend_write_full(ns->current->fd, buffer, length, ns->current->size, FALSE))
+	{
+		/// \todo the partially written data is not reused
+		ns->current->size = BACKEND_SEGMENT_SIZE;
+		return 0;
+	}
+
+	extent.offset = offset;
+	extent.length = length;
+	extent.segment = ns->current;
+	extent.segment_offset = ns->current->size;
+
+	ns->current->size += length;
+
+	backend_file_map(file, offset, length, ns->current, extent.segment_offset);
+	backend_record_append(records, BACKEND_RECORD_WRITE, file, &extent);
+
+	return length;
+}
+
+/**
+ * Replaces the index with one that only contains the current state.
+ * Needs the writer lock.
+ **/
+static gboolean
+backend_namespace_snapshot(BackendNamespace* ns)
+{
+	g_autoptr(GByteArray) records = NULL;
+	g_autofree gchar* index_path = NULL;
+	g_autofree gchar* tmp_path = NULL;
+	GHashTableIter iter;
+	gpointer value;
+	gboolean ret;
+	gint fd;
+
+	index_path = g_build_filename(ns->path, "index", NULL);
+	tmp_path = g_build_filename(ns->path, "index.tmp", NULL);
+
+	records = g_byte_array_new();
+
+	g_hash_table_iter_init(&iter, ns->files);
+
+	while (g_hash_table_iter_next(&iter, NULL, &value))
+	{
+		BackendFile* file = value;
+		GSequenceIter* it;
+
+		backend_record_append(records, BACKEND_RECORD_CREATE, file, NULL);
+
+		for (it = g_sequence_get_begin_iter(file->extents); !g_sequence_iter_is_end(it); it = g_sequence_iter_next(it))
+		{
+			backend_record_append(records, BACKEND_RECORD_WRITE, file, g_sequence_get(it));
+		}
+	}
+
+	if ((fd = open(tmp_path, O_WRONLY | O_CREAT | O_TRUNC, 0600)) == -1)
+	{
+		return FALSE;
+	}
+
+	ret = backend_write_full(fd, records->data, records->len, 0, FALSE) && fsync(fd) == 0;
+	close(fd);
+
+	if (!ret || g_rename(tmp_path, index_path) != 0)
+	{
+		g_unlink(tmp_path);
+		return FALSE;
+	}
+
+	if ((fd = open(index_path, O_WRONLY | O_APPEND)) == -1)
+	{
+		return FALSE;
+	}
+
+	close(ns->index_fd);
+	ns->index_fd = fd;
+
+	return TRUE;
+}
+
+/**
+ * Moves the live extents of segments that mostly contain overwritten data to the current segment.
+ * Runs as a background operation, the writer lock is only held while compacting one segment at a time.
+ **/
+static gpointer
+backend_namespace_compact(gpointer data)
+{
+	BackendNamespace* ns = data;
+	gboolean compacted = FALSE;
+
+	while (TRUE)
+	{
+		g_autoptr(GByteArray) records = NULL;
+		BackendSegment* victim = NULL;
+		GHashTableIter iter;
+		gpointer value;
+		gboolean ret = TRUE;
+
+		g_rw_lock_writer_lock(ns->lock);
+
+		g_hash_table_iter_init(&iter, ns->segments);
+
+		while (g_hash_table_iter_next(&iter, NULL, &value))
+		{
+			if (backend_segment_compactable(ns, value))
+			{
+				victim = value;
+				break;
+			}
+		}
+
+		if (victim == NULL)
+		{
+			if (compacted)
+			{
+				backend_namespace_snapshot(ns);
+			}
+
+			ns->compacting = FALSE;
+			g_rw_lock_writer_unlock(ns->lock);
+
+			break;
+		}
+
+		records = g_byte_array_new();
+
+		g_hash_table_iter_init(&iter, ns->files);
+
+		while (ret && g_hash_table_iter_next(&iter, NULL, &value))
+		{
+			BackendFile* file = value;
+			GSequenceIter* it;
+
+			for (it = g_sequence_get_begin_iter(file->extents); ret && !g_sequence_iter_is_end(it); it = g_sequence_iter_next(it))
+			{
+				BackendExtent* extent = g_sequence_get(it);
+				g_autofree gchar* buffer = NULL;
+
+				if (extent->segment != victim)
+				{
+					continue;
+				}
+
+				if (ns->current->size >= BACKEND_SEGMENT_SIZE && !backend_namespace_rotate(ns))
+				{
+					ret = FALSE;
+					break;
+				}
+
+				buffer = g_malloc(extent->length);
+
+				ret = (backend_read_full(victim->fd, buffer, extent->length, extent->segment_offset) == extent->length)
+				      && backend_write_full(ns->current->fd, buffer, extent->length, ns->current->size, FALSE);
+
+				if (!ret)
+				{
+					break;
+				}
+
+				// The extent keeps its position within the file, only its location changes
+				victim->live -= extent->length;
+				extent->segment = ns->current;
+				extent->segment_offset = ns->current->size;
+				ns->current->size += extent->length;
+				ns->current->live += extent->length;
+
+				backend_record_append(records, BACKEND_RECORD_WRITE, file, extent);
+			}
+		}
+
+		// The victim may only be removed once the new locations are persistent
+		ret = ret && fsync(ns->current->fd) == 0;
+		ret = ret && backend_namespace_write_records(ns, records) && fsync(ns->index_fd) == 0;
+
+		if (ret)
+		{
+			backend_segment_remove(ns, victim);
+			compacted = TRUE;
+		}
+		else
+		{
+			g_warning("Can not compact segment %" G_GUINT64_FORMAT " of namespace %s.", victim->id, ns->name);
+			ns->compacting = FALSE;
+		}
+
+		g_rw_lock_writer_unlock(ns->lock);
+
+		if (!ret)
+		{
+			break;
+		}
+	}
+
+	return NULL;
+}
+
+/**
+ * Replays the index.
+ **/
+static void
+backend_namespace_replay(BackendNamespace* ns)
+{
+	g_autofree gchar* index_path = NULL;
+	g_autofree gchar* contents = NULL;
+	gsize length = 0;
+	gsize position = 0;
+
+	index_path = g_build_filename(ns->path, "index", NULL);
+
+	if (!g_file_get_contents(index_path, &contents, &length, NULL))
+	{
+		return;
+	}
+
+	while (position + sizeof(BackendRecord) <= length)
+	{
+		BackendRecord record;
+		g_autofree gchar* name = NULL;
+		BackendFile* file;
+
+		memcpy(&record, contents + position, sizeof(record));
+
+		if (position + sizeof(record) + record.name_length > length)
+		{
+			break;
+		}
+
+		name = g_strndup(contents + position + sizeof(record), record.name_length);
+		position += sizeof(record) + record.name_length;
+
+		file = g_hash_table_lookup(ns->files, name);
+
+		switch (record.type)
+		{
+			case BACKEND_RECORD_CREATE:
+			case BACKEND_RECORD_WRITE:
+				if (file == NULL)
+				{
+					file = backend_file_new(name);
+					g_hash_table_insert(ns->files, file->name, file);
+				}
+
+				file->modification_time = record.modification_time;
+
+				if (record.type == BACKEND_RECORD_WRITE)
+				{
+					BackendSegment* segment;
+
+					segment = g_hash_table_lookup(ns->segments, &(record.segment));
+
+					if (segment != NULL && record.segment_offset + record.length <= segment->size)
+					{
+						backend_file_map(file, record.offset, record.length, segment, record.segment_offset);
+					}
+				}
+				break;
+			case BACKEND_RECORD_DELETE:
+				if (file != NULL)
+				{
+					backend_file_unmap(file);
+					g_hash_table_remove(ns->files, name);
+				}
+				break;
+			default:
+				g_warning("Invalid record in %s.", index_path);
+				position = length;
+				break;
+		}
+	}
+
+	// Cut off a record that has been written partially
+	if (position < length && truncate(index_path, position) != 0)
+	{
+		g_warning("Can not truncate %s.", index_path);
+	}
+}
+
+static BackendNamespace*
+backend_namespace_load(JBackendData* bd, gchar const* name)
+{
+	BackendNamespace* ns;
+	GDir* dir;
+	g_autofree gchar* index_path = NULL;
+	g_autoptr(GPtrArray) empty = NULL;
+	GHashTableIter iter;
+	gpointer value;
+
+	ns = g_new(BackendNamespace, 1);
+	ns->name = g_strdup(name);
+	ns->path = g_build_filename(bd->path, name, NULL);
+	ns->files = g_hash_table_new_full(g_str_hash, g_str_equal, NULL, backend_file_unref);
+	ns->segments = g_hash_table_new_full(g_int64_hash, g_int64_equal, NULL, backend_segment_free);
+	ns->current = NULL;
+	ns->next_segment = 0;
+	ns->index_fd = -1;
+	ns->compacting = FALSE;
+	ns->compaction = NULL;
+
+	g_rw_lock_init(ns->lock);
+
+	g_mkdir_with_parents(ns->path, 0700);
+
+	if ((dir = g_dir_open(ns->path, 0, NULL)) != NULL)
+	{
+		gchar const* entry;
+
+		while ((entry = g_dir_read_name(dir)) != NULL)
+		{
+			guint64 id;
+
+			if (!g_str_has_suffix(entry, ".segment"))
+			{
+				continue;
+			}
+
+			id = g_ascii_strtoull(entry, NULL, 16);
+			backend_segment_open(ns, id);
+			ns->next_segment = MAX(ns->next_segment, id + 1);
+		}
+
+		g_dir_close(dir);
+	}
+
+	backend_namespace_replay(ns);
+
+	// Segments without live data are left over from overwrites or restarts
+	empty = g_ptr_array_new();
+	g_hash_table_iter_init(&iter, ns->segments);
+
+	while (g_hash_table_iter_next(&iter, NULL, &value))
+	{
+		if (((BackendSegment*)value)->live == 0)
+		{
+			g_ptr_array_add(empty, value);
+		}
+	}
+
+	for (guint i = 0; i < empty->len; i++)
+	{
+		backend_segment_remove(ns, g_ptr_array_index(empty, i));
+	}
+
+	index_path = g_build_filename(ns->path, "index", NULL);
+	ns->index_fd = open(index_path, O_WRONLY | O_CREAT | O_APPEND, 0600);
+
+	if (ns->index_fd == -1 || !backend_namespace_rotate(ns))
+	{
+		g_warning("Can not load namespace %s.", ns->path);
+	}
+
+	return ns;
+}
+
+static void
+backend_namespace_free(gpointer data)
+{
+	BackendNamespace* ns = data;
+
+	if (ns->compaction != NULL)
+	{
+		j_background_operation_wait(ns->compaction);
+		j_background_operation_unref(ns->compaction);
+	}
+
+	if (ns->index_fd != -1)
+	{
+		close(ns->index_fd);
+	}
+
+	g_hash_table_destroy(ns->files);
+	g_hash_table_destroy(ns->segments);
+	g_rw_lock_clear(ns->lock);
+
+	g_free(ns->name);
+	g_free(ns->path);
+	g_free(ns);
+}
+
+/**
+ * Returns a namespace, loading it if necessary.
+ *
+ * \param create Whether to create the namespace if it does not exist.
+ **/
+static BackendNamespace*
+backend_namespace_get(JBackendData* bd, gchar const* name, gboolean create)
+{
+	BackendNamespace* ns;
+
+	g_mutex_lock(bd->mutex);
+
+	if ((ns = g_hash_table_lookup(bd->namespaces, name)) == NULL)
+	{
+		g_autofree gchar* path = NULL;
+
+		path = g_build_filename(bd->path, name, NULL);
+
+		if (create || g_file_test(path, G_FILE_TEST_IS_DIR))
+		{
+			ns = backend_namespace_load(bd, name);
+			g_hash_table_insert(bd->namespaces, ns->name, ns);
+		}
+	}
+
+	g_mutex_unlock(bd->mutex);
+
+	return (ns != NULL && ns->current != NULL) ? ns : NULL;
+}
+
+static gboolean
+backend_create(gpointer backend_data, gchar const* namespace, gchar const* path, gpointer* backend_object)
+{
+	JBackendData* bd = backend_data;
+	JBackendObject* bo;
+	BackendNamespace* ns;
+	BackendFile* file;
+	gboolean ret = TRUE;
+
+	if ((ns = backend_namespace_get(bd, namespace, TRUE)) == NULL)
+	{
+		return FALSE;
+	}
+
+	j_trace_file_begin(path, J_TRACE_FILE_CREATE);
+
+	g_rw_lock_writer_lock(ns->lock);
+
+	if ((file = g_hash_table_lookup(ns->files, path)) == NULL)
+	{
+		g_autoptr(GByteArray) records = NULL;
+
+		file = backend_file_new(path);
+		g_hash_table_insert(ns->files, file->name, file);
+
+		records = g_byte_array_new();
+		backend_record_append(records, BACKEND_RECORD_CREATE, file, NULL);
+		ret = backend_namespace_write_records(ns, records);
+	}
+
+	bo = g_new(JBackendObject, 1);
+	bo->namespace = ns;
+	bo->file = backend_file_ref(file);
+
+	g_rw_lock_writer_unlock(ns->lock);
+
+	j_trace_file_end(path, J_TRACE_FILE_CREATE, 0, 0);
+
+	*backend_object = bo;
+
+	return ret;
+}
+
+static gboolean
+backend_open(gpointer backend_data, gchar const* namespace, gchar const* path, gpointer* backend_object)
+{
+	JBackendData* bd = backend_data;
+	JBackendObject* bo = NULL;
+	BackendNamespace* ns;
+	BackendFile* file;
+
+	if ((ns = backend_namespace_get(bd, namespace, FALSE)) == NULL)
+	{
+		return FALSE;
+	}
+
+	j_trace_file_begin(path, J_TRACE_FILE_OPEN);
+
+	g_rw_lock_reader_lock(ns->lock);
+
+	if ((file = g_hash_table_lookup(ns->files, path)) != NULL)
+	{
+		bo = g_new(JBackendObject, 1);
+		bo->namespace = ns;
+		bo->file = backend_file_ref(file);
+	}
+
+	g_rw_lock_reader_unlock(ns->lock);
+
+	j_trace_file_end(path, J_TRACE_FILE_OPEN, 0, 0);
+
+	*backend_object = bo;
+
+	return (bo != NULL);
+}
+
+static gboolean
+backend_close(gpointer backend_data, gpointer backend_object)
+{
+	JBackendObject* bo = backend_object;
+
+	(void)backend_data;
+
+	backend_file_unref(bo->file);
+	g_free(bo);
+
+	return TRUE;
+}
+
+static gboolean
+backend_delete(gpointer backend_data, gpointer backend_object)
+{
+	JBackendObject* bo = backend_object;
+	BackendNamespace* ns = bo->namespace;
+	gboolean ret = FALSE;
+
+	j_trace_file_begin(bo->file->name, J_TRACE_FILE_DELETE);
+
+	g_rw_lock_writer_lock(ns->lock);
+
+	if (!bo->file->deleted)
+	{
+		g_autoptr(GByteArray) records = NULL;
+
+		records = g_byte_array_new();
+		backend_record_append(records, BACKEND_RECORD_DELETE, bo->file, NULL);
+		ret = backend_namespace_write_records(ns, records);
+
+		bo->file->deleted = TRUE;
+		backend_file_unmap(bo->file);
+		g_hash_table_remove(ns->files, bo->file->name);
+	}
+
+	g_rw_lock_writer_unlock(ns->lock);
+
+	j_trace_file_end(bo->file->name, J_TRACE_FILE_DELETE, 0, 0);
+
+	backend_close(backend_data, bo);
+
+	return ret;
+}
+
+static gboolean
+backend_status(gpointer backend_data, gpointer backend_object, gint64* modification_time, guint64* size)
+{
+	JBackendObject* bo = backend_object;
+	gboolean ret;
+
+	(void)backend_data;
+
+	j_trace_file_begin(bo->file->name, J_TRACE_FILE_STATUS);
+
+	g_rw_lock_reader_lock(bo->namespace->lock);
+
+	ret = !bo->file->deleted;
+
+	if (modification_time != NULL)
+	{
+		*modification_time = bo->file->modification_time;
+	}
+
+	if (size != NULL)
+	{
+		*size = backend_file_get_size(bo->file);
+	}
+
+	g_rw_lock_reader_unlock(bo->namespace->lock);
+
+	j_trace_file_end(bo->file->name, J_TRACE_FILE_STATUS, 0, 0);
+
+	return ret;
+}
+
+static gboolean
+backend_sync(gpointer backend_data, gpointer backend_object)
+{
+	JBackendObject* bo = backend_object;
+	BackendNamespace* ns = bo->namespace;
+	gboolean ret;
+
+	(void)backend_data;
+
+	j_trace_file_begin(bo->file->name, J_TRACE_FILE_SYNC);
+
+	// Older segments have been synced when they were rotated
+	g_rw_lock_reader_lock(ns->lock);
+	ret = (fdatasync(ns->current->fd) == 0);
+	ret = (fdatasync(ns->index_fd) == 0) && ret;
+	g_rw_lock_reader_unlock(ns->lock);
+
+	j_trace_file_end(bo->file->name, J_TRACE_FILE_SYNC, 0, 0);
+
+	return ret;
+}
+
+/**
+ * Reads an extent by resolving it through the extent map.
+ * Holes are filled with zeros, reads end at the end of the object.
+ * Needs the reader lock.
+ *
+ * \return The number of bytes read.
+ **/
+static guint64
+backend_file_read(BackendFile* file, gpointer buffer, guint64 length, guint64 offset)
+{
+	GSequenceIter* iter;
+	guint64 end;
+	guint64 position = offset;
+
+	end = MIN(offset + length, backend_file_get_size(file));
+
+	if (offset >= end)
+	{
+		return 0;
+	}
+
+	iter = backend_file_lookup(file, offset);
+
+	while (position < end)
+	{
+		BackendExtent* extent = NULL;
+		guint64 nbytes;
+
+		if (!g_sequence_iter_is_end(iter))
+		{
+			extent = g_sequence_get(iter);
+		}
+
+		if (extent == NULL || extent->offset > position)
+		{
+			// Hole
+			nbytes = MIN(end, (extent != NULL) ? extent->offset : end) - position;
+			memset((gchar*)buffer + (position - offset), 0, nbytes);
+		}
+		else
+		{
+			guint64 skip = position - extent->offset;
+
+			nbytes = MIN(end, extent->offset + extent->length) - position;
+
+			if (backend_read_full(extent->segment->fd, (gchar*)buffer + (position - offset), nbytes, extent->segment_offset + skip) != nbytes)
+			{
+				break;
+			}
+
+			iter = g_sequence_iter_next(iter);
+		}
+
+		position += nbytes;
+	}
+
+	return position - offset;
+}
+
+static gboolean
+backend_readv(gpointer backend_data, gpointer backend_object, JBackendExtent* extents, guint extents_len)
+{
+	JBackendObject* bo = backend_object;
+	gboolean ret = TRUE;
+
+	(void)backend_data;
+
+	j_trace_file_begin(bo->file->name, J_TRACE_FILE_READ);
+
+	g_rw_lock_reader_lock(bo->namespace->lock);
+
+	for (guint i = 0; i < extents_len; i++)
+	{
+		extents[i].bytes = backend_file_read(bo->file, extents[i].buffer, extents[i].length, extents[i].offset);
+		ret = (extents[i].bytes == extents[i].length) && ret;
+	}
+
+	g_rw_lock_reader_unlock(bo->namespace->lock);
+
+	j_trace_file_end(bo->file->name, J_TRACE_FILE_READ, 0, 0);
+
+	return ret;
+}
+
+static gboolean
+backend_writev(gpointer backend_data, gpointer backend_object, JBackendExtent* extents, guint extents_len, gboolean sync)
+{
+	JBackendObject* bo = backend_object;
+	BackendNamespace* ns = bo->namespace;
+	g_autoptr(GByteArray) records = NULL;
+	gboolean ret = TRUE;
+
+	j_trace_file_begin(bo->file->name, J_TRACE_FILE_WRITE);
+
+	records = g_byte_array_new();
+
+	g_rw_lock_writer_lock(ns->lock);
+
+	if (bo->file->deleted)
+	{
+		ret = FALSE;
+	}
+	else
+	{
+		bo->file->modification_time = g_get_real_time();
+
+		// All extents are appended to the segment back to back
+		for (guint i = 0; i < extents_len; i++)
+		{
+			extents[i].bytes = backend_namespace_append(ns, bo->file, extents[i].buffer, extents[i].length, extents[i].offset, records);
+			ret = (extents[i].bytes == extents[i].length) && ret;
+		}
+
+		// Data is only visible after a restart if its records have been written
+		ret = backend_namespace_write_records(ns, records) && ret;
+	}
+
+	g_rw_lock_writer_unlock(ns->lock);
+
+	j_trace_file_end(bo->file->name, J_TRACE_FILE_WRITE, 0, 0);
+
+	if (sync)
+	{
+		ret = backend_sync(backend_data, bo) && ret;
+	}
+
+	return ret;
+}
+
+static gboolean
+backend_read(gpointer backend_data, gpointer backend_object, gpointer buffer, guint64 length, guint64 offset, guint64* bytes_read)
+{
+	JBackendExtent extent = { buffer, length, offset, 0 };
+	gboolean ret;
+
+	ret = backend_readv(backend_data, backend_object, &extent, 1);
+
+	if (bytes_read != NULL)
+	{
+		*bytes_read = extent.bytes;
+	}
+
+	return ret;
+}
+
+static gboolean
+backend_write(gpointer backend_data, gpointer backend_object, gconstpointer buffer, guint64 length, guint64 offset, guint64* bytes_written)
+{
+	JBackendExtent extent = { (gpointer)buffer, length, offset, 0 };
+	gboolean ret;
+
+	ret = backend_writev(backend_data, backend_object, &extent, 1, FALSE);
+
+	if (bytes_written != NULL)
+	{
+		*bytes_written = extent.bytes;
+	}
+
+	return ret;
+}
+
+static gboolean
+backend_get_by_prefix(gpointer backend_data, gchar const* namespace, gchar const* prefix, gpointer* backend_iterator)
+{
+	JBackendData* bd = backend_data;
+	JBackendIterator* iterator;
+	BackendNamespace* ns;
+	GHashTableIter iter;
+	gpointer key;
+
+	g_return_val_if_fail(namespace != NULL, FALSE);
+	g_return_val_if_fail(backend_iterator != NULL, FALSE);
+
+	if ((ns = backend_namespace_get(bd, namespace, FALSE)) == NULL)
+	{
+		return FALSE;
+	}
+
+	iterator = g_new(JBackendIterator, 1);
+	iterator->names = g_ptr_array_new_with_free_func(g_free);
+	iterator->index = 0;
+
+	// The names are copied because the files might be deleted while iterating
+	g_rw_lock_reader_lock(ns->lock);
+	g_hash_table_iter_init(&iter, ns->files);
+
+	while (g_hash_table_iter_next(&iter, &key, NULL))
+	{
+		if (prefix == NULL || g_str_has_prefix(key, prefix))
+		{
+			g_ptr_array_add(iterator->names, g_strdup(key));
+		}
+	}
+
+	g_rw_lock_reader_unlock(ns->lock);
+
+	*backend_iterator = iterator;
+
+	return TRUE;
+}
+
+static gboolean
+backend_get_all(gpointer backend_data, gchar const* namespace, gpointer* backend_iterator)
+{
+	return backend_get_by_prefix(backend_data, namespace, NULL, backend_iterator);
+}
+
+static gboolean
+backend_iterate(gpointer backend_data, gpointer backend_iterator, gchar const** name)
+{
+	JBackendIterator* iterator = backend_iterator;
+
+	(void)backend_data;
+
+	g_return_val_if_fail(backend_iterator != NULL, FALSE);
+	g_return_val_if_fail(name != NULL, FALSE);
+
+	if (iterator->index < iterator->names->len)
+	{
+		*name = g_ptr_array_index(iterator->names, iterator->index);
+		iterator->index++;
+
+		return TRUE;
+	}
+
+	g_ptr_array_unref(iterator->names);
+	g_free(iterator);
+
+	return FALSE;
+}
+
+static gboolean
+backend_init(gchar const* path, gpointer* backend_data)
+{
+	JBackendData* bd;
+
+	g_return_val_if_fail(path != NULL, FALSE);
+
+	bd = g_new(JBackendData, 1);
+	bd->path = g_strdup(path);
+	bd->namespaces = g_hash_table_new_full(g_str_hash, g_str_equal, NULL, backend_namespace_free);
+
+	g_mutex_init(bd->mutex);
+
+	g_mkdir_with_parents(path, 0700);
+
+	*backend_data = bd;
+
+	return TRUE;
+}
+
+static void
+backend_fini(gpointer backend_data)
+{
+	JBackendData* bd = backend_data;
+
+	g_hash_table_destroy(bd->namespaces);
+	g_mutex_clear(bd->mutex);
+
+	g_free(bd->path);
+	g_free(bd);
+}
+
+static JBackend log_backend = {
+	.type = J_BACKEND_TYPE_OBJECT,
+	.component = J_BACKEND_COMPONENT_SERVER,
+	.flags = 0,
+	.object = {
+		.backend_init = backend_init,
+		.backend_fini = backend_fini,
+		.backend_create = backend_create,
+		.backend_delete = backend_delete,
+		.backend_open = backend_open,
+		.backend_close = backend_close,
+		.backend_status = backend_status,
+		.backend_sync = backend_sync,
+		.backend_read = backend_read,
+		.backend_write = backend_write,
+		.backend_readv = backend_readv,
+		.backend_writev = backend_writev,
+		.backend_get_all = backend_get_all,
+		.backend_get_by_prefix = backend_get_by_prefix,
+		.backend_iterate = backend_iterate }
+};
+
+G_MODULE_EXPORT
+JBackend*
+backend_info(void)
+{
+	return &log_backend;
+}
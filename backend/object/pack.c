@@ -0,0 +1,1042 @@
+/*
+ * JULEA - Flexible storage framework
+ * Copyright (C) 2026 Michael Kuhn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * An object backend that packs small objects into large files.
+ *
+ * An LMDB index maps namespace and name to the object's slot within a pack file.
+ * Creating and deleting objects therefore only updates the index instead of the file system's metadata.
+ * Slots are reserved with some headroom, objects that outgrow their slot are moved to a larger one.
+ * Objects that become larger than BACKEND_PACK_THRESHOLD are promoted to standalone files.
+ */
+
+// fallocate() is not part of POSIX
+#define _GNU_SOURCE
+
+#include <julea-config.h>
+
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <gmodule.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <lmdb.h>
+
+#include <julea.h>
+
+/**
+ * Objects up to this size are stored in pack files.
+ **/
+#define BACKEND_PACK_THRESHOLD (64 * 1024)
+
+/**
+ * New slots are allocated in the next pack file once a pack file has reached this size.
+ **/
+#define BACKEND_PACK_SIZE (G_GUINT64_CONSTANT(1024) * 1024 * 1024)
+
+/**
+ * The minimum size of a slot, slots are sized in powers of two.
+ **/
+#define BACKEND_SLOT_SIZE_MIN 512
+
+/**
+ * An index entry.
+ **/
+struct BackendEntry
+{
+	/**
+	 * Whether the object has been promoted to a standalone file.
+	 * Only packed objects use the other members.
+	 **/
+	guint32 standalone;
+	guint32 pack;
+	guint64 offset;
+	guint64 capacity;
+	guint64 length;
+	gint64 modification_time;
+};
+
+typedef struct BackendEntry BackendEntry;
+
+struct JBackendData
+{
+	gchar* path;
+
+	MDB_env* env;
+	MDB_dbi dbi;
+
+	/**
+	 * Protects all members below.
+	 **/
+	GMutex mutex[1];
+
+	/**
+	 * The file descriptors of the pack files.
+	 **/
+	GHashTable* packs;
+
+	guint32 current_pack;
+	guint64 current_size;
+};
+
+typedef struct JBackendData JBackendData;
+
+struct JBackendIterator
+{
+	GPtrArray* names;
+	guint index;
+};
+
+typedef struct JBackendIterator JBackendIterator;
+
+struct JBackendObject
+{
+	/**
+	 * The index key, the namespace and name separated by a null byte.
+	 **/
+	gchar* key;
+	gsize key_len;
+
+	/**
+	 * The path of the standalone file, which is also used for tracing.
+	 **/
+	gchar* path;
+
+	/**
+	 * The standalone file's descriptor, opened on demand.
+	 **/
+	gint fd;
+};
+
+typedef struct JBackendObject JBackendObject;
+
+static guint64
+backend_read_full(gint fd, gpointer buffer, guint64 length, guint64 offset)
+{
+	guint64 nbytes_total = 0;
+
+	while (nbytes_total < length)
+	{
+		gssize nbytes;
+
+		nbytes = pread(fd, (gchar*)buffer + nbytes_total, length - nbytes_total, offset + nbytes_total);
+
+		if (nbytes < 0 && errno == EINTR)
+		{
+			continue;
+		}
+		else if (nbytes <= 0)
+		{
+			break;
+		}
+
+		nbytes_total += nbytes;
+	}
+
+	return nbytes_total;
+}
+
+static guint64
+backend_write_full(gint fd, gconstpointer buffer, guint64 length, guint64 offset)
+{
+	guint64 nbytes_total = 0;
+
+	while (nbytes_total < length)
+	{
+		gssize nbytes;
+
+		nbytes = pwrite(fd, (gchar const*)buffer + nbytes_total, length - nbytes_total, offset + nbytes_total);
+
+		if (nbytes < 0 && errno == EINTR)
+		{
+			continue;
+		}
+		else if (nbytes <= 0)
+		{
+			break;
+		}
+
+		nbytes_total += nbytes;
+	}
+
+	return nbytes_total;
+}
+
+static gint
+backend_pack_get(JBackendData* bd, guint32 pack)
+{
+	gpointer value;
+	gint fd;
+
+	g_mutex_lock(bd->mutex);
+
+	if ((value = g_hash_table_lookup(bd->packs, GUINT_TO_POINTER(pack))) != NULL)
+	{
+		fd = GPOINTER_TO_INT(value) - 1;
+	}
+	else
+	{
+		g_autofree gchar* name = NULL;
+		g_autofree gchar* path = NULL;
+
+		name = g_strdup_printf("%08x.pack", pack);
+		path = g_build_filename(bd->path, "packs", name, NULL);
+
+		if ((fd = open(path, O_RDWR | O_CREAT, 0600)) != -1)
+		{
+			// Store fd + 1 because 0 is a valid file descriptor
+			g_hash_table_insert(bd->packs, GUINT_TO_POINTER(pack), GINT_TO_POINTER(fd + 1));
+		}
+	}
+
+	g_mutex_unlock(bd->mutex);
+
+	return fd;
+}
+
+static void
+backend_pack_close(gpointer data)
+{
+	close(GPOINTER_TO_INT(data) - 1);
+}
+
+/**
+ * Reserves a slot of at least length bytes.
+ **/
+static void
+backend_slot_allocate(JBackendData* bd, guint64 length, BackendEntry* entry)
+{
+	guint64 capacity = BACKEND_SLOT_SIZE_MIN;
+
+	while (capacity < length)
+	{
+		capacity *= 2;
+	}
+
+	g_mutex_lock(bd->mutex);
+
+	if (bd->current_size + capacity > BACKEND_PACK_SIZE)
+	{
+		bd->current_pack++;
+		bd->current_size = 0;
+	}
+
+	entry->pack = bd->current_pack;
+	entry->offset = bd->current_size;
+	entry->capacity = capacity;
+
+	bd->current_size += capacity;
+
+	g_mutex_unlock(bd->mutex);
+}
+
+/**
+ * Releases a slot's space, slots are not reused.
+ **/
+static void
+backend_slot_free(JBackendData* bd, BackendEntry const* entry)
+{
+	gint fd;
+
+	if (entry->standalone || entry->capacity == 0)
+	{
+		return;
+	}
+
+	if ((fd = backend_pack_get(bd, entry->pack)) != -1)
+	{
+		// Errors are ignored, the space is just not returned to the file system
+		fallocate(fd, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE, entry->offset, entry->capacity);
+	}
+}
+
+static gboolean
+backend_entry_get(MDB_txn* txn, JBackendData* bd, JBackendObject* bo, BackendEntry* entry)
+{
+	MDB_val m_key;
+	MDB_val m_value;
+
+	m_key.mv_size = bo->key_len;
+	m_key.mv_data = bo->key;
+
+	if (mdb_get(txn, bd->dbi, &m_key, &m_value) != 0 || m_value.mv_size != sizeof(BackendEntry))
+	{
+		return FALSE;
+	}
+
+	memcpy(entry, m_value.mv_data, sizeof(BackendEntry));
+
+	return TRUE;
+}
+
+static gboolean
+backend_entry_put(MDB_txn* txn, JBackendData* bd, JBackendObject* bo, BackendEntry* entry)
+{
+	MDB_val m_key;
+	MDB_val m_value;
+
+	m_key.mv_size = bo->key_len;
+	m_key.mv_data = bo->key;
+	m_value.mv_size = sizeof(BackendEntry);
+	m_value.mv_data = entry;
+
+	return (mdb_put(txn, bd->dbi, &m_key, &m_value, 0) == 0);
+}
+
+/**
+ * Reads an entry using a read-only transaction.
+ **/
+static gboolean
+backend_entry_lookup(JBackendData* bd, JBackendObject* bo, BackendEntry* entry)
+{
+	MDB_txn* txn;
+	gboolean ret;
+
+	if (mdb_txn_begin(bd->env, NULL, MDB_RDONLY, &txn) != 0)
+	{
+		return FALSE;
+	}
+
+	ret = backend_entry_get(txn, bd, bo, entry);
+	mdb_txn_abort(txn);
+
+	return ret;
+}
+
+static gint
+backend_object_get_fd(JBackendObject* bo)
+{
+	if (bo->fd == -1)
+	{
+		bo->fd = open(bo->path, O_RDWR);
+	}
+
+	return bo->fd;
+}
+
+static JBackendObject*
+backend_object_new(JBackendData* bd, gchar const* namespace, gchar const* path)
+{
+	JBackendObject* bo;
+	gsize namespace_len;
+	gsize path_len;
+
+	namespace_len = strlen(namespace);
+	path_len = strlen(path);
+
+	bo = g_new(JBackendObject, 1);
+	bo->key_len = namespace_len + 1 + path_len;
+	bo->key = g_malloc(bo->key_len);
+	memcpy(bo->key, namespace, namespace_len + 1);
+	memcpy(bo->key + namespace_len + 1, path, path_len);
+	bo->path = g_build_filename(bd->path, "files", namespace, path, NULL);
+	bo->fd = -1;
+
+	return bo;
+}
+
+/**
+ * Moves an object's data into a standalone file.
+ **/
+static gboolean
+backend_object_promote(JBackendData* bd, JBackendObject* bo, BackendEntry* entry)
+{
+	g_autofree gchar* parent = NULL;
+	g_autofree gchar* buffer = NULL;
+	gint fd;
+
+	parent = g_path_get_dirname(bo->path);
+	g_mkdir_with_parents(parent, 0700);
+
+	if (bo->fd != -1)
+	{
+		close(bo->fd);
+	}
+
+	if ((bo->fd = open(bo->path, O_RDWR | O_CREAT | O_TRUNC, 0600)) == -1)
+	{
+		return FALSE;
+	}
+
+	if (entry->length > 0)
+	{
+		buffer = g_malloc(entry->length);
+
+		if ((fd = backend_pack_get(bd, entry->pack)) == -1
+		    || backend_read_full(fd, buffer, entry->length, entry->offset) != entry->length
+		    || backend_write_full(bo->fd, buffer, entry->length, 0) != entry->length)
+		{
+			return FALSE;
+		}
+	}
+
+	backend_slot_free(bd, entry);
+
+	entry->standalone = TRUE;
+	entry->capacity = 0;
+
+	return TRUE;
+}
+
+/**
+ * Moves an object's data into a slot of at least length bytes.
+ **/
+static gboolean
+backend_object_relocate(JBackendData* bd, BackendEntry* entry, guint64 length)
+{
+	BackendEntry old_entry = *entry;
+	g_autofree gchar* buffer = NULL;
+	gint old_fd;
+	gint fd;
+
+	backend_slot_allocate(bd, length, entry);
+
+	if (old_entry.length == 0)
+	{
+		return TRUE;
+	}
+
+	buffer = g_malloc(old_entry.length);
+
+	if ((old_fd = backend_pack_get(bd, old_entry.pack)) == -1 || (fd = backend_pack_get(bd, entry->pack)) == -1
+	    || backend_read_full(old_fd, buffer, old_entry.length, old_entry.offset) != old_entry.length
+	    || backend_write_full(fd, buffer, old_entry.length, entry->offset) != old_entry.length)
+	{
+		return FALSE;
+	}
+
+	backend_slot_free(bd, &old_entry);
+
+	return TRUE;
+}
+
+static gboolean
+backend_create(gpointer backend_data, gchar const* namespace, gchar const* path, gpointer* backend_object)
+{
+	JBackendData* bd = backend_data;
+	JBackendObject* bo;
+	BackendEntry entry;
+	MDB_txn* txn;
+	gboolean ret = FALSE;
+
+	bo = backend_object_new(bd, namespace, path);
+
+	j_trace_file_begin(bo->path, J_TRACE_FILE_CREATE);
+
+	if (mdb_txn_begin(bd->env, NULL, 0, &txn) == 0)
+	{
+		// Creating an existing object opens it
+		if (backend_entry_get(txn, bd, bo, &entry))
+		{
+			ret = TRUE;
+			mdb_txn_abort(txn);
+		}
+		else
+		{
+			memset(&entry, 0, sizeof(entry));
+			entry.modification_time = g_get_real_time();
+
+			ret = backend_entry_put(txn, bd, bo, &entry) && mdb_txn_commit(txn) == 0;
+
+			if (!ret)
+			{
+				mdb_txn_abort(txn);
+			}
+		}
+	}
+
+	j_trace_file_end(bo->path, J_TRACE_FILE_CREATE, 0, 0);
+
+	*backend_object = bo;
+
+	return ret;
+}
+
+static gboolean
+backend_open(gpointer backend_data, gchar const* namespace, gchar const* path, gpointer* backend_object)
+{
+	JBackendData* bd = backend_data;
+	JBackendObject* bo;
+	BackendEntry entry;
+	gboolean ret;
+
+	bo = backend_object_new(bd, namespace, path);
+
+	j_trace_file_begin(bo->path, J_TRACE_FILE_OPEN);
+	ret = backend_entry_lookup(bd, bo, &entry);
+	j_trace_file_end(bo->path, J_TRACE_FILE_OPEN, 0, 0);
+
+	*backend_object = bo;
+
+	return ret;
+}
+
+static gboolean
+backend_close(gpointer backend_data, gpointer backend_object)
+{
+	JBackendObject* bo = backend_object;
+
+	(void)backend_data;
+
+	if (bo->fd != -1)
+	{
+		close(bo->fd);
+	}
+
+	g_free(bo->key);
+	g_free(bo->path);
+	g_free(bo);
+
+	return TRUE;
+}
+
+static gboolean
+backend_delete(gpointer backend_data, gpointer backend_object)
+{
+	JBackendData* bd = backend_data;
+	JBackendObject* bo = backend_object;
+	BackendEntry entry;
+	MDB_txn* txn;
+	MDB_val m_key;
+	gboolean ret = FALSE;
+
+	j_trace_file_begin(bo->path, J_TRACE_FILE_DELETE);
+
+	if (mdb_txn_begin(bd->env, NULL, 0, &txn) == 0)
+	{
+		m_key.mv_size = bo->key_len;
+		m_key.mv_data = bo->key;
+
+		if (backend_entry_get(txn, bd, bo, &entry) && mdb_del(txn, bd->dbi, &m_key, NULL) == 0 && mdb_txn_commit(txn) == 0)
+		{
+			if (entry.standalone)
+			{
+				g_unlink(bo->path);
+			}
+			else
+			{
+				backend_slot_free(bd, &entry);
+			}
+
+			ret = TRUE;
+		}
+		else
+		{
+			mdb_txn_abort(txn);
+		}
+	}
+
+	j_trace_file_end(bo->path, J_TRACE_FILE_DELETE, 0, 0);
+
+	backend_close(backend_data, bo);
+
+	return ret;
+}
+
+static gboolean
+backend_status(gpointer backend_data, gpointer backend_object, gint64* modification_time, guint64* size)
+{
+	JBackendData* bd = backend_data;
+	JBackendObject* bo = backend_object;
+	BackendEntry entry;
+	gboolean ret;
+
+	j_trace_file_begin(bo->path, J_TRACE_FILE_STATUS);
+
+	ret = backend_entry_lookup(bd, bo, &entry);
+
+	if (ret && entry.standalone)
+	{
+		struct stat buf;
+
+		ret = (backend_object_get_fd(bo) != -1 && fstat(bo->fd, &buf) == 0);
+
+		if (ret)
+		{
+			entry.length = buf.st_size;
+			entry.modification_time = buf.st_mtime * G_USEC_PER_SEC;
+		}
+	}
+
+	j_trace_file_end(bo->path, J_TRACE_FILE_STATUS, 0, 0);
+
+	if (ret && modification_time != NULL)
+	{
+		*modification_time = entry.modification_time;
+	}
+
+	if (ret && size != NULL)
+	{
+		*size = entry.length;
+	}
+
+	return ret;
+}
+
+static gboolean
+backend_sync(gpointer backend_data, gpointer backend_object)
+{
+	JBackendData* bd = backend_data;
+	JBackendObject* bo = backend_object;
+	BackendEntry entry;
+	gboolean ret;
+	gint fd = -1;
+
+	j_trace_file_begin(bo->path, J_TRACE_FILE_SYNC);
+
+	ret = backend_entry_lookup(bd, bo, &entry);
+
+	if (ret && entry.standalone)
+	{
+		fd = backend_object_get_fd(bo);
+	}
+	else if (ret && entry.capacity > 0)
+	{
+		fd = backend_pack_get(bd, entry.pack);
+	}
+
+	if (ret && fd != -1)
+	{
+		ret = (fdatasync(fd) == 0);
+	}
+
+	// The index is opened without syncing, so it has to be synced explicitly
+	ret = (mdb_env_sync(bd->env, 1) == 0) && ret;
+
+	j_trace_file_end(bo->path, J_TRACE_FILE_SYNC, 0, 0);
+
+	return ret;
+}
+
+static gboolean
+backend_readv(gpointer backend_data, gpointer backend_object, JBackendExtent* extents, guint extents_len)
+{
+	JBackendData* bd = backend_data;
+	JBackendObject* bo = backend_object;
+	BackendEntry entry;
+	gboolean ret = TRUE;
+	gint fd;
+
+	for (guint i = 0; i < extents_len; i++)
+	{
+		extents[i].bytes = 0;
+	}
+
+	if (!backend_entry_lookup(bd, bo, &entry))
+	{
+		return FALSE;
+	}
+
+	fd = (entry.standalone) ? backend_object_get_fd(bo) : backend_pack_get(bd, entry.pack);
+
+	if (fd == -1 && (entry.standalone || entry.capacity > 0))
+	{
+		return FALSE;
+	}
+
+	j_trace_file_begin(bo->path, J_TRACE_FILE_READ);
+
+	for (guint i = 0; i < extents_len; i++)
+	{
+		if (entry.standalone)
+		{
+			extents[i].bytes = backend_read_full(fd, extents[i].buffer, extents[i].length, extents[i].offset);
+		}
+		else if (extents[i].offset < entry.length)
+		{
+			guint64 length = MIN(extents[i].length, entry.length - extents[i].offset);
+
+			extents[i].bytes = backend_read_full(fd, extents[i].buffer, length, entry.offset + extents[i].offset);
+		}
+
+		ret = (extents[i].bytes == extents[i].length) && ret;
+	}
+
+	j_trace_file_end(bo->path, J_TRACE_FILE_READ, 0, 0);
+
+	return ret;
+}
+
+static gboolean
+backend_writev(gpointer backend_data, gpointer backend_object, JBackendExtent* extents, guint extents_len, gboolean sync)
+{
+	JBackendData* bd = backend_data;
+	JBackendObject* bo = backend_object;
+	BackendEntry entry;
+	MDB_txn* txn;
+	gboolean ret = TRUE;
+	guint64 end = 0;
+	gint fd;
+
+	for (guint i = 0; i < extents_len; i++)
+	{
+		extents[i].bytes = 0;
+		end = MAX(end, extents[i].offset + extents[i].length);
+	}
+
+	// The write transaction serializes all changes to packed objects
+	if (mdb_txn_begin(bd->env, NULL, 0, &txn) != 0)
+	{
+		return FALSE;
+	}
+
+	if (!backend_entry_get(txn, bd, bo, &entry))
+	{
+		mdb_txn_abort(txn);
+		return FALSE;
+	}
+
+	j_trace_file_begin(bo->path, J_TRACE_FILE_WRITE);
+
+	if (entry.standalone)
+	{
+		// Standalone objects do not need the index
+		mdb_txn_abort(txn);
+		txn = NULL;
+	}
+	else if (end > entry.capacity)
+	{
+		if (end > BACKEND_PACK_THRESHOLD)
+		{
+			ret = backend_object_promote(bd, bo, &entry);
+		}
+		else
+		{
+			ret = backend_object_relocate(bd, &entry, end);
+		}
+	}
+
+	if (ret)
+	{
+		fd = (entry.standalone) ? backend_object_get_fd(bo) : backend_pack_get(bd, entry.pack);
+		ret = (fd != -1);
+	}
+
+	for (guint i = 0; ret && i < extents_len; i++)
+	{
+		guint64 offset = extents[i].offset;
+
+		if (!entry.standalone)
+		{
+			offset += entry.offset;
+		}
+
+		extents[i].bytes = backend_write_full(fd, extents[i].buffer, extents[i].length, offset);
+		ret = (extents[i].bytes == extents[i].length) && ret;
+
+		if (!entry.standalone && extents[i].bytes > 0)
+		{
+			entry.length = MAX(entry.length, extents[i].offset + extents[i].bytes);
+		}
+	}
+
+	j_trace_file_end(bo->path, J_TRACE_FILE_WRITE, 0, 0);
+
+	if (txn != NULL)
+	{
+		entry.modification_time = g_get_real_time();
+
+		if (backend_entry_put(txn, bd, bo, &entry) && mdb_txn_commit(txn) == 0)
+		{
+			txn = NULL;
+		}
+		else
+		{
+			ret = FALSE;
+		}
+	}
+
+	if (txn != NULL)
+	{
+		mdb_txn_abort(txn);
+	}
+
+	if (sync)
+	{
+		ret = backend_sync(backend_data, backend_object) && ret;
+	}
+
+	return ret;
+}
+
+static gboolean
+backend_read(gpointer backend_data, gpointer backend_object, gpointer buffer, guint64 length, guint64 offset, guint64* bytes_read)
+{
+	JBackendExtent extent = { buffer, length, offset, 0 };
+	gboolean ret;
+
+	ret = backend_readv(backend_data, backend_object, &extent, 1);
+
+	if (bytes_read != NULL)
+	{
+		*bytes_read = extent.bytes;
+	}
+
+	return ret;
+}
+
+static gboolean
+backend_write(gpointer backend_data, gpointer backend_object, gconstpointer buffer, guint64 length, guint64 offset, guint64* bytes_written)
+{
+	JBackendExtent extent = { (gpointer)buffer, length, offset, 0 };
+	gboolean ret;
+
+	ret = backend_writev(backend_data, backend_object, &extent, 1, FALSE);
+
+	if (bytes_written != NULL)
+	{
+		*bytes_written = extent.bytes;
+	}
+
+	return ret;
+}
+
+static gboolean
+backend_get_by_prefix(gpointer backend_data, gchar const* namespace, gchar const* prefix, gpointer* backend_iterator)
+{
+	JBackendData* bd = backend_data;
+	JBackendIterator* iterator;
+	MDB_txn* txn;
+	MDB_cursor* cursor;
+	MDB_val m_key;
+	MDB_val m_value;
+	g_autofree gchar* key_prefix = NULL;
+	gsize key_prefix_len;
+	gsize namespace_len;
+	MDB_cursor_op cursor_op = MDB_SET_RANGE;
+
+	g_return_val_if_fail(namespace != NULL, FALSE);
+	g_return_val_if_fail(backend_iterator != NULL, FALSE);
+
+	if (prefix == NULL)
+	{
+		prefix = "";
+	}
+
+	// Keys are sorted, so all matching keys follow each other
+	namespace_len = strlen(namespace);
+	key_prefix_len = namespace_len + 1 + strlen(prefix);
+	key_prefix = g_malloc(key_prefix_len);
+	memcpy(key_prefix, namespace, namespace_len + 1);
+	memcpy(key_prefix + namespace_len + 1, prefix, strlen(prefix));
+
+	if (mdb_txn_begin(bd->env, NULL, MDB_RDONLY, &txn) != 0)
+	{
+		return FALSE;
+	}
+
+	if (mdb_cursor_open(txn, bd->dbi, &cursor) != 0)
+	{
+		mdb_txn_abort(txn);
+		return FALSE;
+	}
+
+	iterator = g_new(JBackendIterator, 1);
+	iterator->names = g_ptr_array_new_with_free_func(g_free);
+	iterator->index = 0;
+
+	m_key.mv_size = key_prefix_len;
+	m_key.mv_data = key_prefix;
+
+	while (mdb_cursor_get(cursor, &m_key, &m_value, cursor_op) == 0)
+	{
+		cursor_op = MDB_NEXT;
+
+		if (m_key.mv_size < key_prefix_len || memcmp(m_key.mv_data, key_prefix, key_prefix_len) != 0)
+		{
+			break;
+		}
+
+		g_ptr_array_add(iterator->names, g_strndup((gchar const*)m_key.mv_data + namespace_len + 1, m_key.mv_size - namespace_len - 1));
+	}
+
+	mdb_cursor_close(cursor);
+	mdb_txn_abort(txn);
+
+	*backend_iterator = iterator;
+
+	return TRUE;
+}
+
+static gboolean
+backend_get_all(gpointer backend_data, gchar const* namespace, gpointer* backend_iterator)
+{
+	return backend_get_by_prefix(backend_data, namespace, NULL, backend_iterator);
+}
+
+static gboolean
+backend_iterate(gpointer backend_data, gpointer backend_iterator, gchar const** name)
+{
+	JBackendIterator* iterator = backend_iterator;
+
+	(void)backend_data;
+
+	g_return_val_if_fail(backend_iterator != NULL, FALSE);
+	g_return_val_if_fail(name != NULL, FALSE);
+
+	if (iterator->index < iterator->names->len)
+	{
+		*name = g_ptr_array_index(iterator->names, iterator->index);
+		iterator->index++;
+
+		return TRUE;
+	}
+
+	g_ptr_array_unref(iterator->names);
+	g_free(iterator);
+
+	return FALSE;
+}
+
+static gboolean
+backend_init(gchar const* path, gpointer* backend_data)
+{
+	JBackendData* bd;
+	MDB_txn* txn;
+	GDir* dir;
+	g_autofree gchar* index_path = NULL;
+	g_autofree gchar* packs_path = NULL;
+
+	g_return_val_if_fail(path != NULL, FALSE);
+
+	index_path = g_build_filename(path, "index", NULL);
+	packs_path = g_build_filename(path, "packs", NULL);
+
+	g_mkdir_with_parents(index_path, 0700);
+	g_mkdir_with_parents(packs_path, 0700);
+
+	bd = g_new(JBackendData, 1);
+	bd->path = g_strdup(path);
+	bd->env = NULL;
+	bd->packs = g_hash_table_new_full(NULL, NULL, NULL, backend_pack_close);
+	bd->current_pack = 0;
+	bd->current_size = 0;
+
+	g_mutex_init(bd->mutex);
+
+	if (mdb_env_create(&(bd->env)) != 0)
+	{
+		bd->env = NULL;
+		goto error;
+	}
+
+	/// \todo grow mapsize dynamically
+	if (mdb_env_set_mapsize(bd->env, (gsize)4 * 1024 * 1024 * 1024) != 0)
+	{
+		goto error;
+	}
+
+	// Syncing every create would defeat the purpose, backend_sync() syncs explicitly
+	if (mdb_env_open(bd->env, index_path, MDB_NOSYNC, 0600) != 0)
+	{
+		goto error;
+	}
+
+	if (mdb_txn_begin(bd->env, NULL, 0, &txn) != 0)
+	{
+		goto error;
+	}
+
+	if (mdb_dbi_open(txn, NULL, 0, &(bd->dbi)) != 0 || mdb_txn_commit(txn) != 0)
+	{
+		goto error;
+	}
+
+	// New slots are allocated in a new pack file, because the end of the last one is unknown
+	if ((dir = g_dir_open(packs_path, 0, NULL)) != NULL)
+	{
+		gchar const* name;
+
+		while ((name = g_dir_read_name(dir)) != NULL)
+		{
+			if (g_str_has_suffix(name, ".pack"))
+			{
+				bd->current_pack = MAX(bd->current_pack, g_ascii_strtoull(name, NULL, 16) + 1);
+			}
+		}
+
+		g_dir_close(dir);
+	}
+
+	*backend_data = bd;
+
+	return TRUE;
+
+error:
+	if (bd->env != NULL)
+	{
+		mdb_env_close(bd->env);
+	}
+
+	g_hash_table_destroy(bd->packs);
+	g_mutex_clear(bd->mutex);
+	g_free(bd->path);
+	g_free(bd);
+
+	return FALSE;
+}
+
+static void
+backend_fini(gpointer backend_data)
+{
+	JBackendData* bd = backend_data;
+
+	mdb_env_sync(bd->env, 1);
+	mdb_env_close(bd->env);
+
+	g_hash_table_destroy(bd->packs);
+	g_mutex_clear(bd->mutex);
+
+	g_free(bd->path);
+	g_free(bd);
+}
+
+static JBackend pack_backend = {
+	.type = J_BACKEND_TYPE_OBJECT,
+	.component = J_BACKEND_COMPONENT_SERVER,
+	.flags = 0,
+	.object = {
+		.backend_init = backend_init,
+		.backend_fini = backend_fini,
+		.backend_create = backend_create,
+		.backend_delete = backend_delete,
+		.backend_open = backend_open,
+		.backend_close = backend_close,
+		.backend_status = backend_status,
+		.backend_sync = backend_sync,
+		.backend_read = backend_read,
+		.backend_write = backend_write,
+		.backend_readv = backend_readv,
+		.backend_writev = backend_writev,
+		.backend_get_all = backend_get_all,
+		.backend_get_by_prefix = backend_get_by_prefix,
+		.backend_iterate = backend_iterate }
+};
+
+G_MODULE_EXPORT
+JBackend*
+backend_info(void)
+{
+	return &pack_backend;
+}
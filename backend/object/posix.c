@@ -16,23 +16,85 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+// O_DIRECT, preadv(), pwritev() and copy_file_range() are not part of POSIX
+#define _GNU_SOURCE
+
 #include <julea-config.h>
 
 #include <glib.h>
 #include <glib/gstdio.h>
 #include <gmodule.h>
 
+#include <errno.h>
 #include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
 #include <sys/types.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
+#include <sys/uio.h>
 #include <unistd.h>
 
+#ifdef __linux__
+#include <linux/fs.h>
+#endif
+
+#ifdef HAVE_LMDB
+#include <lmdb.h>
+#endif
+
 #include <julea.h>
 
 struct JBackendData
 {
 	gchar* path;
-	/// \todo check whether hash tables can stay global
+
+	/**
+	 * The open files shared by all threads, protected by files_mutex.
+	 * Each instance has its own table, so that multiple instances (for example, shards of a server) do not contend on a single lock.
+	 **/
+	GMutex files_mutex[1];
+	GHashTable* files;
+
+	/**
+	 * Whether files are opened with O_DIRECT to bypass the page cache.
+	 **/
+	gboolean direct;
+
+	/**
+	 * Whether objects are distributed across subdirectories based on a hash of their name.
+	 * This keeps directories small for namespaces with many objects.
+	 **/
+	gboolean hashed;
+
+	/**
+	 * Whether reads are served from cached memory mappings.
+	 **/
+	gboolean mapped;
+
+	/**
+	 * The memory mappings, protected by mappings_mutex.
+	 * The queue is sorted by the last access, the most recently used mapping comes first.
+	 **/
+	GMutex mappings_mutex[1];
+	GHashTable* mappings;
+	GQueue* mappings_lru;
+
+	/**
+	 * Held for reading while copying from a mapping and for writing while shrinking a file.
+	 * Accessing a mapping beyond the end of its file raises SIGBUS.
+	 **/
+	GRWLock mappings_truncate_lock[1];
+
+#ifdef HAVE_LMDB
+	/**
+	 * A sorted index of all names, NULL if it is disabled.
+	 * Keys consist of the namespace and the name, each including its null byte.
+	 **/
+	MDB_env* index;
+	MDB_dbi index_dbi;
+#endif
 };
 
 typedef struct JBackendData JBackendData;
@@ -41,24 +103,81 @@ struct JBackendIterator
 {
 	JDirIterator* iterator;
 	gchar* prefix;
+
+	/**
+	 * Whether names include the hashed subdirectories, which have to be skipped.
+	 **/
+	gboolean hashed;
+
+#ifdef HAVE_LMDB
+	/**
+	 * The index cursor, NULL if the directory is iterated instead.
+	 **/
+	MDB_txn* txn;
+	MDB_cursor* cursor;
+	MDB_cursor_op cursor_op;
+
+	/**
+	 * The namespace and prefix that all keys have to start with.
+	 **/
+	gchar* key;
+	gsize key_len;
+	gsize namespace_len;
+#endif
 };
 
 typedef struct JBackendIterator JBackendIterator;
 
 struct JBackendObject
 {
+	/**
+	 * The backend instance that owns the file.
+	 **/
+	JBackendData* bd;
+
 	gchar* path;
 	gint fd;
 	guint ref_count;
+
+	/**
+	 * Serializes unaligned direct writes, which read, modify and write whole blocks and fix up the file size afterwards.
+	 * Aligned direct writes only take the lock for reading, so they can still run concurrently.
+	 **/
+	GRWLock direct_lock[1];
 };
 
 typedef struct JBackendObject JBackendObject;
 
-static guint jd_num_backends = 0;
+/**
+ * A read-only memory mapping of a file.
+ **/
+struct BackendMapping
+{
+	gchar* path;
+	gchar* data;
+	guint64 length;
 
-static GHashTable* jd_backend_file_cache = NULL;
+	/**
+	 * The number of readers that are currently using the mapping.
+	 * Mappings that have been removed from the cache are unmapped once this drops to 0.
+	 **/
+	guint ref_count;
+	gboolean cached;
+
+	/**
+	 * The mapping's link in the LRU queue.
+	 **/
+	GList* link;
+
+	/**
+	 * The end of the last read and the number of sequential reads, used to choose the madvise() hint.
+	 **/
+	guint64 next_offset;
+	guint sequential;
+	gint advice;
+};
 
-G_LOCK_DEFINE_STATIC(jd_backend_file_cache);
+typedef struct BackendMapping BackendMapping;
 
 static void
 jd_backend_files_free(gpointer data)
@@ -76,23 +195,32 @@ backend_file_unref(gpointer data)
 {
 	JBackendObject* bo = data;
 
+	JBackendData* bd;
+
 	g_return_if_fail(bo != NULL);
 
-	G_LOCK(jd_backend_file_cache);
+	bd = bo->bd;
+
+	g_mutex_lock(bd->files_mutex);
 
 	if (g_atomic_int_dec_and_test(&(bo->ref_count)))
 	{
-		g_hash_table_remove(jd_backend_file_cache, bo->path);
+		// The object might have been deleted and re-created in the meantime
+		if (g_hash_table_lookup(bd->files, bo->path) == bo)
+		{
+			g_hash_table_remove(bd->files, bo->path);
+		}
 
 		j_trace_file_begin(bo->path, J_TRACE_FILE_CLOSE);
 		close(bo->fd);
 		j_trace_file_end(bo->path, J_TRACE_FILE_CLOSE, 0, 0);
 
+		g_rw_lock_clear(bo->direct_lock);
 		g_free(bo->path);
 		g_free(bo);
 	}
 
-	G_UNLOCK(jd_backend_file_cache);
+	g_mutex_unlock(bd->files_mutex);
 }
 
 static GHashTable*
@@ -111,8 +239,52 @@ jd_backend_files_get_thread(void)
 	return files;
 }
 
+/**
+ * The size of the per-thread bounce buffers used for unaligned direct I/O.
+ **/
+#define BACKEND_DIRECT_BUFFER_SIZE (4 * 1024 * 1024)
+
+static GPrivate jd_backend_direct_buffer = G_PRIVATE_INIT(free);
+
+static gchar*
+backend_direct_buffer_get(void)
+{
+	gchar* buffer;
+
+	buffer = g_private_get(&jd_backend_direct_buffer);
+
+	if (G_UNLIKELY(buffer == NULL))
+	{
+		buffer = j_helper_alloc_aligned(J_BACKEND_ALIGNMENT, BACKEND_DIRECT_BUFFER_SIZE);
+		g_private_set(&jd_backend_direct_buffer, buffer);
+	}
+
+	return buffer;
+}
+
+static gint
+backend_open_fd(JBackendData* bd, gchar const* path, gint flags)
+{
+	gint fd;
+
+	if (!bd->direct)
+	{
+		return open(path, flags, 0600);
+	}
+
+	fd = open(path, flags | O_DIRECT, 0600);
+
+	// Some file systems, such as tmpfs, do not support direct I/O
+	if (fd == -1 && errno == EINVAL)
+	{
+		fd = open(path, flags, 0600);
+	}
+
+	return fd;
+}
+
 static JBackendObject*
-backend_file_get(GHashTable* files, gchar const* key)
+backend_file_get(JBackendData* bd, GHashTable* files, gchar const* key)
 {
 	JBackendObject* bo;
 
@@ -121,13 +293,13 @@ backend_file_get(GHashTable* files, gchar const* key)
 		goto end;
 	}
 
-	G_LOCK(jd_backend_file_cache);
+	g_mutex_lock(bd->files_mutex);
 
-	if ((bo = g_hash_table_lookup(jd_backend_file_cache, key)) != NULL)
+	if ((bo = g_hash_table_lookup(bd->files, key)) != NULL)
 	{
 		g_atomic_int_inc(&(bo->ref_count));
 		g_hash_table_insert(files, bo->path, bo);
-		G_UNLOCK(jd_backend_file_cache);
+		g_mutex_unlock(bd->files_mutex);
 	}
 
 	/* Attention: The caller must call backend_file_add() if NULL is returned! */
@@ -137,271 +309,1510 @@ end:
 }
 
 static void
-backend_file_add(GHashTable* files, JBackendObject* object)
+backend_file_add(JBackendData* bd, GHashTable* files, JBackendObject* object)
 {
 	if (object != NULL)
 	{
-		g_hash_table_insert(jd_backend_file_cache, object->path, object);
+		g_hash_table_insert(bd->files, object->path, object);
 		g_hash_table_insert(files, object->path, object);
 	}
 
-	G_UNLOCK(jd_backend_file_cache);
+	g_mutex_unlock(bd->files_mutex);
+}
+
+/**
+ * Returns the subdirectory of a name when using the hashed layout.
+ * The layout is part of the on-disk format and must not change, see also julea-posix-migrate.
+ **/
+static gchar*
+backend_hashed_dir(gchar const* name)
+{
+	// FNV-1a
+	guint32 hash = 2166136261U;
+
+	for (gchar const* c = name; *c != '\0'; c++)
+	{
+		hash ^= (guchar)*c;
+		hash *= 16777619U;
+	}
+
+	return g_strdup_printf("%02x/%02x", hash & 0xff, (hash >> 8) & 0xff);
+}
+
+static gchar*
+backend_build_path(JBackendData* bd, gchar const* namespace, gchar const* path)
+{
+	if (bd->hashed)
+	{
+		g_autofree gchar* dir = NULL;
+
+		dir = backend_hashed_dir(path);
+
+		return g_build_filename(bd->path, namespace, dir, path, NULL);
+	}
+
+	return g_build_filename(bd->path, namespace, path, NULL);
+}
+
+#ifdef HAVE_LMDB
+/**
+ * Marks an index as complete, real keys are at least two bytes long.
+ **/
+static gchar const backend_index_populated[] = "";
+
+static gchar*
+backend_index_key(gchar const* namespace, gchar const* name, gsize* key_len)
+{
+	gchar* key;
+	gsize namespace_len;
+	gsize name_len;
+
+	namespace_len = strlen(namespace) + 1;
+	name_len = strlen(name) + 1;
+
+	key = g_malloc(namespace_len + name_len);
+	memcpy(key, namespace, namespace_len);
+	memcpy(key + namespace_len, name, name_len);
+
+	*key_len = namespace_len + name_len;
+
+	return key;
+}
+
+/**
+ * Extracts the name below a namespace directory, stripping the hashed subdirectories.
+ *
+ * \return The name or NULL if the path does not belong to an object.
+ **/
+static gchar const*
+backend_index_name(JBackendData* bd, gchar const* path)
+{
+	if (bd->hashed)
+	{
+		if (strlen(path) < 7 || path[2] != '/' || path[5] != '/')
+		{
+			return NULL;
+		}
+
+		path += 6;
+	}
+
+	return path;
 }
 
 static gboolean
-backend_create(gpointer backend_data, gchar const* namespace, gchar const* path, gpointer* backend_object)
+backend_index_update(JBackendData* bd, gchar const* path, gboolean insert)
 {
-	JBackendData* bd = backend_data;
-	GHashTable* files = jd_backend_files_get_thread();
+	MDB_txn* txn;
+	MDB_val m_key;
+	MDB_val m_value;
+	g_autofree gchar* namespace = NULL;
+	g_autofree gchar* key = NULL;
+	gchar const* relative_path;
+	gchar const* name;
+	gchar const* separator;
+	gsize key_len;
+	gint ret;
+
+	// Paths look like bd->path/namespace/name
+	relative_path = path + strlen(bd->path) + 1;
+
+	if ((separator = strchr(relative_path, '/')) == NULL || (name = backend_index_name(bd, separator + 1)) == NULL)
+	{
+		return FALSE;
+	}
 
-	JBackendObject* bo = NULL;
-	g_autofree gchar* parent = NULL;
-	gchar* full_path;
-	gint fd;
+	namespace = g_strndup(relative_path, separator - relative_path);
+	key = backend_index_key(namespace, name, &key_len);
+
+	if (mdb_txn_begin(bd->index, NULL, 0, &txn) != 0)
+	{
+		return FALSE;
+	}
 
-	full_path = g_build_filename(bd->path, namespace, path, NULL);
+	m_key.mv_size = key_len;
+	m_key.mv_data = key;
 
-	if ((bo = backend_file_get(files, full_path)) != NULL)
+	if (insert)
 	{
-		g_free(full_path);
+		m_value.mv_size = 0;
+		m_value.mv_data = NULL;
 
-		/// \todo
-		fd = bo->fd;
+		ret = mdb_put(txn, bd->index_dbi, &m_key, &m_value, 0);
+	}
+	else
+	{
+		ret = mdb_del(txn, bd->index_dbi, &m_key, NULL);
+		ret = (ret == MDB_NOTFOUND) ? 0 : ret;
+	}
 
-		goto end;
+	if (ret != 0)
+	{
+		mdb_txn_abort(txn);
+		return FALSE;
 	}
 
-	j_trace_file_begin(full_path, J_TRACE_FILE_CREATE);
+	return (mdb_txn_commit(txn) == 0);
+}
 
-	parent = g_path_get_dirname(full_path);
-	g_mkdir_with_parents(parent, 0700);
+/**
+ * Adds all existing objects to a new index.
+ **/
+static gboolean
+backend_index_populate(JBackendData* bd)
+{
+	MDB_txn* txn;
+	MDB_val m_key;
+	MDB_val m_value;
+	GDir* dir;
+	gchar const* namespace;
+	gboolean ret = TRUE;
 
-	fd = open(full_path, O_RDWR | O_CREAT, 0600);
+	m_key.mv_size = sizeof(backend_index_populated);
+	m_key.mv_data = (gpointer)backend_index_populated;
 
-	j_trace_file_end(full_path, J_TRACE_FILE_CREATE, 0, 0);
+	if (mdb_txn_begin(bd->index, NULL, 0, &txn) != 0)
+	{
+		return FALSE;
+	}
 
-	if (fd == -1)
+	if (mdb_get(txn, bd->index_dbi, &m_key, &m_value) == 0)
 	{
-		backend_file_add(files, NULL);
-		goto end;
+		mdb_txn_abort(txn);
+		return TRUE;
 	}
 
-	bo = g_new(JBackendObject, 1);
-	bo->path = full_path;
-	bo->fd = fd;
-	bo->ref_count = 1;
+	if ((dir = g_dir_open(bd->path, 0, NULL)) == NULL)
+	{
+		mdb_txn_abort(txn);
+		return FALSE;
+	}
+
+	while (ret && (namespace = g_dir_read_name(dir)) != NULL)
+	{
+		g_autofree gchar* namespace_path = NULL;
+		JDirIterator* iterator;
+
+		// Skip the index itself
+		if (namespace[0] == '.')
+		{
+			continue;
+		}
+
+		namespace_path = g_build_filename(bd->path, namespace, NULL);
+
+		if ((iterator = j_dir_iterator_new(namespace_path)) == NULL)
+		{
+			continue;
+		}
 
-	backend_file_add(files, bo);
+		while (ret && j_dir_iterator_next(iterator))
+		{
+			g_autofree gchar* key = NULL;
+			gchar const* name;
+			gsize key_len;
+
+			if ((name = backend_index_name(bd, j_dir_iterator_get(iterator))) == NULL)
+			{
+				continue;
+			}
+
+			key = backend_index_key(namespace, name, &key_len);
+
+			m_key.mv_size = key_len;
+			m_key.mv_data = key;
+			m_value.mv_size = 0;
+			m_value.mv_data = NULL;
+
+			ret = (mdb_put(txn, bd->index_dbi, &m_key, &m_value, 0) == 0);
+		}
+
+		j_dir_iterator_free(iterator);
+	}
+
+	g_dir_close(dir);
+
+	m_key.mv_size = sizeof(backend_index_populated);
+	m_key.mv_data = (gpointer)backend_index_populated;
+	m_value.mv_size = 0;
+	m_value.mv_data = NULL;
+
+	if (!ret || mdb_put(txn, bd->index_dbi, &m_key, &m_value, 0) != 0)
+	{
+		mdb_txn_abort(txn);
+		return FALSE;
+	}
+
+	return (mdb_txn_commit(txn) == 0);
+}
+
+static gboolean
+backend_index_open(JBackendData* bd)
+{
+	MDB_txn* txn;
+	g_autofree gchar* index_path = NULL;
+
+	index_path = g_build_filename(bd->path, ".index", NULL);
+	g_mkdir_with_parents(index_path, 0700);
+
+	if (mdb_env_create(&(bd->index)) != 0)
+	{
+		bd->index = NULL;
+		return FALSE;
+	}
+
+	/// \todo grow mapsize dynamically
+	// Syncing every create would be too expensive, backend_sync() syncs explicitly
+	// Iterators may be used by other threads than the one that created them
+	if (mdb_env_set_mapsize(bd->index, (gsize)4 * 1024 * 1024 * 1024) != 0
+	    || mdb_env_open(bd->index, index_path, MDB_NOSYNC | MDB_NOTLS, 0600) != 0
+	    || mdb_txn_begin(bd->index, NULL, 0, &txn) != 0)
+	{
+		goto error;
+	}
+
+	if (mdb_dbi_open(txn, NULL, 0, &(bd->index_dbi)) != 0 || mdb_txn_commit(txn) != 0)
+	{
+		goto error;
+	}
+
+	if (!backend_index_populate(bd))
+	{
+		goto error;
+	}
+
+	return TRUE;
+
+error:
+	mdb_env_close(bd->index);
+	bd->index = NULL;
+
+	return FALSE;
+}
+
+static gboolean
+backend_index_iterator_new(JBackendData* bd, gchar const* namespace, gchar const* prefix, JBackendIterator** iterator)
+{
+	MDB_txn* txn;
+	MDB_cursor* cursor;
+	gsize prefix_len;
+
+	if (mdb_txn_begin(bd->index, NULL, MDB_RDONLY, &txn) != 0)
+	{
+		return FALSE;
+	}
+
+	if (mdb_cursor_open(txn, bd->index_dbi, &cursor) != 0)
+	{
+		mdb_txn_abort(txn);
+		return FALSE;
+	}
+
+	prefix_len = (prefix != NULL) ? strlen(prefix) : 0;
+
+	*iterator = g_new(JBackendIterator, 1);
+	(*iterator)->iterator = NULL;
+	(*iterator)->prefix = NULL;
+	(*iterator)->hashed = bd->hashed;
+	(*iterator)->txn = txn;
+	(*iterator)->cursor = cursor;
+	(*iterator)->cursor_op = MDB_SET_RANGE;
+	(*iterator)->namespace_len = strlen(namespace) + 1;
+	(*iterator)->key_len = (*iterator)->namespace_len + prefix_len;
+	(*iterator)->key = g_malloc((*iterator)->key_len);
+
+	memcpy((*iterator)->key, namespace, (*iterator)->namespace_len);
+
+	if (prefix_len > 0)
+	{
+		memcpy((*iterator)->key + (*iterator)->namespace_len, prefix, prefix_len);
+	}
+
+	return TRUE;
+}
+
+/**
+ * Returns the next name from the index.
+ * Keys are sorted, so the first key that does not match ends the iteration.
+ **/
+static gboolean
+backend_index_iterate(JBackendIterator* iterator, gchar const** name)
+{
+	MDB_val m_key;
+	MDB_val m_value;
+
+	m_key.mv_size = iterator->key_len;
+	m_key.mv_data = iterator->key;
+
+	if (mdb_cursor_get(iterator->cursor, &m_key, &m_value, iterator->cursor_op) == 0
+	    && m_key.mv_size > iterator->key_len
+	    && memcmp(m_key.mv_data, iterator->key, iterator->key_len) == 0)
+	{
+		iterator->cursor_op = MDB_NEXT;
+
+		// Keys include the name's null byte
+		*name = (gchar const*)m_key.mv_data + iterator->namespace_len;
+
+		return TRUE;
+	}
+
+	mdb_cursor_close(iterator->cursor);
+	mdb_txn_abort(iterator->txn);
+	g_free(iterator->key);
+	g_free(iterator);
+
+	return FALSE;
+}
+#endif
+
+/**
+ * The maximum number of cached mappings.
+ **/
+#define BACKEND_MAPPINGS_MAX 1024
+
+/**
+ * The number of sequential reads after which a mapping is advised to be read sequentially.
+ **/
+#define BACKEND_MAPPING_SEQUENTIAL 4
+
+static void
+backend_mapping_free(BackendMapping* mapping)
+{
+	munmap(mapping->data, mapping->length);
+	g_free(mapping->path);
+	g_free(mapping);
+}
+
+/**
+ * Removes a mapping from the cache, bd->mappings_mutex has to be held.
+ **/
+static void
+backend_mapping_remove(JBackendData* bd, BackendMapping* mapping)
+{
+	g_hash_table_remove(bd->mappings, mapping->path);
+	g_queue_delete_link(bd->mappings_lru, mapping->link);
+
+	mapping->cached = FALSE;
+	mapping->link = NULL;
+
+	if (mapping->ref_count == 0)
+	{
+		backend_mapping_free(mapping);
+	}
+}
+
+/**
+ * Returns a referenced mapping of the object that covers the given range if possible.
+ *
+ * \return The mapping or NULL if the object can not be mapped.
+ **/
+static BackendMapping*
+backend_mapping_get(JBackendData* bd, JBackendObject* bo, guint64 length, guint64 offset)
+{
+	BackendMapping* mapping;
+	gint advice;
+
+	g_mutex_lock(bd->mappings_mutex);
+
+	mapping = g_hash_table_lookup(bd->mappings, bo->path);
+
+	if (mapping != NULL && offset + length > mapping->length)
+	{
+		struct stat buf;
+
+		// The file might have been extended by another handle
+		if (fstat(bo->fd, &buf) == 0 && (guint64)buf.st_size > mapping->length)
+		{
+			backend_mapping_remove(bd, mapping);
+			mapping = NULL;
+		}
+	}
+
+	if (mapping == NULL)
+	{
+		struct stat buf;
+		gpointer data;
+
+		// Empty files can not be mapped
+		if (fstat(bo->fd, &buf) != 0 || buf.st_size == 0)
+		{
+			goto end;
+		}
+
+		if ((data = mmap(NULL, buf.st_size, PROT_READ, MAP_SHARED, bo->fd, 0)) == MAP_FAILED)
+		{
+			goto end;
+		}
+
+		mapping = g_new(BackendMapping, 1);
+		mapping->path = g_strdup(bo->path);
+		mapping->data = data;
+		mapping->length = buf.st_size;
+		mapping->ref_count = 0;
+		mapping->cached = TRUE;
+		mapping->next_offset = 0;
+		mapping->sequential = 0;
+		mapping->advice = MADV_NORMAL;
+
+		g_hash_table_insert(bd->mappings, mapping->path, mapping);
+		g_queue_push_head(bd->mappings_lru, mapping);
+		mapping->link = bd->mappings_lru->head;
+
+		while (g_queue_get_length(bd->mappings_lru) > BACKEND_MAPPINGS_MAX)
+		{
+			backend_mapping_remove(bd, g_queue_peek_tail(bd->mappings_lru));
+		}
+	}
+	else
+	{
+		g_queue_unlink(bd->mappings_lru, mapping->link);
+		g_queue_push_head_link(bd->mappings_lru, mapping->link);
+	}
+
+	// Only change the hint when the access pattern changes to avoid a system call per read
+	mapping->sequential = (offset == mapping->next_offset) ? mapping->sequential + 1 : 0;
+	mapping->next_offset = offset + length;
+	advice = mapping->advice;
+
+	if (mapping->sequential == 0)
+	{
+		advice = MADV_RANDOM;
+	}
+	else if (mapping->sequential >= BACKEND_MAPPING_SEQUENTIAL)
+	{
+		advice = MADV_SEQUENTIAL;
+	}
+
+	if (advice != mapping->advice)
+	{
+		madvise(mapping->data, mapping->length, advice);
+		mapping->advice = advice;
+	}
+
+	mapping->ref_count++;
+
+end:
+	g_mutex_unlock(bd->mappings_mutex);
+
+	return mapping;
+}
+
+static void
+backend_mapping_release(JBackendData* bd, BackendMapping* mapping)
+{
+	g_mutex_lock(bd->mappings_mutex);
+
+	mapping->ref_count--;
+
+	if (mapping->ref_count == 0 && !mapping->cached)
+	{
+		backend_mapping_free(mapping);
+	}
+
+	g_mutex_unlock(bd->mappings_mutex);
+}
+
+/**
+ * Invalidates an object's mapping if it does not cover the given size.
+ * Shared mappings reflect writes within their range, so only growing the file requires a new mapping.
+ **/
+static void
+backend_mapping_invalidate(JBackendData* bd, gchar const* path, guint64 size)
+{
+	BackendMapping* mapping;
+
+	g_mutex_lock(bd->mappings_mutex);
+
+	if ((mapping = g_hash_table_lookup(bd->mappings, path)) != NULL && size > mapping->length)
+	{
+		backend_mapping_remove(bd, mapping);
+	}
+
+	g_mutex_unlock(bd->mappings_mutex);
+}
+
+/**
+ * Reads from an object's mapping.
+ *
+ * \return TRUE if the mapping could be used, FALSE if the file has to be read instead.
+ **/
+static gboolean
+backend_mapping_read(JBackendData* bd, JBackendObject* bo, gpointer buffer, guint64 length, guint64 offset, guint64* bytes_read)
+{
+	BackendMapping* mapping;
+
+	// Files that are shrunk by other processes can not be protected against, see the documentation of the mmap: option
+	g_rw_lock_reader_lock(bd->mappings_truncate_lock);
+
+	if ((mapping = backend_mapping_get(bd, bo, length, offset)) == NULL)
+	{
+		g_rw_lock_reader_unlock(bd->mappings_truncate_lock);
+
+		return FALSE;
+	}
+
+	*bytes_read = 0;
+
+	if (offset < mapping->length)
+	{
+		*bytes_read = MIN(length, mapping->length - offset);
+		memcpy(buffer, mapping->data + offset, *bytes_read);
+	}
+
+	backend_mapping_release(bd, mapping);
+
+	g_rw_lock_reader_unlock(bd->mappings_truncate_lock);
+
+	return TRUE;
+}
+
+static gboolean
+backend_create(gpointer backend_data, gchar const* namespace, gchar const* path, gpointer* backend_object)
+{
+	JBackendData* bd = backend_data;
+	GHashTable* files = jd_backend_files_get_thread();
+
+	JBackendObject* bo = NULL;
+	g_autofree gchar* parent = NULL;
+	gchar* full_path;
+	gint fd;
+
+	full_path = backend_build_path(bd, namespace, path);
+
+	if ((bo = backend_file_get(bd, files, full_path)) != NULL)
+	{
+		g_free(full_path);
+
+		/// \todo
+		fd = bo->fd;
+
+		goto end;
+	}
+
+	j_trace_file_begin(full_path, J_TRACE_FILE_CREATE);
+
+	parent = g_path_get_dirname(full_path);
+	g_mkdir_with_parents(parent, 0700);
+
+	fd = backend_open_fd(bd, full_path, O_RDWR | O_CREAT);
+
+	j_trace_file_end(full_path, J_TRACE_FILE_CREATE, 0, 0);
+
+	if (fd == -1)
+	{
+		backend_file_add(bd, files, NULL);
+		goto end;
+	}
+
+#ifdef HAVE_LMDB
+	if (bd->index != NULL && !backend_index_update(bd, full_path, TRUE))
+	{
+		close(fd);
+		g_free(full_path);
+		backend_file_add(bd, files, NULL);
+
+		fd = -1;
+		goto end;
+	}
+#endif
+
+	bo = g_new(JBackendObject, 1);
+	bo->bd = bd;
+	bo->path = full_path;
+	bo->fd = fd;
+	bo->ref_count = 1;
+	g_rw_lock_init(bo->direct_lock);
+
+	backend_file_add(bd, files, bo);
+
+end:
+	*backend_object = bo;
+
+	return (fd != -1);
+}
+
+static gboolean
+backend_open(gpointer backend_data, gchar const* namespace, gchar const* path, gpointer* backend_object)
+{
+	JBackendData* bd = backend_data;
+	GHashTable* files = jd_backend_files_get_thread();
+
+	JBackendObject* bo = NULL;
+	gchar* full_path;
+	gint fd;
+
+	full_path = backend_build_path(bd, namespace, path);
+
+	if ((bo = backend_file_get(bd, files, full_path)) != NULL)
+	{
+		g_free(full_path);
+
+		/// \todo
+		fd = bo->fd;
+
+		goto end;
+	}
+
+	j_trace_file_begin(full_path, J_TRACE_FILE_OPEN);
+	fd = backend_open_fd(bd, full_path, O_RDWR);
+	j_trace_file_end(full_path, J_TRACE_FILE_OPEN, 0, 0);
+
+	if (fd == -1)
+	{
+		backend_file_add(bd, files, NULL);
+		goto end;
+	}
+
+	bo = g_new(JBackendObject, 1);
+	bo->bd = bd;
+	bo->path = full_path;
+	bo->fd = fd;
+	bo->ref_count = 1;
+	g_rw_lock_init(bo->direct_lock);
+
+	backend_file_add(bd, files, bo);
+
+end:
+	*backend_object = bo;
+
+	return (fd != -1);
+}
+
+static gboolean
+backend_delete(gpointer backend_data, gpointer backend_object)
+{
+	JBackendData* bd = backend_data;
+	JBackendObject* bo = backend_object;
+	GHashTable* files = jd_backend_files_get_thread();
+	gboolean ret;
+
+	// Other threads might still have the object open, their handles must not be reused when re-creating it
+	// Holding the lock while unlinking also prevents other threads from opening the object in the meantime
+	g_mutex_lock(bd->files_mutex);
+
+	if (g_hash_table_lookup(bd->files, bo->path) == bo)
+	{
+		g_hash_table_remove(bd->files, bo->path);
+	}
+
+	j_trace_file_begin(bo->path, J_TRACE_FILE_DELETE);
+	ret = (g_unlink(bo->path) == 0);
+	j_trace_file_end(bo->path, J_TRACE_FILE_DELETE, 0, 0);
+
+	g_mutex_unlock(bd->files_mutex);
+
+	if (bd->mapped)
+	{
+		backend_mapping_invalidate(bd, bo->path, G_MAXUINT64);
+	}
+
+#ifdef HAVE_LMDB
+	if (ret && bd->index != NULL)
+	{
+		ret = backend_index_update(bd, bo->path, FALSE);
+	}
+#endif
+
+	g_hash_table_remove(files, bo->path);
+
+	return ret;
+}
+
+static gboolean
+backend_close(gpointer backend_data, gpointer backend_object)
+{
+	JBackendObject* bo = backend_object;
+	GHashTable* files = jd_backend_files_get_thread();
+	gboolean ret;
+
+	(void)backend_data;
+
+	ret = g_hash_table_remove(files, bo->path);
+
+	return ret;
+}
+
+static gboolean
+backend_status(gpointer backend_data, gpointer backend_object, gint64* modification_time, guint64* size)
+{
+	JBackendObject* bo = backend_object;
+	gboolean ret = TRUE;
+	struct stat buf;
+
+	(void)backend_data;
+
+	if (modification_time != NULL || size != NULL)
+	{
+		j_trace_file_begin(bo->path, J_TRACE_FILE_STATUS);
+		ret = (fstat(bo->fd, &buf) == 0);
+		j_trace_file_end(bo->path, J_TRACE_FILE_STATUS, 0, 0);
+
+		if (ret && modification_time != NULL)
+		{
+			*modification_time = buf.st_mtime * G_USEC_PER_SEC;
+
+#ifdef HAVE_STMTIM_TVNSEC
+			*modification_time += buf.st_mtim.tv_nsec / 1000;
+#endif
+		}
+
+		if (ret && size != NULL)
+		{
+			*size = buf.st_size;
+		}
+	}
+
+	return ret;
+}
+
+static gboolean
+backend_sync(gpointer backend_data, gpointer backend_object)
+{
+	JBackendData* bd = backend_data;
+	JBackendObject* bo = backend_object;
+	gboolean ret;
+
+	(void)bd;
+
+	j_trace_file_begin(bo->path, J_TRACE_FILE_SYNC);
+	ret = (fsync(bo->fd) == 0);
+
+#ifdef HAVE_LMDB
+	// The index is opened without syncing, so it has to be synced explicitly
+	if (bd->index != NULL)
+	{
+		ret = (mdb_env_sync(bd->index, 1) == 0) && ret;
+	}
+#endif
+
+	j_trace_file_end(bo->path, J_TRACE_FILE_SYNC, 0, 0);
+
+	return ret;
+}
+
+/**
+ * Reads or writes a range of the file, retrying short transfers.
+ *
+ * \return The number of bytes read or written.
+ **/
+static guint64
+backend_direct_io(JBackendObject* bo, gchar* buffer, guint64 length, guint64 offset, gboolean write)
+{
+	guint64 nbytes_total = 0;
+
+	while (nbytes_total < length)
+	{
+		gssize nbytes;
+
+		if (write)
+		{
+			nbytes = pwrite(bo->fd, buffer + nbytes_total, length - nbytes_total, offset + nbytes_total);
+		}
+		else
+		{
+			nbytes = pread(bo->fd, buffer + nbytes_total, length - nbytes_total, offset + nbytes_total);
+		}
+
+		if (nbytes < 0 && errno == EINTR)
+		{
+			continue;
+		}
+		else if (nbytes <= 0)
+		{
+			break;
+		}
+
+		nbytes_total += nbytes;
+	}
+
+	return nbytes_total;
+}
+
+/**
+ * Reads a block into the bounce buffer, the part beyond the end of the file is zeroed.
+ **/
+static void
+backend_direct_read_block(JBackendObject* bo, gchar* block, guint64 offset)
+{
+	guint64 nbytes;
+
+	nbytes = backend_direct_io(bo, block, J_BACKEND_ALIGNMENT, offset, FALSE);
+	memset(block + nbytes, 0, J_BACKEND_ALIGNMENT - nbytes);
+}
+
+/**
+ * Reads or writes an extent using direct I/O.
+ * Aligned extents are transferred as is, others go through the calling thread's bounce buffer.
+ * Partial blocks are written using read-modify-write.
+ *
+ * \return The number of bytes read or written.
+ **/
+static guint64
+backend_direct_transfer(JBackendObject* bo, gchar* buffer, guint64 length, guint64 offset, gboolean write)
+{
+	guint64 const alignment = J_BACKEND_ALIGNMENT;
+
+	gchar* bounce;
+	guint64 nbytes_total = 0;
+	guint64 file_size = 0;
+	struct stat buf;
+
+	if ((guintptr)buffer % alignment == 0 && offset % alignment == 0 && length % alignment == 0)
+	{
+		if (write)
+		{
+			g_rw_lock_reader_lock(bo->direct_lock);
+			nbytes_total = backend_direct_io(bo, buffer, length, offset, write);
+			g_rw_lock_reader_unlock(bo->direct_lock);
+
+			return nbytes_total;
+		}
+
+		return backend_direct_io(bo, buffer, length, offset, write);
+	}
+
+	bounce = backend_direct_buffer_get();
+
+	if (write)
+	{
+		// Other writes to the same blocks or beyond the current end of the file would be lost otherwise
+		g_rw_lock_writer_lock(bo->direct_lock);
+
+		if (fstat(bo->fd, &buf) == 0)
+		{
+			file_size = buf.st_size;
+		}
+	}
+
+	while (nbytes_total < length)
+	{
+		guint64 start = offset + nbytes_total;
+		guint64 head = start % alignment;
+		guint64 block_start = start - head;
+		guint64 piece = MIN(length - nbytes_total, BACKEND_DIRECT_BUFFER_SIZE - head);
+		guint64 block_length = (head + piece + alignment - 1) / alignment * alignment;
+		guint64 nbytes;
+
+		if (write)
+		{
+			if (head > 0)
+			{
+				backend_direct_read_block(bo, bounce, block_start);
+			}
+
+			if ((head + piece) % alignment != 0 && (head == 0 || block_length > alignment))
+			{
+				backend_direct_read_block(bo, bounce + block_length - alignment, block_start + block_length - alignment);
+			}
+
+			memcpy(bounce + head, buffer + nbytes_total, piece);
+		}
+
+		nbytes = backend_direct_io(bo, bounce, block_length, block_start, write);
+		nbytes = (nbytes > head) ? MIN(nbytes - head, piece) : 0;
+
+		if (!write)
+		{
+			memcpy(buffer + nbytes_total, bounce + head, nbytes);
+		}
+
+		nbytes_total += nbytes;
+
+		if (nbytes < piece)
+		{
+			break;
+		}
+	}
+
+	// Writing whole blocks may have extended the file beyond the written data
+	if (write && fstat(bo->fd, &buf) == 0 && (guint64)buf.st_size > MAX(file_size, offset + nbytes_total))
+	{
+		if (ftruncate(bo->fd, MAX(file_size, offset + nbytes_total)) != 0)
+		{
+			g_warning("Can not truncate %s.", bo->path);
+		}
+	}
+
+	if (write)
+	{
+		g_rw_lock_writer_unlock(bo->direct_lock);
+	}
+
+	return nbytes_total;
+}
+
+static gboolean
+backend_read(gpointer backend_data, gpointer backend_object, gpointer buffer, guint64 length, guint64 offset, guint64* bytes_read)
+{
+	JBackendData* bd = backend_data;
+	JBackendObject* bo = backend_object;
+
+	guint64 nbytes_total = 0;
+	gboolean done = FALSE;
+
+	j_trace_file_begin(bo->path, J_TRACE_FILE_READ);
+
+	if (bd->direct)
+	{
+		nbytes_total = backend_direct_transfer(bo, buffer, length, offset, FALSE);
+		done = TRUE;
+	}
+	else if (bd->mapped)
+	{
+		done = backend_mapping_read(bd, bo, buffer, length, offset, &nbytes_total);
+	}
+
+	while (!done && nbytes_total < length)
+	{
+		gssize nbytes;
+
+		nbytes = pread(bo->fd, (gchar*)buffer + nbytes_total, length - nbytes_total, offset + nbytes_total);
+
+		if (nbytes == 0)
+		{
+			break;
+		}
+		else if (nbytes < 0)
+		{
+			if (errno != EINTR)
+			{
+				break;
+			}
+		}
+
+		nbytes_total += nbytes;
+	}
+
+	j_trace_file_end(bo->path, J_TRACE_FILE_READ, nbytes_total, offset);
+
+	if (bytes_read != NULL)
+	{
+		*bytes_read = nbytes_total;
+	}
+
+	return (nbytes_total == length);
+}
+
+static gboolean
+backend_write(gpointer backend_data, gpointer backend_object, gconstpointer buffer, guint64 length, guint64 offset, guint64* bytes_written)
+{
+	JBackendData* bd = backend_data;
+	JBackendObject* bo = backend_object;
+
+	gsize nbytes_total = 0;
+
+	j_trace_file_begin(bo->path, J_TRACE_FILE_WRITE);
+
+	if (bd->direct)
+	{
+		nbytes_total = backend_direct_transfer(bo, (gchar*)buffer, length, offset, TRUE);
+	}
+
+	while (!bd->direct && nbytes_total < length)
+	{
+		gssize nbytes;
+
+		nbytes = pwrite(bo->fd, (gchar const*)buffer + nbytes_total, length - nbytes_total, offset + nbytes_total);
+
+		if (nbytes <= 0)
+		{
+			if (errno != EINTR)
+			{
+				break;
+			}
+		}
+
+		nbytes_total += nbytes;
+	}
+
+	j_trace_file_end(bo->path, J_TRACE_FILE_WRITE, nbytes_total, offset);
+
+	if (bd->mapped)
+	{
+		backend_mapping_invalidate(bd, bo->path, offset + nbytes_total);
+	}
+
+	if (bytes_written != NULL)
+	{
+		*bytes_written = nbytes_total;
+	}
+
+	return (nbytes_total == length);
+}
+
+/**
+ * The maximum number of buffers per system call, Linux does not support more than this.
+ **/
+#define BACKEND_IOV_MAX 1024
+
+static gint
+backend_extent_compare(gconstpointer a, gconstpointer b)
+{
+	JBackendExtent const* extent_a = *((JBackendExtent const* const*)a);
+	JBackendExtent const* extent_b = *((JBackendExtent const* const*)b);
+
+	if (extent_a->offset < extent_b->offset)
+	{
+		return -1;
+	}
+
+	return (extent_a->offset > extent_b->offset) ? 1 : 0;
+}
+
+/**
+ * Reads or writes a contiguous range of the file into or from multiple buffers.
+ *
+ * \return The number of bytes read or written.
+ **/
+static guint64
+backend_transfer_iov(JBackendObject* bo, struct iovec* iov, guint iov_len, guint64 offset, gboolean write)
+{
+	guint64 nbytes_total = 0;
+
+	while (iov_len > 0)
+	{
+		gssize nbytes;
+
+		if (write)
+		{
+			nbytes = pwritev(bo->fd, iov, iov_len, offset + nbytes_total);
+		}
+		else
+		{
+			nbytes = preadv(bo->fd, iov, iov_len, offset + nbytes_total);
+		}
+
+		if (nbytes < 0 && errno == EINTR)
+		{
+			continue;
+		}
+		else if (nbytes <= 0)
+		{
+			break;
+		}
+
+		nbytes_total += nbytes;
+
+		// Skip the buffers that have been transferred completely
+		while (iov_len > 0 && (gsize)nbytes >= iov->iov_len)
+		{
+			nbytes -= iov->iov_len;
+			iov++;
+			iov_len--;
+		}
+
+		if (iov_len > 0)
+		{
+			iov->iov_base = (gchar*)iov->iov_base + nbytes;
+			iov->iov_len -= nbytes;
+		}
+	}
+
+	return nbytes_total;
+}
+
+/**
+ * Reads or writes multiple extents.
+ * The extents are sorted by offset, so that adjacent ones can be transferred using a single system call.
+ **/
+static gboolean
+backend_transferv(JBackendObject* bo, JBackendExtent* extents, guint extents_len, gboolean write)
+{
+	g_autoptr(GPtrArray) sorted = NULL;
+	g_autofree struct iovec* iov = NULL;
+	gboolean overlapping = FALSE;
+	gboolean ret = TRUE;
+	guint i = 0;
+
+	sorted = g_ptr_array_sized_new(extents_len);
+
+	for (guint j = 0; j < extents_len; j++)
+	{
+		g_ptr_array_add(sorted, &(extents[j]));
+	}
+
+	g_ptr_array_sort(sorted, backend_extent_compare);
+
+	for (guint j = 1; j < extents_len; j++)
+	{
+		JBackendExtent* previous = g_ptr_array_index(sorted, j - 1);
+		JBackendExtent* extent = g_ptr_array_index(sorted, j);
+
+		if (extent->offset < previous->offset + previous->length)
+		{
+			overlapping = TRUE;
+			break;
+		}
+	}
+
+	// Overlapping writes have to be performed in their original order
+	if (overlapping && write)
+	{
+		for (guint j = 0; j < extents_len; j++)
+		{
+			g_ptr_array_index(sorted, j) = &(extents[j]);
+		}
+	}
+
+	iov = g_new(struct iovec, MIN(extents_len, BACKEND_IOV_MAX));
+
+	while (i < extents_len)
+	{
+		JBackendExtent* first = g_ptr_array_index(sorted, i);
+		guint64 end = first->offset;
+		guint64 nbytes;
+		guint iov_len = 0;
+		guint j;
+
+		for (j = i; j < extents_len && iov_len < BACKEND_IOV_MAX; j++)
+		{
+			JBackendExtent* extent = g_ptr_array_index(sorted, j);
+
+			if (extent->offset != end)
+			{
+				break;
+			}
+
+			iov[iov_len].iov_base = extent->buffer;
+			iov[iov_len].iov_len = extent->length;
+			iov_len++;
+
+			end += extent->length;
+		}
+
+		j_trace_file_begin(bo->path, (write) ? J_TRACE_FILE_WRITE : J_TRACE_FILE_READ);
+		nbytes = backend_transfer_iov(bo, iov, iov_len, first->offset, write);
+		j_trace_file_end(bo->path, (write) ? J_TRACE_FILE_WRITE : J_TRACE_FILE_READ, nbytes, first->offset);
+
+		ret = (nbytes == end - first->offset) && ret;
+
+		// Short transfers only affect the last extents
+		for (; i < j; i++)
+		{
+			JBackendExtent* extent = g_ptr_array_index(sorted, i);
 
-end:
-	*backend_object = bo;
+			extent->bytes = MIN(nbytes, extent->length);
+			nbytes -= extent->bytes;
+		}
+	}
 
-	return (fd != -1);
+	return ret;
 }
 
+/**
+ * Reads or writes multiple extents using direct I/O.
+ * Vectored I/O can only be used if all extents are aligned.
+ **/
 static gboolean
-backend_open(gpointer backend_data, gchar const* namespace, gchar const* path, gpointer* backend_object)
+backend_direct_transferv(JBackendObject* bo, JBackendExtent* extents, guint extents_len, gboolean write)
 {
-	JBackendData* bd = backend_data;
-	GHashTable* files = jd_backend_files_get_thread();
-
-	JBackendObject* bo = NULL;
-	gchar* full_path;
-	gint fd;
+	gboolean ret = TRUE;
 
-	full_path = g_build_filename(bd->path, namespace, path, NULL);
+	for (guint i = 0; i < extents_len; i++)
+	{
+		if ((guintptr)extents[i].buffer % J_BACKEND_ALIGNMENT != 0 || extents[i].offset % J_BACKEND_ALIGNMENT != 0 || extents[i].length % J_BACKEND_ALIGNMENT != 0)
+		{
+			ret = FALSE;
+			break;
+		}
+	}
 
-	if ((bo = backend_file_get(files, full_path)) != NULL)
+	if (ret)
 	{
-		g_free(full_path);
+		if (write)
+		{
+			g_rw_lock_reader_lock(bo->direct_lock);
+			ret = backend_transferv(bo, extents, extents_len, write);
+			g_rw_lock_reader_unlock(bo->direct_lock);
 
-		/// \todo
-		fd = bo->fd;
+			return ret;
+		}
 
-		goto end;
+		return backend_transferv(bo, extents, extents_len, write);
 	}
 
-	j_trace_file_begin(full_path, J_TRACE_FILE_OPEN);
-	fd = open(full_path, O_RDWR);
-	j_trace_file_end(full_path, J_TRACE_FILE_OPEN, 0, 0);
+	ret = TRUE;
 
-	if (fd == -1)
+	for (guint i = 0; i < extents_len; i++)
 	{
-		backend_file_add(files, NULL);
-		goto end;
-	}
-
-	bo = g_new(JBackendObject, 1);
-	bo->path = full_path;
-	bo->fd = fd;
-	bo->ref_count = 1;
-
-	backend_file_add(files, bo);
+		j_trace_file_begin(bo->path, (write) ? J_TRACE_FILE_WRITE : J_TRACE_FILE_READ);
+		extents[i].bytes = backend_direct_transfer(bo, extents[i].buffer, extents[i].length, extents[i].offset, write);
+		j_trace_file_end(bo->path, (write) ? J_TRACE_FILE_WRITE : J_TRACE_FILE_READ, extents[i].bytes, extents[i].offset);
 
-end:
-	*backend_object = bo;
+		ret = (extents[i].bytes == extents[i].length) && ret;
+	}
 
-	return (fd != -1);
+	return ret;
 }
 
 static gboolean
-backend_delete(gpointer backend_data, gpointer backend_object)
+backend_readv(gpointer backend_data, gpointer backend_object, JBackendExtent* extents, guint extents_len)
 {
-	JBackendObject* bo = backend_object;
-	GHashTable* files = jd_backend_files_get_thread();
-	gboolean ret;
+	JBackendData* bd = backend_data;
 
-	(void)backend_data;
+	if (bd->direct)
+	{
+		return backend_direct_transferv(backend_object, extents, extents_len, FALSE);
+	}
+	else if (bd->mapped)
+	{
+		gboolean ret = TRUE;
 
-	j_trace_file_begin(bo->path, J_TRACE_FILE_DELETE);
-	ret = (g_unlink(bo->path) == 0);
-	j_trace_file_end(bo->path, J_TRACE_FILE_DELETE, 0, 0);
+		// Reading from the mapping does not need system calls, so extents do not have to be combined
+		for (guint i = 0; i < extents_len; i++)
+		{
+			ret = backend_read(backend_data, backend_object, extents[i].buffer, extents[i].length, extents[i].offset, &(extents[i].bytes)) && ret;
+		}
 
-	g_hash_table_remove(files, bo->path);
+		return ret;
+	}
 
-	return ret;
+	return backend_transferv(backend_object, extents, extents_len, FALSE);
 }
 
 static gboolean
-backend_close(gpointer backend_data, gpointer backend_object)
+backend_writev(gpointer backend_data, gpointer backend_object, JBackendExtent* extents, guint extents_len, gboolean sync)
 {
-	JBackendObject* bo = backend_object;
-	GHashTable* files = jd_backend_files_get_thread();
+	JBackendData* bd = backend_data;
 	gboolean ret;
 
-	(void)backend_data;
+	if (bd->direct)
+	{
+		ret = backend_direct_transferv(backend_object, extents, extents_len, TRUE);
+	}
+	else
+	{
+		ret = backend_transferv(backend_object, extents, extents_len, TRUE);
+	}
 
-	ret = g_hash_table_remove(files, bo->path);
+	if (bd->mapped)
+	{
+		JBackendObject* bo = backend_object;
+		guint64 size = 0;
+
+		for (guint i = 0; i < extents_len; i++)
+		{
+			size = MAX(size, extents[i].offset + extents[i].bytes);
+		}
+
+		backend_mapping_invalidate(bd, bo->path, size);
+	}
+
+	if (sync)
+	{
+		ret = backend_sync(backend_data, backend_object) && ret;
+	}
 
 	return ret;
 }
 
 static gboolean
-backend_status(gpointer backend_data, gpointer backend_object, gint64* modification_time, guint64* size)
+backend_copy(gpointer backend_data, gpointer source_object, gpointer destination_object, guint64* bytes_copied)
 {
-	JBackendObject* bo = backend_object;
+	JBackendData* bd = backend_data;
+	JBackendObject* source = source_object;
+	JBackendObject* destination = destination_object;
 	gboolean ret = TRUE;
 	struct stat buf;
+	guint64 size;
 
-	(void)backend_data;
+	if (fstat(source->fd, &buf) != 0)
+	{
+		return FALSE;
+	}
 
-	if (modification_time != NULL || size != NULL)
+	size = buf.st_size;
+
+	j_trace_file_begin(destination->path, J_TRACE_FILE_WRITE);
+
+#ifdef FICLONE
+	// Cloning replaces the destination's data and might therefore shrink it
+	if (bd->mapped)
 	{
-		j_trace_file_begin(bo->path, J_TRACE_FILE_STATUS);
-		ret = (fstat(bo->fd, &buf) == 0);
-		j_trace_file_end(bo->path, J_TRACE_FILE_STATUS, 0, 0);
+		g_rw_lock_writer_lock(bd->mappings_truncate_lock);
+	}
 
-		if (ret && modification_time != NULL)
-		{
-			*modification_time = buf.st_mtime * G_USEC_PER_SEC;
+	// Reflinks share the data blocks, so nothing has to be copied at all
+	if (ioctl(destination->fd, FICLONE, source->fd) == 0)
+	{
+		*bytes_copied = size;
+	}
 
-#ifdef HAVE_STMTIM_TVNSEC
-			*modification_time += buf.st_mtim.tv_nsec / 1000;
+	if (bd->mapped)
+	{
+		backend_mapping_invalidate(bd, destination->path, G_MAXUINT64);
+		g_rw_lock_writer_unlock(bd->mappings_truncate_lock);
+	}
 #endif
-		}
 
-		if (ret && size != NULL)
+	// copy_file_range() copies within the kernel and can use server-side copies on network file systems
+	while (*bytes_copied < size)
+	{
+		off_t source_offset = *bytes_copied;
+		off_t destination_offset = *bytes_copied;
+		gssize nbytes;
+
+		nbytes = copy_file_range(source->fd, &source_offset, destination->fd, &destination_offset, size - *bytes_copied, 0);
+
+		if (nbytes < 0 && errno == EINTR)
 		{
-			*size = buf.st_size;
+			continue;
+		}
+		else if (nbytes <= 0)
+		{
+			break;
 		}
+
+		*bytes_copied += nbytes;
 	}
 
-	return ret;
-}
+	j_trace_file_end(destination->path, J_TRACE_FILE_WRITE, *bytes_copied, 0);
 
-static gboolean
-backend_sync(gpointer backend_data, gpointer backend_object)
-{
-	JBackendObject* bo = backend_object;
-	gboolean ret;
+	// Some file systems do not support copy_file_range(), for example, when copying between different file systems
+	if (*bytes_copied < size)
+	{
+		gpointer buffer;
 
-	(void)backend_data;
+		buffer = j_helper_alloc_aligned(J_BACKEND_ALIGNMENT, BACKEND_DIRECT_BUFFER_SIZE);
 
-	j_trace_file_begin(bo->path, J_TRACE_FILE_SYNC);
-	ret = (fsync(bo->fd) == 0);
-	j_trace_file_end(bo->path, J_TRACE_FILE_SYNC, 0, 0);
+		while (ret && *bytes_copied < size)
+		{
+			guint64 length = MIN(BACKEND_DIRECT_BUFFER_SIZE, size - *bytes_copied);
+			guint64 bytes_read = 0;
+			guint64 bytes_written = 0;
+
+			// Short reads and writes would otherwise loop forever, for instance, if the source has been truncated in the meantime
+			ret = backend_read(backend_data, source, buffer, length, *bytes_copied, &bytes_read) && bytes_read == length;
+			ret = ret && backend_write(backend_data, destination, buffer, bytes_read, *bytes_copied, &bytes_written) && bytes_written == bytes_read;
+
+			*bytes_copied += bytes_written;
+		}
+
+		free(buffer);
+	}
+
+	// Readers must not access the destination's mapping while it is being shrunk
+	if (bd->mapped)
+	{
+		g_rw_lock_writer_lock(bd->mappings_truncate_lock);
+	}
+
+	// The destination might have been larger than the source before
+	if (ret && ftruncate(destination->fd, size) != 0)
+	{
+		ret = FALSE;
+	}
+
+	// Mappings beyond the end of a truncated file can not be accessed anymore
+	if (bd->mapped)
+	{
+		backend_mapping_invalidate(bd, destination->path, G_MAXUINT64);
+		g_rw_lock_writer_unlock(bd->mappings_truncate_lock);
+	}
 
 	return ret;
 }
 
 static gboolean
-backend_read(gpointer backend_data, gpointer backend_object, gpointer buffer, guint64 length, guint64 offset, guint64* bytes_read)
+backend_allocate(gpointer backend_data, gpointer backend_object, guint64 length, guint64 offset)
 {
+	JBackendData* bd = backend_data;
 	JBackendObject* bo = backend_object;
+	gint ret;
 
-	gsize nbytes_total = 0;
+	j_trace_file_begin(bo->path, J_TRACE_FILE_WRITE);
 
-	(void)backend_data;
+	do
+	{
+		ret = fallocate(bo->fd, 0, offset, length);
+	} while (ret != 0 && errno == EINTR);
 
-	j_trace_file_begin(bo->path, J_TRACE_FILE_READ);
+	// posix_fallocate() writes zeros if the file system does not support allocating space
+	if (ret != 0 && errno == EOPNOTSUPP)
+	{
+		ret = posix_fallocate(bo->fd, offset, length);
+	}
 
-	while (nbytes_total < length)
+	j_trace_file_end(bo->path, J_TRACE_FILE_WRITE, 0, offset);
+
+	if (bd->mapped)
 	{
-		gssize nbytes;
+		backend_mapping_invalidate(bd, bo->path, offset + length);
+	}
 
-		nbytes = pread(bo->fd, (gchar*)buffer + nbytes_total, length - nbytes_total, offset + nbytes_total);
+	return (ret == 0);
+}
 
-		if (nbytes == 0)
-		{
-			break;
-		}
-		else if (nbytes < 0)
-		{
-			if (errno != EINTR)
-			{
-				break;
-			}
-		}
+static gboolean
+backend_punch(gpointer backend_data, gpointer backend_object, guint64 length, guint64 offset)
+{
+	JBackendObject* bo = backend_object;
+	gint ret;
 
-		nbytes_total += nbytes;
-	}
+	(void)backend_data;
 
-	j_trace_file_end(bo->path, J_TRACE_FILE_READ, nbytes_total, offset);
+	// Mappings do not have to be invalidated since the size does not change
+	j_trace_file_begin(bo->path, J_TRACE_FILE_WRITE);
 
-	if (bytes_read != NULL)
+	do
 	{
-		*bytes_read = nbytes_total;
-	}
+		ret = fallocate(bo->fd, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE, offset, length);
+	} while (ret != 0 && errno == EINTR);
 
-	return (nbytes_total == length);
+	j_trace_file_end(bo->path, J_TRACE_FILE_WRITE, 0, offset);
+
+	return (ret == 0);
 }
 
 static gboolean
-backend_write(gpointer backend_data, gpointer backend_object, gconstpointer buffer, guint64 length, guint64 offset, guint64* bytes_written)
+backend_get_extents(gpointer backend_data, gpointer backend_object, guint64 length, guint64 offset, GArray* extents)
 {
 	JBackendObject* bo = backend_object;
-
-	gsize nbytes_total = 0;
+	guint64 end = offset + length;
+	struct stat buf;
 
 	(void)backend_data;
 
-	j_trace_file_begin(bo->path, J_TRACE_FILE_WRITE);
+	if (fstat(bo->fd, &buf) != 0)
+	{
+		return FALSE;
+	}
 
-	while (nbytes_total < length)
+	end = MIN(end, (guint64)buf.st_size);
+
+	while (offset < end)
 	{
-		gssize nbytes;
+		JBackendExtent extent;
+		off_t data;
+		off_t hole;
 
-		nbytes = pwrite(bo->fd, (gchar const*)buffer + nbytes_total, length - nbytes_total, offset + nbytes_total);
+		// ENXIO means that there is no more data until the end of the file
+		if ((data = lseek(bo->fd, offset, SEEK_DATA)) < 0)
+		{
+			return (errno == ENXIO);
+		}
 
-		if (nbytes <= 0)
+		if ((guint64)data >= end)
 		{
-			if (errno != EINTR)
-			{
-				break;
-			}
+			break;
 		}
 
-		nbytes_total += nbytes;
-	}
+		if ((hole = lseek(bo->fd, data, SEEK_HOLE)) < 0)
+		{
+			return FALSE;
+		}
 
-	j_trace_file_end(bo->path, J_TRACE_FILE_WRITE, nbytes_total, offset);
+		extent.buffer = NULL;
+		extent.length = MIN((guint64)hole, end) - data;
+		extent.offset = data;
+		extent.bytes = 0;
 
-	if (bytes_written != NULL)
-	{
-		*bytes_written = nbytes_total;
+		g_array_append_val(extents, extent);
+
+		offset = hole;
 	}
 
-	return (nbytes_total == length);
+	return TRUE;
 }
 
 static gboolean
@@ -415,6 +1826,13 @@ backend_get_all(gpointer backend_data, gchar const* namespace, gpointer* backend
 	g_return_val_if_fail(namespace != NULL, FALSE);
 	g_return_val_if_fail(backend_iterator != NULL, FALSE);
 
+#ifdef HAVE_LMDB
+	if (bd->index != NULL)
+	{
+		return backend_index_iterator_new(bd, namespace, NULL, (JBackendIterator**)backend_iterator);
+	}
+#endif
+
 	full_path = g_build_filename(bd->path, namespace, NULL);
 	it = j_dir_iterator_new(full_path);
 
@@ -423,6 +1841,10 @@ backend_get_all(gpointer backend_data, gchar const* namespace, gpointer* backend
 		iterator = g_new(JBackendIterator, 1);
 		iterator->iterator = it;
 		iterator->prefix = NULL;
+		iterator->hashed = bd->hashed;
+#ifdef HAVE_LMDB
+		iterator->txn = NULL;
+#endif
 
 		*backend_iterator = iterator;
 	}
@@ -442,6 +1864,13 @@ backend_get_by_prefix(gpointer backend_data, gchar const* namespace, gchar const
 	g_return_val_if_fail(prefix != NULL, FALSE);
 	g_return_val_if_fail(backend_iterator != NULL, FALSE);
 
+#ifdef HAVE_LMDB
+	if (bd->index != NULL)
+	{
+		return backend_index_iterator_new(bd, namespace, prefix, (JBackendIterator**)backend_iterator);
+	}
+#endif
+
 	full_path = g_build_filename(bd->path, namespace, NULL);
 	it = j_dir_iterator_new(full_path);
 
@@ -450,6 +1879,10 @@ backend_get_by_prefix(gpointer backend_data, gchar const* namespace, gchar const
 		iterator = g_new(JBackendIterator, 1);
 		iterator->iterator = it;
 		iterator->prefix = g_strdup(prefix);
+		iterator->hashed = bd->hashed;
+#ifdef HAVE_LMDB
+		iterator->txn = NULL;
+#endif
 
 		*backend_iterator = iterator;
 	}
@@ -467,12 +1900,30 @@ backend_iterate(gpointer backend_data, gpointer backend_iterator, gchar const**
 	g_return_val_if_fail(backend_iterator != NULL, FALSE);
 	g_return_val_if_fail(name != NULL, FALSE);
 
+#ifdef HAVE_LMDB
+	if (iterator->txn != NULL)
+	{
+		return backend_index_iterate(iterator, name);
+	}
+#endif
+
 	while (j_dir_iterator_next(iterator->iterator))
 	{
 		gchar const* name_;
 
 		name_ = j_dir_iterator_get(iterator->iterator);
 
+		if (iterator->hashed)
+		{
+			// Names look like xx/yy/name, skip everything else
+			if (strlen(name_) < 7 || name_[2] != '/' || name_[5] != '/')
+			{
+				continue;
+			}
+
+			name_ += 6;
+		}
+
 		if (iterator->prefix != NULL && !g_str_has_prefix(name_, iterator->prefix))
 		{
 			continue;
@@ -494,15 +1945,83 @@ static gboolean
 backend_init(gchar const* path, gpointer* backend_data)
 {
 	JBackendData* bd;
+	gboolean indexed = FALSE;
 
 	bd = g_new(JBackendData, 1);
+	bd->direct = FALSE;
+	bd->hashed = FALSE;
+	bd->mapped = FALSE;
+	bd->files = g_hash_table_new(g_str_hash, g_str_equal);
+	bd->mappings = g_hash_table_new(g_str_hash, g_str_equal);
+	bd->mappings_lru = g_queue_new();
+	g_mutex_init(bd->files_mutex);
+	g_mutex_init(bd->mappings_mutex);
+	g_rw_lock_init(bd->mappings_truncate_lock);
+#ifdef HAVE_LMDB
+	bd->index = NULL;
+#endif
+
+	/* Path syntax: [direct:][hashed:][indexed:][mmap:]path
+	   e.g.: direct:hashed:/var/storage/posix */
+	while (TRUE)
+	{
+		if (g_str_has_prefix(path, "direct:"))
+		{
+			bd->direct = TRUE;
+			path += strlen("direct:");
+		}
+		else if (g_str_has_prefix(path, "hashed:"))
+		{
+			bd->hashed = TRUE;
+			path += strlen("hashed:");
+		}
+		else if (g_str_has_prefix(path, "indexed:"))
+		{
+			indexed = TRUE;
+			path += strlen("indexed:");
+		}
+		else if (g_str_has_prefix(path, "mmap:"))
+		{
+			bd->mapped = TRUE;
+			path += strlen("mmap:");
+		}
+		else
+		{
+			break;
+		}
+	}
+
 	bd->path = g_strdup(path);
 
-	jd_backend_file_cache = g_hash_table_new_full(g_str_hash, g_str_equal, NULL, NULL);
+	if (bd->direct && bd->mapped)
+	{
+		// Mappings use the page cache, which direct I/O bypasses
+		g_warning("Can not use mmap: together with direct:, disabling mappings.");
+		bd->mapped = FALSE;
+	}
 
 	g_mkdir_with_parents(path, 0700);
 
-	g_atomic_int_inc(&jd_num_backends);
+	if (indexed)
+	{
+#ifdef HAVE_LMDB
+		if (!backend_index_open(bd))
+#endif
+		{
+			g_warning("Can not open index in %s.", path);
+
+			g_hash_table_destroy(bd->files);
+			g_hash_table_destroy(bd->mappings);
+			g_queue_free(bd->mappings_lru);
+			g_mutex_clear(bd->files_mutex);
+			g_mutex_clear(bd->mappings_mutex);
+			g_rw_lock_clear(bd->mappings_truncate_lock);
+			g_free(bd->path);
+			g_free(bd);
+
+			return FALSE;
+		}
+	}
 
 	*backend_data = bd;
 
@@ -514,11 +2033,27 @@ backend_fini(gpointer backend_data)
 {
 	JBackendData* bd = backend_data;
 
-	if (g_atomic_int_dec_and_test(&jd_num_backends))
+	g_assert(g_hash_table_size(bd->files) == 0);
+	g_hash_table_destroy(bd->files);
+	g_mutex_clear(bd->files_mutex);
+
+	while (!g_queue_is_empty(bd->mappings_lru))
+	{
+		backend_mapping_remove(bd, g_queue_peek_tail(bd->mappings_lru));
+	}
+
+	g_hash_table_destroy(bd->mappings);
+	g_queue_free(bd->mappings_lru);
+	g_mutex_clear(bd->mappings_mutex);
+	g_rw_lock_clear(bd->mappings_truncate_lock);
+
+#ifdef HAVE_LMDB
+	if (bd->index != NULL)
 	{
-		g_assert(g_hash_table_size(jd_backend_file_cache) == 0);
-		g_hash_table_destroy(jd_backend_file_cache);
+		mdb_env_sync(bd->index, 1);
+		mdb_env_close(bd->index);
 	}
+#endif
 
 	g_free(bd->path);
 	g_free(bd);
@@ -539,6 +2074,12 @@ static JBackend posix_backend = {
 		.backend_sync = backend_sync,
 		.backend_read = backend_read,
 		.backend_write = backend_write,
+		.backend_readv = backend_readv,
+		.backend_writev = backend_writev,
+		.backend_copy = backend_copy,
+		.backend_allocate = backend_allocate,
+		.backend_punch = backend_punch,
+		.backend_get_extents = backend_get_extents,
 		.backend_get_all = backend_get_all,
 		.backend_get_by_prefix = backend_get_by_prefix,
 		.backend_iterate = backend_iterate }
@@ -25,10 +25,21 @@
 
 #include <julea.h>
 
+/**
+ * The default number of I/O contexts.
+ **/
+#define BACKEND_IOCTX_COUNT 4
+
 struct JBackendData
 {
 	rados_t backend_connection;
-	rados_ioctx_t backend_io;
+
+	/**
+	 * The I/O contexts, which are assigned to objects round-robin.
+	 **/
+	rados_ioctx_t* backend_ioctxs;
+	guint backend_ioctxs_len;
+	guint backend_ioctxs_next;
 
 	gchar* backend_pool;
 	gchar* backend_config;
@@ -39,48 +50,127 @@ typedef struct JBackendData JBackendData;
 struct JBackendObject
 {
 	gchar* path;
+	rados_ioctx_t io;
+
+	/**
+	 * Asynchronous operations that are still in flight.
+	 * Creates return immediately, their results are collected by backend_wait().
+	 * Writes are waited for before returning, so that their results can be reported to the client.
+	 **/
+	GArray* pending;
 };
 
 typedef struct JBackendObject JBackendObject;
 
+struct JBackendPending
+{
+	rados_completion_t completion;
+
+	/**
+	 * The write operation, which has to be kept until the operation has completed.
+	 **/
+	rados_write_op_t write_op;
+};
+
+typedef struct JBackendPending JBackendPending;
+
+static JBackendObject*
+backend_object_new(JBackendData* bd, gchar const* namespace, gchar const* path)
+{
+	JBackendObject* bo;
+	guint index;
+
+	index = (guint)g_atomic_int_add(&(bd->backend_ioctxs_next), 1) % bd->backend_ioctxs_len;
+
+	bo = g_new(JBackendObject, 1);
+	bo->path = g_strconcat(namespace, path, NULL);
+	bo->io = bd->backend_ioctxs[index];
+	bo->pending = g_array_new(FALSE, FALSE, sizeof(JBackendPending));
+
+	return bo;
+}
+
+static void
+backend_object_free(JBackendObject* bo)
+{
+	g_assert(bo->pending->len == 0);
+
+	g_array_unref(bo->pending);
+	g_free(bo->path);
+	g_free(bo);
+}
+
+/**
+ * Waits for all operations that are in flight.
+ *
+ * \return TRUE if all operations have been successful, FALSE otherwise.
+ **/
+static gboolean
+backend_wait(JBackendObject* bo)
+{
+	gboolean ret = TRUE;
+
+	for (guint i = 0; i < bo->pending->len; i++)
+	{
+		JBackendPending* pending = &g_array_index(bo->pending, JBackendPending, i);
+
+		rados_aio_wait_for_complete(pending->completion);
+		ret = (rados_aio_get_return_value(pending->completion) == 0) && ret;
+		rados_aio_release(pending->completion);
+
+		if (pending->write_op != NULL)
+		{
+			rados_release_write_op(pending->write_op);
+		}
+	}
+
+	g_array_set_size(bo->pending, 0);
+
+	return ret;
+}
+
 static gboolean
 backend_create(gpointer backend_data, gchar const* namespace, gchar const* path, gpointer* backend_object)
 {
 	JBackendData* bd = backend_data;
 	JBackendObject* bo;
-	gchar* full_path = g_strconcat(namespace, path, NULL);
-	gint ret = 0;
+	JBackendPending pending = { NULL, NULL };
+	gint ret;
 
-	j_trace_file_begin(full_path, J_TRACE_FILE_CREATE);
-	ret = rados_write_full(bd->backend_io, full_path, "", 0);
-	j_trace_file_end(full_path, J_TRACE_FILE_CREATE, 0, 0);
+	bo = backend_object_new(bd, namespace, path);
 
-	g_return_val_if_fail(ret == 0, FALSE);
+	j_trace_file_begin(bo->path, J_TRACE_FILE_CREATE);
 
-	bo = g_new(JBackendObject, 1);
-	bo->path = full_path;
+	// The result is collected when the object is written, synced or closed, so that multiple creates can be in flight
+	if ((ret = rados_aio_create_completion2(NULL, NULL, &(pending.completion))) == 0)
+	{
+		if ((ret = rados_aio_write_full(bo->io, bo->path, pending.completion, "", 0)) == 0)
+		{
+			g_array_append_val(bo->pending, pending);
+		}
+		else
+		{
+			rados_aio_release(pending.completion);
+		}
+	}
+
+	j_trace_file_end(bo->path, J_TRACE_FILE_CREATE, 0, 0);
 
 	*backend_object = bo;
 
-	return TRUE;
+	return (ret == 0);
 }
 
 static gboolean
 backend_open(gpointer backend_data, gchar const* namespace, gchar const* path, gpointer* backend_object)
 {
+	JBackendData* bd = backend_data;
 	JBackendObject* bo;
-	gchar* full_path = g_strconcat(namespace, path, NULL);
-	gint ret = 0;
 
-	(void)backend_data;
-
-	j_trace_file_begin(full_path, J_TRACE_FILE_OPEN);
-	j_trace_file_end(full_path, J_TRACE_FILE_OPEN, 0, 0);
-
-	g_return_val_if_fail(ret == 0, FALSE);
+	bo = backend_object_new(bd, namespace, path);
 
-	bo = g_new(JBackendObject, 1);
-	bo->path = full_path;
+	j_trace_file_begin(bo->path, J_TRACE_FILE_OPEN);
+	j_trace_file_end(bo->path, J_TRACE_FILE_OPEN, 0, 0);
 
 	*backend_object = bo;
 
@@ -90,16 +180,18 @@ backend_open(gpointer backend_data, gchar const* namespace, gchar const* path, g
 static gboolean
 backend_delete(gpointer backend_data, gpointer backend_object)
 {
-	JBackendData* bd = backend_data;
 	JBackendObject* bo = backend_object;
 	gint ret = 0;
 
+	(void)backend_data;
+
+	backend_wait(bo);
+
 	j_trace_file_begin(bo->path, J_TRACE_FILE_DELETE);
-	ret = rados_remove(bd->backend_io, bo->path);
+	ret = rados_remove(bo->io, bo->path);
 	j_trace_file_end(bo->path, J_TRACE_FILE_DELETE, 0, 0);
 
-	g_free(bo->path);
-	g_free(bo);
+	backend_object_free(bo);
 
 	return (ret == 0 ? TRUE : FALSE);
 }
@@ -108,31 +200,35 @@ static gboolean
 backend_close(gpointer backend_data, gpointer backend_object)
 {
 	JBackendObject* bo = backend_object;
+	gboolean ret;
 
 	(void)backend_data;
 
 	j_trace_file_begin(bo->path, J_TRACE_FILE_CLOSE);
+	ret = backend_wait(bo);
 	j_trace_file_end(bo->path, J_TRACE_FILE_CLOSE, 0, 0);
 
-	g_free(bo->path);
-	g_free(bo);
+	backend_object_free(bo);
 
-	return TRUE;
+	return ret;
 }
 
 static gboolean
 backend_status(gpointer backend_data, gpointer backend_object, gint64* modification_time, guint64* size)
 {
-	JBackendData* bd = backend_data;
 	JBackendObject* bo = backend_object;
 	gboolean ret = TRUE;
 	gint64 modification_time_ = 0;
 	guint64 size_ = 0;
 
-	if (modification_time != NULL || size != NULL)
+	(void)backend_data;
+
+	ret = backend_wait(bo);
+
+	if (ret && (modification_time != NULL || size != NULL))
 	{
 		j_trace_file_begin(bo->path, J_TRACE_FILE_STATUS);
-		ret = (rados_stat(bd->backend_io, bo->path, &size_, &modification_time_) == 0);
+		ret = (rados_stat(bo->io, bo->path, &size_, &modification_time_) == 0);
 		j_trace_file_end(bo->path, J_TRACE_FILE_STATUS, 0, 0);
 
 		if (ret && modification_time != NULL)
@@ -149,29 +245,32 @@ backend_status(gpointer backend_data, gpointer backend_object, gint64* modificat
 	return ret;
 }
 
-/* Not implemented */
 static gboolean
 backend_sync(gpointer backend_data, gpointer backend_object)
 {
 	JBackendObject* bo = backend_object;
+	gboolean ret;
 
 	(void)backend_data;
 
+	// Operations are persistent once they have completed
 	j_trace_file_begin(bo->path, J_TRACE_FILE_SYNC);
+	ret = backend_wait(bo);
 	j_trace_file_end(bo->path, J_TRACE_FILE_SYNC, 0, 0);
 
-	return TRUE;
+	return ret;
 }
 
 static gboolean
 backend_read(gpointer backend_data, gpointer backend_object, gpointer buffer, guint64 length, guint64 offset, guint64* bytes_read)
 {
-	JBackendData* bd = backend_data;
 	JBackendObject* bo = backend_object;
 	gint ret = 0;
 
+	(void)backend_data;
+
 	j_trace_file_begin(bo->path, J_TRACE_FILE_READ);
-	ret = rados_read(bd->backend_io, bo->path, buffer, length, offset);
+	ret = rados_read(bo->io, bo->path, buffer, length, offset);
 	j_trace_file_end(bo->path, J_TRACE_FILE_READ, length, offset);
 
 	g_return_val_if_fail(ret >= 0, FALSE);
@@ -187,12 +286,13 @@ backend_read(gpointer backend_data, gpointer backend_object, gpointer buffer, gu
 static gboolean
 backend_write(gpointer backend_data, gpointer backend_object, gconstpointer buffer, guint64 length, guint64 offset, guint64* bytes_written)
 {
-	JBackendData* bd = backend_data;
 	JBackendObject* bo = backend_object;
 	gint ret = 0;
 
+	(void)backend_data;
+
 	j_trace_file_begin(bo->path, J_TRACE_FILE_WRITE);
-	ret = rados_write(bd->backend_io, bo->path, buffer, length, offset);
+	ret = rados_write(bo->io, bo->path, buffer, length, offset);
 	j_trace_file_end(bo->path, J_TRACE_FILE_WRITE, length, offset);
 
 	g_return_val_if_fail(ret == 0, FALSE);
@@ -205,6 +305,111 @@ backend_write(gpointer backend_data, gpointer backend_object, gconstpointer buff
 	return TRUE;
 }
 
+static gboolean
+backend_readv(gpointer backend_data, gpointer backend_object, JBackendExtent* extents, guint extents_len)
+{
+	JBackendObject* bo = backend_object;
+	g_autofree gsize* bytes_read = NULL;
+	g_autofree gint* prvals = NULL;
+	rados_read_op_t read_op;
+	rados_completion_t completion;
+	gboolean ret = TRUE;
+	gint op_ret;
+
+	(void)backend_data;
+
+	bytes_read = g_new0(gsize, extents_len);
+	prvals = g_new0(gint, extents_len);
+	read_op = rados_create_read_op();
+
+	// All extents are read using a single request
+	for (guint i = 0; i < extents_len; i++)
+	{
+		rados_read_op_read(read_op, extents[i].offset, extents[i].length, extents[i].buffer, &(bytes_read[i]), &(prvals[i]));
+	}
+
+	// Operations on the same object are ordered, so pending writes do not have to be waited for
+	j_trace_file_begin(bo->path, J_TRACE_FILE_READ);
+
+	if ((op_ret = rados_aio_create_completion2(NULL, NULL, &completion)) == 0)
+	{
+		if ((op_ret = rados_aio_read_op_operate(read_op, bo->io, completion, bo->path, 0)) == 0)
+		{
+			rados_aio_wait_for_complete(completion);
+			op_ret = rados_aio_get_return_value(completion);
+		}
+
+		rados_aio_release(completion);
+	}
+
+	j_trace_file_end(bo->path, J_TRACE_FILE_READ, 0, 0);
+
+	rados_release_read_op(read_op);
+
+	for (guint i = 0; i < extents_len; i++)
+	{
+		extents[i].bytes = (op_ret == 0 && prvals[i] >= 0) ? bytes_read[i] : 0;
+		ret = (op_ret == 0 && prvals[i] >= 0) && ret;
+	}
+
+	return ret;
+}
+
+static gboolean
+backend_writev(gpointer backend_data, gpointer backend_object, JBackendExtent* extents, guint extents_len, gboolean sync)
+{
+	JBackendObject* bo = backend_object;
+	JBackendPending pending = { NULL, NULL };
+	gboolean ret = TRUE;
+	gint op_ret;
+
+	(void)backend_data;
+	(void)sync;
+
+	pending.write_op = rados_create_write_op();
+
+	// All extents are written atomically using a single request
+	for (guint i = 0; i < extents_len; i++)
+	{
+		rados_write_op_write(pending.write_op, extents[i].buffer, extents[i].length, extents[i].offset);
+	}
+
+	j_trace_file_begin(bo->path, J_TRACE_FILE_WRITE);
+
+	if ((op_ret = rados_aio_create_completion2(NULL, NULL, &(pending.completion))) == 0)
+	{
+		if ((op_ret = rados_aio_write_op_operate(pending.write_op, bo->io, pending.completion, bo->path, NULL, 0)) == 0)
+		{
+			g_array_append_val(bo->pending, pending);
+		}
+		else
+		{
+			rados_aio_release(pending.completion);
+		}
+	}
+
+	if (op_ret != 0)
+	{
+		rados_release_write_op(pending.write_op);
+	}
+
+	// The server replies with the number of bytes written, so errors must not be deferred until the object is closed
+	// Writes are persistent once the operation has completed, so syncing does not require any additional work
+	if (op_ret == 0)
+	{
+		ret = backend_wait(bo);
+	}
+
+	j_trace_file_end(bo->path, J_TRACE_FILE_WRITE, 0, 0);
+
+	for (guint i = 0; i < extents_len; i++)
+	{
+		extents[i].bytes = (op_ret == 0 && ret) ? extents[i].length : 0;
+	}
+
+	return (op_ret == 0 && ret);
+}
+
 /// \todo implement backend_get_all
 /// \todo implement backend_get_by_prefix
 /// \todo implement backend_iterate
@@ -217,15 +422,23 @@ backend_init(gchar const* path, gpointer* backend_data)
 
 	g_return_val_if_fail(path != NULL, FALSE);
 
-	/* Path syntax: [config-path]:[pool]
-	   e.g.: /etc/ceph/ceph.conf:data */
+	/* Path syntax: [config-path]:[pool][:ioctxs]
+	   e.g.: /etc/ceph/ceph.conf:data:4 */
 	split = g_strsplit(path, ":", 0);
 
 	bd = g_new(JBackendData, 1);
 	bd->backend_config = g_strdup(split[0]);
 	bd->backend_pool = g_strdup(split[1]);
 	bd->backend_connection = NULL;
-	bd->backend_io = NULL;
+	bd->backend_ioctxs_len = BACKEND_IOCTX_COUNT;
+	bd->backend_ioctxs_next = 0;
+
+	if (split[1] != NULL && split[2] != NULL)
+	{
+		bd->backend_ioctxs_len = MAX(g_ascii_strtoull(split[2], NULL, 10), 1);
+	}
+
+	bd->backend_ioctxs = g_new0(rados_ioctx_t, bd->backend_ioctxs_len);
 
 	g_return_val_if_fail(bd->backend_pool != NULL, FALSE);
 	g_return_val_if_fail(bd->backend_config != NULL, FALSE);
@@ -249,10 +462,15 @@ backend_init(gchar const* path, gpointer* backend_data)
 	}
 
 	/* Initialize IO and select pool */
-	if (rados_ioctx_create(bd->backend_connection, bd->backend_pool, &(bd->backend_io)) != 0)
+	/* Multiple I/O contexts reduce lock contention within librados */
+	for (guint i = 0; i < bd->backend_ioctxs_len; i++)
 	{
-		rados_shutdown(bd->backend_connection);
-		g_critical("Can not connect to RADOS pool %s.", bd->backend_pool);
+		if (rados_ioctx_create(bd->backend_connection, bd->backend_pool, &(bd->backend_ioctxs[i])) != 0)
+		{
+			rados_shutdown(bd->backend_connection);
+			g_critical("Can not connect to RADOS pool %s.", bd->backend_pool);
+			break;
+		}
 	}
 
 	*backend_data = bd;
@@ -266,7 +484,12 @@ backend_fini(gpointer backend_data)
 	JBackendData* bd = backend_data;
 
 	/* Close connection to cluster */
-	rados_ioctx_destroy(bd->backend_io);
+	for (guint i = 0; i < bd->backend_ioctxs_len; i++)
+	{
+		rados_ioctx_destroy(bd->backend_ioctxs[i]);
+	}
+
+	g_free(bd->backend_ioctxs);
 	rados_shutdown(bd->backend_connection);
 
 	/* Free memory */
@@ -289,7 +512,9 @@ static JBackend rados_backend = {
 		.backend_status = backend_status,
 		.backend_sync = backend_sync,
 		.backend_read = backend_read,
-		.backend_write = backend_write }
+		.backend_write = backend_write,
+		.backend_readv = backend_readv,
+		.backend_writev = backend_writev }
 };
 
 G_MODULE_EXPORT
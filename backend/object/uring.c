@@ -0,0 +1,736 @@
+/*
+ * JULEA - Flexible storage framework
+ * Copyright (C) 2026 Michael Kuhn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <julea-config.h>
+
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <gmodule.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <liburing.h>
+
+#include <julea.h>
+
+/**
+ * The number of submission queue entries per ring.
+ * Messages with more extents are submitted in multiple batches.
+ **/
+#define BACKEND_QUEUE_DEPTH 256
+
+/**
+ * The maximum length of a single request, io_uring's lengths are 32 bits wide.
+ * Longer extents are split into multiple requests.
+ **/
+#define BACKEND_REQUEST_LENGTH_MAX (G_GUINT64_CONSTANT(1) << 30)
+
+/**
+ * Identifies the fsync request's completion.
+ **/
+#define BACKEND_SYNC_DATA G_MAXUINT64
+
+struct JBackendData
+{
+	gchar* path;
+};
+
+typedef struct JBackendData JBackendData;
+
+struct JBackendIterator
+{
+	JDirIterator* iterator;
+	gchar* prefix;
+};
+
+typedef struct JBackendIterator JBackendIterator;
+
+/**
+ * Unlike the posix backend, every handle has its own file descriptor.
+ * The server caches handles per worker thread, so files are not reopened for every message.
+ **/
+struct JBackendObject
+{
+	gchar* path;
+	gint fd;
+};
+
+typedef struct JBackendObject JBackendObject;
+
+static void
+backend_ring_free(gpointer data)
+{
+	struct io_uring* ring = data;
+
+	io_uring_queue_exit(ring);
+	g_free(ring);
+}
+
+/**
+ * Rings must not be shared between threads, so every thread gets its own.
+ **/
+static GPrivate backend_rings = G_PRIVATE_INIT(backend_ring_free);
+
+static struct io_uring*
+backend_ring_get_thread(void)
+{
+	struct io_uring* ring;
+
+	ring = g_private_get(&backend_rings);
+
+	if (G_UNLIKELY(ring == NULL))
+	{
+		gint ret;
+
+		ring = g_new(struct io_uring, 1);
+
+		if ((ret = io_uring_queue_init(BACKEND_QUEUE_DEPTH, ring, 0)) < 0)
+		{
+			g_warning("Can not create io_uring: %s", g_strerror(-ret));
+			g_free(ring);
+
+			return NULL;
+		}
+
+		g_private_set(&backend_rings, ring);
+	}
+
+	return ring;
+}
+
+/**
+ * Aborts a batch by waiting for the completions of all requests that have already been submitted.
+ * Afterwards, the kernel no longer uses the requests' buffers.
+ * The thread's ring is replaced if completions could not be reaped or prepared requests have not been submitted.
+ *
+ * \param in_flight The number of submitted requests whose completions have not been reaped yet.
+ * \param queued    Whether prepared requests are still queued.
+ **/
+static void
+backend_ring_abort(struct io_uring* ring, guint in_flight, gboolean queued)
+{
+	gboolean reaped = TRUE;
+
+	for (guint i = 0; i < in_flight; i++)
+	{
+		struct io_uring_cqe* cqe;
+		gint wait_ret;
+
+		while ((wait_ret = io_uring_wait_cqe(ring, &cqe)) == -EINTR)
+		{
+		}
+
+		if (wait_ret < 0)
+		{
+			reaped = FALSE;
+			break;
+		}
+
+		io_uring_cqe_seen(ring, cqe);
+	}
+
+	// Queued requests would be submitted with the next batch, exiting the ring discards them
+	if (!reaped || queued)
+	{
+		g_private_replace(&backend_rings, NULL);
+	}
+}
+
+static gint
+backend_extent_compare(gconstpointer a, gconstpointer b)
+{
+	JBackendExtent const* extent_a = a;
+	JBackendExtent const* extent_b = b;
+
+	if (extent_a->offset < extent_b->offset)
+	{
+		return -1;
+	}
+
+	return (extent_a->offset > extent_b->offset) ? 1 : 0;
+}
+
+static gboolean
+backend_extents_overlap(JBackendExtent const* extents, guint extents_len)
+{
+	g_autofree JBackendExtent* sorted = NULL;
+	guint64 end = 0;
+
+	sorted = g_memdup2(extents, extents_len * sizeof(JBackendExtent));
+	qsort(sorted, extents_len, sizeof(JBackendExtent), backend_extent_compare);
+
+	for (guint i = 0; i < extents_len; i++)
+	{
+		if (i > 0 && sorted[i].offset < end)
+		{
+			return TRUE;
+		}
+
+		end = MAX(end, sorted[i].offset + sorted[i].length);
+	}
+
+	return FALSE;
+}
+
+/**
+ * Reads or writes multiple extents using io_uring.
+ * All extents are submitted as one batch and their completions are reaped together.
+ * Short transfers are resubmitted in another batch.
+ *
+ * \param sync Whether to submit an fsync request behind the writes.
+ **/
+static gboolean
+backend_transferv(JBackendObject* bo, JBackendExtent* extents, guint extents_len, gboolean write, gboolean sync)
+{
+	struct io_uring* ring;
+	g_autofree gboolean* done = NULL;
+	gboolean ordered = FALSE;
+	gboolean synced = !sync;
+	gboolean ret = TRUE;
+	guint remaining = 0;
+
+	if ((ring = backend_ring_get_thread()) == NULL)
+	{
+		return FALSE;
+	}
+
+	done = g_new(gboolean, extents_len);
+
+	for (guint i = 0; i < extents_len; i++)
+	{
+		extents[i].bytes = 0;
+		done[i] = (extents[i].length == 0);
+
+		if (!done[i])
+		{
+			remaining++;
+		}
+	}
+
+	// Overlapping writes have to be performed in their original order
+	if (write && extents_len > 1)
+	{
+		ordered = backend_extents_overlap(extents, extents_len);
+	}
+
+	j_trace_file_begin(bo->path, (write) ? J_TRACE_FILE_WRITE : J_TRACE_FILE_READ);
+
+	while (remaining > 0 || !synced)
+	{
+		struct io_uring_sqe* sqe = NULL;
+		guint submitted = 0;
+		guint reaped;
+		gint submit_ret;
+		gboolean sync_submitted = FALSE;
+		gboolean complete = TRUE;
+
+		// Leave room for the fsync request
+		for (guint i = 0; i < extents_len && submitted < BACKEND_QUEUE_DEPTH - 1; i++)
+		{
+			gchar* buffer;
+			guint64 length;
+
+			if (done[i])
+			{
+				continue;
+			}
+
+			buffer = (gchar*)extents[i].buffer + extents[i].bytes;
+			length = MIN(extents[i].length - extents[i].bytes, BACKEND_REQUEST_LENGTH_MAX);
+
+			sqe = io_uring_get_sqe(ring);
+
+			if (write)
+			{
+				io_uring_prep_write(sqe, bo->fd, buffer, length, extents[i].offset + extents[i].bytes);
+			}
+			else
+			{
+				io_uring_prep_read(sqe, bo->fd, buffer, length, extents[i].offset + extents[i].bytes);
+			}
+
+			io_uring_sqe_set_data64(sqe, i);
+
+			if (ordered)
+			{
+				io_uring_sqe_set_flags(sqe, IOSQE_IO_LINK);
+			}
+
+			submitted++;
+		}
+
+		// Requests that did not fit into this batch will be submitted in the next one
+		if (submitted < remaining)
+		{
+			complete = FALSE;
+		}
+
+		if (ordered && sqe != NULL)
+		{
+			// The last request ends the chain
+			io_uring_sqe_set_flags(sqe, 0);
+		}
+
+		// Draining makes the fsync wait for all writes without serializing them
+		if (!synced && complete)
+		{
+			sqe = io_uring_get_sqe(ring);
+			io_uring_prep_fsync(sqe, bo->fd, 0);
+			io_uring_sqe_set_data64(sqe, BACKEND_SYNC_DATA);
+			io_uring_sqe_set_flags(sqe, IOSQE_IO_DRAIN);
+
+			submitted++;
+			sync_submitted = TRUE;
+		}
+
+		if ((submit_ret = io_uring_submit_and_wait(ring, submitted)) < (gint)submitted)
+		{
+			// The buffers must not be returned to the caller while the kernel might still use them
+			backend_ring_abort(ring, MAX(submit_ret, 0), TRUE);
+			ret = FALSE;
+			break;
+		}
+
+		for (reaped = 0; reaped < submitted; reaped++)
+		{
+			struct io_uring_cqe* cqe;
+			guint64 data;
+			gint res;
+			gint wait_ret;
+
+			while ((wait_ret = io_uring_wait_cqe(ring, &cqe)) == -EINTR)
+			{
+			}
+
+			if (wait_ret < 0)
+			{
+				ret = FALSE;
+				break;
+			}
+
+			data = io_uring_cqe_get_data64(cqe);
+			res = cqe->res;
+
+			io_uring_cqe_seen(ring, cqe);
+
+			if (data == BACKEND_SYNC_DATA)
+			{
+				// The fsync only covers this batch if there is nothing left to write
+				if (res == 0)
+				{
+					synced = TRUE;
+				}
+				else if (res != -EINTR && res != -EAGAIN)
+				{
+					ret = FALSE;
+					synced = TRUE;
+				}
+
+				continue;
+			}
+
+			if (res > 0)
+			{
+				extents[data].bytes += res;
+
+				if (extents[data].bytes == extents[data].length)
+				{
+					done[data] = TRUE;
+					remaining--;
+				}
+			}
+			else if (res != -EINTR && res != -EAGAIN && res != -ECANCELED)
+			{
+				// End of file or error
+				done[data] = TRUE;
+				remaining--;
+				ret = FALSE;
+			}
+		}
+
+		if (reaped < submitted)
+		{
+			backend_ring_abort(ring, submitted - reaped, FALSE);
+			break;
+		}
+
+		if (!ret && remaining > 0)
+		{
+			break;
+		}
+
+		// Data that is written after the fsync has to be synced again
+		if (sync_submitted && remaining > 0)
+		{
+			synced = FALSE;
+		}
+	}
+
+	j_trace_file_end(bo->path, (write) ? J_TRACE_FILE_WRITE : J_TRACE_FILE_READ, 0, 0);
+
+	return ret && remaining == 0;
+}
+
+static gboolean
+backend_create(gpointer backend_data, gchar const* namespace, gchar const* path, gpointer* backend_object)
+{
+	JBackendData* bd = backend_data;
+	JBackendObject* bo;
+	g_autofree gchar* parent = NULL;
+	gchar* full_path;
+	gint fd;
+
+	full_path = g_build_filename(bd->path, namespace, path, NULL);
+
+	j_trace_file_begin(full_path, J_TRACE_FILE_CREATE);
+
+	parent = g_path_get_dirname(full_path);
+	g_mkdir_with_parents(parent, 0700);
+
+	fd = open(full_path, O_RDWR | O_CREAT, 0600);
+
+	j_trace_file_end(full_path, J_TRACE_FILE_CREATE, 0, 0);
+
+	if (fd == -1)
+	{
+		g_free(full_path);
+		return FALSE;
+	}
+
+	bo = g_new(JBackendObject, 1);
+	bo->path = full_path;
+	bo->fd = fd;
+
+	*backend_object = bo;
+
+	return TRUE;
+}
+
+static gboolean
+backend_open(gpointer backend_data, gchar const* namespace, gchar const* path, gpointer* backend_object)
+{
+	JBackendData* bd = backend_data;
+	JBackendObject* bo;
+	gchar* full_path;
+	gint fd;
+
+	full_path = g_build_filename(bd->path, namespace, path, NULL);
+
+	j_trace_file_begin(full_path, J_TRACE_FILE_OPEN);
+	fd = open(full_path, O_RDWR);
+	j_trace_file_end(full_path, J_TRACE_FILE_OPEN, 0, 0);
+
+	if (fd == -1)
+	{
+		g_free(full_path);
+		return FALSE;
+	}
+
+	bo = g_new(JBackendObject, 1);
+	bo->path = full_path;
+	bo->fd = fd;
+
+	*backend_object = bo;
+
+	return TRUE;
+}
+
+static gboolean
+backend_close(gpointer backend_data, gpointer backend_object)
+{
+	JBackendObject* bo = backend_object;
+	gboolean ret;
+
+	(void)backend_data;
+
+	j_trace_file_begin(bo->path, J_TRACE_FILE_CLOSE);
+	ret = (close(bo->fd) == 0);
+	j_trace_file_end(bo->path, J_TRACE_FILE_CLOSE, 0, 0);
+
+	g_free(bo->path);
+	g_free(bo);
+
+	return ret;
+}
+
+static gboolean
+backend_delete(gpointer backend_data, gpointer backend_object)
+{
+	JBackendObject* bo = backend_object;
+	gboolean ret;
+
+	j_trace_file_begin(bo->path, J_TRACE_FILE_DELETE);
+	ret = (g_unlink(bo->path) == 0);
+	j_trace_file_end(bo->path, J_TRACE_FILE_DELETE, 0, 0);
+
+	backend_close(backend_data, bo);
+
+	return ret;
+}
+
+static gboolean
+backend_status(gpointer backend_data, gpointer backend_object, gint64* modification_time, guint64* size)
+{
+	JBackendObject* bo = backend_object;
+	gboolean ret = TRUE;
+	struct stat buf;
+
+	(void)backend_data;
+
+	if (modification_time != NULL || size != NULL)
+	{
+		j_trace_file_begin(bo->path, J_TRACE_FILE_STATUS);
+		ret = (fstat(bo->fd, &buf) == 0);
+		j_trace_file_end(bo->path, J_TRACE_FILE_STATUS, 0, 0);
+
+		if (ret && modification_time != NULL)
+		{
+			*modification_time = buf.st_mtime * G_USEC_PER_SEC;
+
+#ifdef HAVE_STMTIM_TVNSEC
+			*modification_time += buf.st_mtim.tv_nsec / 1000;
+#endif
+		}
+
+		if (ret && size != NULL)
+		{
+			*size = buf.st_size;
+		}
+	}
+
+	return ret;
+}
+
+static gboolean
+backend_sync(gpointer backend_data, gpointer backend_object)
+{
+	JBackendObject* bo = backend_object;
+	gboolean ret;
+
+	(void)backend_data;
+
+	j_trace_file_begin(bo->path, J_TRACE_FILE_SYNC);
+	ret = (fsync(bo->fd) == 0);
+	j_trace_file_end(bo->path, J_TRACE_FILE_SYNC, 0, 0);
+
+	return ret;
+}
+
+static gboolean
+backend_read(gpointer backend_data, gpointer backend_object, gpointer buffer, guint64 length, guint64 offset, guint64* bytes_read)
+{
+	JBackendExtent extent = { buffer, length, offset, 0 };
+	gboolean ret;
+
+	(void)backend_data;
+
+	ret = backend_transferv(backend_object, &extent, 1, FALSE, FALSE);
+
+	if (bytes_read != NULL)
+	{
+		*bytes_read = extent.bytes;
+	}
+
+	return ret;
+}
+
+static gboolean
+backend_write(gpointer backend_data, gpointer backend_object, gconstpointer buffer, guint64 length, guint64 offset, guint64* bytes_written)
+{
+	JBackendExtent extent = { (gpointer)buffer, length, offset, 0 };
+	gboolean ret;
+
+	(void)backend_data;
+
+	ret = backend_transferv(backend_object, &extent, 1, TRUE, FALSE);
+
+	if (bytes_written != NULL)
+	{
+		*bytes_written = extent.bytes;
+	}
+
+	return ret;
+}
+
+static gboolean
+backend_readv(gpointer backend_data, gpointer backend_object, JBackendExtent* extents, guint extents_len)
+{
+	(void)backend_data;
+
+	return backend_transferv(backend_object, extents, extents_len, FALSE, FALSE);
+}
+
+static gboolean
+backend_writev(gpointer backend_data, gpointer backend_object, JBackendExtent* extents, guint extents_len, gboolean sync)
+{
+	(void)backend_data;
+
+	return backend_transferv(backend_object, extents, extents_len, TRUE, sync);
+}
+
+static gboolean
+backend_get_all(gpointer backend_data, gchar const* namespace, gpointer* backend_iterator)
+{
+	JBackendData* bd = backend_data;
+	JBackendIterator* iterator = NULL;
+	JDirIterator* it;
+	g_autofree gchar* full_path = NULL;
+
+	g_return_val_if_fail(namespace != NULL, FALSE);
+	g_return_val_if_fail(backend_iterator != NULL, FALSE);
+
+	full_path = g_build_filename(bd->path, namespace, NULL);
+	it = j_dir_iterator_new(full_path);
+
+	if (it != NULL)
+	{
+		iterator = g_new(JBackendIterator, 1);
+		iterator->iterator = it;
+		iterator->prefix = NULL;
+
+		*backend_iterator = iterator;
+	}
+
+	return (iterator != NULL);
+}
+
+static gboolean
+backend_get_by_prefix(gpointer backend_data, gchar const* namespace, gchar const* prefix, gpointer* backend_iterator)
+{
+	JBackendData* bd = backend_data;
+	JBackendIterator* iterator = NULL;
+	JDirIterator* it;
+	g_autofree gchar* full_path = NULL;
+
+	g_return_val_if_fail(namespace != NULL, FALSE);
+	g_return_val_if_fail(prefix != NULL, FALSE);
+	g_return_val_if_fail(backend_iterator != NULL, FALSE);
+
+	full_path = g_build_filename(bd->path, namespace, NULL);
+	it = j_dir_iterator_new(full_path);
+
+	if (it != NULL)
+	{
+		iterator = g_new(JBackendIterator, 1);
+		iterator->iterator = it;
+		iterator->prefix = g_strdup(prefix);
+
+		*backend_iterator = iterator;
+	}
+
+	return (iterator != NULL);
+}
+
+static gboolean
+backend_iterate(gpointer backend_data, gpointer backend_iterator, gchar const** name)
+{
+	JBackendIterator* iterator = backend_iterator;
+
+	(void)backend_data;
+
+	g_return_val_if_fail(backend_iterator != NULL, FALSE);
+	g_return_val_if_fail(name != NULL, FALSE);
+
+	while (j_dir_iterator_next(iterator->iterator))
+	{
+		gchar const* name_;
+
+		name_ = j_dir_iterator_get(iterator->iterator);
+
+		if (iterator->prefix != NULL && !g_str_has_prefix(name_, iterator->prefix))
+		{
+			continue;
+		}
+
+		*name = name_;
+
+		return TRUE;
+	}
+
+	g_free(iterator->prefix);
+	j_dir_iterator_free(iterator->iterator);
+	g_free(iterator);
+
+	return FALSE;
+}
+
+static gboolean
+backend_init(gchar const* path, gpointer* backend_data)
+{
+	JBackendData* bd;
+
+	g_return_val_if_fail(path != NULL, FALSE);
+
+	// Fail early if io_uring is not available, for instance, because it has been disabled
+	if (backend_ring_get_thread() == NULL)
+	{
+		return FALSE;
+	}
+
+	bd = g_new(JBackendData, 1);
+	bd->path = g_strdup(path);
+
+	g_mkdir_with_parents(path, 0700);
+
+	*backend_data = bd;
+
+	return TRUE;
+}
+
+static void
+backend_fini(gpointer backend_data)
+{
+	JBackendData* bd = backend_data;
+
+	g_free(bd->path);
+	g_free(bd);
+}
+
+static JBackend uring_backend = {
+	.type = J_BACKEND_TYPE_OBJECT,
+	.component = J_BACKEND_COMPONENT_SERVER,
+	.flags = 0,
+	.object = {
+		.backend_init = backend_init,
+		.backend_fini = backend_fini,
+		.backend_create = backend_create,
+		.backend_delete = backend_delete,
+		.backend_open = backend_open,
+		.backend_close = backend_close,
+		.backend_status = backend_status,
+		.backend_sync = backend_sync,
+		.backend_read = backend_read,
+		.backend_write = backend_write,
+		.backend_readv = backend_readv,
+		.backend_writev = backend_writev,
+		.backend_get_all = backend_get_all,
+		.backend_get_by_prefix = backend_get_by_prefix,
+		.backend_iterate = backend_iterate }
+};
+
+G_MODULE_EXPORT
+JBackend*
+backend_info(void)
+{
+	return &uring_backend;
+}
@@ -115,6 +115,7 @@ j_benchmark_add(gchar const* name, BenchmarkFunc benchmark_func)
 	run->iterations = 0;
 	run->operations = 0;
 	run->bytes = 0;
+	run->allocations = 0;
 
 	j_benchmarks = g_list_prepend(j_benchmarks, run);
 }
@@ -202,6 +203,11 @@ j_benchmark_run_one(BenchmarkRun* run)
 			g_print(" (%s/s)", size);
 		}
 
+		if (run->allocations != 0 && run->operations != 0)
+		{
+			g_print(" (%.1f allocations/op)", (gdouble)run->allocations / (gdouble)run->operations);
+		}
+
 		g_print(" [%.3f seconds]\n", elapsed_total);
 	}
 	else
@@ -348,6 +354,7 @@ main(int argc, char** argv)
 	// Core
 	benchmark_background_operation();
 	benchmark_cache();
+	benchmark_connection();
 	benchmark_memory_chunk();
 	benchmark_message();
 
@@ -30,6 +30,7 @@ struct BenchmarkRun
 	guint iterations;
 	guint64 operations;
 	guint64 bytes;
+	guint64 allocations;
 };
 
 typedef struct BenchmarkRun BenchmarkRun;
@@ -49,6 +50,7 @@ void j_benchmark_add(gchar const*, BenchmarkFunc);
 
 void benchmark_background_operation(void);
 void benchmark_cache(void);
+void benchmark_connection(void);
 void benchmark_memory_chunk(void);
 void benchmark_message(void);
 
@@ -0,0 +1,257 @@
+/*
+ * JULEA - Flexible storage framework
+ * Copyright (C) 2010-2026 Michael Kuhn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <julea-config.h>
+
+#include <glib.h>
+#include <gio/gio.h>
+
+#include <string.h>
+
+#include <julea.h>
+
+#include <jmessage.h>
+
+#include "benchmark.h"
+
+/**
+ * Sends pings over a number of concurrent connections to the first object server.
+ * All connections have one outstanding request at a time, so the throughput shows how well the server scales with the number of connections.
+ * The configured transport is used, which allows comparing TCP and libfabric.
+ * Local servers are reached via shared memory unless it has been disabled, which allows comparing it with loopback TCP.
+ **/
+static void
+_benchmark_connection_ping(BenchmarkRun* run, guint connections_len)
+{
+	guint const n = 10;
+
+	JConfiguration* configuration;
+	g_autoptr(JMessage) message = NULL;
+	JNetworkConnection** connections;
+	gchar const* checksum;
+	gchar multiplexed = 0;
+	gchar compression = J_CONFIGURATION_COMPRESSION_NONE;
+
+	configuration = j_configuration();
+	checksum = j_configuration_get_checksum(configuration);
+
+	connections = g_new0(JNetworkConnection*, connections_len);
+
+	for (guint i = 0; i < connections_len; i++)
+	{
+		connections[i] = j_network_connection_init_client(configuration, J_BACKEND_TYPE_OBJECT, 0);
+
+		if (connections[i] == NULL)
+		{
+			g_warning("Can not connect to %s.", j_configuration_get_server(configuration, J_BACKEND_TYPE_OBJECT, 0));
+			goto end;
+		}
+	}
+
+	message = j_message_new(J_MESSAGE_PING, strlen(checksum) + 1 + 1 + 1);
+	j_message_append_string(message, checksum);
+	j_message_append_1(message, &multiplexed);
+	j_message_append_1(message, &compression);
+
+	j_benchmark_timer_start(run);
+
+	while (j_benchmark_iterate(run))
+	{
+		for (guint i = 0; i < n; i++)
+		{
+			for (guint j = 0; j < connections_len; j++)
+			{
+				j_message_send(message, connections[j]);
+			}
+
+			for (guint j = 0; j < connections_len; j++)
+			{
+				g_autoptr(JMessage) reply = NULL;
+
+				reply = j_message_new_reply(message);
+				j_message_receive(reply, connections[j]);
+			}
+		}
+	}
+
+	j_benchmark_timer_stop(run);
+
+	run->operations = n * connections_len;
+
+end:
+	for (guint i = 0; i < connections_len; i++)
+	{
+		if (connections[i] != NULL)
+		{
+			j_network_connection_fini(connections[i]);
+		}
+	}
+
+	g_free(connections);
+}
+
+static void
+benchmark_connection_ping_1(BenchmarkRun* run)
+{
+	_benchmark_connection_ping(run, 1);
+}
+
+static void
+benchmark_connection_ping_16(BenchmarkRun* run)
+{
+	_benchmark_connection_ping(run, 16);
+}
+
+static void
+benchmark_connection_ping_256(BenchmarkRun* run)
+{
+	_benchmark_connection_ping(run, 256);
+}
+
+static void
+benchmark_connection_ping_1024(BenchmarkRun* run)
+{
+	_benchmark_connection_ping(run, 1024);
+}
+
+/**
+ * Sends pings over a single multiplexed connection to the first object server.
+ * Up to outstanding requests are in flight at the same time, so the throughput shows how well latency is hidden by pipelining.
+ * The server may answer the requests in any order, the replies are matched using their message IDs.
+ **/
+static void
+_benchmark_connection_pipeline(BenchmarkRun* run, guint outstanding)
+{
+	guint const n = 1000;
+
+	JConfiguration* configuration;
+	JNetworkConnection* connection;
+	g_autoptr(GHashTable) pending = NULL;
+	JMessage** messages;
+	gchar const* checksum;
+	gchar multiplexed = 1;
+	gchar compression = J_CONFIGURATION_COMPRESSION_NONE;
+
+	configuration = j_configuration();
+	checksum = j_configuration_get_checksum(configuration);
+
+	if (j_configuration_get_transport(configuration) != J_CONFIGURATION_TRANSPORT_TCP)
+	{
+		// Only TCP connections can be multiplexed
+		return;
+	}
+
+	connection = j_network_connection_init_client(configuration, J_BACKEND_TYPE_OBJECT, 0);
+
+	if (connection == NULL)
+	{
+		g_warning("Can not connect to %s.", j_configuration_get_server(configuration, J_BACKEND_TYPE_OBJECT, 0));
+		return;
+	}
+
+	messages = g_new(JMessage*, n);
+	pending = g_hash_table_new(NULL, NULL);
+
+	for (guint i = 0; i < n; i++)
+	{
+		messages[i] = j_message_new(J_MESSAGE_PING, strlen(checksum) + 1 + 1 + 1);
+		j_message_append_string(messages[i], checksum);
+		j_message_append_1(messages[i], &multiplexed);
+		j_message_append_1(messages[i], &compression);
+	}
+
+	j_benchmark_timer_start(run);
+
+	while (j_benchmark_iterate(run))
+	{
+		guint sent = 0;
+		guint received = 0;
+
+		while (received < n)
+		{
+			g_autoptr(JMessage) reply = NULL;
+
+			while (sent < n && sent - received < outstanding)
+			{
+				g_hash_table_add(pending, GUINT_TO_POINTER(j_message_get_id(messages[sent])));
+				j_message_send(messages[sent], connection);
+				sent++;
+			}
+
+			// The reply is not bound to a message, so the next one is received regardless of its ID
+			reply = j_message_new(J_MESSAGE_NONE, 0);
+
+			if (!j_message_receive(reply, connection))
+			{
+				g_warning("Could not receive reply.");
+				goto end;
+			}
+
+			if (!g_hash_table_remove(pending, GUINT_TO_POINTER(j_message_get_id(reply))))
+			{
+				g_warning("Received unexpected reply.");
+			}
+
+			received++;
+		}
+	}
+
+	j_benchmark_timer_stop(run);
+
+	run->operations = n;
+
+end:
+	for (guint i = 0; i < n; i++)
+	{
+		j_message_unref(messages[i]);
+	}
+
+	g_free(messages);
+
+	j_network_connection_fini(connection);
+}
+
+static void
+benchmark_connection_pipeline_1(BenchmarkRun* run)
+{
+	_benchmark_connection_pipeline(run, 1);
+}
+
+static void
+benchmark_connection_pipeline_8(BenchmarkRun* run)
+{
+	_benchmark_connection_pipeline(run, 8);
+}
+
+static void
+benchmark_connection_pipeline_64(BenchmarkRun* run)
+{
+	_benchmark_connection_pipeline(run, 64);
+}
+
+void
+benchmark_connection(void)
+{
+	j_benchmark_add("/connection/ping-1", benchmark_connection_ping_1);
+	j_benchmark_add("/connection/ping-16", benchmark_connection_ping_16);
+	j_benchmark_add("/connection/ping-256", benchmark_connection_ping_256);
+	j_benchmark_add("/connection/ping-1024", benchmark_connection_ping_1024);
+	j_benchmark_add("/connection/pipeline-1", benchmark_connection_pipeline_1);
+	j_benchmark_add("/connection/pipeline-8", benchmark_connection_pipeline_8);
+	j_benchmark_add("/connection/pipeline-64", benchmark_connection_pipeline_64);
+}
@@ -302,6 +302,50 @@ benchmark_kv_unordered_put_delete_batch(BenchmarkRun* run)
 	_benchmark_kv_unordered_put_delete(run, TRUE);
 }
 
+/**
+ * Puts and gets a single small key-value pair, executing every operation on its own.
+ * Each operation requires a round trip to the server, so this shows the latency of the connection.
+ * Running it with and without a Unix domain socket configured (see julea-config --network-socket) compares it with loopback TCP.
+ **/
+static void
+benchmark_kv_put_get_latency(BenchmarkRun* run)
+{
+	guint const n = 1000;
+
+	g_autoptr(JBatch) batch = NULL;
+	g_autoptr(JKV) object = NULL;
+	g_autoptr(JSemantics) semantics = NULL;
+	gboolean ret;
+
+	semantics = j_benchmark_get_semantics();
+	batch = j_batch_new(semantics);
+	object = j_kv_new("benchmark", "latency");
+
+	j_benchmark_timer_start(run);
+
+	while (j_benchmark_iterate(run))
+	{
+		for (guint i = 0; i < n; i++)
+		{
+			j_kv_put(object, g_strdup("empty"), 6, g_free, batch);
+			ret = j_batch_execute(batch);
+			g_assert_true(ret);
+
+			j_kv_get_callback(object, _benchmark_kv_get_callback, NULL, batch);
+			ret = j_batch_execute(batch);
+			g_assert_true(ret);
+		}
+	}
+
+	j_benchmark_timer_stop(run);
+
+	j_kv_delete(object, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+
+	run->operations = n * 2;
+}
+
 void
 benchmark_kv(void)
 {
@@ -313,4 +357,5 @@ benchmark_kv(void)
 	j_benchmark_add("/kv/delete-batch", benchmark_kv_delete_batch);
 	j_benchmark_add("/kv/unordered-put-delete", benchmark_kv_unordered_put_delete);
 	j_benchmark_add("/kv/unordered-put-delete-batch", benchmark_kv_unordered_put_delete_batch);
+	j_benchmark_add("/kv/put-get-latency", benchmark_kv_put_get_latency);
 }
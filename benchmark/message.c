@@ -19,6 +19,7 @@
 #include <julea-config.h>
 
 #include <glib.h>
+#include <gio/gio.h>
 
 #include <julea.h>
 
@@ -34,6 +35,10 @@ _benchmark_message_new(BenchmarkRun* run, gboolean append)
 	guint64 const dummy = 42;
 	gsize const size = m * sizeof(guint64);
 
+	guint64 allocations;
+
+	allocations = j_message_get_allocations();
+
 	j_benchmark_timer_start(run);
 
 	while (j_benchmark_iterate(run))
@@ -57,6 +62,7 @@ _benchmark_message_new(BenchmarkRun* run, gboolean append)
 	j_benchmark_timer_stop(run);
 
 	run->operations = n;
+	run->allocations = j_message_get_allocations() - allocations;
 }
 
 static void
@@ -78,6 +84,10 @@ _benchmark_message_add_operation(BenchmarkRun* run, gboolean large)
 	guint const m = (large) ? 10000 : 100;
 	guint64 const dummy = 42;
 
+	guint64 allocations;
+
+	allocations = j_message_get_allocations();
+
 	j_benchmark_timer_start(run);
 
 	while (j_benchmark_iterate(run))
@@ -100,6 +110,7 @@ _benchmark_message_add_operation(BenchmarkRun* run, gboolean large)
 
 	run->operations = n;
 	run->bytes = n * m * sizeof(guint64);
+	run->allocations = j_message_get_allocations() - allocations;
 }
 
 static void
@@ -114,6 +125,67 @@ benchmark_message_add_operation_large(BenchmarkRun* run)
 	_benchmark_message_add_operation(run, TRUE);
 }
 
+/**
+ * Writes messages consisting of many additional send entries to /dev/null.
+ * This mostly measures the system call overhead of j_message_write(), which gathers all entries into as few writes as possible.
+ **/
+static void
+_benchmark_message_write(BenchmarkRun* run, gboolean large)
+{
+	guint const n = 100;
+	gsize const size = 4 * 1024 * 1024;
+	gsize const block_size = (large) ? 64 * 1024 : 512;
+
+	g_autoptr(GFile) file = NULL;
+	g_autoptr(GFileOutputStream) stream = NULL;
+	g_autoptr(JMessage) message = NULL;
+	g_autofree gchar* buffer = NULL;
+
+	file = g_file_new_for_path("/dev/null");
+	stream = g_file_append_to(file, G_FILE_CREATE_NONE, NULL, NULL);
+
+	if (stream == NULL)
+	{
+		g_warning("Can not open /dev/null.");
+		return;
+	}
+
+	buffer = g_malloc0(size);
+	message = j_message_new(J_MESSAGE_NONE, 0);
+
+	for (gsize i = 0; i < size; i += block_size)
+	{
+		j_message_add_send(message, buffer + i, block_size);
+	}
+
+	j_benchmark_timer_start(run);
+
+	while (j_benchmark_iterate(run))
+	{
+		for (guint i = 0; i < n; i++)
+		{
+			j_message_write(message, G_OUTPUT_STREAM(stream));
+		}
+	}
+
+	j_benchmark_timer_stop(run);
+
+	run->operations = n;
+	run->bytes = n * size;
+}
+
+static void
+benchmark_message_write_small(BenchmarkRun* run)
+{
+	_benchmark_message_write(run, FALSE);
+}
+
+static void
+benchmark_message_write_large(BenchmarkRun* run)
+{
+	_benchmark_message_write(run, TRUE);
+}
+
 void
 benchmark_message(void)
 {
@@ -121,4 +193,6 @@ benchmark_message(void)
 	j_benchmark_add("/message/new-append", benchmark_message_new_append);
 	j_benchmark_add("/message/add-operation-small", benchmark_message_add_operation_small);
 	j_benchmark_add("/message/add-operation-large", benchmark_message_add_operation_large);
+	j_benchmark_add("/message/write-small", benchmark_message_write_small);
+	j_benchmark_add("/message/write-large", benchmark_message_write_large);
 }
@@ -231,7 +231,8 @@ benchmark_object_status_batch(BenchmarkRun* run)
 static void
 _benchmark_object_read(BenchmarkRun* run, gboolean use_batch, guint block_size)
 {
-	guint const n = (use_batch) ? 10000 : 1000;
+	// Limit the amount of data for large block sizes
+	guint const n = MIN((use_batch) ? 10000 : 1000, (256 * 1024 * 1024) / block_size);
 
 	g_autoptr(JObject) object = NULL;
 	g_autoptr(JBatch) batch = NULL;
@@ -303,10 +304,46 @@ benchmark_object_read_batch(BenchmarkRun* run)
 	_benchmark_object_read(run, TRUE, 4 * 1024);
 }
 
+/**
+ * Reads large blocks.
+ * With libfabric, blocks larger than the maximum inject size are transferred via RMA.
+ * Comparing against a configuration with a larger maximum inject size shows the difference to sending them inline.
+ **/
 static void
-_benchmark_object_write(BenchmarkRun* run, gboolean use_batch, guint block_size)
+benchmark_object_read_large(BenchmarkRun* run)
 {
-	guint const n = (use_batch) ? 10000 : 1000;
+	_benchmark_object_read(run, FALSE, 4 * 1024 * 1024);
+}
+
+static void
+benchmark_object_read_large_batch(BenchmarkRun* run)
+{
+	_benchmark_object_read(run, TRUE, 4 * 1024 * 1024);
+}
+
+/**
+ * The contents of written blocks, which matter if compression is enabled.
+ **/
+enum BenchmarkObjectData
+{
+	BENCHMARK_OBJECT_DATA_ZERO,
+	/**
+	 * Text-like data that compresses well.
+	 **/
+	BENCHMARK_OBJECT_DATA_COMPRESSIBLE,
+	/**
+	 * Random data that does not compress at all.
+	 **/
+	BENCHMARK_OBJECT_DATA_INCOMPRESSIBLE
+};
+
+typedef enum BenchmarkObjectData BenchmarkObjectData;
+
+static void
+_benchmark_object_write(BenchmarkRun* run, gboolean use_batch, guint block_size, BenchmarkObjectData data)
+{
+	// Limit the amount of data for large block sizes
+	guint const n = MIN((use_batch) ? 10000 : 1000, (256 * 1024 * 1024) / block_size);
 
 	g_autoptr(JObject) object = NULL;
 	g_autoptr(JBatch) batch = NULL;
@@ -317,6 +354,31 @@ _benchmark_object_write(BenchmarkRun* run, gboolean use_batch, guint block_size)
 
 	dummy = g_malloc0(block_size);
 
+	if (data == BENCHMARK_OBJECT_DATA_COMPRESSIBLE)
+	{
+		g_autoptr(GRand) rand = g_rand_new_with_seed(42);
+
+		// Numbers with few significant digits, similar to textual checkpoint data
+		for (guint i = 0; i + 8 <= block_size; i += 8)
+		{
+			gchar number[9];
+
+			g_snprintf(number, sizeof(number), "%7.2f,", (gdouble)g_rand_int_range(rand, 0, 1000) / 100.0);
+			memcpy(dummy + i, number, 8);
+		}
+	}
+	else if (data == BENCHMARK_OBJECT_DATA_INCOMPRESSIBLE)
+	{
+		g_autoptr(GRand) rand = g_rand_new_with_seed(42);
+
+		for (guint i = 0; i + sizeof(guint32) <= block_size; i += sizeof(guint32))
+		{
+			guint32 value = g_rand_int(rand);
+
+			memcpy(dummy + i, &value, sizeof(value));
+		}
+	}
+
 	semantics = j_benchmark_get_semantics();
 	batch = j_batch_new(semantics);
 
@@ -362,13 +424,45 @@ _benchmark_object_write(BenchmarkRun* run, gboolean use_batch, guint block_size)
 static void
 benchmark_object_write(BenchmarkRun* run)
 {
-	_benchmark_object_write(run, FALSE, 4 * 1024);
+	_benchmark_object_write(run, FALSE, 4 * 1024, BENCHMARK_OBJECT_DATA_ZERO);
 }
 
 static void
 benchmark_object_write_batch(BenchmarkRun* run)
 {
-	_benchmark_object_write(run, TRUE, 4 * 1024);
+	_benchmark_object_write(run, TRUE, 4 * 1024, BENCHMARK_OBJECT_DATA_ZERO);
+}
+
+/**
+ * Writes large blocks.
+ * See benchmark_object_read_large() for details.
+ **/
+static void
+benchmark_object_write_large(BenchmarkRun* run)
+{
+	_benchmark_object_write(run, FALSE, 4 * 1024 * 1024, BENCHMARK_OBJECT_DATA_ZERO);
+}
+
+static void
+benchmark_object_write_large_batch(BenchmarkRun* run)
+{
+	_benchmark_object_write(run, TRUE, 4 * 1024 * 1024, BENCHMARK_OBJECT_DATA_ZERO);
+}
+
+/**
+ * Writes large blocks of compressible and incompressible data.
+ * Useful to compare the codecs supported by --network-compression.
+ **/
+static void
+benchmark_object_write_large_compressible(BenchmarkRun* run)
+{
+	_benchmark_object_write(run, TRUE, 4 * 1024 * 1024, BENCHMARK_OBJECT_DATA_COMPRESSIBLE);
+}
+
+static void
+benchmark_object_write_large_incompressible(BenchmarkRun* run)
+{
+	_benchmark_object_write(run, TRUE, 4 * 1024 * 1024, BENCHMARK_OBJECT_DATA_INCOMPRESSIBLE);
 }
 
 static void
@@ -442,6 +536,12 @@ benchmark_object(void)
 	j_benchmark_add("/object/object/read-batch", benchmark_object_read_batch);
 	j_benchmark_add("/object/object/write", benchmark_object_write);
 	j_benchmark_add("/object/object/write-batch", benchmark_object_write_batch);
+	j_benchmark_add("/object/object/read-large", benchmark_object_read_large);
+	j_benchmark_add("/object/object/read-large-batch", benchmark_object_read_large_batch);
+	j_benchmark_add("/object/object/write-large", benchmark_object_write_large);
+	j_benchmark_add("/object/object/write-large-batch", benchmark_object_write_large_batch);
+	j_benchmark_add("/object/object/write-large-compressible", benchmark_object_write_large_compressible);
+	j_benchmark_add("/object/object/write-large-incompressible", benchmark_object_write_large_incompressible);
 	j_benchmark_add("/object/object/unordered-create-delete", benchmark_object_unordered_create_delete);
 	j_benchmark_add("/object/object/unordered-create-delete-batch", benchmark_object_unordered_create_delete_batch);
 }
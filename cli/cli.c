@@ -48,6 +48,7 @@ j_cmd_usage(void)
 	g_print("  copy        src-uri dst-uri\n");
 	g_print("  delete      uri\n");
 	g_print("  list        uri\n");
+	g_print("  rebalance   object|kv namespace\n");
 	g_print("  status      uri\n");
 	g_print("\n");
 	g_print("URIs:\n");
@@ -128,6 +129,10 @@ main(int argc, char** argv)
 	{
 		success = j_cmd_list(arguments);
 	}
+	else if (g_strcmp0(command, "rebalance") == 0)
+	{
+		success = j_cmd_rebalance(arguments);
+	}
 	else if (g_strcmp0(command, "status") == 0)
 	{
 		success = j_cmd_status(arguments);
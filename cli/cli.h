@@ -33,4 +33,5 @@ gboolean j_cmd_create(gchar const**, gboolean);
 gboolean j_cmd_copy(gchar const**);
 gboolean j_cmd_delete(gchar const**);
 gboolean j_cmd_list(gchar const**);
+gboolean j_cmd_rebalance(gchar const**);
 gboolean j_cmd_status(gchar const**);
@@ -157,6 +157,18 @@ j_cmd_copy(gchar const** arguments)
 		}
 	}
 
+	// Objects are copied by the server without transferring their data to the client
+	if (ouri[0] != NULL && ouri[1] != NULL)
+	{
+		g_autoptr(JBatch) batch = NULL;
+
+		batch = j_batch_new_for_template(J_SEMANTICS_TEMPLATE_DEFAULT);
+		j_object_copy(j_object_uri_get_object(ouri[0]), j_object_uri_get_object(ouri[1]), batch);
+		ret = j_batch_execute(batch);
+
+		goto end;
+	}
+
 	offset = 0;
 	buffer = g_new(gchar, 1024 * 1024);
 
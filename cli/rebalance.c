@@ -0,0 +1,263 @@
+/*
+ * JULEA - Flexible storage framework
+ * Copyright (C) 2026 Michael Kuhn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <julea-config.h>
+
+#include "cli.h"
+
+/**
+ * The number of key-value pairs that are moved using one batch.
+ **/
+#define J_CMD_REBALANCE_BATCH_SIZE 1000
+
+struct JCmdRebalance
+{
+	JBackendType type;
+	gchar const* namespace;
+	guint32 index;
+
+	guint64 moved;
+	gboolean ret;
+};
+
+typedef struct JCmdRebalance JCmdRebalance;
+
+/**
+ * Deletes the moved key-value pairs from their old server.
+ **/
+static gboolean
+j_cmd_rebalance_kv_delete(guint32 index, gchar const* namespace, GPtrArray* keys)
+{
+	g_autoptr(JBatch) batch = NULL;
+
+	batch = j_batch_new_for_template(J_SEMANTICS_TEMPLATE_DEFAULT);
+
+	for (guint i = 0; i < keys->len; i++)
+	{
+		g_autoptr(JKV) kv = NULL;
+
+		kv = j_kv_new_for_index(index, namespace, g_ptr_array_index(keys, i));
+		j_kv_delete(kv, batch);
+	}
+
+	return j_batch_execute(batch);
+}
+
+static void
+j_cmd_rebalance_kv(JCmdRebalance* rebalance)
+{
+	JConfiguration* configuration = j_configuration();
+
+	g_autoptr(JKVIterator) iterator = NULL;
+	g_autoptr(JBatch) batch = NULL;
+	g_autoptr(GPtrArray) moved = NULL;
+	guint pending = 0;
+
+	iterator = j_kv_iterator_new_for_index(rebalance->index, rebalance->namespace, NULL);
+	batch = j_batch_new_for_template(J_SEMANTICS_TEMPLATE_DEFAULT);
+	moved = g_ptr_array_new_with_free_func(g_free);
+
+	while (j_kv_iterator_next(iterator))
+	{
+		g_autoptr(JKV) kv = NULL;
+		gchar const* key;
+		gconstpointer value;
+		gpointer copy;
+		guint32 len;
+
+		key = j_kv_iterator_get(iterator, &value, &len);
+
+		if (j_configuration_get_server_index(configuration, J_BACKEND_TYPE_KV, key) == rebalance->index)
+		{
+			continue;
+		}
+
+#if GLIB_CHECK_VERSION(2, 68, 0)
+		copy = g_memdup2(value, len);
+#else
+		copy = g_memdup(value, len);
+#endif
+
+		kv = j_kv_new(rebalance->namespace, key);
+		j_kv_put(kv, copy, len, g_free, batch);
+		g_ptr_array_add(moved, g_strdup(key));
+		pending++;
+
+		if (pending >= J_CMD_REBALANCE_BATCH_SIZE)
+		{
+			if (!j_batch_execute(batch))
+			{
+				rebalance->ret = FALSE;
+				return;
+			}
+
+			pending = 0;
+		}
+	}
+
+	if (pending > 0 && !j_batch_execute(batch))
+	{
+		rebalance->ret = FALSE;
+		return;
+	}
+
+	// Keys are only deleted after iterating, so that the iterator does not miss any keys
+	if (moved->len > 0 && !j_cmd_rebalance_kv_delete(rebalance->index, rebalance->namespace, moved))
+	{
+		rebalance->ret = FALSE;
+		return;
+	}
+
+	rebalance->moved = moved->len;
+}
+
+static void
+j_cmd_rebalance_object(JCmdRebalance* rebalance)
+{
+	JConfiguration* configuration = j_configuration();
+
+	g_autoptr(JObjectIterator) iterator = NULL;
+	g_autoptr(GPtrArray) names = NULL;
+
+	iterator = j_object_iterator_new_for_index(rebalance->index, rebalance->namespace, NULL);
+	names = g_ptr_array_new_with_free_func(g_free);
+
+	while (j_object_iterator_next(iterator))
+	{
+		gchar const* name;
+
+		name = j_object_iterator_get(iterator);
+
+		if (j_configuration_get_server_index(configuration, J_BACKEND_TYPE_OBJECT, name) != rebalance->index)
+		{
+			g_ptr_array_add(names, g_strdup(name));
+		}
+	}
+
+	// Objects can be large, so they are moved one after another
+	for (guint i = 0; i < names->len; i++)
+	{
+		g_autoptr(JBatch) batch = NULL;
+		g_autoptr(JObject) source = NULL;
+		g_autoptr(JObject) destination = NULL;
+		gchar const* name = g_ptr_array_index(names, i);
+
+		batch = j_batch_new_for_template(J_SEMANTICS_TEMPLATE_DEFAULT);
+		source = j_object_new_for_index(rebalance->index, rebalance->namespace, name);
+		destination = j_object_new(rebalance->namespace, name);
+
+		j_object_copy(source, destination, batch);
+
+		if (!j_batch_execute(batch))
+		{
+			g_printerr("Error: Could not move object “%s”.\n", name);
+			rebalance->ret = FALSE;
+			continue;
+		}
+
+		j_object_delete(source, batch);
+
+		if (!j_batch_execute(batch))
+		{
+			g_printerr("Error: Could not delete object “%s” from server %u.\n", name, rebalance->index);
+			rebalance->ret = FALSE;
+			continue;
+		}
+
+		rebalance->moved++;
+	}
+}
+
+static gpointer
+j_cmd_rebalance_thread(gpointer data)
+{
+	JCmdRebalance* rebalance = data;
+
+	if (rebalance->type == J_BACKEND_TYPE_KV)
+	{
+		j_cmd_rebalance_kv(rebalance);
+	}
+	else
+	{
+		j_cmd_rebalance_object(rebalance);
+	}
+
+	return NULL;
+}
+
+gboolean
+j_cmd_rebalance(gchar const** arguments)
+{
+	gboolean ret = TRUE;
+	g_autofree JCmdRebalance* rebalances = NULL;
+	g_autofree GThread** threads = NULL;
+	JBackendType type;
+	guint32 server_count;
+	guint64 moved = 0;
+
+	if (j_cmd_arguments_length(arguments) != 2)
+	{
+		ret = FALSE;
+		j_cmd_usage();
+		goto end;
+	}
+
+	if (g_strcmp0(arguments[0], "object") == 0)
+	{
+		type = J_BACKEND_TYPE_OBJECT;
+	}
+	else if (g_strcmp0(arguments[0], "kv") == 0)
+	{
+		type = J_BACKEND_TYPE_KV;
+	}
+	else
+	{
+		ret = FALSE;
+		j_cmd_usage();
+		goto end;
+	}
+
+	server_count = j_configuration_get_server_count(j_configuration(), type);
+	rebalances = g_new(JCmdRebalance, server_count);
+	threads = g_new(GThread*, server_count);
+
+	// Every server is scanned by its own thread, keys that are stored on the wrong server are moved to their owner
+	for (guint32 i = 0; i < server_count; i++)
+	{
+		rebalances[i].type = type;
+		rebalances[i].namespace = arguments[1];
+		rebalances[i].index = i;
+		rebalances[i].moved = 0;
+		rebalances[i].ret = TRUE;
+
+		threads[i] = g_thread_new("julea-cli-rebalance", j_cmd_rebalance_thread, &(rebalances[i]));
+	}
+
+	for (guint32 i = 0; i < server_count; i++)
+	{
+		g_thread_join(threads[i]);
+
+		moved += rebalances[i].moved;
+		ret = rebalances[i].ret && ret;
+	}
+
+	g_print("Moved %" G_GUINT64_FORMAT " %s.\n", moved, (type == J_BACKEND_TYPE_KV) ? "key-value pairs" : "objects");
+
+end:
+	return ret;
+}
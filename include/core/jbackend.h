@@ -128,6 +128,34 @@ enum JBackendFlags
 
 typedef enum JBackendFlags JBackendFlags;
 
+/**
+ * The alignment of buffers that the server hands to object backends.
+ * Only buffers of at least this size are aligned, see j_memory_chunk_new_aligned().
+ * This allows backends to use direct I/O without copying data.
+ **/
+#define J_BACKEND_ALIGNMENT 4096
+
+/**
+ * A contiguous part of an object that is read or written.
+ **/
+struct JBackendExtent
+{
+	/**
+	 * The buffer, which is not modified when writing.
+	 **/
+	gpointer buffer;
+
+	guint64 length;
+	guint64 offset;
+
+	/**
+	 * The number of bytes read or written, set by the backend.
+	 **/
+	guint64 bytes;
+};
+
+typedef struct JBackendExtent JBackendExtent;
+
 struct JBackend
 {
 	JBackendType type;
@@ -147,6 +175,11 @@ struct JBackend
 			gboolean (*backend_open)(gpointer, gchar const*, gchar const*, gpointer*);
 
 			gboolean (*backend_delete)(gpointer, gpointer);
+
+			/**
+			 * Closes an object.
+			 * Backends may complete creates and writes asynchronously and report their errors when the object is synced or closed.
+			 **/
 			gboolean (*backend_close)(gpointer, gpointer);
 
 			gboolean (*backend_status)(gpointer, gpointer, gint64*, guint64*);
@@ -155,6 +188,41 @@ struct JBackend
 			gboolean (*backend_read)(gpointer, gpointer, gpointer, guint64, guint64, guint64*);
 			gboolean (*backend_write)(gpointer, gpointer, gconstpointer, guint64, guint64, guint64*);
 
+			/**
+			 * Reads or writes multiple extents of an object at once.
+			 * These are optional, backend_read and backend_write are used for each extent otherwise.
+			 * If the last argument of backend_writev is TRUE, the object has to be synced after all extents have been written.
+			 * This allows backends to submit the sync together with the writes.
+			 *
+			 * \return TRUE if all extents have been read or written completely (and synced), FALSE otherwise.
+			 **/
+			gboolean (*backend_readv)(gpointer, gpointer, JBackendExtent*, guint);
+			gboolean (*backend_writev)(gpointer, gpointer, JBackendExtent*, guint, gboolean);
+
+			/**
+			 * Copies all data of an object into another object.
+			 * This is optional, the data is read and written otherwise.
+			 * Backends can use this to copy data without moving it through memory, for example using reflinks.
+			 *
+			 * \return TRUE if all data has been copied, FALSE otherwise.
+			 **/
+			gboolean (*backend_copy)(gpointer, gpointer, gpointer, guint64*);
+
+			/**
+			 * Allocates storage for a range of an object, extending its size if necessary, or deallocates it.
+			 * Punched ranges keep the object's size and read as zeros.
+			 * These are optional, allocating is not supported and punching writes zeros otherwise.
+			 **/
+			gboolean (*backend_allocate)(gpointer, gpointer, guint64, guint64);
+			gboolean (*backend_punch)(gpointer, gpointer, guint64, guint64);
+
+			/**
+			 * Appends the extents containing data within a range of an object to the array.
+			 * The array contains JBackendExtent, only length and offset are set.
+			 * This is optional, all data up to the object's size is reported otherwise.
+			 **/
+			gboolean (*backend_get_extents)(gpointer, gpointer, guint64, guint64, GArray*);
+
 			gboolean (*backend_get_all)(gpointer, gchar const*, gpointer*);
 			gboolean (*backend_get_by_prefix)(gpointer, gchar const*, gchar const*, gpointer*);
 			gboolean (*backend_iterate)(gpointer, gpointer, gchar const**);
@@ -174,6 +242,15 @@ struct JBackend
 
 			gboolean (*backend_get_all)(gpointer, gchar const*, gpointer*);
 			gboolean (*backend_get_by_prefix)(gpointer, gchar const*, gchar const*, gpointer*);
+
+			/**
+			 * Iterates over the keys from the start key (inclusive) to the end key (exclusive) in ascending order.
+			 * The end key can be NULL to iterate up to the last key, a limit of 0 returns all keys.
+			 * Keys are compared bytewise like strcmp().
+			 * This is optional, callers have to filter and sort all keys of the namespace otherwise.
+			 **/
+			gboolean (*backend_get_range)(gpointer, gchar const*, gchar const*, gchar const*, guint32, gpointer*);
+
 			gboolean (*backend_iterate)(gpointer, gpointer, gchar const**, gconstpointer*, guint32*);
 		} kv;
 
@@ -411,6 +488,15 @@ gboolean j_backend_object_sync(JBackend*, gpointer);
 gboolean j_backend_object_read(JBackend*, gpointer, gpointer, guint64, guint64, guint64*);
 gboolean j_backend_object_write(JBackend*, gpointer, gconstpointer, guint64, guint64, guint64*);
 
+gboolean j_backend_object_readv(JBackend*, gpointer, JBackendExtent*, guint);
+gboolean j_backend_object_writev(JBackend*, gpointer, JBackendExtent*, guint, gboolean);
+
+gboolean j_backend_object_copy(JBackend*, gpointer, gpointer, guint64*);
+
+gboolean j_backend_object_allocate(JBackend*, gpointer, guint64, guint64);
+gboolean j_backend_object_punch(JBackend*, gpointer, guint64, guint64);
+gboolean j_backend_object_get_extents(JBackend*, gpointer, guint64, guint64, GArray*);
+
 gboolean j_backend_object_get_all(JBackend*, gchar const*, gpointer*);
 gboolean j_backend_object_get_by_prefix(JBackend*, gchar const*, gchar const*, gpointer*);
 gboolean j_backend_object_iterate(JBackend*, gpointer, gchar const**);
@@ -427,6 +513,7 @@ gboolean j_backend_kv_get(JBackend*, gpointer, gchar const*, gpointer*, guint32*
 
 gboolean j_backend_kv_get_all(JBackend*, gchar const*, gpointer*);
 gboolean j_backend_kv_get_by_prefix(JBackend*, gchar const*, gchar const*, gpointer*);
+gboolean j_backend_kv_get_range(JBackend*, gchar const*, gchar const*, gchar const*, guint32, gpointer*);
 gboolean j_backend_kv_iterate(JBackend*, gpointer, gchar const**, gconstpointer*, guint32*);
 
 gboolean j_backend_db_init(JBackend*, gchar const*);
@@ -0,0 +1,131 @@
+/*
+ * JULEA - Flexible storage framework
+ * Copyright (C) 2026 Michael Kuhn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file
+ **/
+
+#ifndef JULEA_COMPRESSION_H
+#define JULEA_COMPRESSION_H
+
+#if !defined(JULEA_H) && !defined(JULEA_COMPILATION)
+#error "Only <julea.h> can be included directly."
+#endif
+
+#include <glib.h>
+
+#include <core/jconfiguration.h>
+
+G_BEGIN_DECLS
+
+/**
+ * \defgroup JCompression Compression
+ *
+ * Compression of messages and data sent over the network.
+ *
+ * @{
+ **/
+
+/**
+ * Message bodies and data smaller than this are never compressed.
+ **/
+#define J_COMPRESSION_THRESHOLD (4 * 1024)
+
+/**
+ * Data is compressed in blocks of this size.
+ * This bounds the size of temporary buffers and allows receivers to decompress data directly into their destination buffer.
+ **/
+#define J_COMPRESSION_BLOCK_SIZE (128 * 1024)
+
+/**
+ * Checks whether a codec is supported by this build.
+ *
+ * \code
+ * \endcode
+ *
+ * \param compression A codec.
+ *
+ * \return TRUE if the codec is supported, FALSE otherwise.
+ **/
+gboolean j_compression_available(JConfigurationCompression compression);
+
+/**
+ * Returns the maximum size of compressed data.
+ *
+ * \code
+ * \endcode
+ *
+ * \param compression A codec.
+ * \param length      The length of the uncompressed data.
+ *
+ * \return The maximum length of the compressed data.
+ **/
+gsize j_compression_bound(JConfigurationCompression compression, gsize length);
+
+/**
+ * Compresses data.
+ *
+ * \code
+ * \endcode
+ *
+ * \param compression       A codec.
+ * \param data              The data.
+ * \param length            The length of the data.
+ * \param compressed        A buffer for the compressed data.
+ * \param compressed_length The length of the buffer, should be j_compression_bound().
+ *
+ * \return The length of the compressed data, 0 if the data could not be compressed or would not become smaller.
+ **/
+gsize j_compression_compress(JConfigurationCompression compression, gconstpointer data, gsize length, gpointer compressed, gsize compressed_length);
+
+/**
+ * Decompresses data.
+ *
+ * \code
+ * \endcode
+ *
+ * \param compression       A codec.
+ * \param compressed        The compressed data.
+ * \param compressed_length The length of the compressed data.
+ * \param data              A buffer for the uncompressed data.
+ * \param length            The length of the uncompressed data.
+ *
+ * \return TRUE if exactly length bytes have been decompressed, FALSE otherwise.
+ **/
+gboolean j_compression_decompress(JConfigurationCompression compression, gconstpointer compressed, gsize compressed_length, gpointer data, gsize length);
+
+/**
+ * Returns a temporary buffer of the calling thread.
+ * The buffer is reused by subsequent calls and must not be freed.
+ *
+ * \code
+ * \endcode
+ *
+ * \param length The minimum length.
+ *
+ * \return A buffer.
+ **/
+gpointer j_compression_get_buffer(gsize length);
+
+/**
+ * @}
+ **/
+
+G_END_DECLS
+
+#endif
@@ -43,6 +43,47 @@ struct JConfiguration;
 
 typedef struct JConfiguration JConfiguration;
 
+/**
+ * The transport used for client-server communication.
+ **/
+enum JConfigurationTransport
+{
+	J_CONFIGURATION_TRANSPORT_TCP,
+	J_CONFIGURATION_TRANSPORT_LIBFABRIC
+};
+
+typedef enum JConfigurationTransport JConfigurationTransport;
+
+/**
+ * The compression codec requested for client-server communication.
+ **/
+enum JConfigurationCompression
+{
+	J_CONFIGURATION_COMPRESSION_NONE,
+	J_CONFIGURATION_COMPRESSION_LZ4,
+	J_CONFIGURATION_COMPRESSION_ZSTD
+};
+
+typedef enum JConfigurationCompression JConfigurationCompression;
+
+/**
+ * The policy used to place objects and key-value pairs on servers.
+ **/
+enum JConfigurationPlacement
+{
+	/**
+	 * The server is determined by the key's hash modulo the number of servers.
+	 **/
+	J_CONFIGURATION_PLACEMENT_MODULO,
+	/**
+	 * The server is determined using consistent hashing.
+	 * Adding or removing a server only moves the keys of that server.
+	 **/
+	J_CONFIGURATION_PLACEMENT_RING
+};
+
+typedef enum JConfigurationPlacement JConfigurationPlacement;
+
 /**
  * Returns the configuration.
  *
@@ -103,15 +144,38 @@ G_DEFINE_AUTOPTR_CLEANUP_FUNC(JConfiguration, j_configuration_unref)
 gchar const* j_configuration_get_server(JConfiguration*, JBackendType, guint32);
 guint32 j_configuration_get_server_count(JConfiguration*, JBackendType);
 
+/**
+ * Returns the index of the server responsible for a key.
+ *
+ * \code
+ * \endcode
+ *
+ * \param configuration A configuration.
+ * \param backend       A backend type, either J_BACKEND_TYPE_OBJECT or J_BACKEND_TYPE_KV.
+ * \param key           A key.
+ *
+ * \return The server index.
+ **/
+guint32 j_configuration_get_server_index(JConfiguration* configuration, JBackendType backend, gchar const* key);
+
+JConfigurationPlacement j_configuration_get_placement(JConfiguration*);
+
 gchar const* j_configuration_get_backend(JConfiguration*, JBackendType);
 gchar const* j_configuration_get_backend_path(JConfiguration*, JBackendType);
 
+JConfigurationTransport j_configuration_get_transport(JConfiguration*);
+gchar const* j_configuration_get_provider(JConfiguration*);
+JConfigurationCompression j_configuration_get_compression(JConfiguration*);
+gboolean j_configuration_get_shared_memory(JConfiguration*);
+gchar const* j_configuration_get_socket(JConfiguration*);
+
 guint64 j_configuration_get_max_operation_size(JConfiguration*);
 guint64 j_configuration_get_max_inject_size(JConfiguration*);
 guint16 j_configuration_get_port(JConfiguration*);
 
 guint32 j_configuration_get_max_connections(JConfiguration*);
 guint64 j_configuration_get_stripe_size(JConfiguration*);
+gboolean j_configuration_get_multiplexing(JConfiguration*);
 
 gchar const* j_configuration_get_checksum(JConfiguration*);
 
@@ -31,6 +31,7 @@
 #include <gio/gio.h>
 
 #include <core/jbackend.h>
+#include <core/jnetwork.h>
 
 G_BEGIN_DECLS
 
@@ -42,8 +43,8 @@ G_BEGIN_DECLS
  * @{
  **/
 
-gpointer j_connection_pool_pop(JBackendType, guint32);
-void j_connection_pool_push(JBackendType, guint32, gpointer);
+JNetworkConnection* j_connection_pool_pop(JBackendType, guint32);
+void j_connection_pool_push(JBackendType, guint32, JNetworkConnection*);
 
 /**
  * @}
@@ -58,6 +58,23 @@ typedef struct JMemoryChunk JMemoryChunk;
  **/
 JMemoryChunk* j_memory_chunk_new(guint64 size);
 
+/**
+ * Creates a new chunk whose segments are aligned.
+ * Segments that are smaller than the alignment are not aligned.
+ *
+ * \code
+ * JMemoryChunk* chunk;
+ *
+ * chunk = j_memory_chunk_new_aligned(1024 * 1024, 4096);
+ * \endcode
+ *
+ * \param size      A size.
+ * \param alignment An alignment, must be a power of two.
+ *
+ * \return A new chunk. Should be freed with j_memory_chunk_free().
+ **/
+JMemoryChunk* j_memory_chunk_new_aligned(guint64 size, gsize alignment);
+
 /**
  * Frees the memory allocated for the chunk.
  *
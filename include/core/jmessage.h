@@ -51,11 +51,16 @@ enum JMessageType
 	J_MESSAGE_OBJECT_STATUS,
 	J_MESSAGE_OBJECT_SYNC,
 	J_MESSAGE_OBJECT_WRITE,
+	J_MESSAGE_OBJECT_COPY,
+	J_MESSAGE_OBJECT_ALLOCATE,
+	J_MESSAGE_OBJECT_PUNCH,
+	J_MESSAGE_OBJECT_GET_EXTENTS,
 	J_MESSAGE_KV_PUT,
 	J_MESSAGE_KV_DELETE,
 	J_MESSAGE_KV_GET,
 	J_MESSAGE_KV_GET_ALL,
 	J_MESSAGE_KV_GET_BY_PREFIX,
+	J_MESSAGE_KV_GET_RANGE,
 	J_MESSAGE_DB_SCHEMA_CREATE,
 	J_MESSAGE_DB_SCHEMA_GET,
 	J_MESSAGE_DB_SCHEMA_DELETE,
@@ -67,12 +72,19 @@ enum JMessageType
 
 typedef enum JMessageType JMessageType;
 
+/**
+ * Set in the length returned for a read operation if the data only consists of zeros.
+ * The data is not sent in this case.
+ **/
+#define J_MESSAGE_OBJECT_READ_ZERO (G_GUINT64_CONSTANT(1) << 63)
+
 struct JMessage;
 
 typedef struct JMessage JMessage;
 
 G_END_DECLS
 
+#include <core/jnetwork.h>
 #include <core/jsemantics.h>
 
 G_BEGIN_DECLS
@@ -142,6 +154,30 @@ G_DEFINE_AUTOPTR_CLEANUP_FUNC(JMessage, j_message_unref)
  **/
 JMessageType j_message_get_type(JMessage const* message);
 
+/**
+ * Returns a message's ID.
+ * Replies have the same ID as their original message.
+ *
+ * \code
+ * \endcode
+ *
+ * \param message A message.
+ *
+ * \return The message's ID.
+ **/
+guint32 j_message_get_id(JMessage const* message);
+
+/**
+ * Returns the number of allocations performed by messages in the calling thread.
+ * Messages are recycled using a per-thread pool, so this number should only grow while the pool is warming up.
+ *
+ * \code
+ * \endcode
+ *
+ * \return The number of allocations.
+ **/
+guint64 j_message_get_allocations(void);
+
 /**
  * Returns a message's count.
  *
@@ -293,29 +329,48 @@ gchar const* j_message_get_string(JMessage* message);
 
 /**
  * Writes a message to the network.
+ * Additional data added with j_message_add_send() is sent after the message.
  *
  * \code
  * \endcode
  *
- * \param message A message.
- * \param stream  A network stream.
+ * \param message    A message.
+ * \param connection A network connection.
  *
  * \return TRUE on success, FALSE if an error occurred.
  **/
-gboolean j_message_send(JMessage* message, gpointer stream);
+gboolean j_message_send(JMessage* message, JNetworkConnection* connection);
 
 /**
  * Reads a message from the network.
+ * If the connection is multiplexed and the message is a reply, the reply belonging to the original message is received.
  *
  * \code
  * \endcode
  *
- * \param message A message.
- * \param stream  A network stream.
+ * \param message    A message.
+ * \param connection A network connection.
  *
  * \return TRUE on success, FALSE if an error occurred.
  **/
-gboolean j_message_receive(JMessage* message, gpointer stream);
+gboolean j_message_receive(JMessage* message, JNetworkConnection* connection);
+
+/**
+ * Checks whether a complete message has been buffered, so that j_message_receive() does not block.
+ * Incoming data is buffered without blocking, see j_network_connection_buffer().
+ * Messages that do not fit into the receive buffer are considered complete as soon as the buffer is full, receiving them might still block.
+ * Additional data sent using j_message_add_send() is not part of the message and therefore not checked.
+ *
+ * \code
+ * \endcode
+ *
+ * \param connection A TCP connection.
+ * \param readable   Whether the connection's socket is readable.
+ * \param complete   Returns whether a complete message has been buffered.
+ *
+ * \return TRUE on success, FALSE if the connection has been closed or an error occurred.
+ **/
+gboolean j_message_poll(JNetworkConnection* connection, gboolean readable, gboolean* complete);
 
 /**
  * Reads a message from the network.
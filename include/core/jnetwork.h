@@ -45,6 +45,8 @@ G_BEGIN_DECLS
 /**
  * A paired connection over a network.
  * Connections are used to send data from server to client or vis-a-vis.
+ * Depending on the configured transport (see j_configuration_get_transport()), connections use either TCP or libfabric.
+ * RMA is only supported by libfabric connections.
  * They support usage for:
  * * Messaging: Easy to serialize and verify.
  * * Direct memory read: Sender must "protect memory" until receiver verifies completion.
@@ -173,6 +175,17 @@ G_BEGIN_DECLS
  **/
 JNetworkFabric* j_network_fabric_init_server(JConfiguration* configuration);
 
+/**
+ * Closes a fabric and frees used memory.
+ *
+ * \pre Finish all connections created from this fabric.
+ *
+ * \param fabric A fabric.
+ *
+ * \return TRUE on success, FALSE if an error occurred.
+ **/
+gboolean j_network_fabric_fini(JNetworkFabric* fabric);
+
 /**
  * Gets identifier of memory region.
  *
@@ -213,6 +226,7 @@ JNetworkConnection* j_network_connection_init_client(JConfiguration* configurati
  * Establish connection to client based on established GSocketConnection.
  * The GSocketConnection will be used to send the server fabric data.
  * For the connection process see j_network_connection_init_client().
+ * If \p fabric is NULL, the GSocketConnection itself is used as a TCP connection.
  *
  * \attention This function may reduces j_configuration_max_operation_size according to network capabilities.
  *
@@ -240,7 +254,6 @@ gboolean j_network_connection_fini(JNetworkConnection* connection);
  * If the message is small enough it can be injected to the network, in that case the actions finishes immediately (j_network_connection_wait_for_completion() still works).
  *
  * \todo feedback if message was injected
- * \todo make data a gconstpointer if possible
  *
  * \attention It is only allowed to have J_CONNECTION_MAX_SEND send operations pending at the same time. Each has a maximum size of j_configuration_max_operation_size() (the connection initialization may change this value).
  *
@@ -250,7 +263,7 @@ gboolean j_network_connection_fini(JNetworkConnection* connection);
  *
  * \return TRUE on success, FALSE if an error occurred.
  */
-gboolean j_network_connection_send(JNetworkConnection* connection, gpointer data, gsize length);
+gboolean j_network_connection_send(JNetworkConnection* connection, gconstpointer data, gsize length);
 
 /**
  * Asynchronously receives data via MSG connection.
@@ -267,6 +280,57 @@ gboolean j_network_connection_send(JNetworkConnection* connection, gpointer data
  */
 gboolean j_network_connection_recv(JNetworkConnection* connection, gsize length, gpointer data);
 
+/**
+ * Sends data of arbitrary length and waits for completion.
+ * The data is split into chunks of at most j_configuration_get_max_operation_size() bytes.
+ * The receiver has to use j_network_connection_recv_all() with the same length.
+ *
+ * \param[in] connection A connection.
+ * \param[in] data A data buffer to send.
+ * \param[in] length A length in bytes.
+ *
+ * \return TRUE on success, FALSE if an error occurred.
+ */
+gboolean j_network_connection_send_all(JNetworkConnection* connection, gconstpointer data, gsize length);
+
+/**
+ * Receives data of arbitrary length and waits for completion.
+ * Counterpart to j_network_connection_send_all().
+ *
+ * \param[in] connection A connection.
+ * \param[in] length A length in bytes.
+ * \param[out] data A data buffer to receive into.
+ *
+ * \return TRUE on success, FALSE if an error occurred (check j_network_connection_closed() whether the connection was closed).
+ */
+gboolean j_network_connection_recv_all(JNetworkConnection* connection, gsize length, gpointer data);
+
+/**
+ * Checks whether bulk data is transferred via RMA instead of being sent inline.
+ * This is the case for libfabric connections if the data is larger than j_configuration_get_max_inject_size().
+ * Both parties have to use the same configuration.
+ *
+ * \param[in] connection A connection.
+ * \param[in] length A length in bytes.
+ *
+ * \return TRUE if RMA is used, FALSE otherwise.
+ */
+gboolean j_network_connection_use_rma(JNetworkConnection* connection, gsize length);
+
+/**
+ * Receives bulk data, that is, data added to a message with j_message_add_send().
+ * If j_network_connection_use_rma() is true for \p length, only a memory ID is received and the data is read directly into \p data via RMA.
+ * Afterwards, an acknowledgment is sent so the other party can unregister its memory.
+ * If the connection uses compression, the data is decompressed directly into \p data.
+ *
+ * \param[in] connection A connection.
+ * \param[in] length A length in bytes.
+ * \param[out] data A data buffer to receive into.
+ *
+ * \return TRUE on success, FALSE if an error occurred.
+ */
+gboolean j_network_connection_recv_bulk(JNetworkConnection* connection, gsize length, gpointer data);
+
 /**
  * Asynchronous direct memory read.
  * Initiate an direct memory read.
@@ -298,6 +362,142 @@ gboolean j_network_connection_wait_for_completion(JNetworkConnection* connection
  **/
 gboolean j_network_connection_closed(JNetworkConnection* connection);
 
+/**
+ * Enables or disables multiplexing for a connection.
+ * Multiplexed connections can be used by multiple threads at the same time:
+ * Messages are sent atomically and replies can arrive in any order, so they are matched to their requests using the message ID.
+ * Only TCP connections can be multiplexed.
+ *
+ * \param[in] connection  A connection.
+ * \param[in] multiplexed Whether the connection should be multiplexed.
+ *
+ * \return TRUE on success, FALSE if the connection does not support multiplexing.
+ */
+gboolean j_network_connection_set_multiplexed(JNetworkConnection* connection, gboolean multiplexed);
+
+/**
+ * Checks whether a connection is multiplexed.
+ *
+ * \param[in] connection A connection.
+ *
+ * \return TRUE if the connection is multiplexed, FALSE otherwise.
+ */
+gboolean j_network_connection_get_multiplexed(JNetworkConnection* connection);
+
+/**
+ * Sets the codec used to compress message bodies and bulk data sent over a connection.
+ * Both parties have to use the same codec, it is negotiated when establishing the connection.
+ * Only TCP connections support compression.
+ *
+ * \param[in] connection  A connection.
+ * \param[in] compression A codec.
+ *
+ * \return TRUE on success, FALSE if the connection or this build does not support the codec.
+ */
+gboolean j_network_connection_set_compression(JNetworkConnection* connection, JConfigurationCompression compression);
+
+/**
+ * Returns the codec used by a connection.
+ *
+ * \param[in] connection A connection.
+ *
+ * \return The codec.
+ */
+JConfigurationCompression j_network_connection_get_compression(JNetworkConnection* connection);
+
+/**
+ * Locks a multiplexed connection for sending a complete message.
+ * Does nothing if the connection is not multiplexed.
+ *
+ * \param[in] connection A connection.
+ */
+void j_network_connection_lock_send(JNetworkConnection* connection);
+
+/**
+ * Unlocks a connection locked with j_network_connection_lock_send().
+ *
+ * \param[in] connection A connection.
+ */
+void j_network_connection_unlock_send(JNetworkConnection* connection);
+
+/**
+ * Waits until the calling thread is allowed to receive the reply with the given ID from a multiplexed connection.
+ * If another thread has already received the reply's header, it is returned in \p data and has to be freed with g_free().
+ * Otherwise, \p data is set to NULL and the calling thread has to receive the next header itself.
+ * If it belongs to another reply, it has to be passed on using j_network_connection_handoff_recv().
+ * The calling thread may receive until it calls j_network_connection_release_recv().
+ *
+ * \param[in]  connection A multiplexed connection.
+ * \param[in]  id         The ID of the expected reply.
+ * \param[out] data       A header received by another thread or NULL.
+ *
+ * \return TRUE on success, FALSE if the connection has been closed.
+ */
+gboolean j_network_connection_acquire_recv(JNetworkConnection* connection, guint32 id, gpointer* data);
+
+/**
+ * Passes a received header to the thread waiting for it and gives up the right to receive.
+ *
+ * \param[in] connection A multiplexed connection.
+ * \param[in] id         The ID of the reply the header belongs to.
+ * \param[in] data       The header, will be freed by the recipient.
+ */
+void j_network_connection_handoff_recv(JNetworkConnection* connection, guint32 id, gpointer data);
+
+/**
+ * Gives up the right to receive acquired with j_network_connection_acquire_recv().
+ * Does nothing if the calling thread is not allowed to receive or the connection is not multiplexed.
+ *
+ * \param[in] connection A connection.
+ */
+void j_network_connection_release_recv(JNetworkConnection* connection);
+
+/**
+ * Returns the number of bytes that have already been received but not yet consumed.
+ * Such data does not cause the underlying socket to become readable again, so it has to be checked before waiting for new data.
+ *
+ * \param[in] connection A connection.
+ *
+ * \return The number of buffered bytes, always 0 for libfabric connections.
+ */
+gsize j_network_connection_get_available(JNetworkConnection* connection);
+
+/**
+ * Copies data that has already been received without consuming it.
+ *
+ * \param[in]  connection A TCP connection.
+ * \param[in]  length     The data length.
+ * \param[out] data       A buffer to copy into.
+ *
+ * \return TRUE if enough data has been received and copied, FALSE otherwise.
+ */
+gboolean j_network_connection_peek(JNetworkConnection* connection, gsize length, gpointer data);
+
+/**
+ * Buffers incoming data without blocking, so that it can be received by another thread once it is complete.
+ * If not enough data has been buffered, the caller should wait for the connection's socket to become readable, for instance, using epoll.
+ * Shared-memory connections use the socket only for notifications, which are requested if not enough data is available.
+ * Data that does not fit into the receive buffer or a shared-memory connection's ring is considered buffered as soon as the buffer is full.
+ *
+ * \param[in]  connection A TCP connection.
+ * \param[in]  length     The number of bytes that should be buffered.
+ * \param[in]  readable   Whether the socket is readable, that is, whether it can be read from once without blocking.
+ * \param[out] buffered   Returns whether length bytes have been buffered.
+ *
+ * \return TRUE on success, FALSE if the connection has been closed or an error occurred.
+ */
+gboolean j_network_connection_buffer(JNetworkConnection* connection, gsize length, gboolean readable, gboolean* buffered);
+
+/**
+ * Returns the underlying socket connection of a TCP connection.
+ * Connections to local servers transfer data via shared memory instead, see j_configuration_get_shared_memory().
+ *
+ * \param[in] connection A connection.
+ *
+ * \return The socket connection, NULL for libfabric and shared-memory connections.
+ */
+GSocketConnection* j_network_connection_get_socket_connection(JNetworkConnection* connection);
+
 /**
  * Registers memory to make it RMA-readable.
  * Memory access rights must changed to allow for an RMA read by the other party.
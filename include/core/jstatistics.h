@@ -46,7 +46,9 @@ enum JStatisticsType
 	J_STATISTICS_BYTES_READ,
 	J_STATISTICS_BYTES_WRITTEN,
 	J_STATISTICS_BYTES_RECEIVED,
-	J_STATISTICS_BYTES_SENT
+	J_STATISTICS_BYTES_SENT,
+	J_STATISTICS_OPENS_SAVED,
+	J_STATISTICS_CLOSES_SAVED
 };
 
 typedef enum JStatisticsType JStatisticsType;
@@ -35,6 +35,7 @@
 #include <core/jbackground-operation.h>
 #include <core/jbatch.h>
 #include <core/jcache.h>
+#include <core/jcompression.h>
 #include <core/jconfiguration.h>
 #include <core/jconnection-pool.h>
 #include <core/jcredentials.h>
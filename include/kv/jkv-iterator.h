@@ -70,6 +70,44 @@ JKVIterator* j_kv_iterator_new(gchar const* namespace, gchar const* prefix);
  **/
 JKVIterator* j_kv_iterator_new_for_index(guint32 index, gchar const* namespace, gchar const* prefix);
 
+/**
+ * Creates a new JKVIterator for a range of keys.
+ * The keys are returned in ascending order, keys are compared bytewise like strcmp().
+ *
+ * \code
+ * JKVIterator* iterator;
+ * g_autofree gchar* cursor = NULL;
+ *
+ * iterator = j_kv_iterator_new_range("namespace", "2026-01-01", "2026-02-01", 100);
+ *
+ * while (j_kv_iterator_next(iterator))
+ * {
+ *   ...
+ * }
+ *
+ * // NULL if the whole range has been returned
+ * cursor = j_kv_iterator_get_cursor(iterator);
+ * j_kv_iterator_free(iterator);
+ * \endcode
+ *
+ * \param namespace JKV namespace to iterate over.
+ * \param start First key of the range. Set to NULL to start at the first key.
+ * \param end Key after the range, which is not returned. Set to NULL to iterate up to the last key.
+ * \param limit Maximum number of keys to return. Set to 0 to return all keys of the range.
+ *
+ * \return A new JKVIterator.
+ **/
+JKVIterator* j_kv_iterator_new_range(gchar const* namespace, gchar const* start, gchar const* end, guint32 limit);
+
+/**
+ * Creates a new JKVIterator that continues a range.
+ *
+ * \param cursor A cursor returned by j_kv_iterator_get_cursor().
+ *
+ * \return A new JKVIterator, NULL if the cursor is invalid.
+ **/
+JKVIterator* j_kv_iterator_new_for_cursor(gchar const* cursor);
+
 /**
  * Frees the memory allocated by the JKVIterator.
  *
@@ -105,6 +143,19 @@ gboolean j_kv_iterator_next(JKVIterator* iterator);
  **/
 gchar const* j_kv_iterator_get(JKVIterator* iterator, gconstpointer* value, guint32* len);
 
+/**
+ * Returns a cursor to continue a range after the current key.
+ * The cursor is an opaque string that can be passed to j_kv_iterator_new_for_cursor(), for example, to return the next page of a range.
+ *
+ * \code
+ * \endcode
+ *
+ * \param iterator An iterator created by j_kv_iterator_new_range() or j_kv_iterator_new_for_cursor().
+ *
+ * \return A cursor, NULL if all keys of the range have been returned. Should be freed with g_free().
+ **/
+gchar* j_kv_iterator_get_cursor(JKVIterator* iterator);
+
 /**
  * @}
  **/
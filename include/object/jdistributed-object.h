@@ -172,6 +172,20 @@ void j_distributed_object_status(JDistributedObject* object, gint64* modificatio
  **/
 void j_distributed_object_sync(JDistributedObject* object, JBatch* batch);
 
+/**
+ * Copy an object.
+ * The destination is created if necessary and has to use the same distribution as object.
+ * Each server copies its own part of the object, no data is transferred to the client.
+ *
+ * \code
+ * \endcode
+ *
+ * \param object      An object.
+ * \param destination The destination object.
+ * \param batch       A batch.
+ **/
+void j_distributed_object_copy(JDistributedObject* object, JDistributedObject* destination, JBatch* batch);
+
 /**
  * @}
  **/
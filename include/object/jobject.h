@@ -45,6 +45,17 @@ struct JObject;
 
 typedef struct JObject JObject;
 
+/**
+ * A range of an object that contains data.
+ **/
+struct JObjectExtent
+{
+	guint64 offset;
+	guint64 length;
+};
+
+typedef struct JObjectExtent JObjectExtent;
+
 /**
  * Creates a new object.
  *
@@ -186,6 +197,68 @@ void j_object_status(JObject* object, gint64* modification_time, guint64* size,
  **/
 void j_object_sync(JObject* object, JBatch* batch);
 
+/**
+ * Copies an object.
+ * The destination is created if necessary.
+ * If both objects are stored on the same server, the data is copied by the server without being transferred over the network.
+ *
+ * \code
+ * \endcode
+ *
+ * \param object      An object.
+ * \param destination The destination object.
+ * \param batch       A batch.
+ **/
+void j_object_copy(JObject* object, JObject* destination, JBatch* batch);
+
+/**
+ * Allocates storage for a range of an object.
+ * The object's size is extended if necessary, the range reads as zeros if it has not been written before.
+ * Allocating fails if the backend does not support it.
+ *
+ * \code
+ * \endcode
+ *
+ * \param object An object.
+ * \param length Number of bytes to allocate.
+ * \param offset An offset within \p object.
+ * \param batch  A batch.
+ **/
+void j_object_allocate(JObject* object, guint64 length, guint64 offset, JBatch* batch);
+
+/**
+ * Deallocates the storage of a range of an object, which reads as zeros afterwards.
+ * The object's size is not changed.
+ *
+ * \code
+ * \endcode
+ *
+ * \param object An object.
+ * \param length Number of bytes to deallocate.
+ * \param offset An offset within \p object.
+ * \param batch  A batch.
+ **/
+void j_object_punch(JObject* object, guint64 length, guint64 offset, JBatch* batch);
+
+/**
+ * Gets the ranges of an object that contain data.
+ * All other ranges up to the object's size are holes that read as zeros.
+ * Backends that do not support holes report all data as a single extent.
+ *
+ * \code
+ * g_autoptr(GArray) extents = g_array_new(FALSE, FALSE, sizeof(JObjectExtent));
+ *
+ * j_object_get_extents(object, G_MAXUINT64 / 2, 0, extents, batch);
+ * \endcode
+ *
+ * \param object  An object.
+ * \param length  Number of bytes to query.
+ * \param offset  An offset within \p object.
+ * \param extents An array of JObjectExtent, the extents are appended to it.
+ * \param batch   A batch.
+ **/
+void j_object_get_extents(JObject* object, guint64 length, guint64 offset, GArray* extents, JBatch* batch);
+
 /**
  * @}
  **/
@@ -25,8 +25,12 @@
 #include <glib.h>
 #include <gmodule.h>
 
+#include <stdlib.h>
+#include <string.h>
+
 #include <jbackend.h>
 
+#include <jhelper.h>
 #include <jtrace.h>
 
 /**
@@ -528,6 +532,246 @@ j_backend_object_write(JBackend* backend, gpointer data, gconstpointer buffer, g
 	return ret;
 }
 
+gboolean
+j_backend_object_readv(JBackend* backend, gpointer data, JBackendExtent* extents, guint extents_len)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gboolean ret = TRUE;
+
+	g_return_val_if_fail(backend != NULL, FALSE);
+	g_return_val_if_fail(backend->type == J_BACKEND_TYPE_OBJECT, FALSE);
+	g_return_val_if_fail(data != NULL, FALSE);
+	g_return_val_if_fail(extents != NULL || extents_len == 0, FALSE);
+
+	if (extents_len == 0)
+	{
+		return TRUE;
+	}
+
+	if (backend->object.backend_readv != NULL)
+	{
+		J_TRACE("backend_readv", "%p, %p, %u", data, (gpointer)extents, extents_len);
+		ret = backend->object.backend_readv(backend->data, data, extents, extents_len);
+	}
+	else
+	{
+		for (guint i = 0; i < extents_len; i++)
+		{
+			J_TRACE("backend_read", "%p, %p, %" G_GUINT64_FORMAT ", %" G_GUINT64_FORMAT ", %p", data, extents[i].buffer, extents[i].length, extents[i].offset, (gpointer)&(extents[i].bytes));
+			extents[i].bytes = 0;
+			ret = backend->object.backend_read(backend->data, data, extents[i].buffer, extents[i].length, extents[i].offset, &(extents[i].bytes)) && ret;
+		}
+	}
+
+	return ret;
+}
+
+gboolean
+j_backend_object_writev(JBackend* backend, gpointer data, JBackendExtent* extents, guint extents_len, gboolean sync)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gboolean ret = TRUE;
+
+	g_return_val_if_fail(backend != NULL, FALSE);
+	g_return_val_if_fail(backend->type == J_BACKEND_TYPE_OBJECT, FALSE);
+	g_return_val_if_fail(data != NULL, FALSE);
+	g_return_val_if_fail(extents != NULL || extents_len == 0, FALSE);
+
+	if (extents_len == 0)
+	{
+		return (sync) ? j_backend_object_sync(backend, data) : TRUE;
+	}
+
+	if (backend->object.backend_writev != NULL)
+	{
+		J_TRACE("backend_writev", "%p, %p, %u, %d", data, (gpointer)extents, extents_len, sync);
+		ret = backend->object.backend_writev(backend->data, data, extents, extents_len, sync);
+	}
+	else
+	{
+		for (guint i = 0; i < extents_len; i++)
+		{
+			J_TRACE("backend_write", "%p, %p, %" G_GUINT64_FORMAT ", %" G_GUINT64_FORMAT ", %p", data, extents[i].buffer, extents[i].length, extents[i].offset, (gpointer)&(extents[i].bytes));
+			extents[i].bytes = 0;
+			ret = backend->object.backend_write(backend->data, data, extents[i].buffer, extents[i].length, extents[i].offset, &(extents[i].bytes)) && ret;
+		}
+
+		if (sync)
+		{
+			ret = j_backend_object_sync(backend, data) && ret;
+		}
+	}
+
+	return ret;
+}
+
+gboolean
+j_backend_object_copy(JBackend* backend, gpointer source, gpointer destination, guint64* bytes_copied)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gboolean ret;
+
+	g_return_val_if_fail(backend != NULL, FALSE);
+	g_return_val_if_fail(backend->type == J_BACKEND_TYPE_OBJECT, FALSE);
+	g_return_val_if_fail(source != NULL, FALSE);
+	g_return_val_if_fail(destination != NULL, FALSE);
+	g_return_val_if_fail(bytes_copied != NULL, FALSE);
+
+	*bytes_copied = 0;
+
+	if (backend->object.backend_copy != NULL)
+	{
+		J_TRACE("backend_copy", "%p, %p, %p", source, destination, (gpointer)bytes_copied);
+		ret = backend->object.backend_copy(backend->data, source, destination, bytes_copied);
+	}
+	else
+	{
+		// 4 MiB buffer, aligned to allow direct I/O
+		guint64 const buffer_size = 4 * 1024 * 1024;
+		gpointer buffer;
+		guint64 size;
+
+		if (!j_backend_object_status(backend, source, NULL, &size))
+		{
+			return FALSE;
+		}
+
+		buffer = j_helper_alloc_aligned(J_BACKEND_ALIGNMENT, buffer_size);
+		ret = TRUE;
+
+		while (ret && *bytes_copied < size)
+		{
+			guint64 length = MIN(buffer_size, size - *bytes_copied);
+			guint64 bytes_read = 0;
+			guint64 bytes_written = 0;
+
+			ret = j_backend_object_read(backend, source, buffer, length, *bytes_copied, &bytes_read);
+			ret = ret && j_backend_object_write(backend, destination, buffer, bytes_read, *bytes_copied, &bytes_written);
+			ret = ret && bytes_written == length;
+
+			*bytes_copied += bytes_written;
+		}
+
+		free(buffer);
+	}
+
+	return ret;
+}
+
+gboolean
+j_backend_object_allocate(JBackend* backend, gpointer data, guint64 length, guint64 offset)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gboolean ret = FALSE;
+
+	g_return_val_if_fail(backend != NULL, FALSE);
+	g_return_val_if_fail(backend->type == J_BACKEND_TYPE_OBJECT, FALSE);
+	g_return_val_if_fail(data != NULL, FALSE);
+
+	if (backend->object.backend_allocate != NULL)
+	{
+		J_TRACE("backend_allocate", "%p, %" G_GUINT64_FORMAT ", %" G_GUINT64_FORMAT, data, length, offset);
+		ret = backend->object.backend_allocate(backend->data, data, length, offset);
+	}
+
+	return ret;
+}
+
+gboolean
+j_backend_object_punch(JBackend* backend, gpointer data, guint64 length, guint64 offset)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gboolean ret;
+
+	g_return_val_if_fail(backend != NULL, FALSE);
+	g_return_val_if_fail(backend->type == J_BACKEND_TYPE_OBJECT, FALSE);
+	g_return_val_if_fail(data != NULL, FALSE);
+
+	if (backend->object.backend_punch != NULL)
+	{
+		J_TRACE("backend_punch", "%p, %" G_GUINT64_FORMAT ", %" G_GUINT64_FORMAT, data, length, offset);
+		ret = backend->object.backend_punch(backend->data, data, length, offset);
+	}
+	else
+	{
+		guint64 const buffer_size = 4 * 1024 * 1024;
+		gpointer buffer;
+		guint64 size;
+		guint64 end;
+
+		if (!j_backend_object_status(backend, data, NULL, &size))
+		{
+			return FALSE;
+		}
+
+		// Punching does not change the object's size
+		end = MIN(offset + length, size);
+
+		buffer = j_helper_alloc_aligned(J_BACKEND_ALIGNMENT, buffer_size);
+		memset(buffer, 0, buffer_size);
+		ret = TRUE;
+
+		while (ret && offset < end)
+		{
+			guint64 chunk = MIN(buffer_size, end - offset);
+			guint64 bytes_written = 0;
+
+			ret = j_backend_object_write(backend, data, buffer, chunk, offset, &bytes_written);
+			ret = ret && bytes_written == chunk;
+
+			offset += chunk;
+		}
+
+		free(buffer);
+	}
+
+	return ret;
+}
+
+gboolean
+j_backend_object_get_extents(JBackend* backend, gpointer data, guint64 length, guint64 offset, GArray* extents)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gboolean ret;
+
+	g_return_val_if_fail(backend != NULL, FALSE);
+	g_return_val_if_fail(backend->type == J_BACKEND_TYPE_OBJECT, FALSE);
+	g_return_val_if_fail(data != NULL, FALSE);
+	g_return_val_if_fail(extents != NULL, FALSE);
+
+	if (backend->object.backend_get_extents != NULL)
+	{
+		J_TRACE("backend_get_extents", "%p, %" G_GUINT64_FORMAT ", %" G_GUINT64_FORMAT, data, length, offset);
+		ret = backend->object.backend_get_extents(backend->data, data, length, offset, extents);
+	}
+	else
+	{
+		guint64 size;
+
+		ret = j_backend_object_status(backend, data, NULL, &size);
+
+		if (ret && offset < size)
+		{
+			JBackendExtent extent;
+
+			extent.buffer = NULL;
+			extent.length = MIN(length, size - offset);
+			extent.offset = offset;
+			extent.bytes = 0;
+
+			g_array_append_val(extents, extent);
+		}
+	}
+
+	return ret;
+}
+
 gboolean
 j_backend_kv_init(JBackend* backend, gchar const* path)
 {
@@ -705,6 +949,33 @@ j_backend_kv_get_by_prefix(JBackend* backend, gchar const* namespace, gchar cons
 	return ret;
 }
 
+gboolean
+j_backend_kv_get_range(JBackend* backend, gchar const* namespace, gchar const* start, gchar const* end, guint32 limit, gpointer* iterator)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gboolean ret;
+
+	g_return_val_if_fail(backend != NULL, FALSE);
+	g_return_val_if_fail(backend->type == J_BACKEND_TYPE_KV, FALSE);
+	g_return_val_if_fail(namespace != NULL, FALSE);
+	g_return_val_if_fail(start != NULL, FALSE);
+	g_return_val_if_fail(iterator != NULL, FALSE);
+
+	// Callers have to fall back to j_backend_kv_get_all()
+	if (backend->kv.backend_get_range == NULL)
+	{
+		return FALSE;
+	}
+
+	{
+		J_TRACE("backend_get_range", "%s, %s, %s, %u, %p", namespace, start, end, limit, (gpointer)iterator);
+		ret = backend->kv.backend_get_range(backend->data, namespace, start, end, limit, iterator);
+	}
+
+	return ret;
+}
+
 gboolean
 j_backend_kv_iterate(JBackend* backend, gpointer iterator, gchar const** key, gconstpointer* value, guint32* value_len)
 {
@@ -161,6 +161,22 @@ j_background_operation_new(JBackgroundOperationFunc func, gpointer data)
 
 	g_return_val_if_fail(func != NULL, NULL);
 
+	// The server does not initialize the library, so backends using background operations need the thread pool to be created on demand
+	if (G_UNLIKELY(g_atomic_pointer_get(&j_thread_pool) == NULL))
+	{
+		static gsize initialized = 0;
+
+		if (g_once_init_enter(&initialized))
+		{
+			if (g_atomic_pointer_get(&j_thread_pool) == NULL)
+			{
+				j_background_operation_init(0);
+			}
+
+			g_once_init_leave(&initialized, 1);
+		}
+	}
+
 	background_operation = g_new(JBackgroundOperation, 1);
 	background_operation->func = func;
 	background_operation->data = data;
@@ -0,0 +1,290 @@
+/*
+ * JULEA - Flexible storage framework
+ * Copyright (C) 2026 Michael Kuhn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file
+ **/
+
+#include <julea-config.h>
+
+#include <glib.h>
+
+#ifdef HAVE_LZ4
+#include <lz4.h>
+#endif
+
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+#include <jcompression.h>
+
+#include <jtrace.h>
+
+/**
+ * \addtogroup JCompression
+ *
+ * @{
+ **/
+
+/**
+ * zstd's compression level, low levels are fast enough to keep up with the network.
+ **/
+#define J_COMPRESSION_ZSTD_LEVEL 1
+
+/**
+ * Per-thread compression state.
+ **/
+struct JCompressionState
+{
+	/**
+	 * The temporary buffer, see j_compression_get_buffer().
+	 **/
+	gpointer buffer;
+	gsize buffer_size;
+
+#ifdef HAVE_ZSTD
+	/**
+	 * zstd's contexts, which are expensive to create.
+	 **/
+	ZSTD_CCtx* cctx;
+	ZSTD_DCtx* dctx;
+#endif
+};
+
+typedef struct JCompressionState JCompressionState;
+
+static void
+j_compression_state_free(gpointer data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JCompressionState* state = data;
+
+#ifdef HAVE_ZSTD
+	ZSTD_freeCCtx(state->cctx);
+	ZSTD_freeDCtx(state->dctx);
+#endif
+
+	g_free(state->buffer);
+	g_free(state);
+}
+
+static GPrivate j_compression_state = G_PRIVATE_INIT(j_compression_state_free);
+
+static JCompressionState*
+j_compression_state_get(void)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JCompressionState* state;
+
+	state = g_private_get(&j_compression_state);
+
+	if (G_UNLIKELY(state == NULL))
+	{
+		state = g_new0(JCompressionState, 1);
+		g_private_set(&j_compression_state, state);
+	}
+
+	return state;
+}
+
+gboolean
+j_compression_available(JConfigurationCompression compression)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	switch (compression)
+	{
+		case J_CONFIGURATION_COMPRESSION_NONE:
+			return TRUE;
+		case J_CONFIGURATION_COMPRESSION_LZ4:
+#ifdef HAVE_LZ4
+			return TRUE;
+#else
+			return FALSE;
+#endif
+		case J_CONFIGURATION_COMPRESSION_ZSTD:
+#ifdef HAVE_ZSTD
+			return TRUE;
+#else
+			return FALSE;
+#endif
+		default:
+			return FALSE;
+	}
+}
+
+gsize
+j_compression_bound(JConfigurationCompression compression, gsize length)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	switch (compression)
+	{
+		case J_CONFIGURATION_COMPRESSION_NONE:
+			return length;
+		case J_CONFIGURATION_COMPRESSION_LZ4:
+#ifdef HAVE_LZ4
+			if (length <= LZ4_MAX_INPUT_SIZE)
+			{
+				return LZ4_compressBound(length);
+			}
+#endif
+			return length;
+		case J_CONFIGURATION_COMPRESSION_ZSTD:
+#ifdef HAVE_ZSTD
+			return ZSTD_compressBound(length);
+#else
+			return length;
+#endif
+		default:
+			g_assert_not_reached();
+	}
+
+	return length;
+}
+
+gsize
+j_compression_compress(JConfigurationCompression compression, gconstpointer data, gsize length, gpointer compressed, gsize compressed_length)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gsize ret = 0;
+
+	g_return_val_if_fail(data != NULL, 0);
+	g_return_val_if_fail(compressed != NULL, 0);
+
+	switch (compression)
+	{
+		case J_CONFIGURATION_COMPRESSION_NONE:
+			break;
+		case J_CONFIGURATION_COMPRESSION_LZ4:
+#ifdef HAVE_LZ4
+			if (length <= LZ4_MAX_INPUT_SIZE)
+			{
+				gint lz4_ret;
+
+				lz4_ret = LZ4_compress_default(data, compressed, length, MIN(compressed_length, G_MAXINT));
+				ret = MAX(lz4_ret, 0);
+			}
+#endif
+			break;
+		case J_CONFIGURATION_COMPRESSION_ZSTD:
+#ifdef HAVE_ZSTD
+		{
+			JCompressionState* state;
+			gsize zstd_ret;
+
+			state = j_compression_state_get();
+
+			if (state->cctx == NULL)
+			{
+				state->cctx = ZSTD_createCCtx();
+			}
+
+			zstd_ret = ZSTD_compressCCtx(state->cctx, compressed, compressed_length, data, length, J_COMPRESSION_ZSTD_LEVEL);
+
+			if (!ZSTD_isError(zstd_ret))
+			{
+				ret = zstd_ret;
+			}
+		}
+#endif
+		break;
+		default:
+			g_assert_not_reached();
+	}
+
+	// Incompressible data is sent as is
+	if (ret >= length)
+	{
+		ret = 0;
+	}
+
+	return ret;
+}
+
+gboolean
+j_compression_decompress(JConfigurationCompression compression, gconstpointer compressed, gsize compressed_length, gpointer data, gsize length)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gboolean ret = FALSE;
+
+	g_return_val_if_fail(compressed != NULL, FALSE);
+	g_return_val_if_fail(data != NULL, FALSE);
+
+	switch (compression)
+	{
+		case J_CONFIGURATION_COMPRESSION_NONE:
+			break;
+		case J_CONFIGURATION_COMPRESSION_LZ4:
+#ifdef HAVE_LZ4
+			if (compressed_length <= G_MAXINT && length <= G_MAXINT)
+			{
+				ret = (LZ4_decompress_safe(compressed, data, compressed_length, length) == (gint)length);
+			}
+#endif
+			break;
+		case J_CONFIGURATION_COMPRESSION_ZSTD:
+#ifdef HAVE_ZSTD
+		{
+			JCompressionState* state;
+
+			state = j_compression_state_get();
+
+			if (state->dctx == NULL)
+			{
+				state->dctx = ZSTD_createDCtx();
+			}
+
+			ret = (ZSTD_decompressDCtx(state->dctx, data, length, compressed, compressed_length) == length);
+		}
+#endif
+		break;
+		default:
+			g_assert_not_reached();
+	}
+
+	return ret;
+}
+
+gpointer
+j_compression_get_buffer(gsize length)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JCompressionState* state;
+
+	state = j_compression_state_get();
+
+	if (G_UNLIKELY(state->buffer_size < length))
+	{
+		g_free(state->buffer);
+		state->buffer = g_malloc(length);
+		state->buffer_size = length;
+	}
+
+	return state->buffer;
+}
+
+/**
+ * @}
+ **/
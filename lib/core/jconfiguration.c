@@ -24,6 +24,7 @@
 
 #include <glib.h>
 
+#include <stdlib.h>
 #include <string.h>
 
 #include <jconfiguration.h>
@@ -31,6 +32,7 @@
 
 #include <jbackend.h>
 #include <jcredentials.h>
+#include <jhelper.h>
 #include <jtrace.h>
 
 /**
@@ -39,6 +41,35 @@
  * @{
  **/
 
+/**
+ * The number of virtual nodes per server and unit of weight.
+ **/
+#define J_CONFIGURATION_RING_VNODES 128
+
+/**
+ * A consistent hashing ring.
+ * The points are stored separately from their servers, so that searching them touches as few cache lines as possible.
+ */
+struct JConfigurationRing
+{
+	/**
+	 * The sorted points of all virtual nodes.
+	 */
+	guint32* points;
+
+	/**
+	 * The server of each point.
+	 */
+	guint32* servers;
+
+	/**
+	 * The number of points.
+	 */
+	guint32 len;
+};
+
+typedef struct JConfigurationRing JConfigurationRing;
+
 /**
  * A configuration.
  */
@@ -75,6 +106,21 @@ struct JConfiguration
 		 * The number of db servers.
 		 */
 		guint32 db_len;
+
+		/**
+		 * The placement policy for object and kv servers.
+		 */
+		JConfigurationPlacement placement;
+
+		/**
+		 * The ring of the object servers, only used for J_CONFIGURATION_PLACEMENT_RING.
+		 */
+		JConfigurationRing object_ring;
+
+		/**
+		 * The ring of the kv servers, only used for J_CONFIGURATION_PLACEMENT_RING.
+		 */
+		JConfigurationRing kv_ring;
 	} servers;
 
 	/**
@@ -125,6 +171,38 @@ struct JConfiguration
 		gchar* path;
 	} db;
 
+	/**
+	 * The network configuration.
+	 */
+	struct
+	{
+		/**
+		 * The transport.
+		 */
+		JConfigurationTransport transport;
+
+		/**
+		 * The libfabric provider, NULL lets libfabric choose one.
+		 */
+		gchar* provider;
+
+		/**
+		 * The compression codec requested by clients.
+		 */
+		JConfigurationCompression compression;
+
+		/**
+		 * Whether clients use shared memory to communicate with local servers.
+		 */
+		gboolean shared_memory;
+
+		/**
+		 * The path of the servers' Unix domain sockets, NULL if they should not be used.
+		 * {PORT} is replaced with the server's port.
+		 */
+		gchar* socket;
+	} network;
+
 	guint64 max_operation_size;
 	guint64 max_inject_size;
 	guint16 port;
@@ -132,6 +210,11 @@ struct JConfiguration
 	guint32 max_connections;
 	guint64 stripe_size;
 
+	/**
+	 * Whether clients share one multiplexed connection per server.
+	 */
+	gboolean multiplexing;
+
 	gchar* checksum;
 
 	/**
@@ -142,6 +225,167 @@ struct JConfiguration
 
 static JConfiguration* j_config = NULL;
 
+/**
+ * Mixes the bits of a hash, so that similar keys are spread across the whole ring.
+ **/
+static guint32
+j_configuration_ring_mix(guint32 hash)
+{
+	// Finalizer of MurmurHash3
+	hash ^= hash >> 16;
+	hash *= 0x85ebca6bU;
+	hash ^= hash >> 13;
+	hash *= 0xc2b2ae35U;
+	hash ^= hash >> 16;
+
+	return hash;
+}
+
+static gint
+j_configuration_ring_compare(gconstpointer a, gconstpointer b)
+{
+	guint64 const* x = a;
+	guint64 const* y = b;
+
+	return (*x > *y) - (*x < *y);
+}
+
+/**
+ * Builds a ring for a list of servers.
+ * The points of a server only depend on its name, so the points of other servers do not change when adding or removing one.
+ *
+ * \param ring    The ring.
+ * \param servers The servers.
+ * \param weights The servers' weights, NULL to weight all servers equally.
+ **/
+static void
+j_configuration_ring_init(JConfigurationRing* ring, gchar** servers, gint* weights)
+{
+	g_autofree guint64* entries = NULL;
+	guint32 len = 0;
+	guint32 n = 0;
+
+	for (guint32 i = 0; servers[i] != NULL; i++)
+	{
+		len += J_CONFIGURATION_RING_VNODES * ((weights != NULL) ? weights[i] : 1);
+	}
+
+	entries = g_new(guint64, len);
+
+	for (guint32 i = 0; servers[i] != NULL; i++)
+	{
+		guint32 vnodes = J_CONFIGURATION_RING_VNODES * ((weights != NULL) ? weights[i] : 1);
+
+		for (guint32 j = 0; j < vnodes; j++)
+		{
+			g_autofree gchar* vnode = NULL;
+			guint32 point;
+
+			vnode = g_strdup_printf("%s#%u", servers[i], j);
+			point = j_configuration_ring_mix(j_helper_hash(vnode));
+
+			// Sorting the combined values orders colliding points by server
+			entries[n++] = ((guint64)point << 32) | i;
+		}
+	}
+
+	qsort(entries, len, sizeof(guint64), j_configuration_ring_compare);
+
+	ring->points = g_new(guint32, len);
+	ring->servers = g_new(guint32, len);
+	ring->len = len;
+
+	for (guint32 i = 0; i < len; i++)
+	{
+		ring->points[i] = entries[i] >> 32;
+		ring->servers[i] = entries[i] & 0xffffffff;
+	}
+}
+
+static void
+j_configuration_ring_fini(JConfigurationRing* ring)
+{
+	g_free(ring->points);
+	g_free(ring->servers);
+}
+
+/**
+ * Returns the server of the first point at or after the key's hash.
+ **/
+static guint32
+j_configuration_ring_get(JConfigurationRing const* ring, gchar const* key)
+{
+	guint32 hash;
+	guint32 low = 0;
+	guint32 high = ring->len;
+
+	hash = j_configuration_ring_mix(j_helper_hash(key));
+
+	while (low < high)
+	{
+		guint32 mid = low + (high - low) / 2;
+
+		if (ring->points[mid] < hash)
+		{
+			low = mid + 1;
+		}
+		else
+		{
+			high = mid;
+		}
+	}
+
+	// Wrap around to the first point
+	if (low == ring->len)
+	{
+		low = 0;
+	}
+
+	return ring->servers[low];
+}
+
+/**
+ * Reads the servers' weights.
+ *
+ * \param key_file The configuration data.
+ * \param key      The key of the weights.
+ * \param servers  The servers.
+ * \param weights  Returns the weights, NULL if none are configured.
+ *
+ * \return TRUE if the weights are valid, FALSE otherwise.
+ **/
+static gboolean
+j_configuration_get_weights(GKeyFile* key_file, gchar const* key, gchar** servers, gint** weights)
+{
+	gsize len = 0;
+
+	*weights = NULL;
+
+	if (servers == NULL || !g_key_file_has_key(key_file, "servers", key, NULL))
+	{
+		return TRUE;
+	}
+
+	*weights = g_key_file_get_integer_list(key_file, "servers", key, &len, NULL);
+
+	if (*weights == NULL || len != g_strv_length(servers))
+	{
+		g_critical("Number of %s does not match the number of servers.", key);
+		return FALSE;
+	}
+
+	for (gsize i = 0; i < len; i++)
+	{
+		if ((*weights)[i] <= 0)
+		{
+			g_critical("Weights of %s have to be positive.", key);
+			return FALSE;
+		}
+	}
+
+	return TRUE;
+}
+
 void
 j_configuration_init(void)
 {
@@ -266,12 +510,27 @@ j_configuration_new_for_data(GKeyFile* key_file)
 	gchar* kv_path;
 	gchar* db_backend;
 	gchar* db_path;
+	gchar* network_transport;
+	gchar* network_provider;
+	gchar* network_compression;
+	gchar* network_socket;
+	g_autofree gchar* placement_str = NULL;
+	g_autofree gint* object_weights = NULL;
+	g_autofree gint* kv_weights = NULL;
 	g_autofree gchar* key_file_str = NULL;
+	JConfigurationTransport transport = J_CONFIGURATION_TRANSPORT_TCP;
+	gboolean transport_valid = TRUE;
+	JConfigurationCompression compression = J_CONFIGURATION_COMPRESSION_NONE;
+	gboolean compression_valid = TRUE;
+	JConfigurationPlacement placement = J_CONFIGURATION_PLACEMENT_MODULO;
+	gboolean placement_valid = TRUE;
+	gboolean shared_memory = TRUE;
 	guint64 max_operation_size;
 	guint64 max_inject_size;
 	guint32 port;
 	guint32 max_connections;
 	guint64 stripe_size;
+	gboolean multiplexing;
 
 	g_return_val_if_fail(key_file != NULL, FALSE);
 
@@ -280,6 +539,8 @@ j_configuration_new_for_data(GKeyFile* key_file)
 	port = g_key_file_get_integer(key_file, "core", "port", NULL);
 	max_connections = g_key_file_get_integer(key_file, "clients", "max-connections", NULL);
 	stripe_size = g_key_file_get_uint64(key_file, "clients", "stripe-size", NULL);
+	multiplexing = g_key_file_get_boolean(key_file, "clients", "multiplexing", NULL);
+	placement_str = g_key_file_get_string(key_file, "clients", "placement", NULL);
 	servers_object = g_key_file_get_string_list(key_file, "servers", "object", NULL, NULL);
 	servers_kv = g_key_file_get_string_list(key_file, "servers", "kv", NULL, NULL);
 	servers_db = g_key_file_get_string_list(key_file, "servers", "db", NULL, NULL);
@@ -289,6 +550,68 @@ j_configuration_new_for_data(GKeyFile* key_file)
 	kv_path = g_key_file_get_string(key_file, "kv", "path", NULL);
 	db_backend = g_key_file_get_string(key_file, "db", "backend", NULL);
 	db_path = g_key_file_get_string(key_file, "db", "path", NULL);
+	network_transport = g_key_file_get_string(key_file, "network", "transport", NULL);
+	network_provider = g_key_file_get_string(key_file, "network", "provider", NULL);
+	network_compression = g_key_file_get_string(key_file, "network", "compression", NULL);
+	network_socket = g_key_file_get_string(key_file, "network", "socket", NULL);
+
+	// Shared memory is used by default
+	if (g_key_file_has_key(key_file, "network", "shared-memory", NULL))
+	{
+		shared_memory = g_key_file_get_boolean(key_file, "network", "shared-memory", NULL);
+	}
+
+	if (network_transport == NULL || g_strcmp0(network_transport, "tcp") == 0)
+	{
+		transport = J_CONFIGURATION_TRANSPORT_TCP;
+	}
+	else if (g_strcmp0(network_transport, "libfabric") == 0)
+	{
+		transport = J_CONFIGURATION_TRANSPORT_LIBFABRIC;
+	}
+	else
+	{
+		g_critical("Unknown network transport %s.", network_transport);
+		transport_valid = FALSE;
+	}
+
+	if (network_compression == NULL || g_strcmp0(network_compression, "none") == 0)
+	{
+		compression = J_CONFIGURATION_COMPRESSION_NONE;
+	}
+	else if (g_strcmp0(network_compression, "lz4") == 0)
+	{
+		compression = J_CONFIGURATION_COMPRESSION_LZ4;
+	}
+	else if (g_strcmp0(network_compression, "zstd") == 0)
+	{
+		compression = J_CONFIGURATION_COMPRESSION_ZSTD;
+	}
+	else
+	{
+		g_critical("Unknown network compression %s.", network_compression);
+		compression_valid = FALSE;
+	}
+
+	if (placement_str == NULL || g_strcmp0(placement_str, "modulo") == 0)
+	{
+		placement = J_CONFIGURATION_PLACEMENT_MODULO;
+	}
+	else if (g_strcmp0(placement_str, "ring") == 0)
+	{
+		placement = J_CONFIGURATION_PLACEMENT_RING;
+	}
+	else
+	{
+		g_critical("Unknown placement %s.", placement_str);
+		placement_valid = FALSE;
+	}
+
+	if (!j_configuration_get_weights(key_file, "object-weights", servers_object, &object_weights)
+	    || !j_configuration_get_weights(key_file, "kv-weights", servers_kv, &kv_weights))
+	{
+		placement_valid = FALSE;
+	}
 
 	/// \todo check value ranges (max_operation_size, port, max_connections, stripe_size)
 	// configuration->port < 0 || configuration->port > 65535
@@ -301,8 +624,15 @@ j_configuration_new_for_data(GKeyFile* key_file)
 	    || kv_backend == NULL
 	    || kv_path == NULL
 	    || db_backend == NULL
-	    || db_path == NULL)
+	    || db_path == NULL
+	    || !transport_valid
+	    || !compression_valid
+	    || !placement_valid)
 	{
+		g_free(network_transport);
+		g_free(network_compression);
+		g_free(network_provider);
+		g_free(network_socket);
 		g_free(db_backend);
 		g_free(db_path);
 		g_free(kv_backend);
@@ -323,20 +653,36 @@ j_configuration_new_for_data(GKeyFile* key_file)
 	configuration->servers.object_len = g_strv_length(servers_object);
 	configuration->servers.kv_len = g_strv_length(servers_kv);
 	configuration->servers.db_len = g_strv_length(servers_db);
+	configuration->servers.placement = placement;
+	configuration->servers.object_ring.points = NULL;
+	configuration->servers.object_ring.servers = NULL;
+	configuration->servers.object_ring.len = 0;
+	configuration->servers.kv_ring.points = NULL;
+	configuration->servers.kv_ring.servers = NULL;
+	configuration->servers.kv_ring.len = 0;
 	configuration->object.backend = object_backend;
 	configuration->object.path = object_path;
 	configuration->kv.backend = kv_backend;
 	configuration->kv.path = kv_path;
 	configuration->db.backend = db_backend;
 	configuration->db.path = db_path;
+	configuration->network.transport = transport;
+	configuration->network.provider = network_provider;
+	configuration->network.compression = compression;
+	configuration->network.shared_memory = shared_memory;
+	configuration->network.socket = network_socket;
 	configuration->max_operation_size = max_operation_size;
 	configuration->port = port;
 	configuration->max_inject_size = max_inject_size;
 	configuration->max_connections = max_connections;
 	configuration->stripe_size = stripe_size;
+	configuration->multiplexing = multiplexing;
 	configuration->checksum = NULL;
 	configuration->ref_count = 1;
 
+	g_free(network_transport);
+	g_free(network_compression);
+
 	if (configuration->max_operation_size == 0)
 	{
 		configuration->max_operation_size = 8 * 1024 * 1024;
@@ -364,6 +710,13 @@ j_configuration_new_for_data(GKeyFile* key_file)
 		configuration->stripe_size = 4 * 1024 * 1024;
 	}
 
+	// The rings are built once, looking up a key only requires a binary search
+	if (configuration->servers.placement == J_CONFIGURATION_PLACEMENT_RING)
+	{
+		j_configuration_ring_init(&(configuration->servers.object_ring), servers_object, object_weights);
+		j_configuration_ring_init(&(configuration->servers.kv_ring), servers_kv, kv_weights);
+	}
+
 	key_file_str = g_key_file_to_data(key_file, NULL, NULL);
 	configuration->checksum = g_compute_checksum_for_string(G_CHECKSUM_SHA512, key_file_str, -1);
 
@@ -400,10 +753,16 @@ j_configuration_unref(JConfiguration* configuration)
 		g_free(configuration->object.backend);
 		g_free(configuration->object.path);
 
+		g_free(configuration->network.provider);
+		g_free(configuration->network.socket);
+
 		g_strfreev(configuration->servers.object);
 		g_strfreev(configuration->servers.kv);
 		g_strfreev(configuration->servers.db);
 
+		j_configuration_ring_fini(&(configuration->servers.object_ring));
+		j_configuration_ring_fini(&(configuration->servers.kv_ring));
+
 		g_free(configuration->checksum);
 
 		g_free(configuration);
@@ -457,6 +816,48 @@ j_configuration_get_server_count(JConfiguration* configuration, JBackendType bac
 	return 0;
 }
 
+guint32
+j_configuration_get_server_index(JConfiguration* configuration, JBackendType backend, gchar const* key)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_val_if_fail(configuration != NULL, 0);
+	g_return_val_if_fail(key != NULL, 0);
+
+	switch (backend)
+	{
+		case J_BACKEND_TYPE_OBJECT:
+			if (configuration->servers.placement == J_CONFIGURATION_PLACEMENT_RING)
+			{
+				return j_configuration_ring_get(&(configuration->servers.object_ring), key);
+			}
+
+			return j_helper_hash(key) % configuration->servers.object_len;
+		case J_BACKEND_TYPE_KV:
+			if (configuration->servers.placement == J_CONFIGURATION_PLACEMENT_RING)
+			{
+				return j_configuration_ring_get(&(configuration->servers.kv_ring), key);
+			}
+
+			return j_helper_hash(key) % configuration->servers.kv_len;
+		case J_BACKEND_TYPE_DB:
+		default:
+			g_assert_not_reached();
+	}
+
+	return 0;
+}
+
+JConfigurationPlacement
+j_configuration_get_placement(JConfiguration* configuration)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_val_if_fail(configuration != NULL, J_CONFIGURATION_PLACEMENT_MODULO);
+
+	return configuration->servers.placement;
+}
+
 gchar const*
 j_configuration_get_backend(JConfiguration* configuration, JBackendType backend)
 {
@@ -501,6 +902,56 @@ j_configuration_get_backend_path(JConfiguration* configuration, JBackendType bac
 	return NULL;
 }
 
+JConfigurationTransport
+j_configuration_get_transport(JConfiguration* configuration)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_val_if_fail(configuration != NULL, J_CONFIGURATION_TRANSPORT_TCP);
+
+	return configuration->network.transport;
+}
+
+gchar const*
+j_configuration_get_provider(JConfiguration* configuration)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_val_if_fail(configuration != NULL, NULL);
+
+	return configuration->network.provider;
+}
+
+JConfigurationCompression
+j_configuration_get_compression(JConfiguration* configuration)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_val_if_fail(configuration != NULL, J_CONFIGURATION_COMPRESSION_NONE);
+
+	return configuration->network.compression;
+}
+
+gboolean
+j_configuration_get_shared_memory(JConfiguration* configuration)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_val_if_fail(configuration != NULL, FALSE);
+
+	return configuration->network.shared_memory;
+}
+
+gchar const*
+j_configuration_get_socket(JConfiguration* configuration)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_val_if_fail(configuration != NULL, NULL);
+
+	return configuration->network.socket;
+}
+
 guint64
 j_configuration_get_max_operation_size(JConfiguration* configuration)
 {
@@ -541,6 +992,16 @@ j_configuration_get_stripe_size(JConfiguration* configuration)
 	return configuration->stripe_size;
 }
 
+gboolean
+j_configuration_get_multiplexing(JConfiguration* configuration)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_val_if_fail(configuration != NULL, FALSE);
+
+	return configuration->multiplexing;
+}
+
 guint16
 j_configuration_get_port(JConfiguration* configuration)
 {
@@ -32,6 +32,7 @@
 #include <jbackend.h>
 #include <jhelper.h>
 #include <jmessage.h>
+#include <jnetwork.h>
 #include <jtrace.h>
 
 /**
@@ -44,6 +45,11 @@ struct JConnectionPoolQueue
 {
 	GAsyncQueue* queue;
 	guint count;
+
+	/**
+	 * The connection shared by all threads if multiplexing is used.
+	 **/
+	JNetworkConnection* multiplexed;
 };
 
 typedef struct JConnectionPoolQueue JConnectionPoolQueue;
@@ -61,6 +67,16 @@ struct JConnectionPool
 	guint kv_len;
 	guint db_len;
 	guint max_count;
+
+	/**
+	 * Whether one multiplexed connection per server is used instead of the queues.
+	 **/
+	gboolean multiplexing;
+
+	/**
+	 * Protects establishing multiplexed connections.
+	 **/
+	GMutex mutex[1];
 };
 
 typedef struct JConnectionPool JConnectionPool;
@@ -85,23 +101,29 @@ j_connection_pool_init(JConfiguration* configuration)
 	pool->db_len = j_configuration_get_server_count(configuration, J_BACKEND_TYPE_DB);
 	pool->db_queues = g_new(JConnectionPoolQueue, pool->db_len);
 	pool->max_count = j_configuration_get_max_connections(configuration);
+	// Only TCP connections can be multiplexed
+	pool->multiplexing = j_configuration_get_multiplexing(configuration) && j_configuration_get_transport(configuration) == J_CONFIGURATION_TRANSPORT_TCP;
+	g_mutex_init(pool->mutex);
 
 	for (guint i = 0; i < pool->object_len; i++)
 	{
 		pool->object_queues[i].queue = g_async_queue_new();
 		pool->object_queues[i].count = 0;
+		pool->object_queues[i].multiplexed = NULL;
 	}
 
 	for (guint i = 0; i < pool->kv_len; i++)
 	{
 		pool->kv_queues[i].queue = g_async_queue_new();
 		pool->kv_queues[i].count = 0;
+		pool->kv_queues[i].multiplexed = NULL;
 	}
 
 	for (guint i = 0; i < pool->db_len; i++)
 	{
 		pool->db_queues[i].queue = g_async_queue_new();
 		pool->db_queues[i].count = 0;
+		pool->db_queues[i].multiplexed = NULL;
 	}
 
 	g_atomic_pointer_set(&j_connection_pool, pool);
@@ -121,12 +143,16 @@ j_connection_pool_fini(void)
 
 	for (guint i = 0; i < pool->object_len; i++)
 	{
-		GSocketConnection* connection;
+		JNetworkConnection* connection;
 
 		while ((connection = g_async_queue_try_pop(pool->object_queues[i].queue)) != NULL)
 		{
-			g_io_stream_close(G_IO_STREAM(connection), NULL, NULL);
-			g_object_unref(connection);
+			j_network_connection_fini(connection);
+		}
+
+		if (pool->object_queues[i].multiplexed != NULL)
+		{
+			j_network_connection_fini(pool->object_queues[i].multiplexed);
 		}
 
 		g_async_queue_unref(pool->object_queues[i].queue);
@@ -134,12 +160,16 @@ j_connection_pool_fini(void)
 
 	for (guint i = 0; i < pool->kv_len; i++)
 	{
-		GSocketConnection* connection;
+		JNetworkConnection* connection;
 
 		while ((connection = g_async_queue_try_pop(pool->kv_queues[i].queue)) != NULL)
 		{
-			g_io_stream_close(G_IO_STREAM(connection), NULL, NULL);
-			g_object_unref(connection);
+			j_network_connection_fini(connection);
+		}
+
+		if (pool->kv_queues[i].multiplexed != NULL)
+		{
+			j_network_connection_fini(pool->kv_queues[i].multiplexed);
 		}
 
 		g_async_queue_unref(pool->kv_queues[i].queue);
@@ -147,12 +177,16 @@ j_connection_pool_fini(void)
 
 	for (guint i = 0; i < pool->db_len; i++)
 	{
-		GSocketConnection* connection;
+		JNetworkConnection* connection;
 
 		while ((connection = g_async_queue_try_pop(pool->db_queues[i].queue)) != NULL)
 		{
-			g_io_stream_close(G_IO_STREAM(connection), NULL, NULL);
-			g_object_unref(connection);
+			j_network_connection_fini(connection);
+		}
+
+		if (pool->db_queues[i].multiplexed != NULL)
+		{
+			j_network_connection_fini(pool->db_queues[i].multiplexed);
 		}
 
 		g_async_queue_unref(pool->db_queues[i].queue);
@@ -164,93 +198,171 @@ j_connection_pool_fini(void)
 	g_free(pool->kv_queues);
 	g_free(pool->db_queues);
 
+	g_mutex_clear(pool->mutex);
+
 	g_free(pool);
 }
 
-static GSocketConnection*
-j_connection_pool_pop_internal(GAsyncQueue* queue, guint* count, gchar const* server)
+/**
+ * Establishes a new connection and checks whether the server uses the same configuration.
+ *
+ * \param backend_type The backend type.
+ * \param index        The server index.
+ * \param multiplexed  Whether the connection should be multiplexed.
+ *
+ * \return A new connection or NULL if the server can not be reached.
+ **/
+static JNetworkConnection*
+j_connection_pool_connect(JBackendType backend_type, guint32 index, gboolean multiplexed)
 {
 	J_TRACE_FUNCTION(NULL);
 
-	GSocketConnection* connection;
+	JNetworkConnection* connection;
 
-	g_return_val_if_fail(queue != NULL, NULL);
-	g_return_val_if_fail(count != NULL, NULL);
+	g_autoptr(JMessage) message = NULL;
+	g_autoptr(JMessage) reply = NULL;
 
-	connection = g_async_queue_try_pop(queue);
+	gchar const* client_checksum;
+	gchar const* server_checksum;
+	gchar const* server;
+	gchar multiplexed_flag;
+	gchar compression;
+	guint op_count;
 
-	if (connection != NULL)
+	server = j_configuration_get_server(j_connection_pool->configuration, backend_type, index);
+	connection = j_network_connection_init_client(j_connection_pool->configuration, backend_type, index);
+
+	if (connection == NULL)
 	{
-		return connection;
+		g_critical("Can not connect to %s.", server);
+		return NULL;
 	}
 
-	if ((guint)g_atomic_int_get(count) < j_connection_pool->max_count)
+	client_checksum = j_configuration_get_checksum(j_configuration());
+	multiplexed_flag = (multiplexed) ? 1 : 0;
+	compression = j_configuration_get_compression(j_connection_pool->configuration);
+
+	// The server has to know whether it may handle our messages concurrently and which codec we would like to use
+	message = j_message_new(J_MESSAGE_PING, strlen(client_checksum) + 1 + 1 + 1);
+	j_message_append_string(message, client_checksum);
+	j_message_append_1(message, &multiplexed_flag);
+	j_message_append_1(message, &compression);
+	j_message_send(message, connection);
+
+	reply = j_message_new_reply(message);
+	j_message_receive(reply, connection);
+
+	server_checksum = j_message_get_string(reply);
+	// The server falls back to no compression if it does not support the requested codec
+	compression = j_message_get_1(reply);
+
+	if (g_strcmp0(client_checksum, server_checksum) != 0)
 	{
-		if ((guint)g_atomic_int_add(count, 1) < j_connection_pool->max_count)
+		g_warning("Server %s uses different configuration than client.", server);
+	}
+
+	if (!j_network_connection_set_compression(connection, compression))
+	{
+		g_warning("Server %s requested unsupported compression.", server);
+	}
+
+	op_count = j_message_get_count(reply);
+
+	for (guint i = 0; i < op_count; i++)
+	{
+		gchar const* backend;
+
+		backend = j_message_get_string(reply);
+
+		if (g_strcmp0(backend, "object") == 0)
+		{
+			//g_print("Server has object backend.\n");
+		}
+		else if (g_strcmp0(backend, "kv") == 0)
+		{
+			//g_print("Server has kv backend.\n");
+		}
+		else if (g_strcmp0(backend, "db") == 0)
 		{
-			GError* error = NULL;
-			g_autoptr(GSocketClient) client = NULL;
+			//g_print("Server has db backend.\n");
+		}
+	}
 
-			g_autoptr(JMessage) message = NULL;
-			g_autoptr(JMessage) reply = NULL;
+	// Only enable multiplexing after the handshake, replies are matched to their messages from now on
+	j_network_connection_set_multiplexed(connection, multiplexed);
 
-			gchar const* client_checksum;
-			gchar const* server_checksum;
-			guint op_count;
+	return connection;
+}
 
-			client = g_socket_client_new();
-			connection = g_socket_client_connect_to_host(client, server, j_configuration_get_port(j_configuration()), NULL, &error);
+/**
+ * Returns the multiplexed connection of a queue, establishing it if necessary.
+ *
+ * \param pool_queue   A queue.
+ * \param backend_type The backend type.
+ * \param index        The server index.
+ *
+ * \return The multiplexed connection.
+ **/
+static JNetworkConnection*
+j_connection_pool_pop_multiplexed(JConnectionPoolQueue* pool_queue, JBackendType backend_type, guint32 index)
+{
+	J_TRACE_FUNCTION(NULL);
 
-			if (error != NULL)
-			{
-				g_critical("%s", error->message);
-				g_error_free(error);
-			}
+	JNetworkConnection* connection;
 
-			if (connection == NULL)
-			{
-				g_critical("Can not connect to %s [%d].", server, g_atomic_int_get(count));
-			}
+	connection = g_atomic_pointer_get(&(pool_queue->multiplexed));
 
-			j_helper_set_nodelay(connection, TRUE);
+	if (connection != NULL)
+	{
+		return connection;
+	}
 
-			client_checksum = j_configuration_get_checksum(j_configuration());
+	g_mutex_lock(j_connection_pool->mutex);
 
-			message = j_message_new(J_MESSAGE_PING, strlen(client_checksum) + 1);
-			j_message_append_string(message, client_checksum);
-			j_message_send(message, connection);
+	connection = pool_queue->multiplexed;
 
-			reply = j_message_new_reply(message);
-			j_message_receive(reply, connection);
+	if (connection == NULL)
+	{
+		connection = j_connection_pool_connect(backend_type, index, TRUE);
+		g_atomic_pointer_set(&(pool_queue->multiplexed), connection);
+	}
 
-			server_checksum = j_message_get_string(reply);
+	g_mutex_unlock(j_connection_pool->mutex);
 
-			if (g_strcmp0(client_checksum, server_checksum) != 0)
-			{
-				g_warning("Server %s uses different configuration than client.", server);
-			}
+	return connection;
+}
 
-			op_count = j_message_get_count(reply);
+static JNetworkConnection*
+j_connection_pool_pop_internal(JConnectionPoolQueue* pool_queue, JBackendType backend_type, guint32 index)
+{
+	J_TRACE_FUNCTION(NULL);
 
-			for (guint i = 0; i < op_count; i++)
-			{
-				gchar const* backend;
+	JNetworkConnection* connection;
+	GAsyncQueue* queue;
+	guint* count;
+
+	g_return_val_if_fail(pool_queue != NULL, NULL);
+
+	if (j_connection_pool->multiplexing)
+	{
+		return j_connection_pool_pop_multiplexed(pool_queue, backend_type, index);
+	}
 
-				backend = j_message_get_string(reply);
+	queue = pool_queue->queue;
+	count = &(pool_queue->count);
 
-				if (g_strcmp0(backend, "object") == 0)
-				{
-					//g_print("Server has object backend.\n");
-				}
-				else if (g_strcmp0(backend, "kv") == 0)
-				{
-					//g_print("Server has kv backend.\n");
-				}
-				else if (g_strcmp0(backend, "db") == 0)
-				{
-					//g_print("Server has db backend.\n");
-				}
-			}
+	connection = g_async_queue_try_pop(queue);
+
+	if (connection != NULL)
+	{
+		return connection;
+	}
+
+	if ((guint)g_atomic_int_get(count) < j_connection_pool->max_count)
+	{
+		if ((guint)g_atomic_int_add(count, 1) < j_connection_pool->max_count)
+		{
+			connection = j_connection_pool_connect(backend_type, index, FALSE);
 		}
 		else
 		{
@@ -269,17 +381,24 @@ j_connection_pool_pop_internal(GAsyncQueue* queue, guint* count, gchar const* se
 }
 
 static void
-j_connection_pool_push_internal(GAsyncQueue* queue, GSocketConnection* connection)
+j_connection_pool_push_internal(JConnectionPoolQueue* pool_queue, JNetworkConnection* connection)
 {
 	J_TRACE_FUNCTION(NULL);
 
-	g_return_if_fail(queue != NULL);
+	g_return_if_fail(pool_queue != NULL);
 	g_return_if_fail(connection != NULL);
 
-	g_async_queue_push(queue, connection);
+	if (j_connection_pool->multiplexing)
+	{
+		// Allow other threads to receive their replies
+		j_network_connection_release_recv(connection);
+		return;
+	}
+
+	g_async_queue_push(pool_queue->queue, connection);
 }
 
-gpointer
+JNetworkConnection*
 j_connection_pool_pop(JBackendType backend, guint32 index)
 {
 	J_TRACE_FUNCTION(NULL);
@@ -290,13 +409,13 @@ j_connection_pool_pop(JBackendType backend, guint32 index)
 	{
 		case J_BACKEND_TYPE_OBJECT:
 			g_return_val_if_fail(index < j_connection_pool->object_len, NULL);
-			return j_connection_pool_pop_internal(j_connection_pool->object_queues[index].queue, &(j_connection_pool->object_queues[index].count), j_configuration_get_server(j_connection_pool->configuration, J_BACKEND_TYPE_OBJECT, index));
+			return j_connection_pool_pop_internal(&(j_connection_pool->object_queues[index]), J_BACKEND_TYPE_OBJECT, index);
 		case J_BACKEND_TYPE_KV:
 			g_return_val_if_fail(index < j_connection_pool->kv_len, NULL);
-			return j_connection_pool_pop_internal(j_connection_pool->kv_queues[index].queue, &(j_connection_pool->kv_queues[index].count), j_configuration_get_server(j_connection_pool->configuration, J_BACKEND_TYPE_KV, index));
+			return j_connection_pool_pop_internal(&(j_connection_pool->kv_queues[index]), J_BACKEND_TYPE_KV, index);
 		case J_BACKEND_TYPE_DB:
 			g_return_val_if_fail(index < j_connection_pool->db_len, NULL);
-			return j_connection_pool_pop_internal(j_connection_pool->db_queues[index].queue, &(j_connection_pool->db_queues[index].count), j_configuration_get_server(j_connection_pool->configuration, J_BACKEND_TYPE_DB, index));
+			return j_connection_pool_pop_internal(&(j_connection_pool->db_queues[index]), J_BACKEND_TYPE_DB, index);
 		default:
 			g_assert_not_reached();
 	}
@@ -305,7 +424,7 @@ j_connection_pool_pop(JBackendType backend, guint32 index)
 }
 
 void
-j_connection_pool_push(JBackendType backend, guint32 index, gpointer connection)
+j_connection_pool_push(JBackendType backend, guint32 index, JNetworkConnection* connection)
 {
 	J_TRACE_FUNCTION(NULL);
 
@@ -316,15 +435,15 @@ j_connection_pool_push(JBackendType backend, guint32 index, gpointer connection)
 	{
 		case J_BACKEND_TYPE_OBJECT:
 			g_return_if_fail(index < j_connection_pool->object_len);
-			j_connection_pool_push_internal(j_connection_pool->object_queues[index].queue, connection);
+			j_connection_pool_push_internal(&(j_connection_pool->object_queues[index]), connection);
 			break;
 		case J_BACKEND_TYPE_KV:
 			g_return_if_fail(index < j_connection_pool->kv_len);
-			j_connection_pool_push_internal(j_connection_pool->kv_queues[index].queue, connection);
+			j_connection_pool_push_internal(&(j_connection_pool->kv_queues[index]), connection);
 			break;
 		case J_BACKEND_TYPE_DB:
 			g_return_if_fail(index < j_connection_pool->db_len);
-			j_connection_pool_push_internal(j_connection_pool->db_queues[index].queue, connection);
+			j_connection_pool_push_internal(&(j_connection_pool->db_queues[index]), connection);
 			break;
 		default:
 			g_assert_not_reached();
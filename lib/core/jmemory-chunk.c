@@ -28,6 +28,8 @@
 
 #include <jmemory-chunk.h>
 
+#include <jhelper.h>
+
 #include <jtrace.h>
 
 /**
@@ -55,6 +57,11 @@ struct JMemoryChunk
 	* The current position within #data.
 	*/
 	gchar* current;
+
+	/**
+	* The alignment of segments, see j_memory_chunk_new_aligned().
+	*/
+	gsize alignment;
 };
 
 JMemoryChunk*
@@ -70,6 +77,27 @@ j_memory_chunk_new(guint64 size)
 	cache->size = size;
 	cache->data = g_malloc(cache->size);
 	cache->current = cache->data;
+	cache->alignment = 1;
+
+	return cache;
+}
+
+JMemoryChunk*
+j_memory_chunk_new_aligned(guint64 size, gsize alignment)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JMemoryChunk* cache;
+
+	g_return_val_if_fail(size > 0, NULL);
+	g_return_val_if_fail(alignment > 0 && (alignment & (alignment - 1)) == 0, NULL);
+
+	cache = g_new(JMemoryChunk, 1);
+	cache->size = size;
+	// aligned_alloc() requires the size to be a multiple of the alignment
+	cache->data = j_helper_alloc_aligned(alignment, (size + alignment - 1) & ~((guint64)alignment - 1));
+	cache->current = cache->data;
+	cache->alignment = alignment;
 
 	return cache;
 }
@@ -98,6 +126,20 @@ j_memory_chunk_get(JMemoryChunk* cache, guint64 length)
 
 	g_return_val_if_fail(cache != NULL, NULL);
 
+	// Small segments are not aligned to avoid wasting space
+	if (cache->alignment > 1 && length >= cache->alignment)
+	{
+		guintptr current = (guintptr)cache->current;
+		guintptr aligned = (current + cache->alignment - 1) & ~((guintptr)cache->alignment - 1);
+
+		if (aligned + length > (guintptr)(cache->data + cache->size))
+		{
+			return NULL;
+		}
+
+		cache->current = (gchar*)aligned;
+	}
+
 	if (cache->current + length > cache->data + cache->size)
 	{
 		return NULL;
@@ -25,14 +25,14 @@
 #include <glib.h>
 #include <gio/gio.h>
 
+#include <limits.h>
 #include <math.h>
 #include <string.h>
 
 #include <jmessage.h>
 
+#include <jcompression.h>
 #include <jhelper.h>
-#include <jlist.h>
-#include <jlist-iterator.h>
 #include <jsemantics.h>
 #include <jtrace.h>
 
@@ -42,6 +42,38 @@
  * @{
  **/
 
+/**
+ * Number of send entries stored inside the message, see j_message_add_send().
+ **/
+#define J_MESSAGE_SEND_INLINE 4
+
+/**
+ * Number of vectors j_message_write() can gather without allocating memory.
+ **/
+#define J_MESSAGE_VECTORS_INLINE 16
+
+/**
+ * Pooled message buffers are grouped into size classes.
+ * The classes' sizes are powers of two from 2^J_MESSAGE_POOL_SHIFT_MIN to 2^J_MESSAGE_POOL_SHIFT_MAX.
+ **/
+#define J_MESSAGE_POOL_SHIFT_MIN 8
+#define J_MESSAGE_POOL_SHIFT_MAX 16
+#define J_MESSAGE_POOL_CLASSES (J_MESSAGE_POOL_SHIFT_MAX - J_MESSAGE_POOL_SHIFT_MIN + 1)
+
+/**
+ * Maximum number of messages kept per size class and thread.
+ **/
+#define J_MESSAGE_POOL_CLASS_LEN 16
+
+/**
+ * Maximum number of vectors written at once by j_message_write().
+ **/
+#ifdef IOV_MAX
+#define J_MESSAGE_VECTORS_MAX IOV_MAX
+#else
+#define J_MESSAGE_VECTORS_MAX 1024
+#endif
+
 enum JMessageSemantics
 {
 	J_MESSAGE_SEMANTICS_ATOMICITY_BATCH = 1 << 0,
@@ -59,6 +91,17 @@ enum JMessageSemantics
 
 typedef enum JMessageSemantics JMessageSemantics;
 
+enum JMessageFlags
+{
+	/**
+	 * The body has been compressed using the connection's codec.
+	 * It starts with the uncompressed length, followed by the compressed data.
+	 **/
+	J_MESSAGE_FLAGS_COMPRESSED = 1 << 0
+};
+
+typedef enum JMessageFlags JMessageFlags;
+
 /**
  * Additional message data.
  **/
@@ -108,13 +151,18 @@ struct JMessageHeader
 	 * The operation count.
 	 **/
 	guint32 op_count;
+
+	/**
+	 * The flags, see JMessageFlags.
+	 **/
+	guint32 flags;
 };
 
 #pragma pack()
 
 typedef struct JMessageHeader JMessageHeader;
 
-G_STATIC_ASSERT(sizeof(JMessageHeader) == 5 * sizeof(guint32));
+G_STATIC_ASSERT(sizeof(JMessageHeader) == 6 * sizeof(guint32));
 
 /**
  * A message.
@@ -142,10 +190,13 @@ struct JMessage
 	gchar* current;
 
 	/**
-	 * The list of additional data to send in j_message_write().
-	 * Contains JMessageData elements.
+	 * The additional data to send in j_message_write().
+	 * Points to #send_inline until more than J_MESSAGE_SEND_INLINE entries are added.
 	 **/
-	JList* send_list;
+	JMessageData* send;
+	guint send_len;
+	guint send_size;
+	JMessageData send_inline[J_MESSAGE_SEND_INLINE];
 
 	/**
 	 * The original message.
@@ -183,12 +234,180 @@ j_message_length(JMessage const* message)
 	return GUINT32_FROM_LE(length);
 }
 
+/**
+ * A per-thread pool of unused messages.
+ * Messages are returned to the pool of the thread that releases them.
+ **/
+struct JMessagePool
+{
+	/**
+	 * The unused messages, grouped by the size of their buffers.
+	 **/
+	JMessage* messages[J_MESSAGE_POOL_CLASSES][J_MESSAGE_POOL_CLASS_LEN];
+	guint messages_len[J_MESSAGE_POOL_CLASSES];
+
+	/**
+	 * The number of allocations performed for messages, see j_message_get_allocations().
+	 **/
+	guint64 allocations;
+};
+
+typedef struct JMessagePool JMessagePool;
+
+static void j_message_pool_free(gpointer);
+
+static GPrivate j_message_pool = G_PRIVATE_INIT(j_message_pool_free);
+
+/**
+ * The next message ID.
+ * IDs only have to be unique among a process' outstanding messages, see j_network_connection_acquire_recv().
+ **/
+static gint j_message_next_id = 0;
+
+static void
+j_message_free_internal(JMessage* message)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	if (message->send != message->send_inline)
+	{
+		g_free(message->send);
+	}
+
+	g_free(message->data);
+	g_free(message);
+}
+
+static void
+j_message_pool_free(gpointer data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JMessagePool* pool = data;
+
+	for (guint i = 0; i < J_MESSAGE_POOL_CLASSES; i++)
+	{
+		for (guint j = 0; j < pool->messages_len[i]; j++)
+		{
+			j_message_free_internal(pool->messages[i][j]);
+		}
+	}
+
+	g_free(pool);
+}
+
+static JMessagePool*
+j_message_pool_get(void)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JMessagePool* pool;
+
+	pool = g_private_get(&j_message_pool);
+
+	if (G_UNLIKELY(pool == NULL))
+	{
+		pool = g_new0(JMessagePool, 1);
+		g_private_set(&j_message_pool, pool);
+	}
+
+	return pool;
+}
+
+/**
+ * Returns a message with a buffer of at least the given length.
+ * Messages are taken from the calling thread's pool if possible.
+ *
+ * \private
+ *
+ * \param length A length.
+ *
+ * \return A message with uninitialized header.
+ **/
+static JMessage*
+j_message_alloc(gsize length)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JMessagePool* pool;
+	JMessage* message = NULL;
+	guint size_class;
+
+	pool = j_message_pool_get();
+
+	// Round up to the next size class
+	size_class = MAX(g_bit_storage(length - 1), J_MESSAGE_POOL_SHIFT_MIN) - J_MESSAGE_POOL_SHIFT_MIN;
+
+	if (size_class < J_MESSAGE_POOL_CLASSES)
+	{
+		length = (gsize)1 << (size_class + J_MESSAGE_POOL_SHIFT_MIN);
+
+		if (pool->messages_len[size_class] > 0)
+		{
+			pool->messages_len[size_class]--;
+			message = pool->messages[size_class][pool->messages_len[size_class]];
+		}
+	}
+
+	if (message == NULL)
+	{
+		message = g_new(JMessage, 1);
+		message->size = length;
+		message->data = g_malloc(message->size);
+		pool->allocations += 2;
+	}
+
+	message->current = message->data;
+	message->send = message->send_inline;
+	message->send_len = 0;
+	message->send_size = J_MESSAGE_SEND_INLINE;
+	message->original_message = NULL;
+	message->ref_count = 1;
+
+	return message;
+}
+
+/**
+ * Returns an unused message to the calling thread's pool or frees it if the pool is full.
+ *
+ * \private
+ *
+ * \param message A message.
+ **/
 static void
-j_message_data_free(gpointer data)
+j_message_release(JMessage* message)
 {
 	J_TRACE_FUNCTION(NULL);
 
-	g_free(data);
+	JMessagePool* pool;
+	guint size_class;
+
+	// Round down to the previous size class, the buffer might have grown in between
+	size_class = g_bit_storage(message->size) - 1 - J_MESSAGE_POOL_SHIFT_MIN;
+
+	if (message->size < ((gsize)1 << J_MESSAGE_POOL_SHIFT_MIN) || size_class >= J_MESSAGE_POOL_CLASSES)
+	{
+		j_message_free_internal(message);
+		return;
+	}
+
+	pool = j_message_pool_get();
+
+	if (pool->messages_len[size_class] == J_MESSAGE_POOL_CLASS_LEN)
+	{
+		j_message_free_internal(message);
+		return;
+	}
+
+	// Do not keep large send arrays around
+	if (message->send != message->send_inline)
+	{
+		g_free(message->send);
+		message->send = message->send_inline;
+	}
+
+	pool->messages[size_class][pool->messages_len[size_class]] = message;
+	pool->messages_len[size_class]++;
 }
 
 /**
@@ -267,6 +486,8 @@ j_message_extend(JMessage* message, gsize length)
 	position = message->current - message->data;
 	message->data = g_realloc(message->data, message->size);
 	message->current = message->data + position;
+
+	j_message_pool_get()->allocations++;
 }
 
 static void
@@ -286,6 +507,8 @@ j_message_ensure_size(JMessage* message, gsize length)
 	position = message->current - message->data;
 	message->data = g_realloc(message->data, message->size);
 	message->current = message->data + position;
+
+	j_message_pool_get()->allocations++;
 }
 
 JMessage*
@@ -294,26 +517,21 @@ j_message_new(JMessageType op_type, gsize length)
 	J_TRACE_FUNCTION(NULL);
 
 	JMessage* message;
-	guint32 rand;
+	guint32 id;
 
 	//g_return_val_if_fail(op_type != J_MESSAGE_NONE, NULL);
 
 	length = MAX(256, length);
-	rand = g_random_int();
+	id = (guint32)g_atomic_int_add(&j_message_next_id, 1);
 
-	message = g_new(JMessage, 1);
-	message->size = length;
-	message->data = g_malloc(message->size);
-	message->current = message->data;
-	message->send_list = j_list_new(j_message_data_free);
-	message->original_message = NULL;
-	message->ref_count = 1;
+	message = j_message_alloc(length);
 
 	message->header.length = GUINT32_TO_LE(0);
-	message->header.id = GUINT32_TO_LE(rand);
+	message->header.id = GUINT32_TO_LE(id);
 	message->header.semantics = GUINT32_TO_LE(0);
 	message->header.op_type = GUINT32_TO_LE(op_type);
 	message->header.op_count = GUINT32_TO_LE(0);
+	message->header.flags = GUINT32_TO_LE(0);
 
 	return message;
 }
@@ -327,19 +545,15 @@ j_message_new_reply(JMessage* message)
 
 	g_return_val_if_fail(message != NULL, NULL);
 
-	reply = g_new(JMessage, 1);
-	reply->size = 256;
-	reply->data = g_malloc(reply->size);
-	reply->current = reply->data;
-	reply->send_list = j_list_new(j_message_data_free);
+	reply = j_message_alloc(256);
 	reply->original_message = j_message_ref(message);
-	reply->ref_count = 1;
 
 	reply->header.length = GUINT32_TO_LE(0);
 	reply->header.id = message->header.id;
 	reply->header.semantics = GUINT32_TO_LE(0);
 	reply->header.op_type = message->header.op_type;
 	reply->header.op_count = GUINT32_TO_LE(0);
+	reply->header.flags = GUINT32_TO_LE(0);
 
 	return reply;
 }
@@ -370,14 +584,7 @@ j_message_unref(JMessage* message)
 			j_message_unref(message->original_message);
 		}
 
-		if (message->send_list != NULL)
-		{
-			j_list_unref(message->send_list);
-		}
-
-		g_free(message->data);
-
-		g_free(message);
+		j_message_release(message);
 	}
 }
 
@@ -396,6 +603,24 @@ j_message_get_type(JMessage const* message)
 	return op_type;
 }
 
+guint64
+j_message_get_allocations(void)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	return j_message_pool_get()->allocations;
+}
+
+guint32
+j_message_get_id(JMessage const* message)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_val_if_fail(message != NULL, 0);
+
+	return GUINT32_FROM_LE(message->header.id);
+}
+
 guint32
 j_message_get_count(JMessage const* message)
 {
@@ -587,40 +812,274 @@ j_message_get_string(JMessage* message)
 	return ret;
 }
 
-gboolean
-j_message_receive(JMessage* message, gpointer connection)
+/**
+ * Receives the header of a reply from a multiplexed connection.
+ * Headers belonging to other replies are passed on to the threads waiting for them.
+ *
+ * \param message    A reply.
+ * \param connection A multiplexed connection.
+ *
+ * \return TRUE on success, FALSE if an error occurred.
+ **/
+static gboolean
+j_message_receive_header_multiplexed(JMessage* message, JNetworkConnection* connection)
 {
 	J_TRACE_FUNCTION(NULL);
 
-	GInputStream* stream;
+	guint32 id;
+
+	id = message->original_message->header.id;
+
+	while (TRUE)
+	{
+		JMessageHeader* header;
+
+		if (!j_network_connection_acquire_recv(connection, id, (gpointer*)&header))
+		{
+			return FALSE;
+		}
+
+		if (header != NULL)
+		{
+			message->header = *header;
+			g_free(header);
+
+			return TRUE;
+		}
+
+		if (!j_network_connection_recv_all(connection, sizeof(JMessageHeader), &(message->header)))
+		{
+			j_network_connection_release_recv(connection);
+			return FALSE;
+		}
+
+		if (message->header.id == id)
+		{
+			return TRUE;
+		}
+
+		header = g_new(JMessageHeader, 1);
+		*header = message->header;
+
+		j_network_connection_handoff_recv(connection, header->id, header);
+	}
+}
+
+/**
+ * Receives and decompresses a message's compressed body.
+ * The header is adjusted to describe the uncompressed body.
+ *
+ * \private
+ *
+ * \param message    A message whose header has already been received.
+ * \param connection A connection.
+ *
+ * \return TRUE on success, FALSE if an error occurred.
+ **/
+static gboolean
+j_message_receive_compressed(JMessage* message, JNetworkConnection* connection)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JConfigurationCompression compression;
+	gchar* compressed;
+	gsize compressed_length;
+	guint32 length;
+
+	compression = j_network_connection_get_compression(connection);
+	compressed_length = j_message_length(message);
+
+	if (compression == J_CONFIGURATION_COMPRESSION_NONE || compressed_length < sizeof(length))
+	{
+		return FALSE;
+	}
+
+	compressed = j_compression_get_buffer(compressed_length);
+
+	if (!j_network_connection_recv_all(connection, compressed_length, compressed))
+	{
+		return FALSE;
+	}
+
+	memcpy(&length, compressed, sizeof(length));
+	message->header.length = length;
+	message->header.flags = GUINT32_TO_LE(GUINT32_FROM_LE(message->header.flags) & ~J_MESSAGE_FLAGS_COMPRESSED);
+
+	j_message_ensure_size(message, j_message_length(message));
+
+	return j_compression_decompress(compression, compressed + sizeof(length), compressed_length - sizeof(length), message->data, j_message_length(message));
+}
+
+gboolean
+j_message_receive(JMessage* message, JNetworkConnection* connection)
+{
+	J_TRACE_FUNCTION(NULL);
 
 	g_return_val_if_fail(message != NULL, FALSE);
 	g_return_val_if_fail(connection != NULL, FALSE);
 
-	stream = g_io_stream_get_input_stream(G_IO_STREAM(connection));
-	return j_message_read(message, stream);
+	if (message->original_message != NULL && j_network_connection_get_multiplexed(connection))
+	{
+		if (!j_message_receive_header_multiplexed(message, connection))
+		{
+			return FALSE;
+		}
+	}
+	// TCP connections are buffered, so header and body are usually read using a single system call
+	else if (!j_network_connection_recv_all(connection, sizeof(JMessageHeader), &(message->header)))
+	{
+		return FALSE;
+	}
+
+	if (GUINT32_FROM_LE(message->header.flags) & J_MESSAGE_FLAGS_COMPRESSED)
+	{
+		if (!j_message_receive_compressed(message, connection))
+		{
+			return FALSE;
+		}
+	}
+	else
+	{
+		j_message_ensure_size(message, j_message_length(message));
+
+		if (!j_network_connection_recv_all(connection, j_message_length(message), message->data))
+		{
+			return FALSE;
+		}
+	}
+
+	message->current = message->data;
+
+	if (message->original_message != NULL)
+	{
+		g_assert(message->header.id == message->original_message->header.id);
+	}
+
+	return TRUE;
+}
+
+gboolean
+j_message_poll(JNetworkConnection* connection, gboolean readable, gboolean* complete)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JMessageHeader header;
+	gboolean buffered;
+
+	g_return_val_if_fail(connection != NULL, FALSE);
+	g_return_val_if_fail(complete != NULL, FALSE);
+
+	// The body's length is only known once the header has been buffered
+	if (!j_network_connection_peek(connection, sizeof(JMessageHeader), &header))
+	{
+		if (!j_network_connection_buffer(connection, sizeof(JMessageHeader), readable, &buffered))
+		{
+			return FALSE;
+		}
+
+		if (!buffered || !j_network_connection_peek(connection, sizeof(JMessageHeader), &header))
+		{
+			*complete = FALSE;
+			return TRUE;
+		}
+
+		// The socket has already been read from and might not be readable anymore
+		readable = FALSE;
+	}
+
+	// Compressed messages also specify the length of their body
+	return j_network_connection_buffer(connection, sizeof(JMessageHeader) + GUINT32_FROM_LE(header.length), readable, complete);
 }
 
+static gboolean j_message_write_internal(JMessage*, GOutputStream*, JConfigurationCompression);
+
 gboolean
-j_message_send(JMessage* message, gpointer connection)
+j_message_send(JMessage* message, JNetworkConnection* connection)
 {
 	J_TRACE_FUNCTION(NULL);
 
 	gboolean ret;
 
-	GOutputStream* stream;
+	GSocketConnection* socket_connection;
 
 	g_return_val_if_fail(message != NULL, FALSE);
 	g_return_val_if_fail(connection != NULL, FALSE);
 
-	j_helper_set_cork(connection, TRUE);
+	socket_connection = j_network_connection_get_socket_connection(connection);
+
+	if (socket_connection != NULL)
+	{
+		// j_message_write() gathers the whole message, so corking the socket is not necessary
+		j_network_connection_lock_send(connection);
+		ret = j_message_write_internal(message, g_io_stream_get_output_stream(G_IO_STREAM(socket_connection)), j_network_connection_get_compression(connection));
+		j_network_connection_unlock_send(connection);
 
-	stream = g_io_stream_get_output_stream(G_IO_STREAM(connection));
-	ret = j_message_write(message, stream);
+		return ret;
+	}
 
-	j_helper_set_cork(connection, FALSE);
+	if (!j_network_connection_send_all(connection, &(message->header), sizeof(JMessageHeader))
+	    || !j_network_connection_send_all(connection, message->data, j_message_length(message)))
+	{
+		return FALSE;
+	}
 
-	return ret;
+	if (message->send_len > 0)
+	{
+		g_autoptr(GArray) memory = NULL;
+
+		ret = TRUE;
+		memory = g_array_new(FALSE, FALSE, sizeof(JNetworkConnectionMemory));
+
+		for (guint i = 0; i < message->send_len; i++)
+		{
+			JMessageData* message_data = &(message->send[i]);
+
+			if (j_network_connection_use_rma(connection, message_data->length))
+			{
+				JNetworkConnectionMemory memory_region;
+				JNetworkConnectionMemoryID memory_id;
+
+				// Only send the memory ID, the receiver reads the data directly from our buffer
+				if (!j_network_connection_rma_register(connection, message_data->data, message_data->length, &memory_region))
+				{
+					ret = FALSE;
+					break;
+				}
+
+				g_array_append_val(memory, memory_region);
+
+				j_network_connection_memory_get_id(&memory_region, &memory_id);
+
+				if (!j_network_connection_send_all(connection, &memory_id, sizeof(memory_id)))
+				{
+					ret = FALSE;
+					break;
+				}
+			}
+			else if (!j_network_connection_send_all(connection, message_data->data, message_data->length))
+			{
+				ret = FALSE;
+				break;
+			}
+		}
+
+		// Each RMA read is acknowledged by the receiver, see j_network_connection_recv_bulk()
+		for (guint i = 0; i < memory->len; i++)
+		{
+			JNetworkConnectionAck ack;
+
+			if (ret && (!j_network_connection_recv_all(connection, sizeof(ack), &ack) || ack != J_NETWORK_CONNECTION_ACK))
+			{
+				ret = FALSE;
+			}
+
+			j_network_connection_rma_unregister(connection, &g_array_index(memory, JNetworkConnectionMemory, i));
+		}
+
+		return ret;
+	}
+
+	return TRUE;
 }
 
 gboolean
@@ -667,43 +1126,180 @@ end:
 	return ret;
 }
 
-gboolean
-j_message_write(JMessage* message, GOutputStream* stream)
+/**
+ * Writes a batch of vectors to a stream.
+ *
+ * \param stream      An output stream.
+ * \param vectors     The vectors.
+ * \param vectors_len The number of vectors.
+ * \param error       A GError.
+ *
+ * \return TRUE on success, FALSE otherwise.
+ **/
+static gboolean
+j_message_write_vectors(GOutputStream* stream, GOutputVector* vectors, gsize vectors_len, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gsize bytes_written;
+
+	return g_output_stream_writev_all(stream, vectors, vectors_len, &bytes_written, NULL, error);
+}
+
+/**
+ * Compresses and writes data block by block, see j_network_connection_recv_bulk().
+ *
+ * \param stream      An output stream.
+ * \param compression A codec.
+ * \param data        The data.
+ * \param length      The data length.
+ * \param error       A GError.
+ *
+ * \return TRUE on success, FALSE otherwise.
+ **/
+static gboolean
+j_message_write_compressed(GOutputStream* stream, JConfigurationCompression compression, gconstpointer data, guint64 length, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gchar const* position = data;
+
+	while (length > 0)
+	{
+		GOutputVector vectors[2];
+		gsize block_length = MIN(length, J_COMPRESSION_BLOCK_SIZE);
+		gsize compressed_bound;
+		gsize compressed_length;
+		gpointer compressed;
+		guint32 prefix;
+
+		compressed_bound = j_compression_bound(compression, block_length);
+		compressed = j_compression_get_buffer(compressed_bound);
+		compressed_length = j_compression_compress(compression, position, block_length, compressed, compressed_bound);
+
+		// A length of 0 marks uncompressed blocks
+		prefix = GUINT32_TO_LE(compressed_length);
+
+		vectors[0].buffer = &prefix;
+		vectors[0].size = sizeof(prefix);
+		vectors[1].buffer = (compressed_length > 0) ? compressed : position;
+		vectors[1].size = (compressed_length > 0) ? compressed_length : block_length;
+
+		if (!j_message_write_vectors(stream, vectors, 2, error))
+		{
+			return FALSE;
+		}
+
+		position += block_length;
+		length -= block_length;
+	}
+
+	return TRUE;
+}
+
+/**
+ * Writes a message to a stream, compressing large bodies and data if requested.
+ *
+ * \param message     A message.
+ * \param stream      An output stream.
+ * \param compression A codec.
+ *
+ * \return TRUE on success, FALSE otherwise.
+ **/
+static gboolean
+j_message_write_internal(JMessage* message, GOutputStream* stream, JConfigurationCompression compression)
 {
 	J_TRACE_FUNCTION(NULL);
 
 	gboolean ret = FALSE;
 
-	g_autoptr(JListIterator) iterator = NULL;
+	GOutputVector vectors_inline[J_MESSAGE_VECTORS_INLINE];
+	g_autofree GOutputVector* vectors_heap = NULL;
+	GOutputVector* vectors = vectors_inline;
 	GError* error = NULL;
-	gsize bytes_written;
+	JMessageHeader header;
+	gsize vectors_len = 0;
+	gsize vectors_max;
 
 	g_return_val_if_fail(message != NULL, FALSE);
 	g_return_val_if_fail(stream != NULL, FALSE);
 
-	if (!g_output_stream_write_all(stream, &(message->header), sizeof(JMessageHeader), &bytes_written, NULL, &error) || bytes_written != sizeof(JMessageHeader))
+	vectors_max = MIN(2 + message->send_len, J_MESSAGE_VECTORS_MAX);
+
+	if (vectors_max > J_MESSAGE_VECTORS_INLINE)
 	{
-		goto end;
+		vectors_heap = g_new(GOutputVector, vectors_max);
+		vectors = vectors_heap;
 	}
 
-	if (!g_output_stream_write_all(stream, message->data, j_message_length(message), &bytes_written, NULL, &error) || bytes_written != j_message_length(message))
+	// The message itself is not modified, so it can be sent again
+	header = message->header;
+
+	vectors[vectors_len].buffer = &header;
+	vectors[vectors_len].size = sizeof(JMessageHeader);
+	vectors_len++;
+
+	vectors[vectors_len].buffer = message->data;
+	vectors[vectors_len].size = j_message_length(message);
+
+	if (compression != J_CONFIGURATION_COMPRESSION_NONE && j_message_length(message) >= J_COMPRESSION_THRESHOLD)
 	{
-		goto end;
+		gchar* compressed;
+		gsize compressed_bound;
+		gsize compressed_length;
+
+		compressed_bound = j_compression_bound(compression, j_message_length(message));
+		compressed = j_compression_get_buffer(sizeof(guint32) + compressed_bound);
+		compressed_length = j_compression_compress(compression, message->data, j_message_length(message), compressed + sizeof(guint32), compressed_bound);
+
+		if (compressed_length > 0)
+		{
+			memcpy(compressed, &(message->header.length), sizeof(guint32));
+			header.length = GUINT32_TO_LE(sizeof(guint32) + compressed_length);
+			header.flags = GUINT32_TO_LE(GUINT32_FROM_LE(header.flags) | J_MESSAGE_FLAGS_COMPRESSED);
+
+			vectors[vectors_len].buffer = compressed;
+			vectors[vectors_len].size = sizeof(guint32) + compressed_length;
+		}
 	}
 
-	if (message->send_list != NULL)
+	vectors_len++;
+
+	for (guint i = 0; i < message->send_len; i++)
 	{
-		iterator = j_list_iterator_new(message->send_list);
+		gboolean compress;
+
+		compress = (compression != J_CONFIGURATION_COMPRESSION_NONE && message->send[i].length >= J_COMPRESSION_THRESHOLD);
 
-		while (j_list_iterator_next(iterator))
+		// Compressed data is written directly, the vectors might refer to the temporary compression buffer
+		if (vectors_len == vectors_max || (compress && vectors_len > 0))
 		{
-			JMessageData* message_data = j_list_iterator_get(iterator);
+			if (!j_message_write_vectors(stream, vectors, vectors_len, &error))
+			{
+				goto end;
+			}
 
-			if (!g_output_stream_write_all(stream, message_data->data, message_data->length, &bytes_written, NULL, &error))
+			vectors_len = 0;
+		}
+
+		if (compress)
+		{
+			if (!j_message_write_compressed(stream, compression, message->send[i].data, message->send[i].length, &error))
 			{
 				goto end;
 			}
+
+			continue;
 		}
+
+		vectors[vectors_len].buffer = message->send[i].data;
+		vectors[vectors_len].size = message->send[i].length;
+		vectors_len++;
+	}
+
+	if (vectors_len > 0 && !j_message_write_vectors(stream, vectors, vectors_len, &error))
+	{
+		goto end;
 	}
 
 	g_output_stream_flush(stream, NULL, NULL);
@@ -720,22 +1316,43 @@ end:
 	return ret;
 }
 
+gboolean
+j_message_write(JMessage* message, GOutputStream* stream)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	return j_message_write_internal(message, stream, J_CONFIGURATION_COMPRESSION_NONE);
+}
+
 void
 j_message_add_send(JMessage* message, gconstpointer data, guint64 length)
 {
 	J_TRACE_FUNCTION(NULL);
 
-	JMessageData* message_data;
-
 	g_return_if_fail(message != NULL);
 	g_return_if_fail(data != NULL);
 	g_return_if_fail(length > 0);
 
-	message_data = g_new(JMessageData, 1);
-	message_data->data = data;
-	message_data->length = length;
+	if (G_UNLIKELY(message->send_len == message->send_size))
+	{
+		message->send_size *= 2;
+
+		if (message->send == message->send_inline)
+		{
+			message->send = g_new(JMessageData, message->send_size);
+			memcpy(message->send, message->send_inline, sizeof(message->send_inline));
+		}
+		else
+		{
+			message->send = g_renew(JMessageData, message->send, message->send_size);
+		}
+
+		j_message_pool_get()->allocations++;
+	}
 
-	j_list_append(message->send_list, message_data);
+	message->send[message->send_len].data = data;
+	message->send[message->send_len].length = length;
+	message->send_len++;
 }
 
 void
@@ -26,15 +26,21 @@
 
 #include <glib.h>
 #include <gio/gio.h>
+#include <gio/gunixsocketaddress.h>
 
 #include <rdma/fi_endpoint.h>
 #include <rdma/fi_rma.h>
 #include <rdma/fi_cm.h>
 
 #include <netinet/in.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
 
 #include <jnetwork.h>
 
+#include <jcompression.h>
 #include <jconfiguration.h>
 #include <jhelper.h>
 #include <jtrace.h>
@@ -47,6 +53,82 @@
 
 #define KEY_MIN 1
 
+/**
+ * Size of the input buffer used for TCP connections.
+ **/
+#define J_NETWORK_CONNECTION_INPUT_BUFFER_SIZE (64 * 1024)
+
+/**
+ * Size of each ring buffer of shared-memory connections, must be a power of two.
+ **/
+#define J_NETWORK_SHM_RING_SIZE (1024 * 1024)
+
+/**
+ * Sent by clients right after connecting via TCP.
+ **/
+enum JNetworkConnectionSetup
+{
+	/**
+	 * All data is sent over the socket.
+	 **/
+	J_NETWORK_CONNECTION_SETUP_TCP = 0,
+	/**
+	 * Data is sent over a shared-memory segment, whose name follows.
+	 **/
+	J_NETWORK_CONNECTION_SETUP_SHM = 1
+};
+
+typedef enum JNetworkConnectionSetup JNetworkConnectionSetup;
+
+/**
+ * A single-producer single-consumer ring buffer within a shared-memory segment.
+ * Positions are free-running counters, so the used space is head - tail.
+ *
+ * Waiting parties set the corresponding flag and block on the connection's socket.
+ * The other party clears the flag and sends a single byte (the doorbell) to wake them up.
+ * Since the flag is cleared atomically, exactly one doorbell is sent per wait.
+ **/
+struct JNetworkShmRing
+{
+	/**
+	 * The write position, only modified by the producer.
+	 **/
+	gint head;
+	gchar head_padding[64 - sizeof(gint)];
+
+	/**
+	 * The read position, only modified by the consumer.
+	 **/
+	gint tail;
+	gchar tail_padding[64 - sizeof(gint)];
+
+	/**
+	 * Whether the consumer waits for data.
+	 **/
+	gint data_waiting;
+
+	/**
+	 * Whether the producer waits for space.
+	 **/
+	gint space_waiting;
+	gchar waiting_padding[64 - 2 * sizeof(gint)];
+
+	gchar data[J_NETWORK_SHM_RING_SIZE];
+};
+
+typedef struct JNetworkShmRing JNetworkShmRing;
+
+/**
+ * A shared-memory segment, created by the client.
+ **/
+struct JNetworkShmSegment
+{
+	JNetworkShmRing client_to_server;
+	JNetworkShmRing server_to_client;
+};
+
+typedef struct JNetworkShmSegment JNetworkShmSegment;
+
 /**
  * Highest number of j_network_connection_send() calls before a j_network_connection_wait_for_completion().
  **/
@@ -122,6 +204,73 @@ typedef enum JNetworkFabricEvents JNetworkFabricEvents;
 
 struct JNetworkConnection
 {
+	/**
+	 * The socket connection if the TCP transport is used, NULL otherwise.
+	 * All other members are only used by the libfabric transport.
+	 **/
+	GSocketConnection* socket_connection;
+
+	/**
+	 * The buffered input stream of #socket_connection.
+	 * Allows reading a message's header and body with a single system call.
+	 **/
+	GInputStream* input_stream;
+
+	/**
+	 * State of multiplexed connections, see j_network_connection_set_multiplexed().
+	 **/
+	struct
+	{
+		gboolean enabled;
+
+		/**
+		 * Makes sure that complete messages are sent.
+		 **/
+		GMutex send_mutex[1];
+
+		/**
+		 * Protects the following members.
+		 **/
+		GMutex mutex[1];
+		GCond cond[1];
+
+		/**
+		 * The thread that is currently allowed to receive, NULL if there is none.
+		 **/
+		GThread* receiver;
+
+		/**
+		 * A header that has been received on behalf of another thread, NULL if there is none.
+		 **/
+		gpointer handoff;
+		guint32 handoff_id;
+	} multiplex;
+
+	/**
+	 * The codec negotiated for this connection, see j_network_connection_set_compression().
+	 **/
+	JConfigurationCompression compression;
+
+	/**
+	 * State of shared-memory connections.
+	 * The socket connection is kept open to detect hangups and to send doorbells.
+	 **/
+	struct
+	{
+		/**
+		 * The mapped segment, NULL if data is sent over the socket.
+		 **/
+		JNetworkShmSegment* segment;
+
+		JNetworkShmRing* send;
+		JNetworkShmRing* recv;
+
+		/**
+		 * Whether j_network_connection_buffer() has announced that we are waiting for a doorbell.
+		 **/
+		gboolean doorbell_expected;
+	} shm;
+
 	JNetworkFabric* fabric;
 
 	struct fi_info* info;
@@ -154,12 +303,13 @@ struct JNetworkConnection
 	{
 		struct
 		{
-			gpointer context;
+			gconstpointer context;
 			gpointer dest;
 			gsize len;
 		} msg_entry[J_NETWORK_CONNECTION_MAX_RECV + J_NETWORK_CONNECTION_MAX_SEND];
 
 		gint msg_len;
+		gint recv_len;
 		gint rma_len;
 	} running_actions;
 
@@ -223,6 +373,34 @@ typedef enum JNetworkConnectionEvents JNetworkConnectionEvents;
 		} \
 	} while (FALSE)
 
+/**
+ * Creates the hints used to find a suitable fabric.
+ *
+ * \param[in] configuration A configuration.
+ *
+ * \return The hints. Should be freed with fi_freeinfo().
+ **/
+static struct fi_info*
+j_network_fabric_hints_new(JConfiguration* configuration)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	struct fi_info* hints;
+	gchar const* provider;
+
+	hints = fi_allocinfo();
+	hints->caps = FI_MSG | FI_SEND | FI_RECV | FI_READ | FI_RMA | FI_REMOTE_READ;
+	hints->mode = FI_MSG_PREFIX;
+	hints->domain_attr->mr_mode = FI_MR_LOCAL | FI_MR_ALLOCATED | FI_MR_PROV_KEY | FI_MR_VIRT_ADDR;
+	hints->ep_attr->type = FI_EP_MSG;
+
+	// fi_freeinfo() will free the provider name
+	provider = j_configuration_get_provider(configuration);
+	hints->fabric_attr->prov_name = (provider != NULL) ? strdup(provider) : NULL;
+
+	return hints;
+}
+
 static void
 free_dangling_infos(struct fi_info* info)
 {
@@ -440,16 +618,10 @@ j_network_fabric_init_server(JConfiguration* configuration)
 	fabric->config = configuration;
 	fabric->con_side = JF_SERVER;
 
-	/// \todo deduplicate FI_VERSION and hints initialization
-	hints = fi_allocinfo();
-	hints->caps = FI_MSG | FI_SEND | FI_RECV | FI_READ | FI_RMA | FI_REMOTE_READ;
-	hints->mode = FI_MSG_PREFIX;
-	hints->domain_attr->mr_mode = FI_MR_LOCAL | FI_MR_ALLOCATED | FI_MR_PROV_KEY | FI_MR_VIRT_ADDR;
-	hints->ep_attr->type = FI_EP_MSG;
-	/// \todo allow setting provider
-	hints->fabric_attr->prov_name = NULL;
+	hints = j_network_fabric_hints_new(configuration);
 
 	res = fi_getinfo(FI_VERSION(1, 11), NULL, NULL, 0, hints, &fabric->info);
+	fi_freeinfo(hints);
 	CHECK("Failed to find fabric for server!");
 
 	free_dangling_infos(fabric->info);
@@ -523,14 +695,7 @@ j_network_fabric_init_client(JConfiguration* configuration, JNetworkFabricAddr*
 	fabric->config = configuration;
 	fabric->con_side = JF_CLIENT;
 
-	/// \todo deduplicate FI_VERSION and hints initialization
-	hints = fi_allocinfo();
-	hints->caps = FI_MSG | FI_SEND | FI_RECV | FI_READ | FI_RMA | FI_REMOTE_READ;
-	hints->mode = FI_MSG_PREFIX;
-	hints->domain_attr->mr_mode = FI_MR_LOCAL | FI_MR_ALLOCATED | FI_MR_PROV_KEY | FI_MR_VIRT_ADDR;
-	hints->ep_attr->type = FI_EP_MSG;
-	/// \todo allow setting provider
-	hints->fabric_attr->prov_name = NULL;
+	hints = j_network_fabric_hints_new(configuration);
 
 	fabric->hints = hints;
 	fabric->hints->addr_format = addr->addr_format;
@@ -552,16 +717,7 @@ end:
 	return NULL;
 }
 
-/**
- * Closes a fabric and frees used memory.
- *
- * \pre Finish all connections created from this fabric.
- *
- * \param this A fabric.
- *
- * \return TRUE on success, FALSE if an error occurred.
- **/
-static gboolean
+gboolean
 j_network_fabric_fini(JNetworkFabric* fabric)
 {
 	J_TRACE_FUNCTION(NULL);
@@ -683,6 +839,7 @@ j_network_connection_init(JNetworkConnection* connection)
 	gint res;
 
 	connection->running_actions.msg_len = 0;
+	connection->running_actions.recv_len = 0;
 	connection->running_actions.rma_len = 0;
 	connection->next_key = KEY_MIN;
 
@@ -723,364 +880,1543 @@ end:
 	return ret;
 }
 
-JNetworkConnection*
-j_network_connection_init_client(JConfiguration* configuration, JBackendType backend, guint index)
+/**
+ * Checks whether a socket connection's other party runs on the same host.
+ *
+ * \param socket_connection A socket connection.
+ *
+ * \return TRUE if the other party is local, FALSE otherwise.
+ **/
+static gboolean
+j_network_connection_shm_is_local(GSocketConnection* socket_connection)
 {
 	J_TRACE_FUNCTION(NULL);
 
-	JNetworkFabricAddr jf_addr;
-	JNetworkConnection* connection;
-	JNetworkConnectionEvents event;
-
-	GError* error = NULL;
-	GInputStream* input_stream;
-	GSocketConnection* socket_connection;
-	g_autoptr(GSocketClient) socket_client = NULL;
-
-	gint res;
-	gchar const* server;
+	g_autoptr(GSocketAddress) local_address = NULL;
+	g_autoptr(GSocketAddress) remote_address = NULL;
+	GInetAddress* local_inet_address;
+	GInetAddress* remote_inet_address;
 
-	connection = g_new0(JNetworkConnection, 1);
+	local_address = g_socket_connection_get_local_address(socket_connection, NULL);
+	remote_address = g_socket_connection_get_remote_address(socket_connection, NULL);
 
-	socket_client = g_socket_client_new();
-	server = j_configuration_get_server(configuration, backend, index);
-	socket_connection = g_socket_client_connect_to_host(socket_client, server, j_configuration_get_port(configuration), NULL, &error);
-	G_CHECK("Failed to build gsocket connection to host");
+	if (G_IS_UNIX_SOCKET_ADDRESS(local_address))
+	{
+		return TRUE;
+	}
 
-	if (socket_connection == NULL)
+	if (!G_IS_INET_SOCKET_ADDRESS(local_address) || !G_IS_INET_SOCKET_ADDRESS(remote_address))
 	{
-		g_warning("Can not connect to %s.", server);
-		goto end;
+		return FALSE;
 	}
 
-	j_helper_set_nodelay(socket_connection, TRUE);
+	local_inet_address = g_inet_socket_address_get_address(G_INET_SOCKET_ADDRESS(local_address));
+	remote_inet_address = g_inet_socket_address_get_address(G_INET_SOCKET_ADDRESS(remote_address));
 
-	input_stream = g_io_stream_get_input_stream(G_IO_STREAM(socket_connection));
+	return g_inet_address_get_is_loopback(remote_inet_address) || g_inet_address_equal(local_inet_address, remote_inet_address);
+}
 
-	g_input_stream_read(input_stream, &jf_addr.addr_format, sizeof(jf_addr.addr_format), NULL, &error);
-	G_CHECK("Failed to read addr format from socket_connection!");
-	jf_addr.addr_format = ntohl(jf_addr.addr_format);
+/**
+ * Maps a shared-memory segment.
+ *
+ * \param fd The segment's file descriptor, which is closed afterwards.
+ *
+ * \return The segment, NULL on failure.
+ **/
+static JNetworkShmSegment*
+j_network_connection_shm_map(gint fd)
+{
+	J_TRACE_FUNCTION(NULL);
 
-	g_input_stream_read(input_stream, &jf_addr.addr_len, sizeof(jf_addr.addr_len), NULL, &error);
-	G_CHECK("Failed to read addr len from socket_connection!");
-	jf_addr.addr_len = ntohl(jf_addr.addr_len);
+	gpointer segment;
 
-	jf_addr.addr = g_malloc(jf_addr.addr_len);
-	g_input_stream_read(input_stream, jf_addr.addr, jf_addr.addr_len, NULL, &error);
-	G_CHECK("Failed to read addr from socket_connection!");
+	segment = mmap(NULL, sizeof(JNetworkShmSegment), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
 
-	g_input_stream_close(input_stream, NULL, &error);
-	G_CHECK("Failed to close input stream!");
+	return (segment != MAP_FAILED) ? segment : NULL;
+}
 
-	g_io_stream_close(G_IO_STREAM(socket_connection), NULL, &error);
-	G_CHECK("Failed to close gsocket!");
+/**
+ * Sets up a client's TCP connection, switching to shared memory if the server runs on the same host.
+ * Data is still sent over the socket if the server can not access the segment, for instance, because it runs in a container.
+ *
+ * \param connection    A connection.
+ * \param shared_memory Whether shared memory may be used.
+ *
+ * \return TRUE on success, FALSE if an error occurred.
+ **/
+static gboolean
+j_network_connection_shm_setup_client(JNetworkConnection* connection, gboolean shared_memory)
+{
+	J_TRACE_FUNCTION(NULL);
 
-	connection->fabric = j_network_fabric_init_client(configuration, &jf_addr);
+	static gint shm_counter = 0;
 
-	if (connection->fabric == NULL)
-	{
-		g_warning("Failed to initialize fabric for client!");
-		goto end;
-	}
+	g_autofree gchar* name = NULL;
+	GInputStream* input_stream;
+	GOutputStream* output_stream;
+	JNetworkShmSegment* segment = NULL;
+	guint8 setup = J_NETWORK_CONNECTION_SETUP_TCP;
+	guint8 accepted = 0;
+	guint32 name_len;
+	gboolean ret = FALSE;
+	gint fd;
 
-	connection->info = connection->fabric->info;
+	// Read from the socket directly, the buffered input stream might consume data that belongs to the first message
+	input_stream = g_io_stream_get_input_stream(G_IO_STREAM(connection->socket_connection));
+	output_stream = g_io_stream_get_output_stream(G_IO_STREAM(connection->socket_connection));
 
-	EXE(j_network_connection_init(connection), "Failed to initelze connection!");
+	if (shared_memory && j_network_connection_shm_is_local(connection->socket_connection))
+	{
+		name = g_strdup_printf("/julea-%d-%d", (gint)getpid(), g_atomic_int_add(&shm_counter, 1));
+		fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
 
-	res = fi_connect(connection->ep, jf_addr.addr, NULL, 0);
-	CHECK("Failed to fire connection request!");
+		if (fd >= 0)
+		{
+			if (ftruncate(fd, sizeof(JNetworkShmSegment)) == 0)
+			{
+				segment = j_network_connection_shm_map(fd);
+			}
+			else
+			{
+				close(fd);
+			}
 
-	do
+			if (segment == NULL)
+			{
+				shm_unlink(name);
+			}
+		}
+	}
+
+	if (segment == NULL)
 	{
-		EXE(j_network_connection_sread_event(connection, 1, &event), "Failed to read event queue, waiting for CONNECTED signal!");
-	} while (event == J_CONNECTION_EVENT_TIMEOUT);
+		return g_output_stream_write_all(output_stream, &setup, sizeof(setup), NULL, NULL, NULL);
+	}
 
-	if (event != J_CONNECTION_EVENT_CONNECTED)
+	setup = J_NETWORK_CONNECTION_SETUP_SHM;
+	name_len = GUINT32_TO_LE(strlen(name));
+
+	if (g_output_stream_write_all(output_stream, &setup, sizeof(setup), NULL, NULL, NULL)
+	    && g_output_stream_write_all(output_stream, &name_len, sizeof(name_len), NULL, NULL, NULL)
+	    && g_output_stream_write_all(output_stream, name, strlen(name), NULL, NULL, NULL)
+	    && g_input_stream_read_all(input_stream, &accepted, sizeof(accepted), NULL, NULL, NULL))
 	{
-		g_warning("Failed to connect to host!");
-		goto end;
+		ret = TRUE;
 	}
 
-	return connection;
+	// Both parties have mapped the segment (or failed to), so its name is not needed anymore
+	shm_unlink(name);
 
-end:
-	/// \todo clean up connection
-	return NULL;
+	if (ret && accepted)
+	{
+		connection->shm.segment = segment;
+		connection->shm.send = &(segment->client_to_server);
+		connection->shm.recv = &(segment->server_to_client);
+	}
+	else
+	{
+		munmap(segment, sizeof(JNetworkShmSegment));
+	}
+
+	return ret;
 }
 
-JNetworkConnection*
-j_network_connection_init_server(JNetworkFabric* fabric, GSocketConnection* gconnection)
+/**
+ * Sets up a server's TCP connection, see j_network_connection_shm_setup_client().
+ *
+ * \param connection A connection.
+ *
+ * \return TRUE on success, FALSE if an error occurred.
+ **/
+static gboolean
+j_network_connection_shm_setup_server(JNetworkConnection* connection)
 {
 	J_TRACE_FUNCTION(NULL);
 
-	JNetworkConnection* connection;
-	JNetworkConnectionEvents con_event;
-	JNetworkFabricAddr* addr = &fabric->fabric_addr_network;
-	JNetworkFabricEvents event;
-
-	GError* error = NULL;
+	g_autofree gchar* name = NULL;
+	GInputStream* input_stream;
 	GOutputStream* output_stream;
+	JNetworkShmSegment* segment = NULL;
+	guint8 setup;
+	guint8 accepted;
+	guint32 name_len;
+	gsize bytes_read;
+	gint fd;
 
-	gint res;
-	struct fi_eq_cm_entry request;
-
-	connection = g_new0(JNetworkConnection, 1);
+	// Read from the socket directly, the buffered input stream might consume data that belongs to the first message
+	input_stream = g_io_stream_get_input_stream(G_IO_STREAM(connection->socket_connection));
 
-	// send addr
-	output_stream = g_io_stream_get_output_stream(G_IO_STREAM(gconnection));
-	g_output_stream_write(output_stream, &addr->addr_format, sizeof(addr->addr_format), NULL, &error);
-	G_CHECK("Failed to write addr_format to stream!");
+	if (!g_input_stream_read_all(input_stream, &setup, sizeof(setup), &bytes_read, NULL, NULL) || bytes_read != sizeof(setup))
+	{
+		return FALSE;
+	}
 
-	g_output_stream_write(output_stream, &addr->addr_len, sizeof(addr->addr_len), NULL, &error);
-	G_CHECK("Failed to write addr_len to stream!");
+	if (setup == J_NETWORK_CONNECTION_SETUP_TCP)
+	{
+		return TRUE;
+	}
 
-	g_output_stream_write(output_stream, addr->addr, ntohl(addr->addr_len), NULL, &error);
-	G_CHECK("Failed to write addr to stream!");
+	if (!g_input_stream_read_all(input_stream, &name_len, sizeof(name_len), &bytes_read, NULL, NULL) || bytes_read != sizeof(name_len))
+	{
+		return FALSE;
+	}
 
-	g_output_stream_close(output_stream, NULL, &error);
-	G_CHECK("Failed to close output stream!");
+	name_len = GUINT32_FROM_LE(name_len);
 
-	do
+	if (name_len == 0 || name_len > 255)
 	{
-		EXE(j_network_fabric_sread_event(fabric, 2, &event, &request), "Failed to wait for connection request");
-	} while (event == J_FABRIC_EVENT_TIMEOUT);
+		return FALSE;
+	}
 
-	if (event != J_FABRIC_EVENT_CONNECTION_REQUEST)
+	name = g_malloc0(name_len + 1);
+
+	if (!g_input_stream_read_all(input_stream, name, name_len, &bytes_read, NULL, NULL) || bytes_read != name_len)
 	{
-		g_warning("expected an connection request and nothing else! (%i)", event);
-		goto end;
+		return FALSE;
 	}
 
-	connection->fabric = fabric;
-	connection->info = request.info;
+	fd = shm_open(name, O_RDWR, 0);
 
-	EXE(j_network_connection_init(connection), "Failed to initelize connection server side!");
+	if (fd >= 0)
+	{
+		segment = j_network_connection_shm_map(fd);
+	}
 
-	res = fi_accept(connection->ep, NULL, 0);
-	CHECK("Failed to accept connection!");
+	if (segment != NULL)
+	{
+		connection->shm.segment = segment;
+		connection->shm.send = &(segment->server_to_client);
+		connection->shm.recv = &(segment->client_to_server);
 
-	EXE(j_network_connection_sread_event(connection, 2, &con_event), "Failed to verify connection!");
+		// The client may send its first message as soon as it has received our answer, so it has to ring the doorbell
+		g_atomic_int_set(&(connection->shm.recv->data_waiting), 1);
+		connection->shm.doorbell_expected = TRUE;
+	}
+
+	accepted = (segment != NULL) ? 1 : 0;
+	output_stream = g_io_stream_get_output_stream(G_IO_STREAM(connection->socket_connection));
+
+	// j_network_connection_fini() unmaps the segment if this fails
+	return g_output_stream_write_all(output_stream, &accepted, sizeof(accepted), NULL, NULL, NULL);
+}
+
+/**
+ * Waits for the other party's doorbell.
+ *
+ * \param connection A shared-memory connection.
+ *
+ * \return TRUE on success, FALSE if the connection has been closed.
+ **/
+static gboolean
+j_network_connection_shm_doorbell_wait(JNetworkConnection* connection)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	guint8 doorbell;
+	gsize bytes_read;
+
+	if (!g_input_stream_read_all(g_io_stream_get_input_stream(G_IO_STREAM(connection->socket_connection)), &doorbell, sizeof(doorbell), &bytes_read, NULL, NULL) || bytes_read != sizeof(doorbell))
+	{
+		connection->closed = TRUE;
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+/**
+ * Wakes up the other party.
+ *
+ * \param connection A shared-memory connection.
+ *
+ * \return TRUE on success, FALSE if an error occurred.
+ **/
+static gboolean
+j_network_connection_shm_doorbell_ring(JNetworkConnection* connection)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	GOutputStream* output_stream;
+	guint8 doorbell = 1;
+
+	output_stream = g_io_stream_get_output_stream(G_IO_STREAM(connection->socket_connection));
+
+	return g_output_stream_write_all(output_stream, &doorbell, sizeof(doorbell), NULL, NULL, NULL);
+}
+
+/**
+ * Announces that we are going to wait for a doorbell.
+ * If the condition has become true in the meantime, the announcement is withdrawn.
+ *
+ * \param connection A shared-memory connection.
+ * \param waiting    The ring's waiting flag.
+ * \param ready      Whether the condition is true, checked after setting the flag.
+ *
+ * \return TRUE if a doorbell will be sent, FALSE if the condition is already true.
+ **/
+static gboolean
+j_network_connection_shm_announce_wait(JNetworkConnection* connection, gint* waiting, gboolean (*ready)(JNetworkShmRing*), JNetworkShmRing* ring)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_atomic_int_set(waiting, 1);
+
+	if (!ready(ring))
+	{
+		return TRUE;
+	}
+
+	// The other party has already cleared the flag, so its doorbell is on the way and has to be consumed
+	if (!g_atomic_int_compare_and_exchange(waiting, 1, 0))
+	{
+		j_network_connection_shm_doorbell_wait(connection);
+	}
+
+	return FALSE;
+}
+
+static guint
+j_network_connection_shm_used(JNetworkShmRing* ring)
+{
+	return (guint)g_atomic_int_get(&(ring->head)) - (guint)g_atomic_int_get(&(ring->tail));
+}
+
+static gboolean
+j_network_connection_shm_has_data(JNetworkShmRing* ring)
+{
+	return j_network_connection_shm_used(ring) > 0;
+}
+
+static gboolean
+j_network_connection_shm_has_space(JNetworkShmRing* ring)
+{
+	return j_network_connection_shm_used(ring) < J_NETWORK_SHM_RING_SIZE;
+}
+
+/**
+ * Copies data into the send ring, waiting for the other party to make room if necessary.
+ *
+ * \param connection A shared-memory connection.
+ * \param data       The data.
+ * \param data_len   The data length.
+ *
+ * \return TRUE on success, FALSE if an error occurred.
+ **/
+static gboolean
+j_network_connection_shm_send(JNetworkConnection* connection, gconstpointer data, gsize data_len)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JNetworkShmRing* ring = connection->shm.send;
+	gchar const* position = data;
+
+	while (data_len > 0)
+	{
+		guint head;
+		guint offset;
+		gsize length;
+		gsize length_first;
+
+		if (!j_network_connection_shm_has_space(ring))
+		{
+			if (j_network_connection_shm_announce_wait(connection, &(ring->space_waiting), j_network_connection_shm_has_space, ring)
+			    && !j_network_connection_shm_doorbell_wait(connection))
+			{
+				return FALSE;
+			}
+
+			continue;
+		}
+
+		head = g_atomic_int_get(&(ring->head));
+		offset = head & (J_NETWORK_SHM_RING_SIZE - 1);
+		length = MIN(data_len, J_NETWORK_SHM_RING_SIZE - j_network_connection_shm_used(ring));
+		length_first = MIN(length, J_NETWORK_SHM_RING_SIZE - offset);
+
+		memcpy(ring->data + offset, position, length_first);
+		memcpy(ring->data, position + length_first, length - length_first);
+
+		g_atomic_int_set(&(ring->head), head + length);
+
+		if (g_atomic_int_compare_and_exchange(&(ring->data_waiting), 1, 0) && !j_network_connection_shm_doorbell_ring(connection))
+		{
+			return FALSE;
+		}
+
+		position += length;
+		data_len -= length;
+	}
+
+	return TRUE;
+}
+
+/**
+ * Copies data out of the receive ring, waiting for the other party if necessary.
+ *
+ * \param connection A shared-memory connection.
+ * \param data_len   The data length.
+ * \param data       A buffer to receive into.
+ *
+ * \return TRUE on success, FALSE if an error occurred.
+ **/
+static gboolean
+j_network_connection_shm_recv(JNetworkConnection* connection, gsize data_len, gpointer data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JNetworkShmRing* ring = connection->shm.recv;
+	gchar* position = data;
+
+	while (data_len > 0)
+	{
+		guint tail;
+		guint offset;
+		gsize length;
+		gsize length_first;
+
+		if (connection->shm.doorbell_expected)
+		{
+			connection->shm.doorbell_expected = FALSE;
+
+			if (!j_network_connection_shm_doorbell_wait(connection))
+			{
+				return FALSE;
+			}
+		}
+
+		if (!j_network_connection_shm_has_data(ring))
+		{
+			connection->shm.doorbell_expected = j_network_connection_shm_announce_wait(connection, &(ring->data_waiting), j_network_connection_shm_has_data, ring);
+			continue;
+		}
+
+		tail = g_atomic_int_get(&(ring->tail));
+		offset = tail & (J_NETWORK_SHM_RING_SIZE - 1);
+		length = MIN(data_len, j_network_connection_shm_used(ring));
+		length_first = MIN(length, J_NETWORK_SHM_RING_SIZE - offset);
+
+		memcpy(position, ring->data + offset, length_first);
+		memcpy(position + length_first, ring->data, length - length_first);
+
+		g_atomic_int_set(&(ring->tail), tail + length);
+
+		if (g_atomic_int_compare_and_exchange(&(ring->space_waiting), 1, 0) && !j_network_connection_shm_doorbell_ring(connection))
+		{
+			return FALSE;
+		}
+
+		position += length;
+		data_len -= length;
+	}
+
+	return TRUE;
+}
+
+/**
+ * Connects to a server on the same host via its Unix domain socket.
+ *
+ * \param configuration A configuration.
+ * \param socket_client A socket client.
+ * \param server        The server.
+ *
+ * \return A socket connection, NULL if the server is not local or does not listen on a Unix domain socket.
+ **/
+static GSocketConnection*
+j_network_connection_connect_unix(JConfiguration* configuration, GSocketClient* socket_client, gchar const* server)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_autoptr(GSocketConnectable) address = NULL;
+	g_autoptr(GSocketAddress) socket_address = NULL;
+	g_autoptr(GInetAddress) inet_address = NULL;
+	g_autofree gchar* port_str = NULL;
+	g_autofree gchar* path = NULL;
+	gchar const* hostname;
+	gchar const* socket_path;
+
+	socket_path = j_configuration_get_socket(configuration);
+
+	if (socket_path == NULL)
+	{
+		return NULL;
+	}
+
+	address = g_network_address_parse(server, j_configuration_get_port(configuration), NULL);
+
+	if (address == NULL)
+	{
+		return NULL;
+	}
+
+	hostname = g_network_address_get_hostname(G_NETWORK_ADDRESS(address));
+	inet_address = g_inet_address_new_from_string(hostname);
+
+	if (g_strcmp0(hostname, g_get_host_name()) != 0 && g_strcmp0(hostname, "localhost") != 0
+	    && (inet_address == NULL || !g_inet_address_get_is_loopback(inet_address)))
+	{
+		return NULL;
+	}
+
+	port_str = g_strdup_printf("%d", g_network_address_get_port(G_NETWORK_ADDRESS(address)));
+	path = j_helper_str_replace(socket_path, "{PORT}", port_str);
+	socket_address = g_unix_socket_address_new(path);
+
+	// Fall back to TCP silently, the server might not have been configured to use the socket
+	return g_socket_client_connect(socket_client, G_SOCKET_CONNECTABLE(socket_address), NULL, NULL);
+}
+
+JNetworkConnection*
+j_network_connection_init_client(JConfiguration* configuration, JBackendType backend, guint index)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JNetworkFabricAddr jf_addr;
+	JNetworkConnection* connection;
+	JNetworkConnectionEvents event;
+
+	GError* error = NULL;
+	GInputStream* input_stream;
+	GSocketConnection* socket_connection;
+	g_autoptr(GSocketClient) socket_client = NULL;
+
+	gint res;
+	gchar const* server;
+
+	connection = g_new0(JNetworkConnection, 1);
+
+	socket_client = g_socket_client_new();
+	server = j_configuration_get_server(configuration, backend, index);
+	socket_connection = NULL;
+
+	// Local servers are preferably reached via their Unix domain sockets, bypassing the TCP stack
+	if (j_configuration_get_transport(configuration) == J_CONFIGURATION_TRANSPORT_TCP)
+	{
+		socket_connection = j_network_connection_connect_unix(configuration, socket_client, server);
+	}
+
+	if (socket_connection == NULL)
+	{
+		socket_connection = g_socket_client_connect_to_host(socket_client, server, j_configuration_get_port(configuration), NULL, &error);
+		G_CHECK("Failed to build gsocket connection to host");
+	}
+
+	if (socket_connection == NULL)
+	{
+		g_warning("Can not connect to %s.", server);
+		goto end;
+	}
+
+	if (G_IS_TCP_CONNECTION(socket_connection))
+	{
+		j_helper_set_nodelay(socket_connection, TRUE);
+	}
+
+	if (j_configuration_get_transport(configuration) == J_CONFIGURATION_TRANSPORT_TCP)
+	{
+		connection->socket_connection = socket_connection;
+		connection->input_stream = g_buffered_input_stream_new_sized(g_io_stream_get_input_stream(G_IO_STREAM(socket_connection)), J_NETWORK_CONNECTION_INPUT_BUFFER_SIZE);
+		connection->closed = FALSE;
+
+		g_mutex_init(connection->multiplex.send_mutex);
+		g_mutex_init(connection->multiplex.mutex);
+		g_cond_init(connection->multiplex.cond);
+
+		// Multiplexed connections are shared between threads, which shared-memory connections do not support
+		if (!j_network_connection_shm_setup_client(connection, j_configuration_get_shared_memory(configuration) && !j_configuration_get_multiplexing(configuration)))
+		{
+			g_warning("Can not set up connection to %s.", server);
+			j_network_connection_fini(connection);
+			return NULL;
+		}
+
+		return connection;
+	}
+
+	input_stream = g_io_stream_get_input_stream(G_IO_STREAM(socket_connection));
+
+	g_input_stream_read(input_stream, &jf_addr.addr_format, sizeof(jf_addr.addr_format), NULL, &error);
+	G_CHECK("Failed to read addr format from socket_connection!");
+	jf_addr.addr_format = ntohl(jf_addr.addr_format);
+
+	g_input_stream_read(input_stream, &jf_addr.addr_len, sizeof(jf_addr.addr_len), NULL, &error);
+	G_CHECK("Failed to read addr len from socket_connection!");
+	jf_addr.addr_len = ntohl(jf_addr.addr_len);
+
+	jf_addr.addr = g_malloc(jf_addr.addr_len);
+	g_input_stream_read(input_stream, jf_addr.addr, jf_addr.addr_len, NULL, &error);
+	G_CHECK("Failed to read addr from socket_connection!");
+
+	g_input_stream_close(input_stream, NULL, &error);
+	G_CHECK("Failed to close input stream!");
+
+	g_io_stream_close(G_IO_STREAM(socket_connection), NULL, &error);
+	g_object_unref(socket_connection);
+	G_CHECK("Failed to close gsocket!");
+
+	connection->fabric = j_network_fabric_init_client(configuration, &jf_addr);
+
+	if (connection->fabric == NULL)
+	{
+		g_warning("Failed to initialize fabric for client!");
+		goto end;
+	}
+
+	connection->info = connection->fabric->info;
+
+	EXE(j_network_connection_init(connection), "Failed to initelze connection!");
+
+	res = fi_connect(connection->ep, jf_addr.addr, NULL, 0);
+	CHECK("Failed to fire connection request!");
+
+	do
+	{
+		EXE(j_network_connection_sread_event(connection, 1, &event), "Failed to read event queue, waiting for CONNECTED signal!");
+	} while (event == J_CONNECTION_EVENT_TIMEOUT);
+
+	if (event != J_CONNECTION_EVENT_CONNECTED)
+	{
+		g_warning("Failed to connect to host!");
+		goto end;
+	}
+
+	return connection;
+
+end:
+	/// \todo clean up connection
+	return NULL;
+}
+
+JNetworkConnection*
+j_network_connection_init_server(JNetworkFabric* fabric, GSocketConnection* gconnection)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JNetworkConnection* connection;
+	JNetworkConnectionEvents con_event;
+	JNetworkFabricAddr* addr;
+	JNetworkFabricEvents event;
+
+	GError* error = NULL;
+	GOutputStream* output_stream;
+
+	gint res;
+	struct fi_eq_cm_entry request;
+
+	connection = g_new0(JNetworkConnection, 1);
+
+	if (fabric == NULL)
+	{
+		if (G_IS_TCP_CONNECTION(gconnection))
+		{
+			j_helper_set_nodelay(gconnection, TRUE);
+		}
+
+		connection->socket_connection = g_object_ref(gconnection);
+		connection->input_stream = g_buffered_input_stream_new_sized(g_io_stream_get_input_stream(G_IO_STREAM(gconnection)), J_NETWORK_CONNECTION_INPUT_BUFFER_SIZE);
+		connection->closed = FALSE;
+
+		g_mutex_init(connection->multiplex.send_mutex);
+		g_mutex_init(connection->multiplex.mutex);
+		g_cond_init(connection->multiplex.cond);
+
+		if (!j_network_connection_shm_setup_server(connection))
+		{
+			j_network_connection_fini(connection);
+			return NULL;
+		}
+
+		return connection;
+	}
+
+	// send addr
+	addr = &fabric->fabric_addr_network;
+	output_stream = g_io_stream_get_output_stream(G_IO_STREAM(gconnection));
+	g_output_stream_write(output_stream, &addr->addr_format, sizeof(addr->addr_format), NULL, &error);
+	G_CHECK("Failed to write addr_format to stream!");
+
+	g_output_stream_write(output_stream, &addr->addr_len, sizeof(addr->addr_len), NULL, &error);
+	G_CHECK("Failed to write addr_len to stream!");
+
+	g_output_stream_write(output_stream, addr->addr, ntohl(addr->addr_len), NULL, &error);
+	G_CHECK("Failed to write addr to stream!");
+
+	g_output_stream_close(output_stream, NULL, &error);
+	G_CHECK("Failed to close output stream!");
+
+	do
+	{
+		EXE(j_network_fabric_sread_event(fabric, 2, &event, &request), "Failed to wait for connection request");
+	} while (event == J_FABRIC_EVENT_TIMEOUT);
+
+	if (event != J_FABRIC_EVENT_CONNECTION_REQUEST)
+	{
+		g_warning("expected an connection request and nothing else! (%i)", event);
+		goto end;
+	}
+
+	connection->fabric = fabric;
+	connection->info = request.info;
+
+	EXE(j_network_connection_init(connection), "Failed to initelize connection server side!");
+
+	res = fi_accept(connection->ep, NULL, 0);
+	CHECK("Failed to accept connection!");
+
+	EXE(j_network_connection_sread_event(connection, 2, &con_event), "Failed to verify connection!");
 
 	if (con_event != J_CONNECTION_EVENT_CONNECTED)
 	{
-		g_warning("expected and connection ack and nothing else!");
-		goto end;
+		g_warning("expected and connection ack and nothing else!");
+		goto end;
+	}
+
+	return connection;
+
+end:
+	/// \todo clean up connection
+	return NULL;
+}
+
+gboolean
+j_network_connection_send(JNetworkConnection* connection, gconstpointer data, gsize data_len)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gboolean ret = FALSE;
+
+	gint res;
+	gpointer context;
+	gsize size;
+
+	if (connection->shm.segment != NULL)
+	{
+		return j_network_connection_shm_send(connection, data, data_len);
+	}
+
+	if (connection->socket_connection != NULL)
+	{
+		GError* error = NULL;
+		GOutputStream* output_stream;
+
+		output_stream = g_io_stream_get_output_stream(G_IO_STREAM(connection->socket_connection));
+
+		if (!g_output_stream_write_all(output_stream, data, data_len, NULL, NULL, &error))
+		{
+			g_warning("Failed to send data: %s", error->message);
+			g_error_free(error);
+
+			return FALSE;
+		}
+
+		return TRUE;
+	}
+
+	// we used paired endponits -> inject and send don't need destination addr (last parameter)
+
+	if (data_len < connection->inject_size)
+	{
+		do
+		{
+			res = fi_inject(connection->ep, data, data_len, 0);
+		} while (res == -FI_EAGAIN);
+
+		CHECK("Failed to inject data!");
+
+		ret = TRUE;
+		goto end;
+	}
+
+	// normal send
+	if (connection->memory.active)
+	{
+		uint8_t* segment = (uint8_t*)connection->memory.buffer + connection->memory.used;
+
+		context = segment;
+		memcpy(segment + connection->memory.tx_prefix_size, data, data_len);
+		size = data_len + connection->memory.tx_prefix_size;
+
+		do
+		{
+			res = fi_send(connection->ep, segment, size, fi_mr_desc(connection->memory.mr), 0, context);
+		} while (res == -FI_EAGAIN);
+
+		CHECK("Failed to initelize sending!");
+
+		connection->memory.used += size;
+
+		g_assert_true(connection->memory.used <= connection->memory.buffer_size);
+		g_assert_true(connection->running_actions.msg_len + 1 < J_NETWORK_CONNECTION_MAX_SEND + J_NETWORK_CONNECTION_MAX_RECV);
+	}
+	else
+	{
+		// Pending sends without a bounce buffer do not have to be told apart, so the connection is a sufficient context
+		context = connection;
+		size = data_len;
+
+		do
+		{
+			res = fi_send(connection->ep, data, size, NULL, 0, connection);
+		} while (res == -FI_EAGAIN);
+
+		CHECK("Failed to initelize sending!");
+	}
+
+	connection->running_actions.msg_entry[connection->running_actions.msg_len].context = context;
+	connection->running_actions.msg_entry[connection->running_actions.msg_len].dest = NULL;
+	connection->running_actions.msg_entry[connection->running_actions.msg_len].len = 0;
+	connection->running_actions.msg_len++;
+
+	ret = TRUE;
+
+end:
+	return ret;
+}
+
+gboolean
+j_network_connection_recv(JNetworkConnection* connection, gsize data_len, gpointer data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gboolean ret = FALSE;
+
+	gint res;
+	gpointer segment;
+	gsize size;
+
+	if (connection->shm.segment != NULL)
+	{
+		return j_network_connection_shm_recv(connection, data_len, data);
+	}
+
+	if (connection->socket_connection != NULL)
+	{
+		GError* error = NULL;
+		gsize bytes_read;
+
+		if (!g_input_stream_read_all(connection->input_stream, data, data_len, &bytes_read, NULL, &error))
+		{
+			g_warning("Failed to receive data: %s", error->message);
+			g_error_free(error);
+
+			return FALSE;
+		}
+
+		if (bytes_read != data_len)
+		{
+			// The other party closed the connection
+			connection->closed = TRUE;
+
+			return FALSE;
+		}
+
+		return TRUE;
+	}
+
+	segment = connection->memory.active ? (char*)connection->memory.buffer + connection->memory.used : data;
+	size = data_len + connection->memory.rx_prefix_size;
+
+	res = fi_recv(connection->ep, segment, size, connection->memory.active ? fi_mr_desc(connection->memory.mr) : NULL, 0, segment);
+	CHECK("Failed to initelized receiving!");
+
+	if (connection->memory.active)
+	{
+		connection->memory.used += size;
+
+		g_assert_true(connection->memory.used <= connection->memory.buffer_size);
+		g_assert_true(connection->running_actions.msg_len < J_NETWORK_CONNECTION_MAX_SEND + J_NETWORK_CONNECTION_MAX_RECV);
+
+		connection->running_actions.msg_entry[connection->running_actions.msg_len].context = segment;
+		connection->running_actions.msg_entry[connection->running_actions.msg_len].dest = data;
+		connection->running_actions.msg_entry[connection->running_actions.msg_len].len = data_len;
+	}
+	else
+	{
+		connection->running_actions.msg_entry[connection->running_actions.msg_len].context = segment;
+		connection->running_actions.msg_entry[connection->running_actions.msg_len].dest = NULL;
+		connection->running_actions.msg_entry[connection->running_actions.msg_len].len = 0;
+	}
+
+	connection->running_actions.msg_len++;
+	connection->running_actions.recv_len++;
+
+	return TRUE;
+
+end:
+	return ret;
+}
+
+gboolean
+j_network_connection_closed(JNetworkConnection* connection)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	return connection->closed;
+}
+
+gboolean
+j_network_connection_wait_for_completion(JNetworkConnection* connection)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gboolean ret = FALSE;
+
+	struct fi_cq_entry entry;
+
+	gint res;
+	gint i;
+
+	if (connection->socket_connection != NULL)
+	{
+		// Sending and receiving are synchronous for TCP
+		return !connection->closed;
+	}
+
+	while (connection->running_actions.rma_len + connection->running_actions.msg_len)
+	{
+		gboolean rx;
+
+		if (connection->running_actions.rma_len == 0 && connection->running_actions.msg_len == connection->running_actions.recv_len)
+		{
+			// Only receives are pending, which might take arbitrarily long (for example, on idle connections), so block instead of polling
+			rx = TRUE;
+			res = fi_cq_sread(connection->cq.rx, &entry, 1, NULL, 1000);
+
+			if (res == -FI_EAGAIN)
+			{
+				JNetworkConnectionEvents event;
+
+				if (j_network_connection_sread_event(connection, 0, &event) && event == J_CONNECTION_EVENT_SHUTDOWN)
+				{
+					connection->closed = TRUE;
+					goto end;
+				}
+
+				continue;
+			}
+		}
+		else
+		{
+			do
+			{
+				rx = TRUE;
+				res = fi_cq_read(connection->cq.rx, &entry, 1);
+
+				if (res == -FI_EAGAIN)
+				{
+					rx = FALSE;
+					res = fi_cq_read(connection->cq.tx, &entry, 1);
+				}
+			} while (res == -FI_EAGAIN);
+		}
+
+		if (res == -FI_EAVAIL)
+		{
+			JNetworkConnectionEvents event;
+
+			struct fi_cq_err_entry err_entry;
+
+			j_network_connection_sread_event(connection, 0, &event);
+
+			if (event == J_CONNECTION_EVENT_SHUTDOWN)
+			{
+				connection->closed = TRUE;
+				goto end;
+			}
+
+			res = fi_cq_readerr(rx ? connection->cq.rx : connection->cq.tx, &err_entry, 0);
+			CHECK("Failed to read error of cq!");
+
+			g_warning("Failed to read completion queue\nWidth:\t%s", fi_cq_strerror(rx ? connection->cq.rx : connection->cq.tx, err_entry.prov_errno, err_entry.err_data, NULL, 0));
+
+			goto end;
+		}
+		else
+		{
+			CHECK("Failed to read completion queue!");
+		}
+
+		for (i = 0; i <= connection->running_actions.msg_len; i++)
+		{
+			if (i == connection->running_actions.msg_len)
+			{
+				// If there is no match -> it's an rma transafer -> context = memory region
+				res = fi_close(&((struct fid_mr*)entry.op_context)->fid);
+				CHECK("Failed to free receiving memory!");
+
+				connection->running_actions.rma_len--;
+
+				break;
+			}
+
+			if (connection->running_actions.msg_entry[i].context == entry.op_context)
+			{
+				connection->running_actions.msg_len--;
+
+				if (rx)
+				{
+					connection->running_actions.recv_len--;
+				}
+
+				if (connection->running_actions.msg_entry[i].dest)
+				{
+					// The received data is preceded by the message prefix
+					memcpy(connection->running_actions.msg_entry[i].dest, (guint8 const*)connection->running_actions.msg_entry[i].context + connection->memory.rx_prefix_size, connection->running_actions.msg_entry[i].len);
+				}
+
+				connection->running_actions.msg_entry[i] = connection->running_actions.msg_entry[connection->running_actions.msg_len];
+
+				break;
+			}
+		}
+	}
+
+	connection->memory.used = 0;
+
+	return TRUE;
+
+end:
+	return ret;
+}
+
+gboolean
+j_network_connection_send_all(JNetworkConnection* connection, gconstpointer data, gsize length)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	guint8 const* position = data;
+	guint64 max_operation_size;
+
+	g_return_val_if_fail(connection != NULL, FALSE);
+	g_return_val_if_fail(data != NULL || length == 0, FALSE);
+
+	if (connection->socket_connection != NULL)
+	{
+		return j_network_connection_send(connection, data, length);
+	}
+
+	max_operation_size = j_configuration_get_max_operation_size(connection->fabric->config);
+
+	while (length > 0)
+	{
+		gsize chunk_length = MIN(length, max_operation_size);
+
+		if (!j_network_connection_send(connection, position, chunk_length) || !j_network_connection_wait_for_completion(connection))
+		{
+			return FALSE;
+		}
+
+		position += chunk_length;
+		length -= chunk_length;
+	}
+
+	return TRUE;
+}
+
+gboolean
+j_network_connection_recv_all(JNetworkConnection* connection, gsize length, gpointer data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	guint8* position = data;
+	guint64 max_operation_size;
+
+	g_return_val_if_fail(connection != NULL, FALSE);
+	g_return_val_if_fail(data != NULL || length == 0, FALSE);
+
+	if (connection->socket_connection != NULL)
+	{
+		return j_network_connection_recv(connection, length, data);
+	}
+
+	max_operation_size = j_configuration_get_max_operation_size(connection->fabric->config);
+
+	while (length > 0)
+	{
+		gsize chunk_length = MIN(length, max_operation_size);
+
+		if (!j_network_connection_recv(connection, chunk_length, position) || !j_network_connection_wait_for_completion(connection))
+		{
+			return FALSE;
+		}
+
+		position += chunk_length;
+		length -= chunk_length;
+	}
+
+	return TRUE;
+}
+
+gboolean
+j_network_connection_use_rma(JNetworkConnection* connection, gsize length)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_val_if_fail(connection != NULL, FALSE);
+
+	if (connection->socket_connection != NULL)
+	{
+		return FALSE;
+	}
+
+	return (length > j_configuration_get_max_inject_size(connection->fabric->config));
+}
+
+/**
+ * Receives data that has been compressed block by block.
+ * Each block is preceded by its compressed length, a length of 0 denotes an uncompressed block.
+ * Blocks are decompressed directly into \p data.
+ *
+ * \param connection A connection.
+ * \param length     The length of the uncompressed data.
+ * \param data       A data buffer to receive into.
+ *
+ * \return TRUE on success, FALSE if an error occurred.
+ **/
+static gboolean
+j_network_connection_recv_compressed(JNetworkConnection* connection, gsize length, gpointer data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	guint8* position = data;
+
+	while (length > 0)
+	{
+		gsize block_length = MIN(length, J_COMPRESSION_BLOCK_SIZE);
+		guint32 compressed_length;
+
+		if (!j_network_connection_recv_all(connection, sizeof(compressed_length), &compressed_length))
+		{
+			return FALSE;
+		}
+
+		compressed_length = GUINT32_FROM_LE(compressed_length);
+
+		if (compressed_length == 0)
+		{
+			if (!j_network_connection_recv_all(connection, block_length, position))
+			{
+				return FALSE;
+			}
+		}
+		else
+		{
+			gpointer compressed;
+
+			if (compressed_length > j_compression_bound(connection->compression, block_length))
+			{
+				return FALSE;
+			}
+
+			compressed = j_compression_get_buffer(compressed_length);
+
+			if (!j_network_connection_recv_all(connection, compressed_length, compressed)
+			    || !j_compression_decompress(connection->compression, compressed, compressed_length, position, block_length))
+			{
+				return FALSE;
+			}
+		}
+
+		position += block_length;
+		length -= block_length;
+	}
+
+	return TRUE;
+}
+
+gboolean
+j_network_connection_recv_bulk(JNetworkConnection* connection, gsize length, gpointer data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JNetworkConnectionMemoryID memory_id;
+	JNetworkConnectionAck ack = J_NETWORK_CONNECTION_ACK;
+
+	g_return_val_if_fail(connection != NULL, FALSE);
+	g_return_val_if_fail(data != NULL || length == 0, FALSE);
+
+	if (connection->compression != J_CONFIGURATION_COMPRESSION_NONE && length >= J_COMPRESSION_THRESHOLD)
+	{
+		return j_network_connection_recv_compressed(connection, length, data);
+	}
+
+	if (!j_network_connection_use_rma(connection, length))
+	{
+		return j_network_connection_recv_all(connection, length, data);
 	}
 
-	return connection;
+	if (!j_network_connection_recv_all(connection, sizeof(memory_id), &memory_id))
+	{
+		return FALSE;
+	}
 
-end:
-	/// \todo clean up connection
-	return NULL;
+	g_return_val_if_fail(memory_id.size == length, FALSE);
+
+	if (!j_network_connection_rma_read(connection, &memory_id, data) || !j_network_connection_wait_for_completion(connection))
+	{
+		return FALSE;
+	}
+
+	// The other party has to keep the memory registered until it has been read
+	return j_network_connection_send_all(connection, &ack, sizeof(ack));
 }
 
 gboolean
-j_network_connection_send(JNetworkConnection* connection, gpointer data, gsize data_len)
+j_network_connection_set_multiplexed(JNetworkConnection* connection, gboolean multiplexed)
 {
 	J_TRACE_FUNCTION(NULL);
 
-	gboolean ret = FALSE;
+	g_return_val_if_fail(connection != NULL, FALSE);
 
-	gint res;
-	gpointer context;
-	gsize size;
+	// libfabric connections share their completion queues between sending and receiving
+	// Shared-memory connections use the socket for doorbells, which can not be told apart when multiple threads wait
+	if ((connection->socket_connection == NULL || connection->shm.segment != NULL) && multiplexed)
+	{
+		return FALSE;
+	}
 
-	// we used paired endponits -> inject and send don't need destination addr (last parameter)
+	connection->multiplex.enabled = multiplexed;
 
-	if (data_len < connection->inject_size)
+	return TRUE;
+}
+
+gboolean
+j_network_connection_get_multiplexed(JNetworkConnection* connection)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_val_if_fail(connection != NULL, FALSE);
+
+	return connection->multiplex.enabled;
+}
+
+gboolean
+j_network_connection_set_compression(JNetworkConnection* connection, JConfigurationCompression compression)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_val_if_fail(connection != NULL, FALSE);
+
+	if (compression != J_CONFIGURATION_COMPRESSION_NONE)
 	{
-		do
+		// libfabric connections transfer large data via RMA, which can not be compressed
+		// Shared-memory connections do not benefit from compression
+		if (connection->socket_connection == NULL || connection->shm.segment != NULL || !j_compression_available(compression))
 		{
-			res = fi_inject(connection->ep, data, data_len, 0);
-		} while (res == -FI_EAGAIN);
+			return FALSE;
+		}
+	}
 
-		CHECK("Failed to inject data!");
+	connection->compression = compression;
 
-		ret = TRUE;
-		goto end;
+	return TRUE;
+}
+
+JConfigurationCompression
+j_network_connection_get_compression(JNetworkConnection* connection)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_val_if_fail(connection != NULL, J_CONFIGURATION_COMPRESSION_NONE);
+
+	return connection->compression;
+}
+
+void
+j_network_connection_lock_send(JNetworkConnection* connection)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_if_fail(connection != NULL);
+
+	if (connection->multiplex.enabled)
+	{
+		g_mutex_lock(connection->multiplex.send_mutex);
 	}
+}
 
-	// normal send
-	if (connection->memory.active)
+void
+j_network_connection_unlock_send(JNetworkConnection* connection)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_if_fail(connection != NULL);
+
+	if (connection->multiplex.enabled)
 	{
-		uint8_t* segment = (uint8_t*)connection->memory.buffer + connection->memory.used;
+		g_mutex_unlock(connection->multiplex.send_mutex);
+	}
+}
 
-		context = segment;
-		memcpy(segment + connection->memory.tx_prefix_size, data, data_len);
-		size = data_len + connection->memory.tx_prefix_size;
+gboolean
+j_network_connection_acquire_recv(JNetworkConnection* connection, guint32 id, gpointer* data)
+{
+	J_TRACE_FUNCTION(NULL);
 
-		do
-		{
-			res = fi_send(connection->ep, segment, size, fi_mr_desc(connection->memory.mr), 0, context);
-		} while (res == -FI_EAGAIN);
+	GThread* self;
+	gboolean ret = FALSE;
 
-		CHECK("Failed to initelize sending!");
+	g_return_val_if_fail(connection != NULL, FALSE);
+	g_return_val_if_fail(connection->multiplex.enabled, FALSE);
+	g_return_val_if_fail(data != NULL, FALSE);
 
-		connection->memory.used += size;
+	self = g_thread_self();
+	*data = NULL;
 
-		g_assert_true(connection->memory.used <= connection->memory.buffer_size);
-		g_assert_true(connection->running_actions.msg_len + 1 < J_NETWORK_CONNECTION_MAX_SEND + J_NETWORK_CONNECTION_MAX_RECV);
-	}
-	else
+	g_mutex_lock(connection->multiplex.mutex);
+
+	while (TRUE)
 	{
-		context = data;
-		size = data_len;
+		if (connection->multiplex.handoff != NULL && connection->multiplex.handoff_id == id)
+		{
+			*data = connection->multiplex.handoff;
+			connection->multiplex.handoff = NULL;
+			connection->multiplex.receiver = self;
+			ret = TRUE;
+			break;
+		}
 
-		do
+		if (connection->multiplex.receiver == self)
 		{
-			res = fi_send(connection->ep, data, size, NULL, 0, context);
-		} while (res == -FI_EAGAIN);
-	}
+			ret = TRUE;
+			break;
+		}
 
-	connection->running_actions.msg_entry[connection->running_actions.msg_len].context = context;
-	connection->running_actions.msg_entry[connection->running_actions.msg_len].dest = NULL;
-	connection->running_actions.msg_entry[connection->running_actions.msg_len].len = 0;
-	connection->running_actions.msg_len++;
+		if (connection->closed)
+		{
+			break;
+		}
 
-	ret = TRUE;
+		// The data following a handed off header belongs to its recipient
+		if (connection->multiplex.receiver == NULL && connection->multiplex.handoff == NULL)
+		{
+			connection->multiplex.receiver = self;
+			ret = TRUE;
+			break;
+		}
+
+		g_cond_wait(connection->multiplex.cond, connection->multiplex.mutex);
+	}
+
+	g_mutex_unlock(connection->multiplex.mutex);
 
-end:
 	return ret;
 }
 
-gboolean
-j_network_connection_recv(JNetworkConnection* connection, gsize data_len, gpointer data)
+void
+j_network_connection_handoff_recv(JNetworkConnection* connection, guint32 id, gpointer data)
 {
 	J_TRACE_FUNCTION(NULL);
 
-	gboolean ret = FALSE;
+	g_return_if_fail(connection != NULL);
+	g_return_if_fail(connection->multiplex.enabled);
+	g_return_if_fail(data != NULL);
 
-	gint res;
-	gpointer segment;
-	gsize size;
+	g_mutex_lock(connection->multiplex.mutex);
 
-	segment = connection->memory.active ? (char*)connection->memory.buffer + connection->memory.used : data;
-	size = data_len + connection->memory.rx_prefix_size;
+	g_warn_if_fail(connection->multiplex.receiver == g_thread_self());
+	g_warn_if_fail(connection->multiplex.handoff == NULL);
 
-	res = fi_recv(connection->ep, segment, size, connection->memory.active ? fi_mr_desc(connection->memory.mr) : NULL, 0, segment);
-	CHECK("Failed to initelized receiving!");
+	connection->multiplex.handoff = data;
+	connection->multiplex.handoff_id = id;
+	connection->multiplex.receiver = NULL;
 
-	if (connection->memory.active)
-	{
-		connection->memory.used += size;
+	g_cond_broadcast(connection->multiplex.cond);
+	g_mutex_unlock(connection->multiplex.mutex);
+}
 
-		g_assert_true(connection->memory.used <= connection->memory.buffer_size);
-		g_assert_true(connection->running_actions.msg_len < J_NETWORK_CONNECTION_MAX_SEND + J_NETWORK_CONNECTION_MAX_RECV);
+void
+j_network_connection_release_recv(JNetworkConnection* connection)
+{
+	J_TRACE_FUNCTION(NULL);
 
-		connection->running_actions.msg_entry[connection->running_actions.msg_len].context = segment;
-		connection->running_actions.msg_entry[connection->running_actions.msg_len].dest = data;
-		connection->running_actions.msg_entry[connection->running_actions.msg_len].len = data_len;
+	g_return_if_fail(connection != NULL);
+
+	if (!connection->multiplex.enabled)
+	{
+		return;
 	}
-	else
+
+	g_mutex_lock(connection->multiplex.mutex);
+
+	if (connection->multiplex.receiver == g_thread_self())
 	{
-		connection->running_actions.msg_entry[connection->running_actions.msg_len].context = segment;
-		connection->running_actions.msg_entry[connection->running_actions.msg_len].dest = NULL;
-		connection->running_actions.msg_entry[connection->running_actions.msg_len].len = 0;
+		connection->multiplex.receiver = NULL;
+		g_cond_broadcast(connection->multiplex.cond);
 	}
 
-	connection->running_actions.msg_len++;
+	g_mutex_unlock(connection->multiplex.mutex);
+}
 
-	return TRUE;
+gsize
+j_network_connection_get_available(JNetworkConnection* connection)
+{
+	J_TRACE_FUNCTION(NULL);
 
-end:
-	return ret;
+	g_return_val_if_fail(connection != NULL, 0);
+
+	if (connection->shm.segment != NULL)
+	{
+		return j_network_connection_shm_used(connection->shm.recv);
+	}
+
+	if (connection->socket_connection == NULL)
+	{
+		return 0;
+	}
+
+	return g_buffered_input_stream_get_available(G_BUFFERED_INPUT_STREAM(connection->input_stream));
 }
 
-gboolean
-j_network_connection_closed(JNetworkConnection* connection)
+/**
+ * Copies data out of the receive ring without consuming it.
+ *
+ * \param ring     A ring.
+ * \param length   The data length, at most the number of used bytes.
+ * \param data     A buffer to copy into.
+ **/
+static void
+j_network_connection_shm_peek(JNetworkShmRing* ring, gsize length, gpointer data)
 {
 	J_TRACE_FUNCTION(NULL);
 
-	return connection->closed;
+	guint offset;
+	gsize length_first;
+
+	offset = (guint)g_atomic_int_get(&(ring->tail)) & (J_NETWORK_SHM_RING_SIZE - 1);
+	length_first = MIN(length, J_NETWORK_SHM_RING_SIZE - offset);
+
+	memcpy(data, ring->data + offset, length_first);
+	memcpy((gchar*)data + length_first, ring->data, length - length_first);
 }
 
 gboolean
-j_network_connection_wait_for_completion(JNetworkConnection* connection)
+j_network_connection_peek(JNetworkConnection* connection, gsize length, gpointer data)
 {
 	J_TRACE_FUNCTION(NULL);
 
-	gboolean ret = FALSE;
+	g_return_val_if_fail(connection != NULL, FALSE);
+	g_return_val_if_fail(data != NULL, FALSE);
 
-	struct fi_cq_entry entry;
+	if (j_network_connection_get_available(connection) < length)
+	{
+		return FALSE;
+	}
 
-	gint res;
-	gint i;
+	if (connection->shm.segment != NULL)
+	{
+		j_network_connection_shm_peek(connection->shm.recv, length, data);
 
-	while (connection->running_actions.rma_len + connection->running_actions.msg_len)
+		return TRUE;
+	}
+
+	return (g_buffered_input_stream_peek(G_BUFFERED_INPUT_STREAM(connection->input_stream), data, 0, length) == length);
+}
+
+gboolean
+j_network_connection_buffer(JNetworkConnection* connection, gsize length, gboolean readable, gboolean* buffered)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_val_if_fail(connection != NULL, FALSE);
+	g_return_val_if_fail(connection->socket_connection != NULL, FALSE);
+	g_return_val_if_fail(buffered != NULL, FALSE);
+
+	if (connection->shm.segment != NULL)
 	{
-		gboolean rx;
+		JNetworkShmRing* ring = connection->shm.recv;
 
-		do
+		// The doorbell has been sent because new data has been written
+		if (readable && connection->shm.doorbell_expected)
 		{
-			rx = TRUE;
-			res = fi_cq_read(connection->cq.rx, &entry, 1);
+			connection->shm.doorbell_expected = FALSE;
 
-			if (res == -FI_EAGAIN)
+			if (!j_network_connection_shm_doorbell_wait(connection))
 			{
-				rx = FALSE;
-				res = fi_cq_read(connection->cq.tx, &entry, 1);
+				return FALSE;
 			}
-		} while (res == -FI_EAGAIN);
+		}
 
-		if (res == -FI_EAVAIL)
+		// Data that does not fit into the ring can only be received while the other party is still writing
+		if (j_network_connection_shm_used(ring) >= MIN(length, J_NETWORK_SHM_RING_SIZE))
 		{
-			JNetworkConnectionEvents event;
-
-			struct fi_cq_err_entry err_entry;
+			*buffered = TRUE;
+			return TRUE;
+		}
 
-			j_network_connection_sread_event(connection, 0, &event);
+		if (!connection->shm.doorbell_expected)
+		{
+			g_atomic_int_set(&(ring->data_waiting), 1);
 
-			if (event == J_CONNECTION_EVENT_SHUTDOWN)
+			// The other party might have written the missing data before noticing the flag
+			if (j_network_connection_shm_used(ring) >= MIN(length, J_NETWORK_SHM_RING_SIZE))
 			{
-				connection->closed = TRUE;
-				goto end;
+				// The other party has already cleared the flag, so its doorbell is on the way and will be consumed when receiving
+				if (!g_atomic_int_compare_and_exchange(&(ring->data_waiting), 1, 0))
+				{
+					connection->shm.doorbell_expected = TRUE;
+				}
+
+				*buffered = TRUE;
+				return TRUE;
 			}
 
-			res = fi_cq_readerr(rx ? connection->cq.rx : connection->cq.tx, &err_entry, 0);
-			CHECK("Failed to read error of cq!");
+			connection->shm.doorbell_expected = TRUE;
+		}
 
-			g_warning("Failed to read completion queue\nWidth:\t%s", fi_cq_strerror(rx ? connection->cq.rx : connection->cq.tx, err_entry.prov_errno, err_entry.err_data, NULL, 0));
+		*buffered = FALSE;
+		return TRUE;
+	}
 
-			goto end;
-		}
-		else
-		{
-			CHECK("Failed to read completion queue!");
-		}
+	// The length is untrusted, so do not grow the buffer for large data
+	length = MIN(length, g_buffered_input_stream_get_buffer_size(G_BUFFERED_INPUT_STREAM(connection->input_stream)));
 
-		for (i = 0; i <= connection->running_actions.msg_len; i++)
-		{
-			if (i == connection->running_actions.msg_len)
-			{
-				// If there is no match -> it's an rma transafer -> context = memory region
-				res = fi_close(&((struct fid_mr*)entry.op_context)->fid);
-				CHECK("Failed to free receiving memory!");
+	if (readable && j_network_connection_get_available(connection) < length)
+	{
+		GBufferedInputStream* input_stream = G_BUFFERED_INPUT_STREAM(connection->input_stream);
+		GError* error = NULL;
+		gssize bytes_read;
 
-				connection->running_actions.rma_len--;
-			}
-			if (connection->running_actions.msg_entry[i].context == entry.op_context)
-			{
-				connection->running_actions.msg_len--;
+		// A readable socket returns the available data right away, so this does not block
+		// Reading as much as fits into the buffer allows buffering the following messages using the same system call
+		bytes_read = g_buffered_input_stream_fill(input_stream, g_buffered_input_stream_get_buffer_size(input_stream) - j_network_connection_get_available(connection), NULL, &error);
 
-				if (connection->running_actions.msg_entry[i].dest)
-				{
-					memcpy(connection->running_actions.msg_entry[i].dest, connection->running_actions.msg_entry[i].context, connection->running_actions.msg_entry[i].len);
-				}
+		if (bytes_read < 0)
+		{
+			g_warning("Failed to receive data: %s", error->message);
+			g_error_free(error);
 
-				connection->running_actions.msg_entry[i] = connection->running_actions.msg_entry[connection->running_actions.msg_len];
+			return FALSE;
+		}
 
-				break;
-			}
+		if (bytes_read == 0)
+		{
+			// The other party closed the connection
+			connection->closed = TRUE;
+
+			return FALSE;
 		}
 	}
 
-	connection->memory.used = 0;
+	*buffered = (j_network_connection_get_available(connection) >= length);
 
 	return TRUE;
+}
 
-end:
-	// g_message("\t\toverhead: %f", (double)(sum)/CLOCKS_PER_SEC);
-	return ret;
+GSocketConnection*
+j_network_connection_get_socket_connection(JNetworkConnection* connection)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_val_if_fail(connection != NULL, NULL);
+
+	// Data of shared-memory connections must not be written to the socket
+	if (connection->shm.segment != NULL)
+	{
+		return NULL;
+	}
+
+	return connection->socket_connection;
 }
 
 gboolean
@@ -1092,6 +2428,8 @@ j_network_connection_rma_register(JNetworkConnection* connection, gconstpointer
 
 	gint res;
 
+	g_return_val_if_fail(connection->socket_connection == NULL, FALSE);
+
 	res = fi_mr_reg(connection->domain, data, data_len, FI_REMOTE_READ, 0, connection->next_key, 0, &handle->memory_region, NULL);
 	CHECK("Failed to register memory region!");
 
@@ -1112,6 +2450,8 @@ j_network_connection_rma_unregister(JNetworkConnection* connection, JNetworkConn
 
 	gint res;
 
+	g_return_val_if_fail(connection->socket_connection == NULL, FALSE);
+
 	connection->next_key = KEY_MIN;
 
 	res = fi_close(&handle->memory_region->fid);
@@ -1148,6 +2488,8 @@ j_network_connection_rma_read(JNetworkConnection* connection, const JNetworkConn
 	/// \todo static? thread-safety
 	static unsigned key = 0;
 
+	g_return_val_if_fail(connection->socket_connection == NULL, FALSE);
+
 	res = fi_mr_reg(connection->domain, data, memoryID->size, FI_READ, 0, ++key, 0, &mr, 0);
 	CHECK("Failed to register receiving memory!");
 
@@ -1186,6 +2528,30 @@ j_network_connection_fini(JNetworkConnection* connection)
 
 	gint res;
 
+	if (connection->socket_connection != NULL)
+	{
+		if (connection->shm.segment != NULL)
+		{
+			munmap(connection->shm.segment, sizeof(JNetworkShmSegment));
+		}
+
+		// The base stream is closed together with the socket connection
+		g_filter_input_stream_set_close_base_stream(G_FILTER_INPUT_STREAM(connection->input_stream), FALSE);
+		g_object_unref(connection->input_stream);
+
+		g_io_stream_close(G_IO_STREAM(connection->socket_connection), NULL, NULL);
+		g_object_unref(connection->socket_connection);
+
+		g_free(connection->multiplex.handoff);
+		g_mutex_clear(connection->multiplex.send_mutex);
+		g_mutex_clear(connection->multiplex.mutex);
+		g_cond_clear(connection->multiplex.cond);
+
+		g_free(connection);
+
+		return TRUE;
+	}
+
 	res = fi_shutdown(connection->ep, 0);
 	CHECK("failed to send shutdown signal");
 
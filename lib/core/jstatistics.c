@@ -82,6 +82,16 @@ struct JStatistics
 	 * The number of sent bytes.
 	 **/
 	guint64 bytes_sent;
+
+	/**
+	 * The number of opens saved by reusing cached handles.
+	 **/
+	guint64 opens_saved;
+
+	/**
+	 * The number of closes saved by reusing cached handles.
+	 **/
+	guint64 closes_saved;
 };
 
 static gchar const*
@@ -107,6 +117,10 @@ j_statistics_get_type_name(JStatisticsType type)
 			return "bytes_received";
 		case J_STATISTICS_BYTES_SENT:
 			return "bytes_sent";
+		case J_STATISTICS_OPENS_SAVED:
+			return "opens_saved";
+		case J_STATISTICS_CLOSES_SAVED:
+			return "closes_saved";
 		default:
 			g_warn_if_reached();
 			return NULL;
@@ -130,6 +144,8 @@ j_statistics_new(gboolean trace)
 	statistics->bytes_written = 0;
 	statistics->bytes_received = 0;
 	statistics->bytes_sent = 0;
+	statistics->opens_saved = 0;
+	statistics->closes_saved = 0;
 
 	return statistics;
 }
@@ -179,6 +195,12 @@ j_statistics_get(JStatistics* statistics, JStatisticsType type)
 		case J_STATISTICS_BYTES_SENT:
 			value = statistics->bytes_sent;
 			break;
+		case J_STATISTICS_OPENS_SAVED:
+			value = statistics->opens_saved;
+			break;
+		case J_STATISTICS_CLOSES_SAVED:
+			value = statistics->closes_saved;
+			break;
 		default:
 			g_warn_if_reached();
 			break;
@@ -220,6 +242,12 @@ j_statistics_add(JStatistics* statistics, JStatisticsType type, guint64 value)
 		case J_STATISTICS_BYTES_SENT:
 			statistics->bytes_sent += value;
 			break;
+		case J_STATISTICS_OPENS_SAVED:
+			statistics->opens_saved += value;
+			break;
+		case J_STATISTICS_CLOSES_SAVED:
+			statistics->closes_saved += value;
+			break;
 		default:
 			g_warn_if_reached();
 			break;
@@ -31,6 +31,30 @@
 
 #include <julea.h>
 
+/**
+ * A key-value pair of a range.
+ **/
+struct JKVIteratorEntry
+{
+	gchar* key;
+	gpointer value;
+	guint32 len;
+};
+
+typedef struct JKVIteratorEntry JKVIteratorEntry;
+
+/**
+ * A key-value pair of a received frame.
+ **/
+struct JKVIteratorFrameEntry
+{
+	gchar const* key;
+	gconstpointer value;
+	guint32 len;
+};
+
+typedef struct JKVIteratorFrameEntry JKVIteratorFrameEntry;
+
 /**
  * \ingroup JKVIterator
  **/
@@ -54,28 +78,180 @@ struct JKVIterator
 	gconstpointer value;
 	guint32 len;
 
-	JMessage** replies;
-	guint32 replies_n;
-	guint32 replies_cur;
+	/**
+	 * The namespace and prefix, used to request the entries of each server.
+	 **/
+	gchar* namespace;
+	gchar* prefix;
+
+	/**
+	 * The next server to request entries from and the last one to iterate over.
+	 **/
+	guint32 index_next;
+	guint32 index_last;
+
+	/**
+	 * The entries of the server that is currently being iterated over.
+	 * Servers send their entries in frames, all of which are received before iterating over them.
+	 * This allows returning the connection right away, so that operations started while iterating do not block on it.
+	 **/
+	struct
+	{
+		/**
+		 * The received frames, which own the entries' data.
+		 **/
+		GPtrArray* frames;
+
+		/**
+		 * The entries, pointing into the frames.
+		 **/
+		GArray* entries;
+		guint position;
+	} request;
+
+	/**
+	 * The range, entries is NULL if the iterator does not iterate over a range.
+	 * The entries of all servers are received at once and merged.
+	 **/
+	struct
+	{
+		gchar* start;
+		gchar* end;
+		guint32 limit;
+
+		GPtrArray* entries;
+		guint position;
+	} range;
 
 	gboolean done;
 };
 
-static JMessage*
-fetch_reply(guint32 index, gchar const* namespace, gchar const* prefix)
+static void
+j_kv_iterator_frame_free(gpointer data)
+{
+	j_message_unref(data);
+}
+
+static void
+j_kv_iterator_entry_free(gpointer data)
+{
+	JKVIteratorEntry* entry = data;
+
+	g_free(entry->key);
+	g_free(entry->value);
+	g_free(entry);
+}
+
+static gint
+j_kv_iterator_entry_compare(gconstpointer a, gconstpointer b)
+{
+	JKVIteratorEntry const* x = *((JKVIteratorEntry* const*)a);
+	JKVIteratorEntry const* y = *((JKVIteratorEntry* const*)b);
+
+	return strcmp(x->key, y->key);
+}
+
+static void
+j_kv_iterator_entry_add(JKVIterator* iterator, gchar const* key, gconstpointer value, guint32 len)
+{
+	JKVIteratorEntry* entry;
+
+	entry = g_new(JKVIteratorEntry, 1);
+	entry->key = g_strdup(key);
+#if GLIB_CHECK_VERSION(2, 68, 0)
+	entry->value = g_memdup2(value, len);
+#else
+	entry->value = g_memdup(value, len);
+#endif
+	entry->len = len;
+
+	g_ptr_array_add(iterator->range.entries, entry);
+}
+
+/**
+ * Receives all frames of a request and returns the connection.
+ *
+ * \param iterator   A JKVIterator.
+ * \param index      The server's index.
+ * \param message    The request.
+ * \param connection The connection the request has been sent on.
+ **/
+static void
+j_kv_iterator_receive(JKVIterator* iterator, guint32 index, JMessage* message, gpointer connection)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gboolean done = FALSE;
+
+	g_array_set_size(iterator->request.entries, 0);
+	g_ptr_array_set_size(iterator->request.frames, 0);
+	iterator->request.position = 0;
+
+	while (!done)
+	{
+		JMessage* reply;
+		guint32 count;
+
+		reply = j_message_new_reply(message);
+
+		if (!j_message_receive(reply, connection))
+		{
+			j_message_unref(reply);
+			break;
+		}
+
+		g_ptr_array_add(iterator->request.frames, reply);
+		count = j_message_get_count(reply);
+
+		if (count == 0)
+		{
+			g_warn_if_reached();
+			break;
+		}
+
+		for (guint32 i = 0; i < count; i++)
+		{
+			JKVIteratorFrameEntry entry;
+
+			entry.len = j_message_get_4(reply);
+
+			// The last frame ends with an empty entry
+			if (entry.len == 0)
+			{
+				done = TRUE;
+				break;
+			}
+
+			entry.value = j_message_get_n(reply, entry.len);
+			entry.key = j_message_get_string(reply);
+
+			g_array_append_val(iterator->request.entries, entry);
+		}
+	}
+
+	j_connection_pool_push(J_BACKEND_TYPE_KV, index, connection);
+}
+
+/**
+ * Requests and receives the entries of the next server.
+ *
+ * \param iterator A JKVIterator.
+ **/
+static void
+j_kv_iterator_fetch(JKVIterator* iterator)
 {
 	J_TRACE_FUNCTION(NULL);
 
 	g_autoptr(JMessage) message = NULL;
-	JMessage* reply;
 	JMessageType message_type;
 	gpointer kv_connection;
 	gsize namespace_len;
 	gsize prefix_len;
+	guint32 index;
 
-	namespace_len = strlen(namespace) + 1;
+	namespace_len = strlen(iterator->namespace) + 1;
 
-	if (prefix == NULL)
+	if (iterator->prefix == NULL)
 	{
 		message_type = J_MESSAGE_KV_GET_ALL;
 		prefix_len = 0;
@@ -83,38 +259,150 @@ fetch_reply(guint32 index, gchar const* namespace, gchar const* prefix)
 	else
 	{
 		message_type = J_MESSAGE_KV_GET_BY_PREFIX;
-		prefix_len = strlen(prefix) + 1;
+		prefix_len = strlen(iterator->prefix) + 1;
 	}
 
+	index = iterator->index_next;
+	iterator->index_next++;
+
 	message = j_message_new(message_type, namespace_len + prefix_len);
-	j_message_append_n(message, namespace, namespace_len);
+	j_message_append_n(message, iterator->namespace, namespace_len);
 
-	if (prefix != NULL)
+	if (iterator->prefix != NULL)
 	{
-		j_message_append_n(message, prefix, prefix_len);
+		j_message_append_n(message, iterator->prefix, prefix_len);
 	}
 
 	kv_connection = j_connection_pool_pop(J_BACKEND_TYPE_KV, index);
 	j_message_send(message, kv_connection);
 
-	reply = j_message_new_reply(message);
-	j_message_receive(reply, kv_connection);
+	j_kv_iterator_receive(iterator, index, message, kv_connection);
+}
+
+/**
+ * Receives the entries of a range from all servers.
+ *
+ * \param iterator A JKVIterator.
+ **/
+static void
+j_kv_iterator_receive_range(JKVIterator* iterator)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_autofree JMessage** messages = NULL;
+	g_autofree gpointer* connections = NULL;
+	guint32 index_first = iterator->index_next;
+	guint32 index_count = iterator->index_last - iterator->index_next + 1;
+	gsize namespace_len;
+	gsize start_len;
+	gsize end_len = 0;
+	gchar has_end;
+
+	namespace_len = strlen(iterator->namespace) + 1;
+	start_len = strlen(iterator->range.start) + 1;
+	has_end = (iterator->range.end != NULL);
+
+	if (has_end)
+	{
+		end_len = strlen(iterator->range.end) + 1;
+	}
+
+	messages = g_new(JMessage*, index_count);
+	connections = g_new(gpointer, index_count);
+
+	// Send all requests first, so that the servers scan their ranges in parallel
+	for (guint32 i = 0; i < index_count; i++)
+	{
+		messages[i] = j_message_new(J_MESSAGE_KV_GET_RANGE, namespace_len + start_len + 1 + end_len + 4);
+		j_message_append_n(messages[i], iterator->namespace, namespace_len);
+		j_message_append_n(messages[i], iterator->range.start, start_len);
+		j_message_append_1(messages[i], &has_end);
+
+		if (has_end)
+		{
+			j_message_append_n(messages[i], iterator->range.end, end_len);
+		}
 
-	j_connection_pool_push(J_BACKEND_TYPE_KV, index, kv_connection);
+		j_message_append_4(messages[i], &(iterator->range.limit));
+
+		connections[i] = j_connection_pool_pop(J_BACKEND_TYPE_KV, index_first + i);
+		j_message_send(messages[i], connections[i]);
+	}
+
+	for (guint32 i = 0; i < index_count; i++)
+	{
+		j_kv_iterator_receive(iterator, index_first + i, messages[i], connections[i]);
+		j_message_unref(messages[i]);
 
-	return reply;
+		for (guint j = 0; j < iterator->request.entries->len; j++)
+		{
+			JKVIteratorFrameEntry* entry = &g_array_index(iterator->request.entries, JKVIteratorFrameEntry, j);
+
+			j_kv_iterator_entry_add(iterator, entry->key, entry->value, entry->len);
+		}
+	}
+
+	g_array_set_size(iterator->request.entries, 0);
+	g_ptr_array_set_size(iterator->request.frames, 0);
+
+	iterator->index_next = iterator->index_last + 1;
 }
 
-JKVIterator*
-j_kv_iterator_new(gchar const* namespace, gchar const* prefix)
+/**
+ * Reads the entries of a range from the client backend.
+ *
+ * \param iterator  A JKVIterator.
+ * \param namespace The namespace.
+ **/
+static void
+j_kv_iterator_get_range(JKVIterator* iterator, gchar const* namespace)
 {
 	J_TRACE_FUNCTION(NULL);
 
-	JKVIterator* iterator;
+	gboolean sorted;
+	gboolean truncated = FALSE;
 
-	JConfiguration* configuration = j_configuration();
+	sorted = j_backend_kv_get_range(iterator->kv_backend, namespace, iterator->range.start, iterator->range.end, iterator->range.limit, &(iterator->cursor));
 
-	g_return_val_if_fail(namespace != NULL, NULL);
+	// Backends without support for ranges return all keys, which have to be filtered here
+	if (!sorted && !j_backend_kv_get_all(iterator->kv_backend, namespace, &(iterator->cursor)))
+	{
+		return;
+	}
+
+	while (j_backend_kv_iterate(iterator->kv_backend, iterator->cursor, &(iterator->key), &(iterator->value), &(iterator->len)))
+	{
+		GPtrArray* entries = iterator->range.entries;
+
+		if (!sorted && (strcmp(iterator->key, iterator->range.start) < 0 || (iterator->range.end != NULL && strcmp(iterator->key, iterator->range.end) >= 0)))
+		{
+			continue;
+		}
+
+		// Keys larger than the first limit entries can not be part of the range
+		if (truncated && strcmp(iterator->key, ((JKVIteratorEntry*)g_ptr_array_index(entries, iterator->range.limit - 1))->key) >= 0)
+		{
+			continue;
+		}
+
+		j_kv_iterator_entry_add(iterator, iterator->key, iterator->value, iterator->len);
+
+		// Only keep the first entries instead of copying all matching ones
+		if (!sorted && iterator->range.limit > 0 && entries->len >= 2 * (guint64)iterator->range.limit)
+		{
+			g_ptr_array_sort(entries, j_kv_iterator_entry_compare);
+			g_ptr_array_set_size(entries, iterator->range.limit);
+			truncated = TRUE;
+		}
+	}
+}
+
+static JKVIterator*
+j_kv_iterator_alloc(guint32 index_first, guint32 index_last)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JKVIterator* iterator;
 
 	/// \todo still necessary?
 	//j_operation_cache_flush();
@@ -125,17 +413,37 @@ j_kv_iterator_new(gchar const* namespace, gchar const* prefix)
 	iterator->key = NULL;
 	iterator->value = NULL;
 	iterator->len = 0;
-	iterator->replies_n = j_configuration_get_server_count(configuration, J_BACKEND_TYPE_KV);
-	iterator->replies = g_new0(JMessage*, iterator->replies_n);
-	iterator->replies_cur = 0;
-	iterator->done = (iterator->kv_backend == NULL);
+	iterator->namespace = NULL;
+	iterator->prefix = NULL;
+	iterator->index_next = index_first;
+	iterator->index_last = index_last;
+	iterator->request.frames = g_ptr_array_new_with_free_func(j_kv_iterator_frame_free);
+	iterator->request.entries = g_array_new(FALSE, FALSE, sizeof(JKVIteratorFrameEntry));
+	iterator->request.position = 0;
+	iterator->range.start = NULL;
+	iterator->range.end = NULL;
+	iterator->range.limit = 0;
+	iterator->range.entries = NULL;
+	iterator->range.position = 0;
+	iterator->done = FALSE;
+
+	return iterator;
+}
+
+static JKVIterator*
+j_kv_iterator_new_internal(gchar const* namespace, gchar const* prefix, guint32 index_first, guint32 index_last)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JKVIterator* iterator;
+
+	iterator = j_kv_iterator_alloc(index_first, index_last);
 
 	if (iterator->kv_backend == NULL)
 	{
-		for (guint32 i = 0; i < iterator->replies_n; i++)
-		{
-			iterator->replies[i] = fetch_reply(i, namespace, prefix);
-		}
+		// Entries are only requested once the iterator reaches the respective server
+		iterator->namespace = g_strdup(namespace);
+		iterator->prefix = g_strdup(prefix);
 	}
 	else
 	{
@@ -153,50 +461,97 @@ j_kv_iterator_new(gchar const* namespace, gchar const* prefix)
 }
 
 JKVIterator*
-j_kv_iterator_new_for_index(guint32 index, gchar const* namespace, gchar const* prefix)
+j_kv_iterator_new(gchar const* namespace, gchar const* prefix)
 {
 	J_TRACE_FUNCTION(NULL);
 
-	JKVIterator* iterator;
+	JConfiguration* configuration = j_configuration();
+
+	g_return_val_if_fail(namespace != NULL, NULL);
+
+	return j_kv_iterator_new_internal(namespace, prefix, 0, j_configuration_get_server_count(configuration, J_BACKEND_TYPE_KV) - 1);
+}
+
+JKVIterator*
+j_kv_iterator_new_for_index(guint32 index, gchar const* namespace, gchar const* prefix)
+{
+	J_TRACE_FUNCTION(NULL);
 
 	JConfiguration* configuration = j_configuration();
 
 	g_return_val_if_fail(namespace != NULL, NULL);
 	g_return_val_if_fail(index < j_configuration_get_server_count(configuration, J_BACKEND_TYPE_KV), NULL);
 
-	/// \todo still necessary?
-	//j_operation_cache_flush();
+	return j_kv_iterator_new_internal(namespace, prefix, index, index);
+}
 
-	iterator = g_new(JKVIterator, 1);
-	iterator->kv_backend = j_kv_get_backend();
-	iterator->cursor = NULL;
-	iterator->key = NULL;
-	iterator->value = NULL;
-	iterator->len = 0;
-	iterator->replies_n = 1;
-	iterator->replies = g_new0(JMessage*, 1);
-	iterator->replies_cur = 0;
-	iterator->done = (iterator->kv_backend == NULL);
+JKVIterator*
+j_kv_iterator_new_range(gchar const* namespace, gchar const* start, gchar const* end, guint32 limit)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JConfiguration* configuration = j_configuration();
+	JKVIterator* iterator;
+
+	g_return_val_if_fail(namespace != NULL, NULL);
+
+	iterator = j_kv_iterator_alloc(0, j_configuration_get_server_count(configuration, J_BACKEND_TYPE_KV) - 1);
+	iterator->namespace = g_strdup(namespace);
+	iterator->range.start = g_strdup((start != NULL) ? start : "");
+	iterator->range.end = g_strdup(end);
+	iterator->range.limit = limit;
+	iterator->range.entries = g_ptr_array_new_with_free_func(j_kv_iterator_entry_free);
 
 	if (iterator->kv_backend == NULL)
 	{
-		iterator->replies[0] = fetch_reply(index, namespace, prefix);
+		j_kv_iterator_receive_range(iterator);
 	}
 	else
 	{
-		if (prefix == NULL)
-		{
-			j_backend_kv_get_all(iterator->kv_backend, namespace, &(iterator->cursor));
-		}
-		else
-		{
-			j_backend_kv_get_by_prefix(iterator->kv_backend, namespace, prefix, &(iterator->cursor));
-		}
+		j_kv_iterator_get_range(iterator, namespace);
+	}
+
+	// Each server returns its first entries, only the overall first ones are part of the range
+	g_ptr_array_sort(iterator->range.entries, j_kv_iterator_entry_compare);
+
+	if (limit > 0 && iterator->range.entries->len > limit)
+	{
+		g_ptr_array_set_size(iterator->range.entries, limit);
 	}
 
 	return iterator;
 }
 
+JKVIterator*
+j_kv_iterator_new_for_cursor(gchar const* cursor)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_autoptr(GVariant) variant = NULL;
+	guchar* data;
+	gsize len;
+	gchar const* namespace;
+	gchar const* start;
+	gchar const* end;
+	guint32 limit;
+
+	g_return_val_if_fail(cursor != NULL, NULL);
+
+	data = g_base64_decode(cursor, &len);
+	variant = g_variant_new_from_data(G_VARIANT_TYPE("(ssmsu)"), data, len, FALSE, g_free, data);
+	g_variant_ref_sink(variant);
+
+	// Cursors are passed in by users, so they can not be trusted
+	if (!g_variant_is_normal_form(variant))
+	{
+		return NULL;
+	}
+
+	g_variant_get(variant, "(&s&sm&su)", &namespace, &start, &end, &limit);
+
+	return j_kv_iterator_new_range(namespace, start, end, limit);
+}
+
 void
 j_kv_iterator_free(JKVIterator* iterator)
 {
@@ -204,7 +559,11 @@ j_kv_iterator_free(JKVIterator* iterator)
 
 	g_return_if_fail(iterator != NULL);
 
-	if (!iterator->done)
+	if (iterator->range.entries != NULL)
+	{
+		g_ptr_array_unref(iterator->range.entries);
+	}
+	else if (iterator->kv_backend != NULL && !iterator->done)
 	{
 		// There is currently no way to cancel an iterator, so drain it.
 		while (j_kv_iterator_next(iterator))
@@ -212,15 +571,13 @@ j_kv_iterator_free(JKVIterator* iterator)
 		}
 	}
 
-	for (guint32 i = 0; i < iterator->replies_n; i++)
-	{
-		if (iterator->replies[i] != NULL)
-		{
-			j_message_unref(iterator->replies[i]);
-		}
-	}
+	g_array_unref(iterator->request.entries);
+	g_ptr_array_unref(iterator->request.frames);
 
-	g_free(iterator->replies);
+	g_free(iterator->namespace);
+	g_free(iterator->prefix);
+	g_free(iterator->range.start);
+	g_free(iterator->range.end);
 
 	g_free(iterator);
 }
@@ -234,23 +591,43 @@ j_kv_iterator_next(JKVIterator* iterator)
 
 	g_return_val_if_fail(iterator != NULL, FALSE);
 
-	if (iterator->kv_backend == NULL)
+	if (iterator->range.entries != NULL)
 	{
-	retry:
-		iterator->len = j_message_get_4(iterator->replies[iterator->replies_cur]);
-
-		if (iterator->len > 0)
+		if (iterator->range.position < iterator->range.entries->len)
 		{
-			iterator->value = j_message_get_n(iterator->replies[iterator->replies_cur], iterator->len);
-			iterator->key = j_message_get_string(iterator->replies[iterator->replies_cur]);
+			JKVIteratorEntry* entry = g_ptr_array_index(iterator->range.entries, iterator->range.position);
+
+			iterator->key = entry->key;
+			iterator->value = entry->value;
+			iterator->len = entry->len;
+			iterator->range.position++;
 
 			ret = TRUE;
 		}
-		else if (iterator->replies_cur < iterator->replies_n - 1)
+
+		iterator->done = !ret;
+	}
+	else if (iterator->kv_backend == NULL)
+	{
+		// Servers without any entries are skipped
+		while (iterator->request.position == iterator->request.entries->len && iterator->index_next <= iterator->index_last)
+		{
+			j_kv_iterator_fetch(iterator);
+		}
+
+		if (iterator->request.position < iterator->request.entries->len)
 		{
-			iterator->replies_cur++;
-			goto retry;
+			JKVIteratorFrameEntry* entry = &g_array_index(iterator->request.entries, JKVIteratorFrameEntry, iterator->request.position);
+
+			iterator->key = entry->key;
+			iterator->value = entry->value;
+			iterator->len = entry->len;
+			iterator->request.position++;
+
+			ret = TRUE;
 		}
+
+		iterator->done = !ret;
 	}
 	else
 	{
@@ -274,3 +651,41 @@ j_kv_iterator_get(JKVIterator* iterator, gconstpointer* value, guint32* len)
 
 	return iterator->key;
 }
+
+gchar*
+j_kv_iterator_get_cursor(JKVIterator* iterator)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_autoptr(GVariant) variant = NULL;
+	g_autofree gchar* start = NULL;
+	guint position;
+
+	g_return_val_if_fail(iterator != NULL, NULL);
+	g_return_val_if_fail(iterator->range.entries != NULL, NULL);
+
+	position = iterator->range.position;
+
+	// Fewer entries than the limit means that the whole range has been received
+	if (position == iterator->range.entries->len && (iterator->range.limit == 0 || iterator->range.entries->len < iterator->range.limit))
+	{
+		return NULL;
+	}
+
+	if (position == 0)
+	{
+		start = g_strdup(iterator->range.start);
+	}
+	else
+	{
+		JKVIteratorEntry* entry = g_ptr_array_index(iterator->range.entries, position - 1);
+
+		// Appending the smallest possible character results in the smallest key after the current one
+		start = g_strconcat(entry->key, "\x01", NULL);
+	}
+
+	variant = g_variant_new("(ssmsu)", iterator->namespace, start, iterator->range.end, iterator->range.limit);
+	g_variant_ref_sink(variant);
+
+	return g_base64_encode(g_variant_get_data(variant), g_variant_get_size(variant));
+}
@@ -533,7 +533,7 @@ j_kv_new(gchar const* namespace, gchar const* key)
 	g_return_val_if_fail(key != NULL, NULL);
 
 	kv = g_new(JKV, 1);
-	kv->index = j_helper_hash(key) % j_configuration_get_server_count(configuration, J_BACKEND_TYPE_KV);
+	kv->index = j_configuration_get_server_index(configuration, J_BACKEND_TYPE_KV, key);
 	kv->namespace = g_strdup(namespace);
 	kv->key = g_strdup(key);
 	kv->ref_count = 1;
@@ -119,6 +119,12 @@ struct JDistributedObjectOperation
 			guint64 offset;
 			guint64* bytes_written;
 		} write;
+
+		struct
+		{
+			JDistributedObject* object;
+			JDistributedObject* destination;
+		} copy;
 	};
 };
 
@@ -215,6 +221,19 @@ j_distributed_object_write_free(gpointer data)
 	g_free(operation);
 }
 
+static void
+j_distributed_object_copy_free(gpointer data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JDistributedObjectOperation* operation = data;
+
+	j_distributed_object_unref(operation->copy.object);
+	j_distributed_object_unref(operation->copy.destination);
+
+	g_free(operation);
+}
+
 /**
  * Executes create operations in a background operation.
  *
@@ -368,15 +387,19 @@ j_distributed_object_read_background_operation(gpointer data)
 			guint64 nbytes;
 
 			nbytes = j_message_get_8(reply);
-			j_helper_atomic_add(bytes_read, nbytes);
 
-			if (nbytes > 0)
+			// Data within holes is not sent
+			if (nbytes & J_MESSAGE_OBJECT_READ_ZERO)
 			{
-				GInputStream* input;
-
-				input = g_io_stream_get_input_stream(G_IO_STREAM(object_connection));
-				g_input_stream_read_all(input, read_data, nbytes, NULL, NULL, NULL);
+				nbytes &= ~J_MESSAGE_OBJECT_READ_ZERO;
+				memset(read_data, 0, nbytes);
 			}
+			else if (nbytes > 0)
+			{
+				j_network_connection_recv_bulk(object_connection, nbytes, read_data);
+			}
+
+			j_helper_atomic_add(bytes_read, nbytes);
 		}
 
 		operations_done += reply_operation_count;
@@ -552,6 +575,55 @@ j_distributed_object_sync_background_operation(gpointer data)
 	return NULL;
 }
 
+/**
+ * Executes copy operations in a background operation.
+ *
+ * \private
+ *
+ * \param data Background data.
+ *
+ * \return #data.
+ **/
+static gpointer
+j_distributed_object_copy_background_operation(gpointer data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JDistributedObjectBackgroundData* background_data = data;
+
+	g_autoptr(JMessage) reply = NULL;
+	gpointer object_connection;
+
+	object_connection = j_connection_pool_pop(J_BACKEND_TYPE_OBJECT, background_data->index);
+	j_message_send(background_data->message, object_connection);
+
+	reply = j_message_new_reply(background_data->message);
+
+	if (j_message_receive(reply, object_connection) && j_message_get_count(reply) == j_message_get_count(background_data->message))
+	{
+		guint32 operation_count;
+
+		operation_count = j_message_get_count(reply);
+
+		for (guint i = 0; i < operation_count; i++)
+		{
+			guint32 status;
+
+			status = j_message_get_4(reply);
+			background_data->ret = (status == 1) && background_data->ret;
+		}
+	}
+	else
+	{
+		background_data->ret = FALSE;
+	}
+
+	j_message_unref(background_data->message);
+	j_connection_pool_push(J_BACKEND_TYPE_OBJECT, background_data->index, object_connection);
+
+	return data;
+}
+
 static gboolean
 j_distributed_object_create_exec(JList* operations, JSemantics* semantics)
 {
@@ -1362,6 +1434,147 @@ j_distributed_object_sync_exec(JList* operations, JSemantics* semantics)
 	return ret;
 }
 
+static gboolean
+j_distributed_object_copy_exec(JList* operations, JSemantics* semantics)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gboolean ret = TRUE;
+
+	JBackend* object_backend;
+	g_autoptr(JListIterator) it = NULL;
+	g_autofree JMessage** messages = NULL;
+	gchar const* namespace = NULL;
+	gsize namespace_len = 0;
+	guint32 server_count = 0;
+
+	g_return_val_if_fail(operations != NULL, FALSE);
+	g_return_val_if_fail(semantics != NULL, FALSE);
+
+	{
+		JDistributedObjectOperation* operation = j_list_get_first(operations);
+		JDistributedObject* object = operation->copy.object;
+
+		g_assert(operation != NULL);
+		g_assert(object != NULL);
+
+		namespace = object->namespace;
+		namespace_len = strlen(namespace) + 1;
+	}
+
+	it = j_list_iterator_new(operations);
+	object_backend = j_object_get_backend();
+
+	if (object_backend == NULL)
+	{
+		server_count = j_configuration_get_server_count(j_configuration(), J_BACKEND_TYPE_OBJECT);
+		messages = g_new(JMessage*, server_count);
+
+		/// \todo use actual distribution
+		for (guint i = 0; i < server_count; i++)
+		{
+			messages[i] = j_message_new(J_MESSAGE_OBJECT_COPY, namespace_len);
+			j_message_set_semantics(messages[i], semantics);
+			j_message_append_n(messages[i], namespace, namespace_len);
+		}
+	}
+
+	while (j_list_iterator_next(it))
+	{
+		JDistributedObjectOperation* operation = j_list_iterator_get(it);
+		JDistributedObject* object = operation->copy.object;
+		JDistributedObject* destination = operation->copy.destination;
+
+		if (object_backend == NULL)
+		{
+			gsize name_len;
+			gsize destination_namespace_len;
+			gsize destination_name_len;
+
+			name_len = strlen(object->name) + 1;
+			destination_namespace_len = strlen(destination->namespace) + 1;
+			destination_name_len = strlen(destination->name) + 1;
+
+			// Every server copies its own part, the destination has the same layout
+			/// \todo use actual distribution
+			for (guint i = 0; i < server_count; i++)
+			{
+				j_message_add_operation(messages[i], name_len + destination_namespace_len + destination_name_len);
+				j_message_append_n(messages[i], object->name, name_len);
+				j_message_append_n(messages[i], destination->namespace, destination_namespace_len);
+				j_message_append_n(messages[i], destination->name, destination_name_len);
+			}
+		}
+		else
+		{
+			gpointer object_handle;
+			gpointer destination_handle;
+			guint64 bytes_copied;
+
+			// Creating the destination would truncate the source
+			if (g_strcmp0(object->namespace, destination->namespace) == 0 && g_strcmp0(object->name, destination->name) == 0)
+			{
+				ret = FALSE;
+				continue;
+			}
+
+			if (j_backend_object_open(object_backend, object->namespace, object->name, &object_handle))
+			{
+				if (j_backend_object_create(object_backend, destination->namespace, destination->name, &destination_handle))
+				{
+					ret = j_backend_object_copy(object_backend, object_handle, destination_handle, &bytes_copied) && ret;
+					ret = j_backend_object_close(object_backend, destination_handle) && ret;
+				}
+				else
+				{
+					ret = FALSE;
+				}
+
+				ret = j_backend_object_close(object_backend, object_handle) && ret;
+			}
+			else
+			{
+				ret = FALSE;
+			}
+		}
+	}
+
+	if (object_backend == NULL)
+	{
+		g_autofree gpointer* background_data = NULL;
+
+		background_data = g_new(gpointer, server_count);
+
+		/// \todo use actual distribution
+		for (guint i = 0; i < server_count; i++)
+		{
+			JDistributedObjectBackgroundData* data;
+
+			data = g_new(JDistributedObjectBackgroundData, 1);
+			data->index = i;
+			data->message = messages[i];
+			data->operations = NULL;
+			data->semantics = semantics;
+			data->ret = TRUE;
+
+			background_data[i] = data;
+		}
+
+		j_helper_execute_parallel(j_distributed_object_copy_background_operation, background_data, server_count);
+
+		for (guint i = 0; i < server_count; i++)
+		{
+			JDistributedObjectBackgroundData* data = background_data[i];
+
+			ret = data->ret && ret;
+
+			g_free(data);
+		}
+	}
+
+	return ret;
+}
+
 JDistributedObject*
 j_distributed_object_new(gchar const* namespace, gchar const* name, JDistribution* distribution)
 {
@@ -1587,6 +1800,30 @@ j_distributed_object_sync(JDistributedObject* object, JBatch* batch)
 	j_batch_add(batch, operation);
 }
 
+void
+j_distributed_object_copy(JDistributedObject* object, JDistributedObject* destination, JBatch* batch)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JDistributedObjectOperation* iop;
+	JOperation* operation;
+
+	g_return_if_fail(object != NULL);
+	g_return_if_fail(destination != NULL);
+
+	iop = g_new(JDistributedObjectOperation, 1);
+	iop->copy.object = j_distributed_object_ref(object);
+	iop->copy.destination = j_distributed_object_ref(destination);
+
+	operation = j_operation_new();
+	operation->key = object;
+	operation->data = iop;
+	operation->exec_func = j_distributed_object_copy_exec;
+	operation->free_func = j_distributed_object_copy_free;
+
+	j_batch_add(batch, operation);
+}
+
 /**
  * @}
  **/
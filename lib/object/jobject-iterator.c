@@ -50,26 +50,66 @@ struct JObjectIterator
 	 **/
 	gchar const* name;
 
-	JMessage** replies;
-	guint32 replies_n;
-	guint32 replies_cur;
+	/**
+	 * The namespace and prefix, used to request the names of each server.
+	 **/
+	gchar* namespace;
+	gchar* prefix;
+
+	/**
+	 * The next server to request names from and the last one to iterate over.
+	 **/
+	guint32 index_next;
+	guint32 index_last;
+
+	/**
+	 * The names of the server that is currently being iterated over.
+	 * Servers send their names in frames, all of which are received before iterating over them.
+	 * This allows returning the connection right away, so that operations started while iterating do not block on it.
+	 **/
+	struct
+	{
+		/**
+		 * The received frames, which own the names.
+		 **/
+		GPtrArray* frames;
+
+		/**
+		 * The names, pointing into the frames.
+		 **/
+		GPtrArray* names;
+		guint position;
+	} request;
 };
 
-static JMessage*
-fetch_reply(guint32 index, gchar const* namespace, gchar const* prefix)
+static void
+j_object_iterator_frame_free(gpointer data)
+{
+	j_message_unref(data);
+}
+
+/**
+ * Requests and receives the names of the next server.
+ * The connection is returned as soon as all frames have been received.
+ *
+ * \param iterator A JObjectIterator.
+ **/
+static void
+j_object_iterator_fetch(JObjectIterator* iterator)
 {
 	J_TRACE_FUNCTION(NULL);
 
 	g_autoptr(JMessage) message = NULL;
-	JMessage* reply;
 	JMessageType message_type;
 	gpointer object_connection;
 	gsize namespace_len;
 	gsize prefix_len;
+	guint32 index;
+	gboolean done = FALSE;
 
-	namespace_len = strlen(namespace) + 1;
+	namespace_len = strlen(iterator->namespace) + 1;
 
-	if (prefix == NULL)
+	if (iterator->prefix == NULL)
 	{
 		message_type = J_MESSAGE_OBJECT_GET_ALL;
 		prefix_len = 0;
@@ -77,56 +117,96 @@ fetch_reply(guint32 index, gchar const* namespace, gchar const* prefix)
 	else
 	{
 		message_type = J_MESSAGE_OBJECT_GET_BY_PREFIX;
-		prefix_len = strlen(prefix) + 1;
+		prefix_len = strlen(iterator->prefix) + 1;
 	}
 
+	index = iterator->index_next;
+	iterator->index_next++;
+
+	g_ptr_array_set_size(iterator->request.names, 0);
+	g_ptr_array_set_size(iterator->request.frames, 0);
+	iterator->request.position = 0;
+
 	message = j_message_new(message_type, namespace_len + prefix_len);
-	j_message_append_n(message, namespace, namespace_len);
+	j_message_append_n(message, iterator->namespace, namespace_len);
 
-	if (prefix != NULL)
+	if (iterator->prefix != NULL)
 	{
-		j_message_append_n(message, prefix, prefix_len);
+		j_message_append_n(message, iterator->prefix, prefix_len);
 	}
 
 	object_connection = j_connection_pool_pop(J_BACKEND_TYPE_OBJECT, index);
 	j_message_send(message, object_connection);
 
-	reply = j_message_new_reply(message);
-	j_message_receive(reply, object_connection);
+	while (!done)
+	{
+		JMessage* reply;
+		guint32 count;
 
-	j_connection_pool_push(J_BACKEND_TYPE_OBJECT, index, object_connection);
+		reply = j_message_new_reply(message);
+
+		if (!j_message_receive(reply, object_connection))
+		{
+			j_message_unref(reply);
+			break;
+		}
 
-	return reply;
+		g_ptr_array_add(iterator->request.frames, reply);
+		count = j_message_get_count(reply);
+
+		if (count == 0)
+		{
+			g_warn_if_reached();
+			break;
+		}
+
+		for (guint32 i = 0; i < count; i++)
+		{
+			gchar const* name;
+
+			name = j_message_get_string(reply);
+
+			// The last frame ends with an empty name
+			if (name[0] == '\0')
+			{
+				done = TRUE;
+				break;
+			}
+
+			g_ptr_array_add(iterator->request.names, (gpointer)name);
+		}
+	}
+
+	j_connection_pool_push(J_BACKEND_TYPE_OBJECT, index, object_connection);
 }
 
-JObjectIterator*
-j_object_iterator_new(gchar const* namespace, gchar const* prefix)
+static JObjectIterator*
+j_object_iterator_new_internal(gchar const* namespace, gchar const* prefix, guint32 index_first, guint32 index_last)
 {
 	J_TRACE_FUNCTION(NULL);
 
 	JObjectIterator* iterator;
 
-	JConfiguration* configuration = j_configuration();
-
-	g_return_val_if_fail(namespace != NULL, NULL);
-
-	//// \todo still necessary?
+	/// \todo still necessary?
 	//j_operation_cache_flush();
 
 	iterator = g_new(JObjectIterator, 1);
 	iterator->object_backend = j_object_get_backend();
 	iterator->cursor = NULL;
 	iterator->name = NULL;
-	iterator->replies_n = j_configuration_get_server_count(configuration, J_BACKEND_TYPE_OBJECT);
-	iterator->replies = g_new0(JMessage*, iterator->replies_n);
-	iterator->replies_cur = 0;
+	iterator->namespace = NULL;
+	iterator->prefix = NULL;
+	iterator->index_next = index_first;
+	iterator->index_last = index_last;
+	iterator->request.frames = g_ptr_array_new_with_free_func(j_object_iterator_frame_free);
+	iterator->request.names = g_ptr_array_new();
+	iterator->request.position = 0;
 
 	if (iterator->object_backend == NULL)
 	{
-		for (guint32 i = 0; i < iterator->replies_n; i++)
-		{
-			iterator->replies[i] = fetch_reply(i, namespace, prefix);
-		}
+		// Names are only requested once the iterator reaches the respective server
+		iterator->namespace = g_strdup(namespace);
+		iterator->prefix = g_strdup(prefix);
 	}
 	else
 	{
@@ -144,45 +224,28 @@ j_object_iterator_new(gchar const* namespace, gchar const* prefix)
 }
 
 JObjectIterator*
-j_object_iterator_new_for_index(guint32 index, gchar const* namespace, gchar const* prefix)
+j_object_iterator_new(gchar const* namespace, gchar const* prefix)
 {
 	J_TRACE_FUNCTION(NULL);
 
-	JObjectIterator* iterator;
-
 	JConfiguration* configuration = j_configuration();
 
 	g_return_val_if_fail(namespace != NULL, NULL);
-	g_return_val_if_fail(index < j_configuration_get_server_count(configuration, J_BACKEND_TYPE_OBJECT), NULL);
 
-	/// \todo still necessary?
-	//j_operation_cache_flush();
+	return j_object_iterator_new_internal(namespace, prefix, 0, j_configuration_get_server_count(configuration, J_BACKEND_TYPE_OBJECT) - 1);
+}
 
-	iterator = g_new(JObjectIterator, 1);
-	iterator->object_backend = j_object_get_backend();
-	iterator->cursor = NULL;
-	iterator->name = NULL;
-	iterator->replies_n = 1;
-	iterator->replies = g_new0(JMessage*, 1);
-	iterator->replies_cur = 0;
+JObjectIterator*
+j_object_iterator_new_for_index(guint32 index, gchar const* namespace, gchar const* prefix)
+{
+	J_TRACE_FUNCTION(NULL);
 
-	if (iterator->object_backend == NULL)
-	{
-		iterator->replies[0] = fetch_reply(index, namespace, prefix);
-	}
-	else
-	{
-		if (prefix == NULL)
-		{
-			/// \todo j_backend_object_get_all(iterator->object_backend, namespace, &(iterator->cursor));
-		}
-		else
-		{
-			/// \todo j_backend_object_get_by_prefix(iterator->object_backend, namespace, prefix, &(iterator->cursor));
-		}
-	}
+	JConfiguration* configuration = j_configuration();
 
-	return iterator;
+	g_return_val_if_fail(namespace != NULL, NULL);
+	g_return_val_if_fail(index < j_configuration_get_server_count(configuration, J_BACKEND_TYPE_OBJECT), NULL);
+
+	return j_object_iterator_new_internal(namespace, prefix, index, index);
 }
 
 void
@@ -192,15 +255,11 @@ j_object_iterator_free(JObjectIterator* iterator)
 
 	g_return_if_fail(iterator != NULL);
 
-	for (guint32 i = 0; i < iterator->replies_n; i++)
-	{
-		if (iterator->replies[i] != NULL)
-		{
-			j_message_unref(iterator->replies[i]);
-		}
-	}
+	g_ptr_array_unref(iterator->request.names);
+	g_ptr_array_unref(iterator->request.frames);
 
-	g_free(iterator->replies);
+	g_free(iterator->namespace);
+	g_free(iterator->prefix);
 
 	g_free(iterator);
 }
@@ -216,17 +275,18 @@ j_object_iterator_next(JObjectIterator* iterator)
 
 	if (iterator->object_backend == NULL)
 	{
-	retry:
-		iterator->name = j_message_get_string(iterator->replies[iterator->replies_cur]);
-
-		if (iterator->name[0] != '\0')
+		// Servers without any names are skipped
+		while (iterator->request.position == iterator->request.names->len && iterator->index_next <= iterator->index_last)
 		{
-			ret = TRUE;
+			j_object_iterator_fetch(iterator);
 		}
-		else if (iterator->replies_cur < iterator->replies_n - 1)
+
+		if (iterator->request.position < iterator->request.names->len)
 		{
-			iterator->replies_cur++;
-			goto retry;
+			iterator->name = g_ptr_array_index(iterator->request.names, iterator->request.position);
+			iterator->request.position++;
+
+			ret = TRUE;
 		}
 	}
 	else
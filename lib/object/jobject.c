@@ -70,6 +70,30 @@ struct JObjectOperation
 			guint64 offset;
 			guint64* bytes_written;
 		} write;
+
+		struct
+		{
+			JObject* object;
+			JObject* destination;
+		} copy;
+
+		/**
+		 * Also used for punching.
+		 **/
+		struct
+		{
+			JObject* object;
+			guint64 length;
+			guint64 offset;
+		} allocate;
+
+		struct
+		{
+			JObject* object;
+			guint64 length;
+			guint64 offset;
+			GArray* extents;
+		} get_extents;
 	};
 };
 
@@ -227,6 +251,44 @@ j_object_write_free(gpointer data)
 	g_free(operation);
 }
 
+static void
+j_object_copy_free(gpointer data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JObjectOperation* operation = data;
+
+	j_object_unref(operation->copy.object);
+	j_object_unref(operation->copy.destination);
+
+	g_free(operation);
+}
+
+static void
+j_object_allocate_free(gpointer data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JObjectOperation* operation = data;
+
+	j_object_unref(operation->allocate.object);
+
+	g_free(operation);
+}
+
+static void
+j_object_get_extents_free(gpointer data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JObjectOperation* operation = data;
+
+	j_object_unref(operation->get_extents.object);
+	g_array_unref(operation->get_extents.extents);
+
+	g_free(operation);
+}
+
 static gboolean
 j_object_create_exec(JList* operations, JSemantics* semantics)
 {
@@ -238,6 +300,7 @@ j_object_create_exec(JList* operations, JSemantics* semantics)
 	JBackend* object_backend;
 	g_autoptr(JListIterator) it = NULL;
 	g_autoptr(JMessage) message = NULL;
+	g_autoptr(GPtrArray) object_handles = NULL;
 	gchar const* namespace;
 	gsize namespace_len;
 	guint32 index;
@@ -273,6 +336,10 @@ j_object_create_exec(JList* operations, JSemantics* semantics)
 		j_message_set_semantics(message, semantics);
 		j_message_append_n(message, namespace, namespace_len);
 	}
+	else
+	{
+		object_handles = g_ptr_array_new();
+	}
 
 	while (j_list_iterator_next(it))
 	{
@@ -292,10 +359,16 @@ j_object_create_exec(JList* operations, JSemantics* semantics)
 			gpointer object_handle;
 
 			ret = j_backend_object_create(object_backend, object->namespace, object->name, &object_handle) && ret;
-			ret = j_backend_object_close(object_backend, object_handle) && ret;
+			g_ptr_array_add(object_handles, object_handle);
 		}
 	}
 
+	// Objects are closed after all have been created, so that asynchronous backends can create them in parallel
+	for (guint i = 0; object_handles != NULL && i < object_handles->len; i++)
+	{
+		ret = j_backend_object_close(object_backend, g_ptr_array_index(object_handles, i)) && ret;
+	}
+
 	if (object_backend == NULL)
 	{
 		JSemanticsPersistency persistency;
@@ -423,6 +496,74 @@ j_object_delete_exec(JList* operations, JSemantics* semantics)
 	return ret;
 }
 
+/**
+ * Reads or writes all operations of a batch using a single backend call.
+ *
+ * \param object_backend The backend.
+ * \param object_handle  The object's handle.
+ * \param operations     The read or write operations.
+ * \param write          Whether the operations are writes.
+ *
+ * \return TRUE on success, FALSE otherwise.
+ **/
+static gboolean
+j_object_backend_transfer(JBackend* object_backend, gpointer object_handle, JList* operations, gboolean write)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_autofree JBackendExtent* extents = NULL;
+	JListIterator* it;
+	gboolean ret;
+	guint i;
+
+	extents = g_new(JBackendExtent, j_list_length(operations));
+	it = j_list_iterator_new(operations);
+
+	for (i = 0; j_list_iterator_next(it); i++)
+	{
+		JObjectOperation* operation = j_list_iterator_get(it);
+
+		if (write)
+		{
+			extents[i].buffer = (gpointer)operation->write.data;
+			extents[i].length = operation->write.length;
+			extents[i].offset = operation->write.offset;
+		}
+		else
+		{
+			extents[i].buffer = operation->read.data;
+			extents[i].length = operation->read.length;
+			extents[i].offset = operation->read.offset;
+		}
+
+		extents[i].bytes = 0;
+	}
+
+	j_list_iterator_free(it);
+
+	if (write)
+	{
+		ret = j_backend_object_writev(object_backend, object_handle, extents, i, FALSE);
+	}
+	else
+	{
+		ret = j_backend_object_readv(object_backend, object_handle, extents, i);
+	}
+
+	it = j_list_iterator_new(operations);
+
+	for (i = 0; j_list_iterator_next(it); i++)
+	{
+		JObjectOperation* operation = j_list_iterator_get(it);
+
+		j_helper_atomic_add((write) ? operation->write.bytes_written : operation->read.bytes_read, extents[i].bytes);
+	}
+
+	j_list_iterator_free(it);
+
+	return ret;
+}
+
 static gboolean
 j_object_read_exec(JList* operations, JSemantics* semantics)
 {
@@ -483,10 +624,8 @@ j_object_read_exec(JList* operations, JSemantics* semantics)
 	while (j_list_iterator_next(it))
 	{
 		JObjectOperation* operation = j_list_iterator_get(it);
-		gpointer data = operation->read.data;
 		guint64 length = operation->read.length;
 		guint64 offset = operation->read.offset;
-		guint64* bytes_read = operation->read.bytes_read;
 
 		j_trace_file_begin(object->name, J_TRACE_FILE_READ);
 
@@ -496,13 +635,6 @@ j_object_read_exec(JList* operations, JSemantics* semantics)
 			j_message_append_8(message, &length);
 			j_message_append_8(message, &offset);
 		}
-		else
-		{
-			guint64 nbytes = 0;
-
-			ret = j_backend_object_read(object_backend, object_handle, data, length, offset, &nbytes) && ret;
-			j_helper_atomic_add(bytes_read, nbytes);
-		}
 
 		j_trace_file_end(object->name, J_TRACE_FILE_READ, length, offset);
 	}
@@ -554,15 +686,19 @@ j_object_read_exec(JList* operations, JSemantics* semantics)
 				guint64 nbytes;
 
 				nbytes = j_message_get_8(reply);
-				j_helper_atomic_add(bytes_read, nbytes);
 
-				if (nbytes > 0)
+				// Data within holes is not sent
+				if (nbytes & J_MESSAGE_OBJECT_READ_ZERO)
 				{
-					GInputStream* input;
-
-					input = g_io_stream_get_input_stream(G_IO_STREAM(object_connection));
-					g_input_stream_read_all(input, data, nbytes, NULL, NULL, NULL);
+					nbytes &= ~J_MESSAGE_OBJECT_READ_ZERO;
+					memset(data, 0, nbytes);
 				}
+				else if (nbytes > 0)
+				{
+					j_network_connection_recv_bulk(object_connection, nbytes, data);
+				}
+
+				j_helper_atomic_add(bytes_read, nbytes);
 			}
 
 			operations_done += reply_operation_count;
@@ -574,6 +710,7 @@ j_object_read_exec(JList* operations, JSemantics* semantics)
 	}
 	else
 	{
+		ret = j_object_backend_transfer(object_backend, object_handle, operations, FALSE) && ret;
 		ret = j_backend_object_close(object_backend, object_handle) && ret;
 	}
 
@@ -677,13 +814,6 @@ j_object_write_exec(JList* operations, JSemantics* semantics)
 				j_helper_atomic_add(bytes_written, length);
 			}
 		}
-		else
-		{
-			guint64 nbytes = 0;
-
-			ret = j_backend_object_write(object_backend, object_handle, data, length, offset, &nbytes) && ret;
-			j_helper_atomic_add(bytes_written, nbytes);
-		}
 
 		j_trace_file_end(object->name, J_TRACE_FILE_WRITE, length, offset);
 	}
@@ -733,6 +863,7 @@ j_object_write_exec(JList* operations, JSemantics* semantics)
 	}
 	else
 	{
+		ret = j_object_backend_transfer(object_backend, object_handle, operations, TRUE) && ret;
 		ret = j_backend_object_close(object_backend, object_handle) && ret;
 	}
 
@@ -963,7 +1094,7 @@ j_object_new(gchar const* namespace, gchar const* name)
 	g_return_val_if_fail(name != NULL, NULL);
 
 	object = g_new(JObject, 1);
-	object->index = j_helper_hash(name) % j_configuration_get_server_count(configuration, J_BACKEND_TYPE_OBJECT);
+	object->index = j_configuration_get_server_index(configuration, J_BACKEND_TYPE_OBJECT, name);
 	object->namespace = g_strdup(namespace);
 	object->name = g_strdup(name);
 	object->ref_count = 1;
@@ -1195,6 +1326,564 @@ j_object_sync(JObject* object, JBatch* batch)
 	j_batch_add(batch, operation);
 }
 
+/**
+ * Copies an object between two servers by reading and writing its data.
+ *
+ * \param source      The source object.
+ * \param destination The destination object.
+ * \param semantics   The semantics to use.
+ *
+ * \return TRUE on success, FALSE otherwise.
+ **/
+static gboolean
+j_object_copy_transfer(JObject* source, JObject* destination, JSemantics* semantics)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	guint64 const buffer_size = 4 * 1024 * 1024;
+	g_autoptr(JBatch) batch = NULL;
+	g_autofree gchar* buffer = NULL;
+	gboolean ret;
+	guint64 size = 0;
+
+	batch = j_batch_new(semantics);
+
+	// Creating an object does not necessarily truncate it, so an existing destination is deleted first
+	// The destination usually does not exist, so the result is ignored
+	j_object_delete(destination, batch);
+	j_batch_execute(batch);
+
+	j_object_status(source, NULL, &size, batch);
+	j_object_create(destination, batch);
+	ret = j_batch_execute(batch);
+
+	buffer = g_malloc(MIN(size, buffer_size));
+
+	for (guint64 offset = 0; ret && offset < size; offset += buffer_size)
+	{
+		guint64 length = MIN(buffer_size, size - offset);
+		guint64 bytes_read = 0;
+		guint64 bytes_written = 0;
+
+		j_object_read(source, buffer, length, offset, &bytes_read, batch);
+		ret = j_batch_execute(batch) && bytes_read == length;
+
+		if (ret)
+		{
+			j_object_write(destination, buffer, length, offset, &bytes_written, batch);
+			ret = j_batch_execute(batch) && bytes_written == length;
+		}
+	}
+
+	return ret;
+}
+
+static gboolean
+j_object_copy_exec(JList* operations, JSemantics* semantics)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gboolean ret = TRUE;
+
+	JBackend* object_backend;
+	g_autoptr(JListIterator) it = NULL;
+	g_autoptr(JMessage) message = NULL;
+	gchar const* namespace;
+	gsize namespace_len;
+	guint32 index;
+
+	g_return_val_if_fail(operations != NULL, FALSE);
+	g_return_val_if_fail(semantics != NULL, FALSE);
+
+	{
+		JObjectOperation* operation = j_list_get_first(operations);
+		JObject* object = operation->copy.object;
+
+		g_assert(operation != NULL);
+		g_assert(object != NULL);
+
+		namespace = object->namespace;
+		namespace_len = strlen(namespace) + 1;
+		index = object->index;
+	}
+
+	it = j_list_iterator_new(operations);
+	object_backend = j_object_get_backend();
+
+	if (object_backend == NULL)
+	{
+		message = j_message_new(J_MESSAGE_OBJECT_COPY, namespace_len);
+		j_message_set_semantics(message, semantics);
+		j_message_append_n(message, namespace, namespace_len);
+	}
+
+	while (j_list_iterator_next(it))
+	{
+		JObjectOperation* operation = j_list_iterator_get(it);
+		JObject* object = operation->copy.object;
+		JObject* destination = operation->copy.destination;
+
+		if (object_backend == NULL)
+		{
+			gsize name_len;
+			gsize destination_namespace_len;
+			gsize destination_name_len;
+
+			// Only objects on the same server can be copied by the server
+			if (destination->index != index)
+			{
+				ret = j_object_copy_transfer(object, destination, semantics) && ret;
+				continue;
+			}
+
+			name_len = strlen(object->name) + 1;
+			destination_namespace_len = strlen(destination->namespace) + 1;
+			destination_name_len = strlen(destination->name) + 1;
+
+			j_message_add_operation(message, name_len + destination_namespace_len + destination_name_len);
+			j_message_append_n(message, object->name, name_len);
+			j_message_append_n(message, destination->namespace, destination_namespace_len);
+			j_message_append_n(message, destination->name, destination_name_len);
+		}
+		else
+		{
+			gpointer object_handle;
+			gpointer destination_handle;
+			guint64 bytes_copied;
+
+			// Creating the destination would truncate the source
+			if (g_strcmp0(object->namespace, destination->namespace) == 0 && g_strcmp0(object->name, destination->name) == 0)
+			{
+				ret = FALSE;
+				continue;
+			}
+
+			if (j_backend_object_open(object_backend, object->namespace, object->name, &object_handle))
+			{
+				// Creating an object does not necessarily truncate it, so an existing destination is deleted first
+				if (j_backend_object_open(object_backend, destination->namespace, destination->name, &destination_handle))
+				{
+					j_backend_object_delete(object_backend, destination_handle);
+				}
+
+				if (j_backend_object_create(object_backend, destination->namespace, destination->name, &destination_handle))
+				{
+					ret = j_backend_object_copy(object_backend, object_handle, destination_handle, &bytes_copied) && ret;
+					ret = j_backend_object_close(object_backend, destination_handle) && ret;
+				}
+				else
+				{
+					ret = FALSE;
+				}
+
+				ret = j_backend_object_close(object_backend, object_handle) && ret;
+			}
+			else
+			{
+				ret = FALSE;
+			}
+		}
+	}
+
+	if (object_backend == NULL && j_message_get_count(message) > 0)
+	{
+		g_autoptr(JMessage) reply = NULL;
+		gpointer object_connection;
+
+		object_connection = j_connection_pool_pop(J_BACKEND_TYPE_OBJECT, index);
+		j_message_send(message, object_connection);
+
+		// A reply is always sent because copies can fail, for example, if the source does not exist
+		reply = j_message_new_reply(message);
+
+		if (j_message_receive(reply, object_connection) && j_message_get_count(reply) == j_message_get_count(message))
+		{
+			for (guint32 i = 0; i < j_message_get_count(reply); i++)
+			{
+				ret = (j_message_get_4(reply) == 1) && ret;
+			}
+		}
+		else
+		{
+			ret = FALSE;
+		}
+
+		j_connection_pool_push(J_BACKEND_TYPE_OBJECT, index, object_connection);
+	}
+
+	return ret;
+}
+
+void
+j_object_copy(JObject* object, JObject* destination, JBatch* batch)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JObjectOperation* iop;
+	JOperation* operation;
+
+	g_return_if_fail(object != NULL);
+	g_return_if_fail(destination != NULL);
+
+	iop = g_new(JObjectOperation, 1);
+	iop->copy.object = j_object_ref(object);
+	iop->copy.destination = j_object_ref(destination);
+
+	operation = j_operation_new();
+	operation->key = object;
+	operation->data = iop;
+	operation->exec_func = j_object_copy_exec;
+	operation->free_func = j_object_copy_free;
+
+	j_batch_add(batch, operation);
+}
+
+/**
+ * Allocates or punches ranges of an object.
+ *
+ * \param operations The operations.
+ * \param semantics  The semantics to use.
+ * \param type       J_MESSAGE_OBJECT_ALLOCATE or J_MESSAGE_OBJECT_PUNCH.
+ *
+ * \return TRUE on success, FALSE otherwise.
+ **/
+static gboolean
+j_object_allocate_punch_exec(JList* operations, JSemantics* semantics, JMessageType type)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gboolean ret = TRUE;
+
+	JBackend* object_backend;
+	g_autoptr(JListIterator) it = NULL;
+	g_autoptr(JMessage) message = NULL;
+	JObject* object;
+	gpointer object_handle = NULL;
+
+	{
+		JObjectOperation* operation = j_list_get_first(operations);
+
+		object = operation->allocate.object;
+
+		g_assert(operation != NULL);
+		g_assert(object != NULL);
+	}
+
+	it = j_list_iterator_new(operations);
+	object_backend = j_object_get_backend();
+
+	if (object_backend == NULL)
+	{
+		gsize name_len;
+		gsize namespace_len;
+
+		namespace_len = strlen(object->namespace) + 1;
+		name_len = strlen(object->name) + 1;
+
+		message = j_message_new(type, namespace_len + name_len);
+		j_message_set_semantics(message, semantics);
+		j_message_append_n(message, object->namespace, namespace_len);
+		j_message_append_n(message, object->name, name_len);
+	}
+	else if (!j_backend_object_open(object_backend, object->namespace, object->name, &object_handle))
+	{
+		return FALSE;
+	}
+
+	while (j_list_iterator_next(it))
+	{
+		JObjectOperation* operation = j_list_iterator_get(it);
+		guint64 length = operation->allocate.length;
+		guint64 offset = operation->allocate.offset;
+
+		if (object_backend == NULL)
+		{
+			j_message_add_operation(message, sizeof(guint64) + sizeof(guint64));
+			j_message_append_8(message, &length);
+			j_message_append_8(message, &offset);
+		}
+		else if (type == J_MESSAGE_OBJECT_ALLOCATE)
+		{
+			ret = j_backend_object_allocate(object_backend, object_handle, length, offset) && ret;
+		}
+		else
+		{
+			ret = j_backend_object_punch(object_backend, object_handle, length, offset) && ret;
+		}
+	}
+
+	if (object_backend == NULL)
+	{
+		g_autoptr(JMessage) reply = NULL;
+		gpointer object_connection;
+
+		object_connection = j_connection_pool_pop(J_BACKEND_TYPE_OBJECT, object->index);
+		j_message_send(message, object_connection);
+
+		reply = j_message_new_reply(message);
+
+		if (j_message_receive(reply, object_connection) && j_message_get_count(reply) == j_message_get_count(message))
+		{
+			for (guint32 i = 0; i < j_message_get_count(reply); i++)
+			{
+				ret = (j_message_get_4(reply) == 1) && ret;
+			}
+		}
+		else
+		{
+			ret = FALSE;
+		}
+
+		j_connection_pool_push(J_BACKEND_TYPE_OBJECT, object->index, object_connection);
+	}
+	else
+	{
+		ret = j_backend_object_close(object_backend, object_handle) && ret;
+	}
+
+	return ret;
+}
+
+static gboolean
+j_object_allocate_exec(JList* operations, JSemantics* semantics)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_val_if_fail(operations != NULL, FALSE);
+	g_return_val_if_fail(semantics != NULL, FALSE);
+
+	return j_object_allocate_punch_exec(operations, semantics, J_MESSAGE_OBJECT_ALLOCATE);
+}
+
+static gboolean
+j_object_punch_exec(JList* operations, JSemantics* semantics)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_val_if_fail(operations != NULL, FALSE);
+	g_return_val_if_fail(semantics != NULL, FALSE);
+
+	return j_object_allocate_punch_exec(operations, semantics, J_MESSAGE_OBJECT_PUNCH);
+}
+
+static gboolean
+j_object_get_extents_exec(JList* operations, JSemantics* semantics)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gboolean ret = TRUE;
+
+	JBackend* object_backend;
+	g_autoptr(JListIterator) it = NULL;
+	g_autoptr(JMessage) message = NULL;
+	g_autoptr(GArray) backend_extents = NULL;
+	JObject* object;
+	gpointer object_handle = NULL;
+
+	g_return_val_if_fail(operations != NULL, FALSE);
+	g_return_val_if_fail(semantics != NULL, FALSE);
+
+	{
+		JObjectOperation* operation = j_list_get_first(operations);
+
+		object = operation->get_extents.object;
+
+		g_assert(operation != NULL);
+		g_assert(object != NULL);
+	}
+
+	it = j_list_iterator_new(operations);
+	object_backend = j_object_get_backend();
+
+	if (object_backend == NULL)
+	{
+		gsize name_len;
+		gsize namespace_len;
+
+		namespace_len = strlen(object->namespace) + 1;
+		name_len = strlen(object->name) + 1;
+
+		message = j_message_new(J_MESSAGE_OBJECT_GET_EXTENTS, namespace_len + name_len);
+		j_message_set_semantics(message, semantics);
+		j_message_append_n(message, object->namespace, namespace_len);
+		j_message_append_n(message, object->name, name_len);
+	}
+	else if (j_backend_object_open(object_backend, object->namespace, object->name, &object_handle))
+	{
+		backend_extents = g_array_new(FALSE, FALSE, sizeof(JBackendExtent));
+	}
+	else
+	{
+		return FALSE;
+	}
+
+	while (j_list_iterator_next(it))
+	{
+		JObjectOperation* operation = j_list_iterator_get(it);
+		guint64 length = operation->get_extents.length;
+		guint64 offset = operation->get_extents.offset;
+
+		if (object_backend == NULL)
+		{
+			j_message_add_operation(message, sizeof(guint64) + sizeof(guint64));
+			j_message_append_8(message, &length);
+			j_message_append_8(message, &offset);
+			continue;
+		}
+
+		g_array_set_size(backend_extents, 0);
+
+		if (!j_backend_object_get_extents(object_backend, object_handle, length, offset, backend_extents))
+		{
+			ret = FALSE;
+			continue;
+		}
+
+		for (guint i = 0; i < backend_extents->len; i++)
+		{
+			JBackendExtent* backend_extent = &g_array_index(backend_extents, JBackendExtent, i);
+			JObjectExtent extent;
+
+			extent.offset = backend_extent->offset;
+			extent.length = backend_extent->length;
+
+			g_array_append_val(operation->get_extents.extents, extent);
+		}
+	}
+
+	if (object_backend == NULL)
+	{
+		g_autoptr(JMessage) reply = NULL;
+		gpointer object_connection;
+
+		object_connection = j_connection_pool_pop(J_BACKEND_TYPE_OBJECT, object->index);
+		j_message_send(message, object_connection);
+
+		reply = j_message_new_reply(message);
+
+		if (j_message_receive(reply, object_connection) && j_message_get_count(reply) == j_message_get_count(message))
+		{
+			g_autoptr(JListIterator) reply_it = NULL;
+
+			reply_it = j_list_iterator_new(operations);
+
+			while (j_list_iterator_next(reply_it))
+			{
+				JObjectOperation* operation = j_list_iterator_get(reply_it);
+				guint32 count;
+
+				count = j_message_get_4(reply);
+
+				// The server could not determine the extents
+				if (count == G_MAXUINT32)
+				{
+					ret = FALSE;
+					continue;
+				}
+
+				for (guint32 i = 0; i < count; i++)
+				{
+					JObjectExtent extent;
+
+					extent.offset = j_message_get_8(reply);
+					extent.length = j_message_get_8(reply);
+
+					g_array_append_val(operation->get_extents.extents, extent);
+				}
+			}
+		}
+		else
+		{
+			ret = FALSE;
+		}
+
+		j_connection_pool_push(J_BACKEND_TYPE_OBJECT, object->index, object_connection);
+	}
+	else
+	{
+		ret = j_backend_object_close(object_backend, object_handle) && ret;
+	}
+
+	return ret;
+}
+
+void
+j_object_allocate(JObject* object, guint64 length, guint64 offset, JBatch* batch)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JObjectOperation* iop;
+	JOperation* operation;
+
+	g_return_if_fail(object != NULL);
+	g_return_if_fail(length > 0);
+
+	iop = g_new(JObjectOperation, 1);
+	iop->allocate.object = j_object_ref(object);
+	iop->allocate.length = length;
+	iop->allocate.offset = offset;
+
+	operation = j_operation_new();
+	operation->key = object;
+	operation->data = iop;
+	operation->exec_func = j_object_allocate_exec;
+	operation->free_func = j_object_allocate_free;
+
+	j_batch_add(batch, operation);
+}
+
+void
+j_object_punch(JObject* object, guint64 length, guint64 offset, JBatch* batch)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JObjectOperation* iop;
+	JOperation* operation;
+
+	g_return_if_fail(object != NULL);
+	g_return_if_fail(length > 0);
+
+	iop = g_new(JObjectOperation, 1);
+	iop->allocate.object = j_object_ref(object);
+	iop->allocate.length = length;
+	iop->allocate.offset = offset;
+
+	operation = j_operation_new();
+	operation->key = object;
+	operation->data = iop;
+	operation->exec_func = j_object_punch_exec;
+	operation->free_func = j_object_allocate_free;
+
+	j_batch_add(batch, operation);
+}
+
+void
+j_object_get_extents(JObject* object, guint64 length, guint64 offset, GArray* extents, JBatch* batch)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JObjectOperation* iop;
+	JOperation* operation;
+
+	g_return_if_fail(object != NULL);
+	g_return_if_fail(extents != NULL);
+	g_return_if_fail(g_array_get_element_size(extents) == sizeof(JObjectExtent));
+
+	iop = g_new(JObjectOperation, 1);
+	iop->get_extents.object = j_object_ref(object);
+	iop->get_extents.length = length;
+	iop->get_extents.offset = offset;
+	iop->get_extents.extents = g_array_ref(extents);
+
+	operation = j_operation_new();
+	operation->key = object;
+	operation->data = iop;
+	operation->exec_func = j_object_get_extents_exec;
+	operation->free_func = j_object_get_extents_free;
+
+	j_batch_add(batch, operation);
+}
+
 /**
  * Returns the object backend.
  *
@@ -0,0 +1,791 @@
+/*
+ * JULEA - Flexible storage framework
+ * Copyright (C) 2010-2026 Michael Kuhn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <julea-config.h>
+
+#include <glib.h>
+#include <gio/gio.h>
+
+#include <errno.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <julea.h>
+
+#include "server.h"
+
+/**
+ * The server's event loop.
+ *
+ * A small number of I/O threads wait for incoming data on all client connections using epoll.
+ * Connections are registered with EPOLLONESHOT, that is, a connection is disarmed as soon as data arrives.
+ * The I/O thread buffers the incoming data without blocking and only hands the connection to the worker pool once a complete message has arrived.
+ * This way, slow clients sending partial messages do not block any thread.
+ * After the worker has handled the message (including any payload following it), the connection is rearmed.
+ * This guarantees that at most one thread reads from a connection at any time.
+ * Payloads and messages that do not fit into the receive buffer are received by the worker, which gives up if the client does not send them in time.
+ *
+ * Multiplexed connections are rearmed as soon as a message has been received, unless a payload follows it.
+ * Their messages are therefore handled concurrently and replies are sent in the order in which they are completed.
+ * Clients match replies to their messages using the message ID.
+ *
+ * libfabric connections can not be waited for using epoll, so each of them is handled by a dedicated thread instead.
+ * Shared-memory connections transfer their data using ring buffers, their sockets only carry doorbells and can therefore be waited for as usual.
+ **/
+
+struct JDIOThread;
+
+/**
+ * A client connection.
+ **/
+struct JDConnection
+{
+	JNetworkConnection* connection;
+
+	/**
+	 * The connection's file descriptor.
+	 **/
+	gint fd;
+
+	/**
+	 * The I/O thread the connection is registered with.
+	 **/
+	struct JDIOThread* io_thread;
+
+	/**
+	 * The connection's statistics, merged into the global ones when the connection is closed.
+	 * Only used for messages that are handled sequentially.
+	 **/
+	JStatistics* statistics;
+
+	/**
+	 * The reference count.
+	 * The I/O thread holds one reference until the connection is closed, each task holds another one.
+	 **/
+	gint ref_count;
+};
+
+typedef struct JDConnection JDConnection;
+
+/**
+ * A task to be handled by a worker.
+ **/
+struct JDTask
+{
+	/**
+	 * The connection, NULL if the worker has to flush its object cache.
+	 **/
+	JDConnection* connection;
+
+	/**
+	 * A message of a multiplexed connection that is handled concurrently.
+	 * If NULL, the connection has become readable and the worker has to receive the next message.
+	 **/
+	JMessage* message;
+};
+
+typedef struct JDTask JDTask;
+
+struct JDIOThread
+{
+	GThread* thread;
+
+	gint epoll_fd;
+
+	/**
+	 * Used to wake up the thread when shutting down.
+	 **/
+	gint wakeup_fd;
+
+	/**
+	 * All connections registered with this thread.
+	 * Protected by mutex.
+	 **/
+	GHashTable* connections;
+	GMutex mutex[1];
+};
+
+typedef struct JDIOThread JDIOThread;
+
+static JDIOThread* jd_io_threads = NULL;
+static guint jd_io_threads_len = 0;
+static guint jd_io_threads_next = 0;
+
+static GThreadPool* jd_workers = NULL;
+
+static gint jd_event_running = 0;
+
+/**
+ * The timeout for receiving and sending data, in seconds.
+ **/
+#define JD_CONNECTION_TIMEOUT 60
+
+/**
+ * The maximum time workers wait for each other when flushing their object caches, in seconds.
+ **/
+#define JD_WORKERS_FLUSH_TIMEOUT 10
+
+/**
+ * The number of workers that still have to flush their object cache when shutting down.
+ * Protected by jd_workers_flush_mutex.
+ **/
+static guint jd_workers_flush_pending = 0;
+static GMutex jd_workers_flush_mutex[1];
+static GCond jd_workers_flush_cond[1];
+
+/**
+ * The fabric used for libfabric connections, NULL when using TCP.
+ **/
+static JNetworkFabric* jd_fabric = NULL;
+
+/**
+ * The number of active libfabric connections.
+ **/
+static gint jd_fabric_connections = 0;
+
+static void
+jd_memory_chunk_free(gpointer data)
+{
+	j_memory_chunk_free(data);
+}
+
+/// \todo The memory chunk could also be shared by all workers.
+static GPrivate jd_worker_memory_chunk = G_PRIVATE_INIT(jd_memory_chunk_free);
+
+/**
+ * Merges a connection's statistics into the global ones.
+ *
+ * \param statistics The connection's statistics.
+ **/
+static void
+jd_statistics_merge(JStatistics* statistics)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	guint64 value;
+
+	g_mutex_lock(jd_statistics_mutex);
+
+	value = j_statistics_get(statistics, J_STATISTICS_FILES_CREATED);
+	j_statistics_add(jd_statistics, J_STATISTICS_FILES_CREATED, value);
+	value = j_statistics_get(statistics, J_STATISTICS_FILES_DELETED);
+	j_statistics_add(jd_statistics, J_STATISTICS_FILES_DELETED, value);
+	value = j_statistics_get(statistics, J_STATISTICS_SYNC);
+	j_statistics_add(jd_statistics, J_STATISTICS_SYNC, value);
+	value = j_statistics_get(statistics, J_STATISTICS_BYTES_READ);
+	j_statistics_add(jd_statistics, J_STATISTICS_BYTES_READ, value);
+	value = j_statistics_get(statistics, J_STATISTICS_BYTES_WRITTEN);
+	j_statistics_add(jd_statistics, J_STATISTICS_BYTES_WRITTEN, value);
+	value = j_statistics_get(statistics, J_STATISTICS_BYTES_RECEIVED);
+	j_statistics_add(jd_statistics, J_STATISTICS_BYTES_RECEIVED, value);
+	value = j_statistics_get(statistics, J_STATISTICS_BYTES_SENT);
+	j_statistics_add(jd_statistics, J_STATISTICS_BYTES_SENT, value);
+	value = j_statistics_get(statistics, J_STATISTICS_OPENS_SAVED);
+	j_statistics_add(jd_statistics, J_STATISTICS_OPENS_SAVED, value);
+	value = j_statistics_get(statistics, J_STATISTICS_CLOSES_SAVED);
+	j_statistics_add(jd_statistics, J_STATISTICS_CLOSES_SAVED, value);
+
+	g_mutex_unlock(jd_statistics_mutex);
+}
+
+static JDConnection*
+jd_connection_ref(JDConnection* connection)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_atomic_int_inc(&(connection->ref_count));
+
+	return connection;
+}
+
+static void
+jd_connection_unref(JDConnection* connection)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	if (g_atomic_int_dec_and_test(&(connection->ref_count)))
+	{
+		jd_statistics_merge(connection->statistics);
+
+		j_network_connection_fini(connection->connection);
+
+		j_statistics_free(connection->statistics);
+
+		g_free(connection);
+	}
+}
+
+static void
+jd_connection_close(JDConnection* connection)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JDIOThread* io_thread = connection->io_thread;
+
+	epoll_ctl(io_thread->epoll_fd, EPOLL_CTL_DEL, connection->fd, NULL);
+
+	g_mutex_lock(io_thread->mutex);
+	g_hash_table_remove(io_thread->connections, connection);
+	g_mutex_unlock(io_thread->mutex);
+
+	jd_connection_unref(connection);
+}
+
+static gboolean
+jd_connection_arm(JDConnection* connection, gint op)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	struct epoll_event event;
+
+	event.events = EPOLLIN | EPOLLONESHOT;
+	event.data.ptr = connection;
+
+	if (epoll_ctl(connection->io_thread->epoll_fd, op, connection->fd, &event) != 0)
+	{
+		g_warning("Could not arm connection: %s", g_strerror(errno));
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+static JMemoryChunk*
+jd_worker_get_memory_chunk(guint64 memory_chunk_size)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JMemoryChunk* memory_chunk;
+
+	memory_chunk = g_private_get(&jd_worker_memory_chunk);
+
+	if (memory_chunk == NULL)
+	{
+		memory_chunk = j_memory_chunk_new_aligned(memory_chunk_size, J_BACKEND_ALIGNMENT);
+		g_private_set(&jd_worker_memory_chunk, memory_chunk);
+	}
+
+	return memory_chunk;
+}
+
+/**
+ * Checks whether a complete message has been buffered for a connection.
+ * If so, the connection is handed to the workers, otherwise it is rearmed.
+ *
+ * \param connection A connection.
+ * \param readable Whether the connection's socket is readable.
+ **/
+static void
+jd_connection_poll(JDConnection* connection, gboolean readable)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gboolean complete;
+
+	// Errors and hangups cause j_message_poll() to fail
+	if (!j_message_poll(connection->connection, readable, &complete))
+	{
+		jd_connection_close(connection);
+		return;
+	}
+
+	if (complete)
+	{
+		JDTask* task;
+
+		task = g_new(JDTask, 1);
+		task->connection = jd_connection_ref(connection);
+		task->message = NULL;
+
+		g_thread_pool_push(jd_workers, task, NULL);
+	}
+	else if (!jd_connection_arm(connection, EPOLL_CTL_MOD))
+	{
+		jd_connection_close(connection);
+	}
+}
+
+/**
+ * Receives and handles the messages of a connection that has a complete message buffered.
+ * Messages of multiplexed connections are handed to the workers unless a payload follows them, all other messages are handled right away.
+ * The connection's messages are handled until no complete message is buffered and the connection is then rearmed.
+ *
+ * \param connection A connection.
+ * \param memory_chunk The worker's memory chunk.
+ * \param memory_chunk_size The memory chunk's size.
+ **/
+static void
+jd_connection_dispatch(JDConnection* connection, JMemoryChunk* memory_chunk, guint64 memory_chunk_size)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	while (TRUE)
+	{
+		JMessage* message;
+		gboolean complete;
+
+		message = j_message_new(J_MESSAGE_NONE, 0);
+
+		// Errors, hangups and timeouts also cause j_message_receive() to fail
+		if (!j_message_receive(message, connection->connection))
+		{
+			j_message_unref(message);
+			jd_connection_close(connection);
+			return;
+		}
+
+		// Payloads have to be received before the next message can be
+		if (j_network_connection_get_multiplexed(connection->connection) && !jd_message_has_payload(message))
+		{
+			JDTask* task;
+
+			task = g_new(JDTask, 1);
+			task->connection = jd_connection_ref(connection);
+			task->message = message;
+
+			g_thread_pool_push(jd_workers, task, NULL);
+		}
+		else
+		{
+			jd_handle_message(message, connection->connection, memory_chunk, memory_chunk_size, connection->statistics);
+			j_message_unref(message);
+		}
+
+		// Messages that have already been buffered do not make the socket readable
+		if (!j_message_poll(connection->connection, FALSE, &complete))
+		{
+			jd_connection_close(connection);
+			return;
+		}
+
+		if (!complete)
+		{
+			break;
+		}
+	}
+
+	if (!jd_connection_arm(connection, EPOLL_CTL_MOD))
+	{
+		jd_connection_close(connection);
+	}
+}
+
+/**
+ * Flushes the calling worker's object cache, so that its handles are closed by the thread that opened them.
+ * Each worker waits until all others have flushed their caches, so that every worker usually handles exactly one flush task.
+ * Workers that are still busy (for instance, receiving a payload) do not hold up the others, their handles are only closed when they exit.
+ **/
+static void
+jd_worker_flush(void)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gint64 end_time;
+
+	jd_object_cache_flush();
+
+	end_time = g_get_monotonic_time() + JD_WORKERS_FLUSH_TIMEOUT * G_TIME_SPAN_SECOND;
+
+	g_mutex_lock(jd_workers_flush_mutex);
+
+	jd_workers_flush_pending--;
+
+	if (jd_workers_flush_pending == 0)
+	{
+		g_cond_broadcast(jd_workers_flush_cond);
+	}
+
+	while (jd_workers_flush_pending > 0)
+	{
+		if (!g_cond_wait_until(jd_workers_flush_cond, jd_workers_flush_mutex, end_time))
+		{
+			g_debug("Not all workers flushed their object caches in time.");
+			break;
+		}
+	}
+
+	g_mutex_unlock(jd_workers_flush_mutex);
+}
+
+static void
+jd_worker_func(gpointer data, gpointer user_data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JDTask* task = data;
+	JDConnection* connection = task->connection;
+	JMemoryChunk* memory_chunk;
+	guint64 memory_chunk_size;
+
+	(void)user_data;
+
+	if (connection == NULL)
+	{
+		jd_worker_flush();
+		g_free(task);
+
+		return;
+	}
+
+	memory_chunk_size = j_configuration_get_max_operation_size(jd_configuration);
+	memory_chunk = jd_worker_get_memory_chunk(memory_chunk_size);
+
+	if (task->message == NULL)
+	{
+		jd_connection_dispatch(connection, memory_chunk, memory_chunk_size);
+	}
+	else
+	{
+		JStatistics* statistics;
+
+		// Messages of multiplexed connections are handled concurrently, so they can not share the connection's statistics
+		statistics = j_statistics_new(TRUE);
+
+		jd_handle_message(task->message, connection->connection, memory_chunk, memory_chunk_size, statistics);
+
+		jd_statistics_merge(statistics);
+		j_statistics_free(statistics);
+
+		j_message_unref(task->message);
+	}
+
+	jd_connection_unref(connection);
+
+	g_free(task);
+}
+
+static gpointer
+jd_io_thread_func(gpointer data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JDIOThread* io_thread = data;
+	struct epoll_event events[64];
+
+	while (g_atomic_int_get(&jd_event_running))
+	{
+		gint n;
+
+		n = epoll_wait(io_thread->epoll_fd, events, G_N_ELEMENTS(events), -1);
+
+		if (n < 0)
+		{
+			if (errno == EINTR)
+			{
+				continue;
+			}
+
+			g_critical("Could not wait for events: %s", g_strerror(errno));
+			break;
+		}
+
+		for (gint i = 0; i < n; i++)
+		{
+			JDConnection* connection = events[i].data.ptr;
+
+			// The wakeup file descriptor does not have a connection
+			if (connection == NULL)
+			{
+				continue;
+			}
+
+			// Only buffers the available data, receiving is left to the workers once the message is complete
+			jd_connection_poll(connection, TRUE);
+		}
+	}
+
+	return NULL;
+}
+
+/**
+ * Handles a libfabric connection.
+ * The connection is established using the socket connection, which is then closed.
+ *
+ * \param data The socket connection.
+ **/
+static gpointer
+jd_fabric_connection_func(gpointer data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	GSocketConnection* socket_connection = data;
+	JNetworkConnection* connection;
+	JMemoryChunk* memory_chunk;
+	JMessage* message;
+	JStatistics* statistics;
+	guint64 memory_chunk_size;
+
+	connection = j_network_connection_init_server(jd_fabric, socket_connection);
+
+	g_io_stream_close(G_IO_STREAM(socket_connection), NULL, NULL);
+	g_object_unref(socket_connection);
+
+	if (connection == NULL)
+	{
+		g_warning("Could not establish libfabric connection.");
+		g_atomic_int_add(&jd_fabric_connections, -1);
+
+		return NULL;
+	}
+
+	memory_chunk_size = j_configuration_get_max_operation_size(jd_configuration);
+	memory_chunk = jd_worker_get_memory_chunk(memory_chunk_size);
+	message = j_message_new(J_MESSAGE_NONE, 0);
+	statistics = j_statistics_new(TRUE);
+
+	while (g_atomic_int_get(&jd_event_running) && j_message_receive(message, connection))
+	{
+		jd_handle_message(message, connection, memory_chunk, memory_chunk_size, statistics);
+	}
+
+	jd_statistics_merge(statistics);
+
+	j_network_connection_fini(connection);
+
+	j_message_unref(message);
+	j_statistics_free(statistics);
+
+	g_atomic_int_add(&jd_fabric_connections, -1);
+
+	return NULL;
+}
+
+gboolean
+jd_event_init(guint io_threads, guint workers)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	GError* error = NULL;
+
+	g_return_val_if_fail(jd_io_threads == NULL, FALSE);
+
+	if (io_threads == 0)
+	{
+		io_threads = g_get_num_processors();
+	}
+
+	if (workers == 0)
+	{
+		workers = g_get_num_processors();
+	}
+
+	if (j_configuration_get_transport(jd_configuration) == J_CONFIGURATION_TRANSPORT_LIBFABRIC)
+	{
+		jd_fabric = j_network_fabric_init_server(jd_configuration);
+
+		if (jd_fabric == NULL)
+		{
+			g_critical("Could not initialize fabric.");
+			return FALSE;
+		}
+	}
+
+	jd_workers = g_thread_pool_new(jd_worker_func, NULL, workers, TRUE, &error);
+
+	if (jd_workers == NULL)
+	{
+		g_critical("Could not create worker pool: %s", error->message);
+		g_error_free(error);
+
+		return FALSE;
+	}
+
+	g_atomic_int_set(&jd_event_running, 1);
+
+	jd_io_threads = g_new0(JDIOThread, io_threads);
+	jd_io_threads_len = io_threads;
+
+	for (guint i = 0; i < io_threads; i++)
+	{
+		JDIOThread* io_thread = &(jd_io_threads[i]);
+		struct epoll_event event;
+
+		io_thread->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+		io_thread->wakeup_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+
+		if (io_thread->epoll_fd < 0 || io_thread->wakeup_fd < 0)
+		{
+			g_critical("Could not create event loop: %s", g_strerror(errno));
+			return FALSE;
+		}
+
+		event.events = EPOLLIN;
+		event.data.ptr = NULL;
+		epoll_ctl(io_thread->epoll_fd, EPOLL_CTL_ADD, io_thread->wakeup_fd, &event);
+
+		io_thread->connections = g_hash_table_new(NULL, NULL);
+		g_mutex_init(io_thread->mutex);
+
+		io_thread->thread = g_thread_new("julea-server-io", jd_io_thread_func, io_thread);
+	}
+
+	g_debug("Started event loop with %u I/O threads and %u workers.", io_threads, workers);
+
+	return TRUE;
+}
+
+void
+jd_event_fini(void)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	guint workers;
+
+	g_return_if_fail(jd_io_threads != NULL);
+
+	g_atomic_int_set(&jd_event_running, 0);
+
+	for (guint i = 0; i < jd_io_threads_len; i++)
+	{
+		guint64 one = 1;
+
+		if (write(jd_io_threads[i].wakeup_fd, &one, sizeof(one)) != sizeof(one))
+		{
+			g_warning("Could not wake up I/O thread: %s", g_strerror(errno));
+		}
+	}
+
+	for (guint i = 0; i < jd_io_threads_len; i++)
+	{
+		g_thread_join(jd_io_threads[i].thread);
+	}
+
+	workers = (guint)g_thread_pool_get_max_threads(jd_workers);
+	jd_workers_flush_pending = workers;
+
+	// The flush tasks are queued after all messages that have already been received
+	for (guint i = 0; i < workers; i++)
+	{
+		JDTask* task;
+
+		task = g_new(JDTask, 1);
+		task->connection = NULL;
+		task->message = NULL;
+
+		g_thread_pool_push(jd_workers, task, NULL);
+	}
+
+	g_thread_pool_free(jd_workers, FALSE, TRUE);
+	jd_workers = NULL;
+
+	jd_object_cache_fini();
+
+	for (guint i = 0; i < jd_io_threads_len; i++)
+	{
+		JDIOThread* io_thread = &(jd_io_threads[i]);
+		GHashTableIter iter;
+		gpointer connection;
+
+		g_hash_table_iter_init(&iter, io_thread->connections);
+
+		while (g_hash_table_iter_next(&iter, &connection, NULL))
+		{
+			jd_connection_unref(connection);
+		}
+
+		g_hash_table_unref(io_thread->connections);
+		g_mutex_clear(io_thread->mutex);
+
+		close(io_thread->wakeup_fd);
+		close(io_thread->epoll_fd);
+	}
+
+	g_free(jd_io_threads);
+	jd_io_threads = NULL;
+	jd_io_threads_len = 0;
+
+	if (jd_fabric != NULL)
+	{
+		/// \todo libfabric connections only notice the shutdown after receiving their next message
+		if (g_atomic_int_get(&jd_fabric_connections) == 0)
+		{
+			j_network_fabric_fini(jd_fabric);
+		}
+		else
+		{
+			g_debug("Not closing fabric because of %d active connections.", g_atomic_int_get(&jd_fabric_connections));
+		}
+
+		jd_fabric = NULL;
+	}
+}
+
+gboolean
+jd_event_add_connection(GSocketConnection* socket_connection)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JDConnection* connection;
+	JDIOThread* io_thread;
+	guint index;
+
+	g_return_val_if_fail(jd_io_threads != NULL, FALSE);
+	g_return_val_if_fail(socket_connection != NULL, FALSE);
+
+	if (jd_fabric != NULL)
+	{
+		GThread* thread;
+
+		g_atomic_int_inc(&jd_fabric_connections);
+
+		// The socket connection is only used to exchange the fabric address
+		thread = g_thread_new("julea-server-fabric", jd_fabric_connection_func, g_object_ref(socket_connection));
+		g_thread_unref(thread);
+
+		return TRUE;
+	}
+
+	index = (guint)g_atomic_int_add(&jd_io_threads_next, 1) % jd_io_threads_len;
+	io_thread = &(jd_io_threads[index]);
+
+	connection = g_new(JDConnection, 1);
+	connection->connection = j_network_connection_init_server(NULL, socket_connection);
+
+	if (connection->connection == NULL)
+	{
+		g_free(connection);
+
+		return FALSE;
+	}
+
+	connection->fd = g_socket_get_fd(g_socket_connection_get_socket(socket_connection));
+	// Workers receiving payloads must not wait forever for clients that stop sending
+	g_socket_set_timeout(g_socket_connection_get_socket(socket_connection), JD_CONNECTION_TIMEOUT);
+	connection->io_thread = io_thread;
+	connection->statistics = j_statistics_new(TRUE);
+	connection->ref_count = 1;
+
+	g_mutex_lock(io_thread->mutex);
+	g_hash_table_add(io_thread->connections, connection);
+	g_mutex_unlock(io_thread->mutex);
+
+	if (!jd_connection_arm(connection, EPOLL_CTL_ADD))
+	{
+		g_mutex_lock(io_thread->mutex);
+		g_hash_table_remove(io_thread->connections, connection);
+		g_mutex_unlock(io_thread->mutex);
+
+		jd_connection_unref(connection);
+
+		return FALSE;
+	}
+
+	return TRUE;
+}
@@ -28,8 +28,539 @@
 
 static guint jd_thread_num = 0;
 
+/**
+ * The size after which a streamed reply is sent, see jd_reply_next_frame().
+ **/
+#define JD_REPLY_FRAME_SIZE (64 * 1024)
+
+/**
+ * Sends a frame of a streamed reply and starts the next one.
+ * Every frame is a separate reply to the same message, the last one ends with an empty entry.
+ * This keeps memory usage bounded and allows the client to process frames while later ones are still being produced.
+ *
+ * \param reply      The current frame.
+ * \param message    The message being replied to.
+ * \param connection The connection.
+ *
+ * \return The next frame.
+ **/
+static JMessage*
+jd_reply_next_frame(JMessage* reply, JMessage* message, JNetworkConnection* connection)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	j_message_send(reply, connection);
+	j_message_unref(reply);
+
+	return j_message_new_reply(message);
+}
+
+/**
+ * The minimum number of bytes a read has to cover for holes to be detected.
+ * Detecting holes requires additional system calls, which are not worth it for small reads.
+ **/
+#define JD_OBJECT_HOLES_MIN_LENGTH (1024 * 1024)
+
+/**
+ * Finds extents that lie completely within holes of an object and sets their number of bytes.
+ * Extents smaller than a file system block are not considered, because holes consist of whole blocks.
+ *
+ * \param backend     The object's backend.
+ * \param object      The object.
+ * \param extents     The extents.
+ * \param extents_len The number of extents.
+ *
+ * \return An array marking the extents within holes, NULL if there are none.
+ **/
+static gboolean*
+jd_object_find_holes(JBackend* backend, gpointer object, JBackendExtent* extents, guint extents_len)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_autoptr(GArray) data_extents = NULL;
+	gboolean* holes = NULL;
+	guint64 start = G_MAXUINT64;
+	guint64 end = 0;
+	guint64 length = 0;
+	guint64 size = 0;
+
+	// Without support for extents, all of the object would be reported as data
+	if (backend->object.backend_get_extents == NULL || extents_len == 0)
+	{
+		return NULL;
+	}
+
+	for (guint i = 0; i < extents_len; i++)
+	{
+		if (extents[i].length < J_BACKEND_ALIGNMENT)
+		{
+			continue;
+		}
+
+		start = MIN(start, extents[i].offset);
+		end = MAX(end, extents[i].offset + extents[i].length);
+		length += extents[i].length;
+	}
+
+	if (length < JD_OBJECT_HOLES_MIN_LENGTH)
+	{
+		return NULL;
+	}
+
+	data_extents = g_array_new(FALSE, FALSE, sizeof(JBackendExtent));
+
+	// A single query covers all extents, the data extents are sorted by offset
+	if (!j_backend_object_get_extents(backend, object, end - start, start, data_extents))
+	{
+		return NULL;
+	}
+
+	for (guint i = 0; i < extents_len; i++)
+	{
+		guint64 extent_end = extents[i].offset + extents[i].length;
+		gboolean hole = (extents[i].length >= J_BACKEND_ALIGNMENT);
+
+		for (guint j = 0; j < data_extents->len && hole; j++)
+		{
+			JBackendExtent* data_extent = &g_array_index(data_extents, JBackendExtent, j);
+
+			if (data_extent->offset >= extent_end)
+			{
+				break;
+			}
+
+			hole = (data_extent->offset + data_extent->length <= extents[i].offset);
+		}
+
+		if (!hole)
+		{
+			continue;
+		}
+
+		if (holes == NULL)
+		{
+			if (!j_backend_object_status(backend, object, NULL, &size))
+			{
+				return NULL;
+			}
+
+			holes = g_new0(gboolean, extents_len);
+		}
+
+		holes[i] = TRUE;
+		extents[i].bytes = (extents[i].offset < size) ? MIN(extents[i].length, size - extents[i].offset) : 0;
+	}
+
+	return holes;
+}
+
+/**
+ * Reads extents using a single backend call and adds the results to the reply.
+ * Extents within holes are not read, only their length is sent.
+ *
+ * \param backend     The object's backend.
+ * \param object      The object.
+ * \param extents     The extents, whose buffers must stay valid until the reply has been sent.
+ * \param extents_len The number of extents.
+ * \param reply       The reply.
+ * \param statistics  Statistics.
+ **/
+static void
+jd_object_read_extents(JBackend* backend, gpointer object, JBackendExtent* extents, guint extents_len, JMessage* reply, JStatistics* statistics)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_autofree gboolean* holes = NULL;
+
+	holes = jd_object_find_holes(backend, object, extents, extents_len);
+
+	if (holes == NULL)
+	{
+		j_backend_object_readv(backend, object, extents, extents_len);
+	}
+	else
+	{
+		g_autofree JBackendExtent* data_extents = NULL;
+		guint data_extents_len = 0;
+
+		data_extents = g_new(JBackendExtent, extents_len);
+
+		for (guint i = 0; i < extents_len; i++)
+		{
+			if (!holes[i])
+			{
+				data_extents[data_extents_len] = extents[i];
+				data_extents_len++;
+			}
+		}
+
+		j_backend_object_readv(backend, object, data_extents, data_extents_len);
+
+		for (guint i = 0, j = 0; i < extents_len; i++)
+		{
+			if (!holes[i])
+			{
+				extents[i].bytes = data_extents[j].bytes;
+				j++;
+			}
+		}
+	}
+
+	for (guint i = 0; i < extents_len; i++)
+	{
+		guint64 bytes_read = extents[i].bytes;
+
+		if (holes != NULL && holes[i] && bytes_read > 0)
+		{
+			guint64 zero = bytes_read | J_MESSAGE_OBJECT_READ_ZERO;
+
+			j_message_add_operation(reply, sizeof(guint64));
+			j_message_append_8(reply, &zero);
+			continue;
+		}
+
+		j_statistics_add(statistics, J_STATISTICS_BYTES_READ, bytes_read);
+
+		j_message_add_operation(reply, sizeof(guint64));
+		j_message_append_8(reply, &bytes_read);
+
+		if (bytes_read > 0)
+		{
+			j_message_add_send(reply, extents[i].buffer, bytes_read);
+		}
+
+		j_statistics_add(statistics, J_STATISTICS_BYTES_SENT, bytes_read);
+	}
+}
+
+/**
+ * Writes extents using a single backend call and adds the results to the reply.
+ *
+ * \param backend     The object's backend.
+ * \param object      The object.
+ * \param extents     The extents.
+ * \param extents_len The number of extents.
+ * \param sync        Whether the object should be synced afterwards.
+ * \param reply       The reply, NULL if no reply is sent.
+ * \param statistics  Statistics.
+ **/
+static void
+jd_object_write_extents(JBackend* backend, gpointer object, JBackendExtent* extents, guint extents_len, gboolean sync, JMessage* reply, JStatistics* statistics)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	j_backend_object_writev(backend, object, extents, extents_len, sync);
+
+	if (sync)
+	{
+		j_statistics_add(statistics, J_STATISTICS_SYNC, 1);
+	}
+
+	for (guint i = 0; i < extents_len; i++)
+	{
+		guint64 bytes_written = extents[i].bytes;
+
+		j_statistics_add(statistics, J_STATISTICS_BYTES_WRITTEN, bytes_written);
+
+		if (reply != NULL)
+		{
+			j_message_add_operation(reply, sizeof(guint64));
+			j_message_append_8(reply, &bytes_written);
+		}
+	}
+}
+
+/**
+ * Copies an object, possibly between two shards.
+ *
+ * \param source_backend      The source object's backend.
+ * \param source              The source object.
+ * \param destination_backend The destination object's backend.
+ * \param destination         The destination object.
+ * \param bytes_copied        Returns the number of bytes copied.
+ *
+ * \return TRUE on success, FALSE otherwise.
+ **/
+static gboolean
+jd_object_copy(JBackend* source_backend, gpointer source, JBackend* destination_backend, gpointer destination, guint64* bytes_copied)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	guint64 const buffer_size = 4 * 1024 * 1024;
+
+	gpointer buffer;
+	guint64 size;
+	guint64 offset = 0;
+	gboolean ret = TRUE;
+
+	if (source_backend == destination_backend)
+	{
+		return j_backend_object_copy(source_backend, source, destination, bytes_copied);
+	}
+
+	// Backends of different shards do not share their storage, so the data has to be copied here
+	if (!j_backend_object_status(source_backend, source, NULL, &size))
+	{
+		return FALSE;
+	}
+
+	buffer = j_helper_alloc_aligned(J_BACKEND_ALIGNMENT, buffer_size);
+
+	while (ret && offset < size)
+	{
+		guint64 bytes_read = 0;
+		guint64 bytes_written = 0;
+
+		if (!j_backend_object_read(source_backend, source, buffer, MIN(buffer_size, size - offset), offset, &bytes_read) || bytes_read == 0)
+		{
+			break;
+		}
+
+		ret = j_backend_object_write(destination_backend, destination, buffer, bytes_read, offset, &bytes_written) && bytes_written == bytes_read;
+
+		offset += bytes_written;
+	}
+
+	free(buffer);
+
+	*bytes_copied = offset;
+
+	return (ret && offset == size);
+}
+
+/**
+ * Returns the shard of a key, starting a batch for it if necessary.
+ *
+ * \param namespace The namespace.
+ * \param key       The key.
+ * \param semantics The semantics.
+ * \param batches   One batch per shard, NULL if not started yet.
+ *
+ * \return The shard.
+ **/
+static guint
+jd_kv_batch_get(gchar const* namespace, gchar const* key, JSemantics* semantics, gpointer* batches)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	guint shard;
+
+	shard = jd_shard(namespace, key);
+
+	if (batches[shard] == NULL)
+	{
+		j_backend_kv_batch_start(jd_kv_backends[shard], namespace, semantics, &batches[shard]);
+	}
+
+	return shard;
+}
+
+/**
+ * Executes all started batches.
+ *
+ * \param batches One batch per shard, NULL if not started.
+ **/
+static void
+jd_kv_batch_execute(gpointer* batches)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	for (guint shard = 0; shard < jd_shards; shard++)
+	{
+		if (batches[shard] != NULL)
+		{
+			j_backend_kv_batch_execute(jd_kv_backends[shard], batches[shard]);
+		}
+	}
+}
+
+/**
+ * A key-value pair returned by a range scan.
+ **/
+struct JDKVEntry
+{
+	gchar* key;
+	gpointer value;
+	guint32 len;
+};
+
+typedef struct JDKVEntry JDKVEntry;
+
+static void
+jd_kv_entry_free(gpointer data)
+{
+	JDKVEntry* entry = data;
+
+	g_free(entry->key);
+	g_free(entry->value);
+	g_free(entry);
+}
+
+static gint
+jd_kv_entry_compare(gconstpointer a, gconstpointer b)
+{
+	JDKVEntry const* x = *((JDKVEntry* const*)a);
+	JDKVEntry const* y = *((JDKVEntry* const*)b);
+
+	return strcmp(x->key, y->key);
+}
+
+/**
+ * Restores the max-heap property after the entry at the given position has changed.
+ * The heap keeps the smallest keys seen so far, with the largest of them at the root.
+ *
+ * \param heap  An array of JDKVEntry ordered as a max-heap by key.
+ * \param index The position of the changed entry.
+ **/
+static void
+jd_kv_heap_fix(GPtrArray* heap, guint index)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gpointer* data = heap->pdata;
+
+	// Move the entry up as long as it is larger than its parent
+	while (index > 0 && strcmp(((JDKVEntry*)data[(index - 1) / 2])->key, ((JDKVEntry*)data[index])->key) < 0)
+	{
+		gpointer tmp = data[index];
+
+		data[index] = data[(index - 1) / 2];
+		data[(index - 1) / 2] = tmp;
+		index = (index - 1) / 2;
+	}
+
+	// Move the entry down as long as one of its children is larger
+	while (TRUE)
+	{
+		guint largest = index;
+		gpointer tmp;
+
+		for (guint child = 2 * index + 1; child <= 2 * index + 2 && child < heap->len; child++)
+		{
+			if (strcmp(((JDKVEntry*)data[largest])->key, ((JDKVEntry*)data[child])->key) < 0)
+			{
+				largest = child;
+			}
+		}
+
+		if (largest == index)
+		{
+			break;
+		}
+
+		tmp = data[index];
+		data[index] = data[largest];
+		data[largest] = tmp;
+		index = largest;
+	}
+}
+
+/**
+ * Appends the first key-value pairs of a range to an array.
+ *
+ * \param backend   The backend.
+ * \param namespace The namespace.
+ * \param start     The first key.
+ * \param end       The end key (exclusive), NULL for no end.
+ * \param limit     The maximum number of key-value pairs, 0 for no limit.
+ * \param entries   An array of JDKVEntry.
+ **/
+static void
+jd_kv_get_range(JBackend* backend, gchar const* namespace, gchar const* start, gchar const* end, guint32 limit, GPtrArray* entries)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_autoptr(GPtrArray) heap = NULL;
+	gpointer iterator;
+	gchar const* key;
+	gconstpointer value;
+	guint32 len;
+	gboolean sorted;
+
+	sorted = j_backend_kv_get_range(backend, namespace, start, end, limit, &iterator);
+
+	// Backends without support for ranges return all keys, which have to be filtered here
+	if (!sorted && !j_backend_kv_get_all(backend, namespace, &iterator))
+	{
+		return;
+	}
+
+	// Only the first entries are needed, so keep at most limit of them instead of copying all matching ones
+	if (!sorted && limit > 0)
+	{
+		heap = g_ptr_array_new_with_free_func(jd_kv_entry_free);
+	}
+
+	while (j_backend_kv_iterate(backend, iterator, &key, &value, &len))
+	{
+		JDKVEntry* entry;
+
+		if (!sorted && (strcmp(key, start) < 0 || (end != NULL && strcmp(key, end) >= 0)))
+		{
+			continue;
+		}
+
+		// Keys that are larger than all kept ones are skipped without copying their values
+		if (heap != NULL && heap->len == limit)
+		{
+			if (strcmp(key, ((JDKVEntry*)g_ptr_array_index(heap, 0))->key) >= 0)
+			{
+				continue;
+			}
+
+			jd_kv_entry_free(heap->pdata[0]);
+			heap->pdata[0] = NULL;
+		}
+
+		entry = g_new(JDKVEntry, 1);
+		entry->key = g_strdup(key);
+#if GLIB_CHECK_VERSION(2, 68, 0)
+		entry->value = g_memdup2(value, len);
+#else
+		entry->value = g_memdup(value, len);
+#endif
+		entry->len = len;
+
+		if (sorted || limit == 0)
+		{
+			g_ptr_array_add(entries, entry);
+		}
+		else if (heap->len == limit)
+		{
+			// Replace the largest kept entry
+			heap->pdata[0] = entry;
+			jd_kv_heap_fix(heap, 0);
+		}
+		else
+		{
+			g_ptr_array_add(heap, entry);
+			jd_kv_heap_fix(heap, heap->len - 1);
+		}
+	}
+
+	if (heap != NULL)
+	{
+		for (guint i = 0; i < heap->len; i++)
+		{
+			g_ptr_array_add(entries, g_ptr_array_index(heap, i));
+		}
+
+		// The entries are owned by the array now
+		g_ptr_array_set_free_func(heap, NULL);
+	}
+}
+
 gboolean
-jd_handle_message(JMessage* message, GSocketConnection* connection, JMemoryChunk* memory_chunk, guint64 memory_chunk_size, JStatistics* statistics)
+jd_message_has_payload(JMessage* message)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	// Only written data follows its message, see J_MESSAGE_OBJECT_WRITE below
+	return (j_message_get_type(message) == J_MESSAGE_OBJECT_WRITE);
+}
+
+gboolean
+jd_handle_message(JMessage* message, JNetworkConnection* connection, JMemoryChunk* memory_chunk, guint64 memory_chunk_size, JStatistics* statistics)
 {
 	J_TRACE_FUNCTION(NULL);
 
@@ -67,17 +598,16 @@ jd_handle_message(JMessage* message, GSocketConnection* connection, JMemoryChunk
 			{
 				path = j_message_get_string(message);
 
-				if (j_backend_object_create(jd_object_backend, namespace, path, &object))
+				// Objects are usually written right after being created, so keep their handles
+				if (jd_object_cache_create(namespace, path, &object, statistics))
 				{
 					j_statistics_add(statistics, J_STATISTICS_FILES_CREATED, 1);
 
 					if (persistency == J_SEMANTICS_PERSISTENCY_STORAGE)
 					{
-						j_backend_object_sync(jd_object_backend, object);
+						j_backend_object_sync(jd_object_backend_for(namespace, path), object);
 						j_statistics_add(statistics, J_STATISTICS_SYNC, 1);
 					}
-
-					j_backend_object_close(jd_object_backend, object);
 				}
 
 				if (reply != NULL)
@@ -95,7 +625,6 @@ jd_handle_message(JMessage* message, GSocketConnection* connection, JMemoryChunk
 		case J_MESSAGE_OBJECT_DELETE:
 		{
 			g_autoptr(JMessage) reply = NULL;
-			gpointer object;
 
 			if (persistency == J_SEMANTICS_PERSISTENCY_NETWORK || persistency == J_SEMANTICS_PERSISTENCY_STORAGE)
 			{
@@ -110,8 +639,8 @@ jd_handle_message(JMessage* message, GSocketConnection* connection, JMemoryChunk
 
 				path = j_message_get_string(message);
 
-				if (j_backend_object_open(jd_object_backend, namespace, path, &object)
-				    && j_backend_object_delete(jd_object_backend, object))
+				// Cached handles of the object are invalidated
+				if (jd_object_cache_delete(namespace, path, statistics))
 				{
 					status = 1;
 					j_statistics_add(statistics, J_STATISTICS_FILES_DELETED, 1);
@@ -135,13 +664,22 @@ jd_handle_message(JMessage* message, GSocketConnection* connection, JMemoryChunk
 			g_autoptr(JMessage) reply = NULL;
 			gpointer iterator;
 			gchar const* empty = "";
+			gsize frame_size = 0;
 
 			reply = j_message_new_reply(message);
 			namespace = j_message_get_string(message);
 
-			if (j_backend_object_get_all(jd_object_backend, namespace, &iterator))
+			// Objects of a namespace are spread across all shards
+			for (guint shard = 0; shard < jd_shards; shard++)
 			{
-				while (j_backend_object_iterate(jd_object_backend, iterator, &key))
+				JBackend* object_backend = jd_object_backends[shard];
+
+				if (!j_backend_object_get_all(object_backend, namespace, &iterator))
+				{
+					continue;
+				}
+
+				while (j_backend_object_iterate(object_backend, iterator, &key))
 				{
 					gsize key_len;
 
@@ -149,6 +687,14 @@ jd_handle_message(JMessage* message, GSocketConnection* connection, JMemoryChunk
 
 					j_message_add_operation(reply, key_len);
 					j_message_append_string(reply, key);
+
+					frame_size += key_len;
+
+					if (frame_size >= JD_REPLY_FRAME_SIZE)
+					{
+						reply = jd_reply_next_frame(reply, message, connection);
+						frame_size = 0;
+					}
 				}
 			}
 
@@ -164,14 +710,22 @@ jd_handle_message(JMessage* message, GSocketConnection* connection, JMemoryChunk
 			gchar const* prefix;
 			gpointer iterator;
 			gchar const* empty = "";
+			gsize frame_size = 0;
 
 			reply = j_message_new_reply(message);
 			namespace = j_message_get_string(message);
 			prefix = j_message_get_string(message);
 
-			if (j_backend_object_get_by_prefix(jd_object_backend, namespace, prefix, &iterator))
+			for (guint shard = 0; shard < jd_shards; shard++)
 			{
-				while (j_backend_object_iterate(jd_object_backend, iterator, &key))
+				JBackend* object_backend = jd_object_backends[shard];
+
+				if (!j_backend_object_get_by_prefix(object_backend, namespace, prefix, &iterator))
+				{
+					continue;
+				}
+
+				while (j_backend_object_iterate(object_backend, iterator, &key))
 				{
 					gsize key_len;
 
@@ -179,6 +733,14 @@ jd_handle_message(JMessage* message, GSocketConnection* connection, JMemoryChunk
 
 					j_message_add_operation(reply, key_len);
 					j_message_append_string(reply, key);
+
+					frame_size += key_len;
+
+					if (frame_size >= JD_REPLY_FRAME_SIZE)
+					{
+						reply = jd_reply_next_frame(reply, message, connection);
+						frame_size = 0;
+					}
 				}
 			}
 
@@ -191,22 +753,26 @@ jd_handle_message(JMessage* message, GSocketConnection* connection, JMemoryChunk
 		case J_MESSAGE_OBJECT_READ:
 		{
 			JMessage* reply;
+			g_autofree JBackendExtent* extents = NULL;
+			JBackend* object_backend;
 			gpointer object;
+			guint extents_len = 0;
 			gboolean ret;
 
 			namespace = j_message_get_string(message);
 			path = j_message_get_string(message);
+			object_backend = jd_object_backend_for(namespace, path);
 
 			reply = j_message_new_reply(message);
+			extents = g_new(JBackendExtent, operation_count);
 
-			ret = j_backend_object_open(jd_object_backend, namespace, path, &object);
+			ret = jd_object_cache_open(namespace, path, &object, statistics);
 
 			for (i = 0; i < operation_count; i++)
 			{
 				gchar* buf;
 				guint64 length;
 				guint64 offset;
-				guint64 bytes_read = 0;
 
 				length = j_message_get_8(message);
 				offset = j_message_get_8(message);
@@ -218,6 +784,11 @@ jd_handle_message(JMessage* message, GSocketConnection* connection, JMemoryChunk
 
 				if (length > memory_chunk_size)
 				{
+					guint64 bytes_read = 0;
+
+					jd_object_read_extents(object_backend, object, extents, extents_len, reply, statistics);
+					extents_len = 0;
+
 					/// \todo return proper error
 					j_message_add_operation(reply, sizeof(guint64));
 					j_message_append_8(reply, &bytes_read);
@@ -228,6 +799,9 @@ jd_handle_message(JMessage* message, GSocketConnection* connection, JMemoryChunk
 
 				if (buf == NULL)
 				{
+					jd_object_read_extents(object_backend, object, extents, extents_len, reply, statistics);
+					extents_len = 0;
+
 					/// \todo ugly
 					j_message_send(reply, connection);
 					j_message_unref(reply);
@@ -238,23 +812,15 @@ jd_handle_message(JMessage* message, GSocketConnection* connection, JMemoryChunk
 					buf = j_memory_chunk_get(memory_chunk, length);
 				}
 
-				j_backend_object_read(jd_object_backend, object, buf, length, offset, &bytes_read);
-				j_statistics_add(statistics, J_STATISTICS_BYTES_READ, bytes_read);
-
-				j_message_add_operation(reply, sizeof(guint64));
-				j_message_append_8(reply, &bytes_read);
-
-				if (bytes_read > 0)
-				{
-					j_message_add_send(reply, buf, bytes_read);
-				}
-
-				j_statistics_add(statistics, J_STATISTICS_BYTES_SENT, bytes_read);
+				extents[extents_len].buffer = buf;
+				extents[extents_len].length = length;
+				extents[extents_len].offset = offset;
+				extents_len++;
 			}
 
 			if (ret)
 			{
-				j_backend_object_close(jd_object_backend, object);
+				jd_object_read_extents(object_backend, object, extents, extents_len, reply, statistics);
 			}
 
 			j_message_send(reply, connection);
@@ -266,7 +832,10 @@ jd_handle_message(JMessage* message, GSocketConnection* connection, JMemoryChunk
 		case J_MESSAGE_OBJECT_WRITE:
 		{
 			g_autoptr(JMessage) reply = NULL;
+			g_autofree JBackendExtent* extents = NULL;
+			JBackend* object_backend;
 			gpointer object;
+			guint extents_len = 0;
 			gboolean ret;
 
 			if (persistency == J_SEMANTICS_PERSISTENCY_NETWORK || persistency == J_SEMANTICS_PERSISTENCY_STORAGE)
@@ -276,60 +845,69 @@ jd_handle_message(JMessage* message, GSocketConnection* connection, JMemoryChunk
 
 			namespace = j_message_get_string(message);
 			path = j_message_get_string(message);
+			object_backend = jd_object_backend_for(namespace, path);
+
+			extents = g_new(JBackendExtent, operation_count);
 
-			ret = j_backend_object_open(jd_object_backend, namespace, path, &object);
+			ret = jd_object_cache_open(namespace, path, &object, statistics);
 
 			for (i = 0; i < operation_count; i++)
 			{
-				GInputStream* input;
 				gchar* buf;
 				guint64 length;
 				guint64 offset;
-				guint64 bytes_written = 0;
 
 				length = j_message_get_8(message);
 				offset = j_message_get_8(message);
 
 				if (length > memory_chunk_size && reply != NULL && G_LIKELY(ret))
 				{
+					guint64 bytes_written = 0;
+
+					jd_object_write_extents(object_backend, object, extents, extents_len, FALSE, reply, statistics);
+					extents_len = 0;
+					j_memory_chunk_reset(memory_chunk);
+
 					/// \todo return proper error
 					j_message_add_operation(reply, sizeof(guint64));
 					j_message_append_8(reply, &bytes_written);
 					continue;
 				}
 
-				// Guaranteed to work because memory_chunk is reset below
 				buf = j_memory_chunk_get(memory_chunk, length);
-				g_assert(buf != NULL);
 
-				input = g_io_stream_get_input_stream(G_IO_STREAM(connection));
-				g_input_stream_read_all(input, buf, length, NULL, NULL, NULL);
-				j_statistics_add(statistics, J_STATISTICS_BYTES_RECEIVED, length);
-
-				if (G_LIKELY(ret))
+				// Write the data received so far to make room for the next payload
+				if (buf == NULL)
 				{
-					j_backend_object_write(jd_object_backend, object, buf, length, offset, &bytes_written);
-					j_statistics_add(statistics, J_STATISTICS_BYTES_WRITTEN, bytes_written);
-
-					if (reply != NULL)
+					if (G_LIKELY(ret))
 					{
-						j_message_add_operation(reply, sizeof(guint64));
-						j_message_append_8(reply, &bytes_written);
+						jd_object_write_extents(object_backend, object, extents, extents_len, FALSE, reply, statistics);
+						extents_len = 0;
 					}
+
+					j_memory_chunk_reset(memory_chunk);
+					buf = j_memory_chunk_get(memory_chunk, length);
 				}
 
-				j_memory_chunk_reset(memory_chunk);
-			}
+				// Guaranteed to work because memory_chunk has been reset above if necessary
+				g_assert(buf != NULL);
 
-			if (persistency == J_SEMANTICS_PERSISTENCY_STORAGE)
-			{
-				j_backend_object_sync(jd_object_backend, object);
-				j_statistics_add(statistics, J_STATISTICS_SYNC, 1);
+				j_network_connection_recv_bulk(connection, length, buf);
+				j_statistics_add(statistics, J_STATISTICS_BYTES_RECEIVED, length);
+
+				if (G_LIKELY(ret))
+				{
+					extents[extents_len].buffer = buf;
+					extents[extents_len].length = length;
+					extents[extents_len].offset = offset;
+					extents_len++;
+				}
 			}
 
-			if (ret)
+			// The sync is handed to the backend together with the remaining extents
+			if (G_LIKELY(ret))
 			{
-				j_backend_object_close(jd_object_backend, object);
+				jd_object_write_extents(object_backend, object, extents, extents_len, persistency == J_SEMANTICS_PERSISTENCY_STORAGE, reply, statistics);
 			}
 
 			if (reply != NULL)
@@ -356,10 +934,8 @@ jd_handle_message(JMessage* message, GSocketConnection* connection, JMemoryChunk
 
 				path = j_message_get_string(message);
 
-				/// \todo return value
-				j_backend_object_open(jd_object_backend, namespace, path, &object);
-
-				if (j_backend_object_status(jd_object_backend, object, &modification_time, &size))
+				if (jd_object_cache_open(namespace, path, &object, statistics)
+				    && j_backend_object_status(jd_object_backend_for(namespace, path), object, &modification_time, &size))
 				{
 					j_statistics_add(statistics, J_STATISTICS_FILES_STATED, 1);
 				}
@@ -367,8 +943,6 @@ jd_handle_message(JMessage* message, GSocketConnection* connection, JMemoryChunk
 				j_message_add_operation(reply, sizeof(gint64) + sizeof(guint64));
 				j_message_append_8(reply, &modification_time);
 				j_message_append_8(reply, &size);
-
-				j_backend_object_close(jd_object_backend, object);
 			}
 
 			j_message_send(reply, connection);
@@ -390,11 +964,10 @@ jd_handle_message(JMessage* message, GSocketConnection* connection, JMemoryChunk
 			{
 				path = j_message_get_string(message);
 
-				if (j_backend_object_open(jd_object_backend, namespace, path, &object))
+				if (jd_object_cache_open(namespace, path, &object, statistics))
 				{
-					j_backend_object_sync(jd_object_backend, object);
+					j_backend_object_sync(jd_object_backend_for(namespace, path), object);
 					j_statistics_add(statistics, J_STATISTICS_SYNC, 1);
-					j_backend_object_close(jd_object_backend, object);
 				}
 
 				if (reply != NULL)
@@ -409,6 +982,172 @@ jd_handle_message(JMessage* message, GSocketConnection* connection, JMemoryChunk
 			}
 		}
 		break;
+		case J_MESSAGE_OBJECT_COPY:
+		{
+			g_autoptr(JMessage) reply = NULL;
+
+			reply = j_message_new_reply(message);
+			namespace = j_message_get_string(message);
+
+			for (i = 0; i < operation_count; i++)
+			{
+				gchar const* destination_namespace;
+				gchar const* destination_path;
+				JBackend* source_backend;
+				JBackend* destination_backend;
+				gpointer source;
+				gpointer destination;
+				guint64 bytes_copied = 0;
+				guint32 status = 0;
+
+				path = j_message_get_string(message);
+				destination_namespace = j_message_get_string(message);
+				destination_path = j_message_get_string(message);
+
+				// Re-creating the destination would truncate the source if both are the same object
+				if ((g_strcmp0(namespace, destination_namespace) != 0 || g_strcmp0(path, destination_path) != 0)
+				    && jd_object_cache_open(namespace, path, &source, statistics))
+				{
+					// Backends do not necessarily truncate existing objects when creating them, so the destination is deleted first to not leave its old data behind
+					jd_object_cache_delete(destination_namespace, destination_path, statistics);
+
+					if (jd_object_cache_create(destination_namespace, destination_path, &destination, statistics))
+					{
+						j_statistics_add(statistics, J_STATISTICS_FILES_CREATED, 1);
+
+						source_backend = jd_object_backend_for(namespace, path);
+						destination_backend = jd_object_backend_for(destination_namespace, destination_path);
+
+						// The data does not leave the server, so it is not counted as sent or received
+						if (jd_object_copy(source_backend, source, destination_backend, destination, &bytes_copied))
+						{
+							status = 1;
+						}
+
+						j_statistics_add(statistics, J_STATISTICS_BYTES_READ, bytes_copied);
+						j_statistics_add(statistics, J_STATISTICS_BYTES_WRITTEN, bytes_copied);
+
+						if (persistency == J_SEMANTICS_PERSISTENCY_STORAGE)
+						{
+							j_backend_object_sync(destination_backend, destination);
+							j_statistics_add(statistics, J_STATISTICS_SYNC, 1);
+						}
+					}
+				}
+
+				j_message_add_operation(reply, sizeof(status));
+				j_message_append_4(reply, &status);
+			}
+
+			j_message_send(reply, connection);
+		}
+		break;
+		case J_MESSAGE_OBJECT_ALLOCATE:
+		case J_MESSAGE_OBJECT_PUNCH:
+		{
+			g_autoptr(JMessage) reply = NULL;
+			JBackend* object_backend;
+			gpointer object;
+			gboolean allocate;
+			gboolean ret;
+
+			allocate = (j_message_get_type(message) == J_MESSAGE_OBJECT_ALLOCATE);
+
+			// A reply is always sent because allocating can fail, for example, if there is not enough space
+			reply = j_message_new_reply(message);
+
+			namespace = j_message_get_string(message);
+			path = j_message_get_string(message);
+			object_backend = jd_object_backend_for(namespace, path);
+
+			ret = jd_object_cache_open(namespace, path, &object, statistics);
+
+			for (i = 0; i < operation_count; i++)
+			{
+				guint64 length;
+				guint64 offset;
+				guint32 status = 0;
+
+				length = j_message_get_8(message);
+				offset = j_message_get_8(message);
+
+				if (ret)
+				{
+					if (allocate)
+					{
+						status = j_backend_object_allocate(object_backend, object, length, offset);
+					}
+					else
+					{
+						status = j_backend_object_punch(object_backend, object, length, offset);
+					}
+				}
+
+				j_message_add_operation(reply, sizeof(status));
+				j_message_append_4(reply, &status);
+			}
+
+			if (ret && persistency == J_SEMANTICS_PERSISTENCY_STORAGE)
+			{
+				j_backend_object_sync(object_backend, object);
+				j_statistics_add(statistics, J_STATISTICS_SYNC, 1);
+			}
+
+			j_message_send(reply, connection);
+		}
+		break;
+		case J_MESSAGE_OBJECT_GET_EXTENTS:
+		{
+			g_autoptr(JMessage) reply = NULL;
+			g_autoptr(GArray) extents = NULL;
+			gpointer object;
+			gboolean ret;
+
+			reply = j_message_new_reply(message);
+			extents = g_array_new(FALSE, FALSE, sizeof(JBackendExtent));
+
+			namespace = j_message_get_string(message);
+			path = j_message_get_string(message);
+
+			ret = jd_object_cache_open(namespace, path, &object, statistics);
+
+			for (i = 0; i < operation_count; i++)
+			{
+				guint64 length;
+				guint64 offset;
+				guint32 count = 0;
+
+				length = j_message_get_8(message);
+				offset = j_message_get_8(message);
+
+				g_array_set_size(extents, 0);
+
+				// The count is G_MAXUINT32 if the extents could not be determined
+				if (!ret || !j_backend_object_get_extents(jd_object_backend_for(namespace, path), object, length, offset, extents))
+				{
+					count = G_MAXUINT32;
+					g_array_set_size(extents, 0);
+				}
+				else
+				{
+					count = extents->len;
+				}
+
+				j_message_add_operation(reply, sizeof(guint32) + extents->len * 2 * sizeof(guint64));
+				j_message_append_4(reply, &count);
+
+				for (guint j = 0; j < extents->len; j++)
+				{
+					JBackendExtent* extent = &g_array_index(extents, JBackendExtent, j);
+
+					j_message_append_8(reply, &(extent->offset));
+					j_message_append_8(reply, &(extent->length));
+				}
+			}
+
+			j_message_send(reply, connection);
+		}
+		break;
 		case J_MESSAGE_STATISTICS:
 		{
 			g_autoptr(JMessage) reply = NULL;
@@ -426,7 +1165,7 @@ jd_handle_message(JMessage* message, GSocketConnection* connection, JMemoryChunk
 			}
 
 			reply = j_message_new_reply(message);
-			j_message_add_operation(reply, 8 * sizeof(guint64));
+			j_message_add_operation(reply, 10 * sizeof(guint64));
 
 			value = j_statistics_get(r_statistics, J_STATISTICS_FILES_CREATED);
 			j_message_append_8(reply, &value);
@@ -444,6 +1183,10 @@ jd_handle_message(JMessage* message, GSocketConnection* connection, JMemoryChunk
 			j_message_append_8(reply, &value);
 			value = j_statistics_get(r_statistics, J_STATISTICS_BYTES_SENT);
 			j_message_append_8(reply, &value);
+			value = j_statistics_get(r_statistics, J_STATISTICS_OPENS_SAVED);
+			j_message_append_8(reply, &value);
+			value = j_statistics_get(r_statistics, J_STATISTICS_CLOSES_SAVED);
+			j_message_append_8(reply, &value);
 
 			if (get_all != 0)
 			{
@@ -458,6 +1201,8 @@ jd_handle_message(JMessage* message, GSocketConnection* connection, JMemoryChunk
 			g_autoptr(JMessage) reply = NULL;
 			gchar const* client_checksum;
 			gchar const* server_checksum;
+			gchar multiplexed;
+			gchar compression;
 			guint num;
 
 			num = g_atomic_int_add(&jd_thread_num, 1);
@@ -465,23 +1210,38 @@ jd_handle_message(JMessage* message, GSocketConnection* connection, JMemoryChunk
 			//g_message("HELLO %d", num);
 
 			client_checksum = j_message_get_string(message);
+			multiplexed = j_message_get_1(message);
+			compression = j_message_get_1(message);
 			server_checksum = j_configuration_get_checksum(jd_configuration);
 
+			// Messages of multiplexed connections may be handled concurrently by the event loop
+			j_network_connection_set_multiplexed(connection, multiplexed != 0);
+
 			if (g_strcmp0(client_checksum, server_checksum) != 0)
 			{
 				g_warning("Client %d uses different configuration than server.", num);
 			}
 
+			// Fall back to no compression if the requested codec is not supported by this build or transport
+			if ((guchar)compression > J_CONFIGURATION_COMPRESSION_ZSTD || !j_network_connection_set_compression(connection, compression))
+			{
+				compression = J_CONFIGURATION_COMPRESSION_NONE;
+			}
+
+			// The reply has to be sent uncompressed since the client does not know the codec yet
+			j_network_connection_set_compression(connection, J_CONFIGURATION_COMPRESSION_NONE);
+
 			reply = j_message_new_reply(message);
 			j_message_append_string(reply, server_checksum);
+			j_message_append_1(reply, &compression);
 
-			if (jd_object_backend != NULL)
+			if (jd_object_backends != NULL)
 			{
 				j_message_add_operation(reply, 7);
 				j_message_append_string(reply, "object");
 			}
 
-			if (jd_kv_backend != NULL)
+			if (jd_kv_backends != NULL)
 			{
 				j_message_add_operation(reply, 3);
 				j_message_append_string(reply, "kv");
@@ -494,12 +1254,14 @@ jd_handle_message(JMessage* message, GSocketConnection* connection, JMemoryChunk
 			}
 
 			j_message_send(reply, connection);
+
+			j_network_connection_set_compression(connection, compression);
 		}
 		break;
 		case J_MESSAGE_KV_PUT:
 		{
 			g_autoptr(JMessage) reply = NULL;
-			gpointer batch;
+			g_autofree gpointer* batches = NULL;
 
 			if (persistency == J_SEMANTICS_PERSISTENCY_NETWORK || persistency == J_SEMANTICS_PERSISTENCY_STORAGE)
 			{
@@ -507,19 +1269,21 @@ jd_handle_message(JMessage* message, GSocketConnection* connection, JMemoryChunk
 			}
 
 			namespace = j_message_get_string(message);
-			j_backend_kv_batch_start(jd_kv_backend, namespace, semantics, &batch);
+			batches = g_new0(gpointer, jd_shards);
 
 			for (i = 0; i < operation_count; i++)
 			{
 				gconstpointer data;
 				guint32 len;
 				gboolean ret;
+				guint shard;
 
 				key = j_message_get_string(message);
 				len = j_message_get_4(message);
 				data = j_message_get_n(message, len);
 
-				ret = j_backend_kv_put(jd_kv_backend, batch, key, data, len);
+				shard = jd_kv_batch_get(namespace, key, semantics, batches);
+				ret = j_backend_kv_put(jd_kv_backends[shard], batches[shard], key, data, len);
 
 				if (reply != NULL)
 				{
@@ -531,7 +1295,7 @@ jd_handle_message(JMessage* message, GSocketConnection* connection, JMemoryChunk
 				}
 			}
 
-			j_backend_kv_batch_execute(jd_kv_backend, batch);
+			jd_kv_batch_execute(batches);
 
 			if (reply != NULL)
 			{
@@ -542,7 +1306,7 @@ jd_handle_message(JMessage* message, GSocketConnection* connection, JMemoryChunk
 		case J_MESSAGE_KV_DELETE:
 		{
 			g_autoptr(JMessage) reply = NULL;
-			gpointer batch;
+			g_autofree gpointer* batches = NULL;
 
 			if (persistency == J_SEMANTICS_PERSISTENCY_NETWORK || persistency == J_SEMANTICS_PERSISTENCY_STORAGE)
 			{
@@ -550,15 +1314,17 @@ jd_handle_message(JMessage* message, GSocketConnection* connection, JMemoryChunk
 			}
 
 			namespace = j_message_get_string(message);
-			j_backend_kv_batch_start(jd_kv_backend, namespace, semantics, &batch);
+			batches = g_new0(gpointer, jd_shards);
 
 			for (i = 0; i < operation_count; i++)
 			{
 				gboolean ret;
+				guint shard;
 
 				key = j_message_get_string(message);
 
-				ret = j_backend_kv_delete(jd_kv_backend, batch, key);
+				shard = jd_kv_batch_get(namespace, key, semantics, batches);
+				ret = j_backend_kv_delete(jd_kv_backends[shard], batches[shard], key);
 
 				if (reply != NULL)
 				{
@@ -570,7 +1336,7 @@ jd_handle_message(JMessage* message, GSocketConnection* connection, JMemoryChunk
 				}
 			}
 
-			j_backend_kv_batch_execute(jd_kv_backend, batch);
+			jd_kv_batch_execute(batches);
 
 			if (reply != NULL)
 			{
@@ -581,20 +1347,22 @@ jd_handle_message(JMessage* message, GSocketConnection* connection, JMemoryChunk
 		case J_MESSAGE_KV_GET:
 		{
 			g_autoptr(JMessage) reply = NULL;
-			gpointer batch;
+			g_autofree gpointer* batches = NULL;
 
 			reply = j_message_new_reply(message);
 			namespace = j_message_get_string(message);
-			j_backend_kv_batch_start(jd_kv_backend, namespace, semantics, &batch);
+			batches = g_new0(gpointer, jd_shards);
 
 			for (i = 0; i < operation_count; i++)
 			{
 				gpointer value;
 				guint32 len;
+				guint shard;
 
 				key = j_message_get_string(message);
+				shard = jd_kv_batch_get(namespace, key, semantics, batches);
 
-				if (j_backend_kv_get(jd_kv_backend, batch, key, &value, &len))
+				if (j_backend_kv_get(jd_kv_backends[shard], batches[shard], key, &value, &len))
 				{
 					j_message_add_operation(reply, 4 + len);
 					j_message_append_4(reply, &len);
@@ -611,7 +1379,7 @@ jd_handle_message(JMessage* message, GSocketConnection* connection, JMemoryChunk
 				}
 			}
 
-			j_backend_kv_batch_execute(jd_kv_backend, batch);
+			jd_kv_batch_execute(batches);
 
 			j_message_send(reply, connection);
 		}
@@ -623,22 +1391,38 @@ jd_handle_message(JMessage* message, GSocketConnection* connection, JMemoryChunk
 			gconstpointer value;
 			guint32 len;
 			guint32 zero = 0;
+			gsize frame_size = 0;
 
 			reply = j_message_new_reply(message);
 			namespace = j_message_get_string(message);
 
-			j_backend_kv_get_all(jd_kv_backend, namespace, &iterator);
-
-			while (j_backend_kv_iterate(jd_kv_backend, iterator, &key, &value, &len))
+			// Keys of a namespace are spread across all shards
+			for (guint shard = 0; shard < jd_shards; shard++)
 			{
-				gsize key_len;
+				if (!j_backend_kv_get_all(jd_kv_backends[shard], namespace, &iterator))
+				{
+					continue;
+				}
 
-				key_len = strlen(key) + 1;
+				while (j_backend_kv_iterate(jd_kv_backends[shard], iterator, &key, &value, &len))
+				{
+					gsize key_len;
+
+					key_len = strlen(key) + 1;
+
+					j_message_add_operation(reply, 4 + len + key_len);
+					j_message_append_4(reply, &len);
+					j_message_append_n(reply, value, len);
+					j_message_append_string(reply, key);
 
-				j_message_add_operation(reply, 4 + len + key_len);
-				j_message_append_4(reply, &len);
-				j_message_append_n(reply, value, len);
-				j_message_append_string(reply, key);
+					frame_size += 4 + len + key_len;
+
+					if (frame_size >= JD_REPLY_FRAME_SIZE)
+					{
+						reply = jd_reply_next_frame(reply, message, connection);
+						frame_size = 0;
+					}
+				}
 			}
 
 			j_message_add_operation(reply, 4);
@@ -655,23 +1439,98 @@ jd_handle_message(JMessage* message, GSocketConnection* connection, JMemoryChunk
 			gconstpointer value;
 			guint32 len;
 			guint32 zero = 0;
+			gsize frame_size = 0;
 
 			reply = j_message_new_reply(message);
 			namespace = j_message_get_string(message);
 			prefix = j_message_get_string(message);
 
-			j_backend_kv_get_by_prefix(jd_kv_backend, namespace, prefix, &iterator);
+			for (guint shard = 0; shard < jd_shards; shard++)
+			{
+				if (!j_backend_kv_get_by_prefix(jd_kv_backends[shard], namespace, prefix, &iterator))
+				{
+					continue;
+				}
+
+				while (j_backend_kv_iterate(jd_kv_backends[shard], iterator, &key, &value, &len))
+				{
+					gsize key_len;
+
+					key_len = strlen(key) + 1;
+
+					j_message_add_operation(reply, 4 + len + key_len);
+					j_message_append_4(reply, &len);
+					j_message_append_n(reply, value, len);
+					j_message_append_string(reply, key);
+
+					frame_size += 4 + len + key_len;
 
-			while (j_backend_kv_iterate(jd_kv_backend, iterator, &key, &value, &len))
+					if (frame_size >= JD_REPLY_FRAME_SIZE)
+					{
+						reply = jd_reply_next_frame(reply, message, connection);
+						frame_size = 0;
+					}
+				}
+			}
+
+			j_message_add_operation(reply, 4);
+			j_message_append_4(reply, &zero);
+
+			j_message_send(reply, connection);
+		}
+		break;
+		case J_MESSAGE_KV_GET_RANGE:
+		{
+			g_autoptr(JMessage) reply = NULL;
+			g_autoptr(GPtrArray) entries = NULL;
+			gchar const* start;
+			gchar const* end = NULL;
+			guint32 limit;
+			guint32 entries_len;
+			guint32 zero = 0;
+			gsize frame_size = 0;
+
+			reply = j_message_new_reply(message);
+			namespace = j_message_get_string(message);
+			start = j_message_get_string(message);
+
+			if (j_message_get_1(message) != 0)
+			{
+				end = j_message_get_string(message);
+			}
+
+			limit = j_message_get_4(message);
+
+			entries = g_ptr_array_new_with_free_func(jd_kv_entry_free);
+
+			// Each shard returns its first entries, which are then merged
+			for (guint shard = 0; shard < jd_shards; shard++)
+			{
+				jd_kv_get_range(jd_kv_backends[shard], namespace, start, end, limit, entries);
+			}
+
+			g_ptr_array_sort(entries, jd_kv_entry_compare);
+			entries_len = (limit > 0) ? MIN(limit, entries->len) : entries->len;
+
+			for (guint32 j = 0; j < entries_len; j++)
 			{
+				JDKVEntry* entry = g_ptr_array_index(entries, j);
 				gsize key_len;
 
-				key_len = strlen(key) + 1;
+				key_len = strlen(entry->key) + 1;
+
+				j_message_add_operation(reply, 4 + entry->len + key_len);
+				j_message_append_4(reply, &(entry->len));
+				j_message_append_n(reply, entry->value, entry->len);
+				j_message_append_string(reply, entry->key);
 
-				j_message_add_operation(reply, 4 + len + key_len);
-				j_message_append_4(reply, &len);
-				j_message_append_n(reply, value, len);
-				j_message_append_string(reply, key);
+				frame_size += 4 + entry->len + key_len;
+
+				if (frame_size >= JD_REPLY_FRAME_SIZE)
+				{
+					reply = jd_reply_next_frame(reply, message, connection);
+					frame_size = 0;
+				}
 			}
 
 			j_message_add_operation(reply, 4);
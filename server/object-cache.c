@@ -0,0 +1,513 @@
+/*
+ * JULEA - Flexible storage framework
+ * Copyright (C) 2026 Michael Kuhn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <julea-config.h>
+
+#include <glib.h>
+
+#include <julea.h>
+
+#include "server.h"
+
+/**
+ * Caches open object handles, so that consecutive operations on the same object do not have to open and close it every time.
+ *
+ * Every worker thread has its own cache, because backends such as posix manage their handles per thread.
+ * For the same reason, handles are only ever closed by the thread that opened them.
+ * When an object is deleted, the other workers' handles are marked as stale and closed the next time their worker uses its cache.
+ * When shutting down, every worker flushes its own cache using jd_object_cache_flush().
+ **/
+
+/**
+ * The maximum number of handles per worker.
+ **/
+#define JD_OBJECT_CACHE_SIZE 128
+
+/**
+ * A cached handle.
+ **/
+struct JDObjectCacheEntry
+{
+	/**
+	 * The namespace and path, separated by a slash.
+	 **/
+	gchar* key;
+
+	/**
+	 * The backend of the object's shard and its handle.
+	 **/
+	JBackend* backend;
+	gpointer object;
+
+	/**
+	 * The number of operations that have used the handle.
+	 **/
+	guint64 uses;
+
+	/**
+	 * Whether the object has been deleted by another worker.
+	 **/
+	gboolean stale;
+};
+
+typedef struct JDObjectCacheEntry JDObjectCacheEntry;
+
+/**
+ * A worker's cache.
+ **/
+struct JDObjectCache
+{
+	/**
+	 * Maps keys to links in lru.
+	 **/
+	GHashTable* entries;
+
+	/**
+	 * The entries, most recently used first.
+	 **/
+	GQueue lru[1];
+
+	/**
+	 * The number of stale entries.
+	 **/
+	gint stale;
+
+	/**
+	 * Protects entries and lru, only needed because other workers mark entries as stale.
+	 **/
+	GMutex mutex[1];
+};
+
+typedef struct JDObjectCache JDObjectCache;
+
+/**
+ * All workers' caches.
+ **/
+static GPtrArray* jd_object_caches = NULL;
+
+G_LOCK_DEFINE_STATIC(jd_object_caches);
+
+static void jd_object_cache_free(gpointer);
+
+static GPrivate jd_worker_object_cache = G_PRIVATE_INIT(jd_object_cache_free);
+
+static void
+jd_object_cache_entry_close(JDObjectCacheEntry* entry, JStatistics* statistics)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	j_backend_object_close(entry->backend, entry->object);
+
+	// Every operation but the first one would have had to close the handle itself
+	if (statistics != NULL && entry->uses > 1)
+	{
+		j_statistics_add(statistics, J_STATISTICS_CLOSES_SAVED, entry->uses - 1);
+	}
+
+	g_free(entry->key);
+	g_free(entry);
+}
+
+/**
+ * Removes an entry from a cache without closing its handle.
+ *
+ * \param cache A cache, whose mutex must be held.
+ * \param link  The entry's link.
+ *
+ * \return The entry.
+ **/
+static JDObjectCacheEntry*
+jd_object_cache_remove(JDObjectCache* cache, GList* link)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JDObjectCacheEntry* entry = link->data;
+
+	g_hash_table_remove(cache->entries, entry->key);
+	g_queue_delete_link(cache->lru, link);
+
+	if (entry->stale)
+	{
+		g_atomic_int_add(&(cache->stale), -1);
+	}
+
+	return entry;
+}
+
+/**
+ * Frees a cache, closing all of its handles.
+ * This is called when a worker's cache is flushed or its thread exits, so the handles are closed by the thread that opened them.
+ *
+ * \param data A cache.
+ **/
+static void
+jd_object_cache_free(gpointer data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JDObjectCache* cache = data;
+	JDObjectCacheEntry* entry;
+
+	G_LOCK(jd_object_caches);
+
+	g_ptr_array_remove_fast(jd_object_caches, cache);
+
+	G_UNLOCK(jd_object_caches);
+
+	while ((entry = g_queue_pop_head(cache->lru)) != NULL)
+	{
+		jd_object_cache_entry_close(entry, NULL);
+	}
+
+	g_hash_table_unref(cache->entries);
+	g_mutex_clear(cache->mutex);
+	g_free(cache);
+}
+
+/**
+ * Returns the calling worker's cache, closing handles of objects that have been deleted in the meantime.
+ *
+ * \param statistics Statistics.
+ *
+ * \return The cache.
+ **/
+static JDObjectCache*
+jd_object_cache_get(JStatistics* statistics)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JDObjectCache* cache;
+
+	cache = g_private_get(&jd_worker_object_cache);
+
+	if (G_UNLIKELY(cache == NULL))
+	{
+		cache = g_new(JDObjectCache, 1);
+		cache->entries = g_hash_table_new(g_str_hash, g_str_equal);
+		g_queue_init(cache->lru);
+		cache->stale = 0;
+		g_mutex_init(cache->mutex);
+
+		G_LOCK(jd_object_caches);
+
+		if (jd_object_caches == NULL)
+		{
+			jd_object_caches = g_ptr_array_new();
+		}
+
+		g_ptr_array_add(jd_object_caches, cache);
+
+		G_UNLOCK(jd_object_caches);
+
+		g_private_set(&jd_worker_object_cache, cache);
+	}
+
+	if (G_UNLIKELY(g_atomic_int_get(&(cache->stale)) > 0))
+	{
+		GList* link;
+
+		g_mutex_lock(cache->mutex);
+
+		link = cache->lru->head;
+
+		while (link != NULL)
+		{
+			GList* next = link->next;
+			JDObjectCacheEntry* entry = link->data;
+
+			if (entry->stale)
+			{
+				jd_object_cache_entry_close(jd_object_cache_remove(cache, link), statistics);
+			}
+
+			link = next;
+		}
+
+		g_mutex_unlock(cache->mutex);
+	}
+
+	return cache;
+}
+
+/**
+ * Inserts a handle into a cache, closing the least recently used one if the cache is full.
+ *
+ * \param cache      A cache.
+ * \param key        The key, which is owned by the cache afterwards.
+ * \param backend    The backend the handle belongs to.
+ * \param object     The handle.
+ * \param statistics Statistics.
+ **/
+static void
+jd_object_cache_insert(JDObjectCache* cache, gchar* key, JBackend* backend, gpointer object, JStatistics* statistics)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JDObjectCacheEntry* entry;
+	JDObjectCacheEntry* evicted = NULL;
+
+	entry = g_new(JDObjectCacheEntry, 1);
+	entry->key = key;
+	entry->backend = backend;
+	entry->object = object;
+	entry->uses = 1;
+	entry->stale = FALSE;
+
+	g_mutex_lock(cache->mutex);
+
+	if (g_queue_get_length(cache->lru) >= JD_OBJECT_CACHE_SIZE)
+	{
+		evicted = jd_object_cache_remove(cache, cache->lru->tail);
+	}
+
+	g_queue_push_head(cache->lru, entry);
+	g_hash_table_insert(cache->entries, entry->key, cache->lru->head);
+
+	g_mutex_unlock(cache->mutex);
+
+	if (evicted != NULL)
+	{
+		jd_object_cache_entry_close(evicted, statistics);
+	}
+}
+
+/**
+ * Removes a handle from the calling worker's cache.
+ *
+ * \param cache A cache.
+ * \param key   The key.
+ *
+ * \return The entry, NULL if the object is not cached.
+ **/
+static JDObjectCacheEntry*
+jd_object_cache_take(JDObjectCache* cache, gchar const* key)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JDObjectCacheEntry* entry = NULL;
+	GList* link;
+
+	g_mutex_lock(cache->mutex);
+
+	if ((link = g_hash_table_lookup(cache->entries, key)) != NULL)
+	{
+		entry = jd_object_cache_remove(cache, link);
+	}
+
+	g_mutex_unlock(cache->mutex);
+
+	return entry;
+}
+
+gboolean
+jd_object_cache_open(gchar const* namespace, gchar const* path, gpointer* object, JStatistics* statistics)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JBackend* backend;
+	JDObjectCache* cache;
+	GList* link;
+	gchar* key;
+
+	g_return_val_if_fail(namespace != NULL, FALSE);
+	g_return_val_if_fail(path != NULL, FALSE);
+	g_return_val_if_fail(object != NULL, FALSE);
+
+	cache = jd_object_cache_get(statistics);
+	key = g_strconcat(namespace, "/", path, NULL);
+
+	g_mutex_lock(cache->mutex);
+
+	if ((link = g_hash_table_lookup(cache->entries, key)) != NULL)
+	{
+		JDObjectCacheEntry* entry = link->data;
+
+		g_queue_unlink(cache->lru, link);
+		g_queue_push_head_link(cache->lru, link);
+
+		entry->uses++;
+		*object = entry->object;
+
+		g_mutex_unlock(cache->mutex);
+
+		g_free(key);
+		j_statistics_add(statistics, J_STATISTICS_OPENS_SAVED, 1);
+
+		return TRUE;
+	}
+
+	g_mutex_unlock(cache->mutex);
+
+	backend = jd_object_backend_for(namespace, path);
+
+	if (!j_backend_object_open(backend, namespace, path, object))
+	{
+		g_free(key);
+		return FALSE;
+	}
+
+	jd_object_cache_insert(cache, key, backend, *object, statistics);
+
+	return TRUE;
+}
+
+gboolean
+jd_object_cache_create(gchar const* namespace, gchar const* path, gpointer* object, JStatistics* statistics)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JBackend* backend;
+	JDObjectCache* cache;
+	JDObjectCacheEntry* entry;
+	gchar* key;
+
+	g_return_val_if_fail(namespace != NULL, FALSE);
+	g_return_val_if_fail(path != NULL, FALSE);
+	g_return_val_if_fail(object != NULL, FALSE);
+
+	cache = jd_object_cache_get(statistics);
+	key = g_strconcat(namespace, "/", path, NULL);
+
+	// Backends might return the existing handle, which must not be cached twice
+	if ((entry = jd_object_cache_take(cache, key)) != NULL)
+	{
+		jd_object_cache_entry_close(entry, statistics);
+	}
+
+	backend = jd_object_backend_for(namespace, path);
+
+	if (!j_backend_object_create(backend, namespace, path, object))
+	{
+		g_free(key);
+		return FALSE;
+	}
+
+	jd_object_cache_insert(cache, key, backend, *object, statistics);
+
+	return TRUE;
+}
+
+gboolean
+jd_object_cache_delete(gchar const* namespace, gchar const* path, JStatistics* statistics)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JDObjectCache* cache;
+	JDObjectCacheEntry* entry;
+	g_autofree gchar* key = NULL;
+	gpointer object;
+	gboolean ret = FALSE;
+
+	g_return_val_if_fail(namespace != NULL, FALSE);
+	g_return_val_if_fail(path != NULL, FALSE);
+
+	cache = jd_object_cache_get(statistics);
+	key = g_strconcat(namespace, "/", path, NULL);
+
+	G_LOCK(jd_object_caches);
+
+	for (guint i = 0; i < jd_object_caches->len; i++)
+	{
+		JDObjectCache* other_cache = g_ptr_array_index(jd_object_caches, i);
+		GList* link;
+
+		if (other_cache == cache)
+		{
+			continue;
+		}
+
+		g_mutex_lock(other_cache->mutex);
+
+		if ((link = g_hash_table_lookup(other_cache->entries, key)) != NULL)
+		{
+			JDObjectCacheEntry* other_entry = link->data;
+
+			if (!other_entry->stale)
+			{
+				other_entry->stale = TRUE;
+				g_atomic_int_inc(&(other_cache->stale));
+			}
+		}
+
+		g_mutex_unlock(other_cache->mutex);
+	}
+
+	G_UNLOCK(jd_object_caches);
+
+	// Deleting the object also closes the handle
+	if ((entry = jd_object_cache_take(cache, key)) != NULL)
+	{
+		ret = j_backend_object_delete(entry->backend, entry->object);
+
+		j_statistics_add(statistics, J_STATISTICS_OPENS_SAVED, 1);
+
+		if (entry->uses > 1)
+		{
+			j_statistics_add(statistics, J_STATISTICS_CLOSES_SAVED, entry->uses - 1);
+		}
+
+		g_free(entry->key);
+		g_free(entry);
+	}
+	else
+	{
+		JBackend* backend;
+
+		backend = jd_object_backend_for(namespace, path);
+
+		if (j_backend_object_open(backend, namespace, path, &object))
+		{
+			ret = j_backend_object_delete(backend, object);
+		}
+	}
+
+	return ret;
+}
+
+void
+jd_object_cache_flush(void)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	// Replacing the cache frees it, which closes all of its handles
+	g_private_replace(&jd_worker_object_cache, NULL);
+}
+
+void
+jd_object_cache_fini(void)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	G_LOCK(jd_object_caches);
+
+	if (jd_object_caches != NULL)
+	{
+		// Threads handling libfabric connections might still be running, their caches are freed when they exit
+		if (jd_object_caches->len > 0)
+		{
+			g_debug("Not freeing object caches because of %u active threads.", jd_object_caches->len);
+		}
+		else
+		{
+			g_ptr_array_unref(jd_object_caches);
+			jd_object_caches = NULL;
+		}
+	}
+
+	G_UNLOCK(jd_object_caches);
+}
@@ -23,6 +23,7 @@
 #include <glib-unix.h>
 #include <glib-object.h>
 #include <gio/gio.h>
+#include <gio/gunixsocketaddress.h>
 #include <gmodule.h>
 
 #include <locale.h>
@@ -36,12 +37,78 @@
 JStatistics* jd_statistics = NULL;
 GMutex jd_statistics_mutex[1] = { 0 };
 
-JBackend* jd_object_backend = NULL;
-JBackend* jd_kv_backend = NULL;
+/**
+ * The number of shards.
+ * Every shard has its own object and key-value backend instance with its own storage, so that shards do not contend on the backends' locks.
+ **/
+guint jd_shards = 1;
+
+JBackend** jd_object_backends = NULL;
+JBackend** jd_kv_backends = NULL;
+
+/**
+ * Database backends are not sharded since the SQL backends share their connections and locks within the process.
+ **/
 JBackend* jd_db_backend = NULL;
 
 JConfiguration* jd_configuration = NULL;
 
+/**
+ * Returns the shard responsible for a key.
+ * The shard only depends on the namespace and the key, so the number of shards must not be changed for existing storage.
+ *
+ * \param namespace A namespace.
+ * \param key       A key, NULL to only use the namespace.
+ *
+ * \return The shard.
+ **/
+guint
+jd_shard(gchar const* namespace, gchar const* key)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	// FNV-1a
+	guint32 hash = 2166136261U;
+
+	if (jd_shards == 1)
+	{
+		return 0;
+	}
+
+	for (gchar const* c = namespace; *c != '\0'; c++)
+	{
+		hash ^= (guchar)*c;
+		hash *= 16777619U;
+	}
+
+	// Separate the namespace from the key, so that "ab" and "c" do not map to the same shard as "a" and "bc"
+	hash *= 16777619U;
+
+	for (gchar const* c = key; c != NULL && *c != '\0'; c++)
+	{
+		hash ^= (guchar)*c;
+		hash *= 16777619U;
+	}
+
+	return hash % jd_shards;
+}
+
+JBackend*
+jd_object_backend_for(gchar const* namespace, gchar const* path)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	return jd_object_backends[jd_shard(namespace, path)];
+}
+
+JBackend*
+jd_kv_backend_for(gchar const* namespace, gchar const* key)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	return jd_kv_backends[jd_shard(namespace, key)];
+}
+
 static gboolean
 jd_signal(gpointer data)
 {
@@ -58,59 +125,65 @@ jd_signal(gpointer data)
 }
 
 static gboolean
-jd_on_run(GThreadedSocketService* service, GSocketConnection* connection, GObject* source_object, gpointer user_data)
+jd_on_incoming(GSocketService* service, GSocketConnection* connection, GObject* source_object, gpointer user_data)
 {
 	J_TRACE_FUNCTION(NULL);
 
-	JMemoryChunk* memory_chunk;
-	g_autoptr(JMessage) message = NULL;
-	JStatistics* statistics;
-	guint64 memory_chunk_size;
-
 	(void)service;
 	(void)source_object;
 	(void)user_data;
 
-	j_helper_set_nodelay(connection, TRUE);
+	jd_event_add_connection(connection);
+
+	return TRUE;
+}
+
+/**
+ * Listens on the Unix domain socket, which allows local clients to bypass the TCP stack.
+ *
+ * \param socket_service A socket service.
+ * \param port           The server's port.
+ *
+ * \return The socket's path, NULL if no socket is configured or listening failed.
+ **/
+static gchar*
+jd_listen_unix(GSocketService* socket_service, gint port)
+{
+	J_TRACE_FUNCTION(NULL);
 
-	statistics = j_statistics_new(TRUE);
-	memory_chunk_size = j_configuration_get_max_operation_size(jd_configuration);
-	memory_chunk = j_memory_chunk_new(memory_chunk_size);
+	g_autoptr(GSocketAddress) socket_address = NULL;
+	g_autofree gchar* port_str = NULL;
+	GError* error = NULL;
+	gchar* path;
+	gchar const* socket_path;
 
-	message = j_message_new(J_MESSAGE_NONE, 0);
+	socket_path = j_configuration_get_socket(jd_configuration);
 
-	while (j_message_receive(message, connection))
+	if (socket_path == NULL)
 	{
-		jd_handle_message(message, connection, memory_chunk, memory_chunk_size, statistics);
+		return NULL;
 	}
 
-	{
-		guint64 value;
+	port_str = g_strdup_printf("%d", port);
+	path = j_helper_str_replace(socket_path, "{PORT}", port_str);
 
-		g_mutex_lock(jd_statistics_mutex);
+	// The socket might be left over from a server that has not been shut down properly
+	// Since we are listening on the TCP port, no other server can be using it
+	g_unlink(path);
 
-		value = j_statistics_get(statistics, J_STATISTICS_FILES_CREATED);
-		j_statistics_add(jd_statistics, J_STATISTICS_FILES_CREATED, value);
-		value = j_statistics_get(statistics, J_STATISTICS_FILES_DELETED);
-		j_statistics_add(jd_statistics, J_STATISTICS_FILES_DELETED, value);
-		value = j_statistics_get(statistics, J_STATISTICS_SYNC);
-		j_statistics_add(jd_statistics, J_STATISTICS_SYNC, value);
-		value = j_statistics_get(statistics, J_STATISTICS_BYTES_READ);
-		j_statistics_add(jd_statistics, J_STATISTICS_BYTES_READ, value);
-		value = j_statistics_get(statistics, J_STATISTICS_BYTES_WRITTEN);
-		j_statistics_add(jd_statistics, J_STATISTICS_BYTES_WRITTEN, value);
-		value = j_statistics_get(statistics, J_STATISTICS_BYTES_RECEIVED);
-		j_statistics_add(jd_statistics, J_STATISTICS_BYTES_RECEIVED, value);
-		value = j_statistics_get(statistics, J_STATISTICS_BYTES_SENT);
-		j_statistics_add(jd_statistics, J_STATISTICS_BYTES_SENT, value);
+	socket_address = g_unix_socket_address_new(path);
 
-		g_mutex_unlock(jd_statistics_mutex);
-	}
+	if (!g_socket_listener_add_address(G_SOCKET_LISTENER(socket_service), socket_address, G_SOCKET_TYPE_STREAM, G_SOCKET_PROTOCOL_DEFAULT, NULL, NULL, &error))
+	{
+		// Clients fall back to TCP
+		g_warning("Cannot listen on %s: %s", path, error->message);
+		g_error_free(error);
+		g_free(path);
 
-	j_memory_chunk_free(memory_chunk);
-	j_statistics_free(statistics);
+		return NULL;
+	}
 
-	return TRUE;
+	return path;
 }
 
 static gboolean
@@ -198,9 +271,22 @@ jd_is_server_for_backend(gchar const* host, gint port, JBackendType backend_type
 	return FALSE;
 }
 
+/**
+ * Loads a backend and initializes one instance per shard.
+ *
+ * \param host     The server's host name.
+ * \param port     The server's port.
+ * \param type     The backend type.
+ * \param shards   The number of shards.
+ * \param backends The instances, NULL if the server is not responsible for the backend type.
+ * \param module   The backend's module.
+ *
+ * \return TRUE on success, FALSE otherwise.
+ **/
 static gboolean
-jd_load_and_init_backend(gchar const* host, gint port, JBackendType type, JBackend** backend, GModule** module)
+jd_load_and_init_backend(gchar const* host, gint port, JBackendType type, guint shards, JBackend*** backends, GModule** module)
 {
+	JBackend* backend = NULL;
 	gchar const* backend_name;
 	g_autofree gchar* backend_path = NULL;
 	g_autofree gchar* port_str = NULL;
@@ -236,28 +322,98 @@ jd_load_and_init_backend(gchar const* host, gint port, JBackendType type, JBacke
 		return TRUE;
 	}
 
-	if (!j_backend_load(backend_name, J_BACKEND_COMPONENT_SERVER, type, module, backend))
+	if (!j_backend_load(backend_name, J_BACKEND_COMPONENT_SERVER, type, module, &backend))
 	{
 		return FALSE;
 	}
 
-	if (*backend == NULL)
+	if (backend == NULL)
 	{
 		return TRUE;
 	}
 
-	if (!backend_init(*backend, backend_path))
+	// Sharing a path among shards would typically lead to problems, backends without a path do not store anything
+	if (shards > 1 && backend_path[0] != '\0' && strstr(backend_path, "{SHARD}") == NULL)
 	{
-		g_critical("Could not initialize %s backend %s.", type_str, backend_name);
+		g_critical("Path of %s backend %s has to contain {SHARD} when using multiple shards.", type_str, backend_name);
 
 		return FALSE;
 	}
 
-	g_debug("Initialized %s backend %s.", type_str, backend_name);
+	*backends = g_new0(JBackend*, shards);
+
+	for (guint i = 0; i < shards; i++)
+	{
+		g_autofree gchar* shard_path = NULL;
+		g_autofree gchar* shard_str = NULL;
+
+		shard_str = g_strdup_printf("%u", i);
+		shard_path = j_helper_str_replace(backend_path, "{SHARD}", shard_str);
+
+		// The backend's module only provides a single JBackend, so every shard gets its own copy to store its data in
+		(*backends)[i] = g_new(JBackend, 1);
+		*((*backends)[i]) = *backend;
+
+		if (!backend_init((*backends)[i], shard_path))
+		{
+			g_critical("Could not initialize %s backend %s for shard %u.", type_str, backend_name, i);
+
+			return FALSE;
+		}
+	}
+
+	g_debug("Initialized %s backend %s with %u shards.", type_str, backend_name, shards);
 
 	return TRUE;
 }
 
+/**
+ * Finalizes all instances of a backend and unloads it.
+ *
+ * \param type     The backend type.
+ * \param shards   The number of shards.
+ * \param backends The instances.
+ * \param module   The backend's module.
+ **/
+static void
+jd_fini_and_unload_backend(JBackendType type, guint shards, JBackend** backends, GModule* module)
+{
+	if (backends == NULL)
+	{
+		return;
+	}
+
+	for (guint i = 0; i < shards; i++)
+	{
+		switch (type)
+		{
+			case J_BACKEND_TYPE_OBJECT:
+				j_backend_object_fini(backends[i]);
+				break;
+			case J_BACKEND_TYPE_KV:
+				j_backend_kv_fini(backends[i]);
+				break;
+			case J_BACKEND_TYPE_DB:
+				j_backend_db_fini(backends[i]);
+				break;
+			default:
+				g_warn_if_reached();
+		}
+	}
+
+	if (module != NULL)
+	{
+		j_backend_unload(backends[0], module);
+	}
+
+	for (guint i = 0; i < shards; i++)
+	{
+		g_free(backends[i]);
+	}
+
+	g_free(backends);
+}
+
 int
 main(int argc, char** argv)
 {
@@ -266,6 +422,9 @@ main(int argc, char** argv)
 	gboolean opt_daemon = FALSE;
 	g_autofree gchar* opt_host = NULL;
 	gint opt_port = 0;
+	gint opt_io_threads = 0;
+	gint opt_workers = 0;
+	gint opt_shards = 1;
 
 	JTrace* trace;
 	GError* error = NULL;
@@ -273,14 +432,19 @@ main(int argc, char** argv)
 	GModule* object_module = NULL;
 	GModule* kv_module = NULL;
 	GModule* db_module = NULL;
+	JBackend** db_backends = NULL;
 	g_autoptr(GOptionContext) context = NULL;
 	g_autoptr(GSocketService) socket_service = NULL;
+	g_autofree gchar* socket_path = NULL;
 	guint listen_retries = 0;
 
 	GOptionEntry entries[] = {
 		{ "daemon", 0, 0, G_OPTION_ARG_NONE, &opt_daemon, "Run as daemon", NULL },
 		{ "host", 0, 0, G_OPTION_ARG_STRING, &opt_host, "Override host name", "hostname" },
 		{ "port", 0, 0, G_OPTION_ARG_INT, &opt_port, "Port to use", "0" },
+		{ "io-threads", 0, 0, G_OPTION_ARG_INT, &opt_io_threads, "Number of I/O threads (default: number of processors)", "0" },
+		{ "workers", 0, 0, G_OPTION_ARG_INT, &opt_workers, "Number of worker threads (default: number of processors)", "0" },
+		{ "shards", 0, 0, G_OPTION_ARG_INT, &opt_shards, "Number of object and key-value backend instances, their paths have to contain {SHARD}", "1" },
 		{ NULL, 0, 0, 0, NULL, NULL, NULL }
 	};
 
@@ -327,7 +491,21 @@ main(int argc, char** argv)
 		opt_port = j_configuration_get_port(jd_configuration);
 	}
 
-	socket_service = g_threaded_socket_service_new(-1);
+	if (opt_io_threads < 0 || opt_workers < 0)
+	{
+		g_warning("Number of I/O threads and workers must not be negative.");
+		return 1;
+	}
+
+	if (opt_shards < 1)
+	{
+		g_warning("Number of shards must be positive.");
+		return 1;
+	}
+
+	jd_shards = opt_shards;
+
+	socket_service = g_socket_service_new();
 	g_socket_listener_set_backlog(G_SOCKET_LISTENER(socket_service), 128);
 
 	while (TRUE)
@@ -357,34 +535,46 @@ main(int argc, char** argv)
 		break;
 	}
 
+	socket_path = jd_listen_unix(socket_service, opt_port);
+
 	j_trace_init("julea-server");
 
 	trace = j_trace_enter(G_STRFUNC, NULL);
 
-	jd_object_backend = NULL;
-	jd_kv_backend = NULL;
+	jd_object_backends = NULL;
+	jd_kv_backends = NULL;
 	jd_db_backend = NULL;
 
-	if (!jd_load_and_init_backend(opt_host, opt_port, J_BACKEND_TYPE_OBJECT, &jd_object_backend, &object_module))
+	if (!jd_load_and_init_backend(opt_host, opt_port, J_BACKEND_TYPE_OBJECT, jd_shards, &jd_object_backends, &object_module))
 	{
 		return 1;
 	}
 
-	if (!jd_load_and_init_backend(opt_host, opt_port, J_BACKEND_TYPE_KV, &jd_kv_backend, &kv_module))
+	if (!jd_load_and_init_backend(opt_host, opt_port, J_BACKEND_TYPE_KV, jd_shards, &jd_kv_backends, &kv_module))
 	{
 		return 1;
 	}
 
-	if (!jd_load_and_init_backend(opt_host, opt_port, J_BACKEND_TYPE_DB, &jd_db_backend, &db_module))
+	if (!jd_load_and_init_backend(opt_host, opt_port, J_BACKEND_TYPE_DB, 1, &db_backends, &db_module))
 	{
 		return 1;
 	}
 
+	if (db_backends != NULL)
+	{
+		jd_db_backend = db_backends[0];
+	}
+
 	jd_statistics = j_statistics_new(FALSE);
 	g_mutex_init(jd_statistics_mutex);
 
+	if (!jd_event_init(opt_io_threads, opt_workers))
+	{
+		return 1;
+	}
+
+	g_signal_connect(socket_service, "incoming", G_CALLBACK(jd_on_incoming), NULL);
 	g_socket_service_start(socket_service);
-	g_signal_connect(socket_service, "run", G_CALLBACK(jd_on_run), NULL);
 
 	main_loop = g_main_loop_new(NULL, FALSE);
 
@@ -396,38 +586,19 @@ main(int argc, char** argv)
 
 	g_socket_service_stop(socket_service);
 
-	g_mutex_clear(jd_statistics_mutex);
-	j_statistics_free(jd_statistics);
-
-	if (jd_db_backend != NULL)
+	if (socket_path != NULL)
 	{
-		j_backend_db_fini(jd_db_backend);
+		g_unlink(socket_path);
 	}
 
-	if (jd_kv_backend != NULL)
-	{
-		j_backend_kv_fini(jd_kv_backend);
-	}
-
-	if (jd_object_backend != NULL)
-	{
-		j_backend_object_fini(jd_object_backend);
-	}
-
-	if (db_module != NULL)
-	{
-		j_backend_unload(jd_db_backend, db_module);
-	}
+	jd_event_fini();
 
-	if (kv_module != NULL)
-	{
-		j_backend_unload(jd_kv_backend, kv_module);
-	}
+	g_mutex_clear(jd_statistics_mutex);
+	j_statistics_free(jd_statistics);
 
-	if (object_module)
-	{
-		j_backend_unload(jd_object_backend, object_module);
-	}
+	jd_fini_and_unload_backend(J_BACKEND_TYPE_DB, 1, db_backends, db_module);
+	jd_fini_and_unload_backend(J_BACKEND_TYPE_KV, jd_shards, jd_kv_backends, kv_module);
+	jd_fini_and_unload_backend(J_BACKEND_TYPE_OBJECT, jd_shards, jd_object_backends, object_module);
 
 	j_configuration_unref(jd_configuration);
 
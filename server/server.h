@@ -31,12 +31,29 @@
 G_GNUC_INTERNAL extern JStatistics* jd_statistics;
 G_GNUC_INTERNAL extern GMutex jd_statistics_mutex[1];
 
-G_GNUC_INTERNAL extern JBackend* jd_object_backend;
-G_GNUC_INTERNAL extern JBackend* jd_kv_backend;
+G_GNUC_INTERNAL extern guint jd_shards;
+
+G_GNUC_INTERNAL extern JBackend** jd_object_backends;
+G_GNUC_INTERNAL extern JBackend** jd_kv_backends;
 G_GNUC_INTERNAL extern JBackend* jd_db_backend;
 
 G_GNUC_INTERNAL extern JConfiguration* jd_configuration;
 
-G_GNUC_INTERNAL gboolean jd_handle_message(JMessage*, GSocketConnection*, JMemoryChunk*, guint64, JStatistics*);
+G_GNUC_INTERNAL guint jd_shard(gchar const*, gchar const*);
+G_GNUC_INTERNAL JBackend* jd_object_backend_for(gchar const*, gchar const*);
+G_GNUC_INTERNAL JBackend* jd_kv_backend_for(gchar const*, gchar const*);
+
+G_GNUC_INTERNAL gboolean jd_message_has_payload(JMessage*);
+G_GNUC_INTERNAL gboolean jd_handle_message(JMessage*, JNetworkConnection*, JMemoryChunk*, guint64, JStatistics*);
+
+G_GNUC_INTERNAL gboolean jd_object_cache_open(gchar const*, gchar const*, gpointer*, JStatistics*);
+G_GNUC_INTERNAL gboolean jd_object_cache_create(gchar const*, gchar const*, gpointer*, JStatistics*);
+G_GNUC_INTERNAL gboolean jd_object_cache_delete(gchar const*, gchar const*, JStatistics*);
+G_GNUC_INTERNAL void jd_object_cache_flush(void);
+G_GNUC_INTERNAL void jd_object_cache_fini(void);
+
+G_GNUC_INTERNAL gboolean jd_event_init(guint, guint);
+G_GNUC_INTERNAL void jd_event_fini(void);
+G_GNUC_INTERNAL gboolean jd_event_add_connection(GSocketConnection*);
 
 #endif
@@ -0,0 +1,138 @@
+/*
+ * JULEA - Flexible storage framework
+ * Copyright (C) 2026 Michael Kuhn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <julea-config.h>
+
+#include <glib.h>
+
+#include <string.h>
+
+#include <julea.h>
+
+#include <jcompression.h>
+
+#include "test.h"
+
+static void
+test_compression_roundtrip(JConfigurationCompression compression)
+{
+	gsize const length = J_COMPRESSION_BLOCK_SIZE;
+
+	g_autofree gchar* data = NULL;
+	g_autofree gchar* compressed = NULL;
+	g_autofree gchar* decompressed = NULL;
+	g_autoptr(GRand) rand = NULL;
+	gsize compressed_bound;
+	gsize compressed_length;
+	gboolean ret;
+
+	if (!j_compression_available(compression))
+	{
+		g_test_skip("Codec not supported by this build");
+		return;
+	}
+
+	data = g_malloc(length);
+	decompressed = g_malloc(length);
+	rand = g_rand_new_with_seed(42);
+
+	for (gsize i = 0; i < length; i++)
+	{
+		data[i] = 'a' + g_rand_int_range(rand, 0, 4);
+	}
+
+	compressed_bound = j_compression_bound(compression, length);
+	compressed = g_malloc(compressed_bound);
+
+	compressed_length = j_compression_compress(compression, data, length, compressed, compressed_bound);
+	g_assert_cmpuint(compressed_length, >, 0);
+	g_assert_cmpuint(compressed_length, <, length);
+
+	ret = j_compression_decompress(compression, compressed, compressed_length, decompressed, length);
+	g_assert_true(ret);
+	g_assert_cmpmem(data, length, decompressed, length);
+
+	// Truncated data must be rejected
+	ret = j_compression_decompress(compression, compressed, compressed_length, decompressed, length - 1);
+	g_assert_false(ret);
+
+	// Incompressible data is not compressed
+	for (gsize i = 0; i < length; i++)
+	{
+		data[i] = g_rand_int(rand);
+	}
+
+	compressed_length = j_compression_compress(compression, data, length, compressed, compressed_bound);
+	g_assert_cmpuint(compressed_length, ==, 0);
+}
+
+static void
+test_compression_none(void)
+{
+	gchar data[16] = { 0 };
+	gchar compressed[16];
+
+	J_TEST_TRAP_START;
+	g_assert_true(j_compression_available(J_CONFIGURATION_COMPRESSION_NONE));
+	g_assert_cmpuint(j_compression_compress(J_CONFIGURATION_COMPRESSION_NONE, data, sizeof(data), compressed, sizeof(compressed)), ==, 0);
+	J_TEST_TRAP_END;
+}
+
+static void
+test_compression_lz4(void)
+{
+	J_TEST_TRAP_START;
+	test_compression_roundtrip(J_CONFIGURATION_COMPRESSION_LZ4);
+	J_TEST_TRAP_END;
+}
+
+static void
+test_compression_zstd(void)
+{
+	J_TEST_TRAP_START;
+	test_compression_roundtrip(J_CONFIGURATION_COMPRESSION_ZSTD);
+	J_TEST_TRAP_END;
+}
+
+static void
+test_compression_buffer(void)
+{
+	gpointer buffer;
+
+	J_TEST_TRAP_START;
+	buffer = j_compression_get_buffer(42);
+	g_assert_true(buffer != NULL);
+	memset(buffer, 0, 42);
+
+	// The buffer is reused if it is large enough
+	g_assert_true(j_compression_get_buffer(23) == buffer);
+
+	buffer = j_compression_get_buffer(1024 * 1024);
+	g_assert_true(buffer != NULL);
+	memset(buffer, 0, 1024 * 1024);
+	J_TEST_TRAP_END;
+}
+
+void
+test_core_compression(void)
+{
+	g_test_add_func("/core/compression/none", test_compression_none);
+	g_test_add_func("/core/compression/lz4", test_compression_lz4);
+	g_test_add_func("/core/compression/zstd", test_compression_zstd);
+	g_test_add_func("/core/compression/buffer", test_compression_buffer);
+}
@@ -61,6 +61,12 @@ test_configuration_new_for_data(void)
 
 	configuration = j_configuration_new_for_data(key_file);
 	g_assert_true(configuration != NULL);
+	g_assert_cmpint(j_configuration_get_transport(configuration), ==, J_CONFIGURATION_TRANSPORT_TCP);
+	g_assert_null(j_configuration_get_provider(configuration));
+	g_assert_false(j_configuration_get_multiplexing(configuration));
+	g_assert_cmpint(j_configuration_get_compression(configuration), ==, J_CONFIGURATION_COMPRESSION_NONE);
+	g_assert_true(j_configuration_get_shared_memory(configuration));
+	g_assert_null(j_configuration_get_socket(configuration));
 	j_configuration_unref(configuration);
 
 	g_key_file_free(key_file);
@@ -87,6 +93,12 @@ test_configuration_get(void)
 	g_key_file_set_string(key_file, "kv", "path", "NULL2");
 	g_key_file_set_string(key_file, "db", "backend", "null3");
 	g_key_file_set_string(key_file, "db", "path", "NULL3");
+	g_key_file_set_string(key_file, "network", "transport", "libfabric");
+	g_key_file_set_string(key_file, "network", "provider", "sockets");
+	g_key_file_set_string(key_file, "network", "compression", "zstd");
+	g_key_file_set_boolean(key_file, "network", "shared-memory", FALSE);
+	g_key_file_set_string(key_file, "network", "socket", "/tmp/julea-{PORT}.socket");
+	g_key_file_set_boolean(key_file, "clients", "multiplexing", TRUE);
 
 	configuration = j_configuration_new_for_data(key_file);
 	g_assert_true(configuration != NULL);
@@ -111,6 +123,107 @@ test_configuration_get(void)
 	g_assert_cmpstr(j_configuration_get_backend(configuration, J_BACKEND_TYPE_DB), ==, "null3");
 	g_assert_cmpstr(j_configuration_get_backend_path(configuration, J_BACKEND_TYPE_DB), ==, "NULL3");
 
+	g_assert_cmpint(j_configuration_get_transport(configuration), ==, J_CONFIGURATION_TRANSPORT_LIBFABRIC);
+	g_assert_cmpstr(j_configuration_get_provider(configuration), ==, "sockets");
+	g_assert_true(j_configuration_get_multiplexing(configuration));
+	g_assert_cmpint(j_configuration_get_compression(configuration), ==, J_CONFIGURATION_COMPRESSION_ZSTD);
+	g_assert_false(j_configuration_get_shared_memory(configuration));
+	g_assert_cmpstr(j_configuration_get_socket(configuration), ==, "/tmp/julea-{PORT}.socket");
+
+	j_configuration_unref(configuration);
+
+	g_key_file_free(key_file);
+	J_TEST_TRAP_END;
+}
+
+static void
+test_configuration_placement(void)
+{
+	JConfiguration* configuration;
+	JConfiguration* configuration_more;
+	GKeyFile* key_file;
+	gchar const* servers[] = { "host1", "host2", "host3", "host4", NULL };
+	gint weights[] = { 1, 1, 1, 1, 2 };
+	guint counts[5] = { 0 };
+	guint moved = 0;
+
+	J_TEST_TRAP_START;
+	key_file = g_key_file_new();
+	g_key_file_set_string_list(key_file, "servers", "object", servers, 3);
+	g_key_file_set_string_list(key_file, "servers", "kv", servers, 4);
+	g_key_file_set_string_list(key_file, "servers", "db", servers, 1);
+	g_key_file_set_string(key_file, "object", "backend", "null");
+	g_key_file_set_string(key_file, "object", "path", "");
+	g_key_file_set_string(key_file, "kv", "backend", "null");
+	g_key_file_set_string(key_file, "kv", "path", "");
+	g_key_file_set_string(key_file, "db", "backend", "null");
+	g_key_file_set_string(key_file, "db", "path", "");
+	g_key_file_set_string(key_file, "clients", "placement", "ring");
+
+	configuration = j_configuration_new_for_data(key_file);
+	g_assert_true(configuration != NULL);
+	g_assert_cmpint(j_configuration_get_placement(configuration), ==, J_CONFIGURATION_PLACEMENT_RING);
+
+	g_key_file_set_string_list(key_file, "servers", "object", servers, 4);
+	configuration_more = j_configuration_new_for_data(key_file);
+	g_assert_true(configuration_more != NULL);
+
+	// Adding a server must only move keys to the new server
+	for (guint i = 0; i < 10000; i++)
+	{
+		g_autofree gchar* key = NULL;
+		guint32 index;
+		guint32 index_more;
+
+		key = g_strdup_printf("key-%u", i);
+		index = j_configuration_get_server_index(configuration, J_BACKEND_TYPE_OBJECT, key);
+		index_more = j_configuration_get_server_index(configuration_more, J_BACKEND_TYPE_OBJECT, key);
+
+		g_assert_cmpuint(index, <, 3);
+		g_assert_cmpuint(index_more, <, 4);
+
+		if (index != index_more)
+		{
+			g_assert_cmpuint(index_more, ==, 3);
+			moved++;
+		}
+
+		g_assert_cmpuint(j_configuration_get_server_index(configuration, J_BACKEND_TYPE_KV, key), ==, j_configuration_get_server_index(configuration_more, J_BACKEND_TYPE_KV, key));
+	}
+
+	// Roughly a quarter of the keys should be moved
+	g_assert_cmpuint(moved, >, 1500);
+	g_assert_cmpuint(moved, <, 3500);
+
+	j_configuration_unref(configuration_more);
+	j_configuration_unref(configuration);
+
+	// The number of weights has to match the number of servers
+	g_key_file_set_integer_list(key_file, "servers", "kv-weights", weights, 5);
+	g_test_expect_message("JULEA", G_LOG_LEVEL_CRITICAL, "Number of kv-weights does not match*");
+	configuration = j_configuration_new_for_data(key_file);
+	g_test_assert_expected_messages();
+	g_assert_null(configuration);
+
+	weights[3] = 2;
+	g_key_file_set_integer_list(key_file, "servers", "kv-weights", weights, 4);
+	configuration = j_configuration_new_for_data(key_file);
+	g_assert_true(configuration != NULL);
+
+	for (guint i = 0; i < 10000; i++)
+	{
+		g_autofree gchar* key = NULL;
+
+		key = g_strdup_printf("key-%u", i);
+		counts[j_configuration_get_server_index(configuration, J_BACKEND_TYPE_KV, key)]++;
+	}
+
+	// The last server has twice the weight of the others
+	g_assert_cmpuint(counts[3], >, counts[0]);
+	g_assert_cmpuint(counts[3], >, counts[1]);
+	g_assert_cmpuint(counts[3], >, counts[2]);
+	g_assert_cmpuint(counts[4], ==, 0);
+
 	j_configuration_unref(configuration);
 
 	g_key_file_free(key_file);
@@ -123,4 +236,5 @@ test_core_configuration(void)
 	g_test_add_func("/core/configuration/new_ref_unref", test_configuration_new_ref_unref);
 	g_test_add_func("/core/configuration/new_for_data", test_configuration_new_for_data);
 	g_test_add_func("/core/configuration/get", test_configuration_get);
+	g_test_add_func("/core/configuration/placement", test_configuration_placement);
 }
@@ -86,10 +86,45 @@ test_memory_chunk_reset(void)
 	J_TEST_TRAP_END;
 }
 
+static void
+test_memory_chunk_get_aligned(void)
+{
+	JMemoryChunk* memory_chunk;
+	gpointer ret;
+
+	J_TEST_TRAP_START;
+	memory_chunk = j_memory_chunk_new_aligned(4 * 4096, 4096);
+
+	ret = j_memory_chunk_get(memory_chunk, 1);
+	g_assert_true(ret != NULL);
+	g_assert_cmpuint((guintptr)ret % 4096, ==, 0);
+
+	// Segments smaller than the alignment are not aligned
+	ret = j_memory_chunk_get(memory_chunk, 1);
+	g_assert_true(ret != NULL);
+	g_assert_cmpuint((guintptr)ret % 4096, ==, 1);
+
+	ret = j_memory_chunk_get(memory_chunk, 4096);
+	g_assert_true(ret != NULL);
+	g_assert_cmpuint((guintptr)ret % 4096, ==, 0);
+
+	ret = j_memory_chunk_get(memory_chunk, 2 * 4096);
+	g_assert_true(ret != NULL);
+	g_assert_cmpuint((guintptr)ret % 4096, ==, 0);
+
+	// The padding of the first segments does not leave enough space
+	ret = j_memory_chunk_get(memory_chunk, 4096);
+	g_assert_true(ret == NULL);
+
+	j_memory_chunk_free(memory_chunk);
+	J_TEST_TRAP_END;
+}
+
 void
 test_core_memory_chunk(void)
 {
 	g_test_add_func("/core/memory-chunk/new_free", test_memory_chunk_new_free);
 	g_test_add_func("/core/memory-chunk/get", test_memory_chunk_get);
 	g_test_add_func("/core/memory-chunk/reset", test_memory_chunk_reset);
+	g_test_add_func("/core/memory-chunk/get_aligned", test_memory_chunk_get_aligned);
 }
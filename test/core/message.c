@@ -54,6 +54,48 @@ test_message_reply(void)
 
 	reply = j_message_new_reply(message);
 	g_assert_true(reply != NULL);
+	g_assert_cmpuint(j_message_get_id(reply), ==, j_message_get_id(message));
+	J_TEST_TRAP_END;
+}
+
+static void
+test_message_pool(void)
+{
+	guint64 allocations;
+	guint32 id = 0;
+
+	J_TEST_TRAP_START;
+	// Warm up the pool
+	j_message_unref(j_message_new(J_MESSAGE_NONE, 0));
+
+	allocations = j_message_get_allocations();
+
+	for (guint i = 0; i < 1000; i++)
+	{
+		g_autoptr(JMessage) message = NULL;
+		g_autoptr(JMessage) reply = NULL;
+		guint64 dummy = 42;
+
+		message = j_message_new(J_MESSAGE_NONE, 0);
+
+		if (i > 0)
+		{
+			g_assert_cmpuint(j_message_get_id(message), !=, id);
+		}
+
+		id = j_message_get_id(message);
+
+		for (guint j = 0; j < 4; j++)
+		{
+			j_message_add_send(message, &dummy, sizeof(dummy));
+		}
+
+		reply = j_message_new_reply(message);
+		g_assert_cmpuint(j_message_get_id(reply), ==, id);
+	}
+
+	// Only the first reply needs a new message
+	g_assert_cmpuint(j_message_get_allocations(), <=, allocations + 2);
 	J_TEST_TRAP_END;
 }
 
@@ -176,6 +218,69 @@ test_message_write_read(void)
 	J_TEST_TRAP_END;
 }
 
+static void
+test_message_write_send(void)
+{
+	guint const n = 5000;
+
+	g_autoptr(JMessage) message_recv = NULL;
+	g_autoptr(JMessage) message_send = NULL;
+	g_autoptr(GOutputStream) output = NULL;
+	g_autoptr(GInputStream) input = NULL;
+	g_autofree guint32* data = NULL;
+	g_autofree guint32* data_recv = NULL;
+	gboolean ret;
+	guint32 dummy_4 = 42;
+	gsize bytes_read;
+
+	J_TEST_TRAP_START;
+	output = g_memory_output_stream_new(NULL, 0, g_realloc, g_free);
+	input = g_memory_input_stream_new();
+
+	data = g_new(guint32, n);
+	data_recv = g_new0(guint32, n);
+
+	message_send = j_message_new(J_MESSAGE_NONE, 4);
+	g_assert_true(message_send != NULL);
+	message_recv = j_message_new(J_MESSAGE_NONE, 0);
+	g_assert_true(message_recv != NULL);
+
+	ret = j_message_append_4(message_send, &dummy_4);
+	g_assert_true(ret);
+
+	// Use more entries than can be written at once
+	for (guint i = 0; i < n; i++)
+	{
+		data[i] = i;
+		j_message_add_send(message_send, &(data[i]), sizeof(guint32));
+	}
+
+	ret = j_message_write(message_send, output);
+	g_assert_true(ret);
+
+	g_memory_input_stream_add_data(
+		G_MEMORY_INPUT_STREAM(input),
+		g_memory_output_stream_get_data(G_MEMORY_OUTPUT_STREAM(output)),
+		g_memory_output_stream_get_data_size(G_MEMORY_OUTPUT_STREAM(output)),
+		NULL);
+
+	ret = j_message_read(message_recv, input);
+	g_assert_true(ret);
+
+	dummy_4 = j_message_get_4(message_recv);
+	g_assert_cmpuint(dummy_4, ==, 42);
+
+	ret = g_input_stream_read_all(input, data_recv, n * sizeof(guint32), &bytes_read, NULL, NULL);
+	g_assert_true(ret);
+	g_assert_cmpuint(bytes_read, ==, n * sizeof(guint32));
+
+	for (guint i = 0; i < n; i++)
+	{
+		g_assert_cmpuint(data_recv[i], ==, i);
+	}
+	J_TEST_TRAP_END;
+}
+
 static void
 test_message_semantics(void)
 {
@@ -205,8 +310,10 @@ test_core_message(void)
 {
 	g_test_add_func("/core/message/new_ref_unref", test_message_new_ref_unref);
 	g_test_add_func("/core/message/reply", test_message_reply);
+	g_test_add_func("/core/message/pool", test_message_pool);
 	g_test_add_func("/core/message/header", test_message_header);
 	g_test_add_func("/core/message/append", test_message_append);
 	g_test_add_func("/core/message/write_read", test_message_write_read);
+	g_test_add_func("/core/message/write_send", test_message_write_send);
 	g_test_add_func("/core/message/semantics", test_message_semantics);
 }
@@ -184,9 +184,186 @@ test_kv_iterator_next_get(void)
 	J_TEST_TRAP_END;
 }
 
+static void
+test_kv_iterator_frames(void)
+{
+	// Large enough to require multiple frames
+	guint const n = 2000;
+	gsize const value_len = 1024;
+
+	g_autoptr(JBatch) batch = NULL;
+	g_autoptr(JBatch) delete_batch = NULL;
+	g_autoptr(JKVIterator) kv_iterator = NULL;
+	gboolean ret;
+
+	guint kvs = 0;
+
+	J_TEST_TRAP_START;
+	batch = j_batch_new_for_template(J_SEMANTICS_TEMPLATE_DEFAULT);
+	delete_batch = j_batch_new_for_template(J_SEMANTICS_TEMPLATE_DEFAULT);
+
+	for (guint i = 0; i < n; i++)
+	{
+		g_autoptr(JKV) kv = NULL;
+
+		g_autofree gchar* key = NULL;
+		gchar* value = NULL;
+
+		key = g_strdup_printf("test-key-frames-%d", i);
+		value = g_malloc(value_len);
+		memset(value, 'x', value_len);
+		kv = j_kv_new("test-ns-frames", key);
+		j_kv_put(kv, value, value_len, g_free, batch);
+		j_kv_delete(kv, delete_batch);
+	}
+
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+
+	// Freeing an iterator early has to leave the connection in a usable state
+	for (guint i = 0; i < 10; i++)
+	{
+		g_autoptr(JKVIterator) iterator = NULL;
+
+		iterator = j_kv_iterator_new("test-ns-frames", NULL);
+		g_assert_true(j_kv_iterator_next(iterator));
+	}
+
+	kv_iterator = j_kv_iterator_new("test-ns-frames", NULL);
+
+	while (j_kv_iterator_next(kv_iterator))
+	{
+		gchar const* key;
+		gconstpointer value;
+		guint32 len;
+
+		key = j_kv_iterator_get(kv_iterator, &value, &len);
+		g_assert_true(g_str_has_prefix(key, "test-key-frames-"));
+		g_assert_cmpuint(len, ==, value_len);
+		g_assert_cmpint(((gchar const*)value)[value_len - 1], ==, 'x');
+		kvs++;
+	}
+
+	g_assert_cmpuint(kvs, ==, n);
+
+	ret = j_batch_execute(delete_batch);
+	g_assert_true(ret);
+	J_TEST_TRAP_END;
+}
+
+static void
+test_kv_iterator_range(void)
+{
+	guint const n = 100;
+
+	g_autoptr(JBatch) batch = NULL;
+	g_autoptr(JBatch) delete_batch = NULL;
+	g_autofree gchar* cursor = NULL;
+	gboolean ret;
+
+	guint kvs = 0;
+	guint pages = 0;
+
+	J_TEST_TRAP_START;
+	batch = j_batch_new_for_template(J_SEMANTICS_TEMPLATE_DEFAULT);
+	delete_batch = j_batch_new_for_template(J_SEMANTICS_TEMPLATE_DEFAULT);
+
+	for (guint i = 0; i < n; i++)
+	{
+		g_autoptr(JKV) kv = NULL;
+
+		g_autofree gchar* key = NULL;
+		guint32* value = NULL;
+
+		key = g_strdup_printf("test-key-range-%03d", i);
+		value = g_new(guint32, 1);
+		*value = i;
+		kv = j_kv_new("test-ns-range", key);
+		j_kv_put(kv, value, sizeof(guint32), g_free, batch);
+		j_kv_delete(kv, delete_batch);
+	}
+
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+
+	// Keys 010 to 049 in pages of 16 keys
+	cursor = NULL;
+
+	do
+	{
+		g_autoptr(JKVIterator) kv_iterator = NULL;
+		guint page_kvs = 0;
+
+		if (cursor == NULL)
+		{
+			kv_iterator = j_kv_iterator_new_range("test-ns-range", "test-key-range-010", "test-key-range-050", 16);
+		}
+		else
+		{
+			g_autofree gchar* next_cursor = NULL;
+
+			next_cursor = g_steal_pointer(&cursor);
+			kv_iterator = j_kv_iterator_new_for_cursor(next_cursor);
+		}
+
+		g_assert_nonnull(kv_iterator);
+
+		while (j_kv_iterator_next(kv_iterator))
+		{
+			g_autofree gchar* expected = NULL;
+			gchar const* key;
+			gconstpointer value;
+			guint32 len;
+
+			key = j_kv_iterator_get(kv_iterator, &value, &len);
+			expected = g_strdup_printf("test-key-range-%03d", 10 + kvs);
+
+			// Keys of all servers have to be returned in order
+			g_assert_cmpstr(key, ==, expected);
+			g_assert_cmpuint(len, ==, sizeof(guint32));
+			g_assert_cmpuint(*((guint32 const*)value), ==, 10 + kvs);
+
+			kvs++;
+			page_kvs++;
+		}
+
+		g_assert_cmpuint(page_kvs, <=, 16);
+
+		cursor = j_kv_iterator_get_cursor(kv_iterator);
+		pages++;
+	} while (cursor != NULL);
+
+	g_assert_cmpuint(kvs, ==, 40);
+	g_assert_cmpuint(pages, ==, 3);
+
+	// Without an end or a limit, all remaining keys are returned
+	{
+		g_autoptr(JKVIterator) kv_iterator = NULL;
+
+		kvs = 0;
+		kv_iterator = j_kv_iterator_new_range("test-ns-range", "test-key-range-090", NULL, 0);
+
+		while (j_kv_iterator_next(kv_iterator))
+		{
+			kvs++;
+		}
+
+		g_assert_cmpuint(kvs, ==, 10);
+		g_assert_null(j_kv_iterator_get_cursor(kv_iterator));
+	}
+
+	g_assert_null(j_kv_iterator_new_for_cursor("invalid"));
+
+	ret = j_batch_execute(delete_batch);
+	g_assert_true(ret);
+	J_TEST_TRAP_END;
+}
+
 void
 test_kv_kv_iterator(void)
 {
 	g_test_add_func("/kv/kv-iterator/new_free", test_kv_iterator_new_free);
 	g_test_add_func("/kv/kv-iterator/next_get", test_kv_iterator_next_get);
+	g_test_add_func("/kv/kv-iterator/frames", test_kv_iterator_frames);
+	g_test_add_func("/kv/kv-iterator/range", test_kv_iterator_range);
 }
@@ -20,6 +20,8 @@
 
 #include <glib.h>
 
+#include <string.h>
+
 #include <julea.h>
 #include <julea-object.h>
 
@@ -181,6 +183,74 @@ test_object_read_write(void)
 	J_TEST_TRAP_END;
 }
 
+static void
+test_object_read_write_strided(void)
+{
+	guint const n = 64;
+
+	g_autoptr(JBatch) batch = NULL;
+	g_autoptr(JObject) object = NULL;
+	g_autofree gchar* buffer = NULL;
+	g_autofree gchar* buffer2 = NULL;
+	guint64 nbytes = 0;
+	gboolean ret;
+
+	J_TEST_TRAP_START;
+	batch = j_batch_new_for_template(J_SEMANTICS_TEMPLATE_DEFAULT);
+	buffer = g_malloc0(n * 8);
+	buffer2 = g_malloc0(n * 8);
+
+	for (guint i = 0; i < n * 8; i++)
+	{
+		buffer[i] = 'a' + (i % 26);
+	}
+
+	object = j_object_new("test", "test-object-rw-strided");
+	g_assert_true(object != NULL);
+
+	j_object_create(object, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+
+	// Write every other block in reverse order, so that the server has to sort them
+	for (guint i = n; i > 0; i--)
+	{
+		if ((i - 1) % 2 == 0)
+		{
+			j_object_write(object, buffer + (i - 1) * 8, 8, (i - 1) * 8, &nbytes, batch);
+		}
+	}
+
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+	g_assert_cmpuint(nbytes, ==, n * 4);
+
+	// Fill the gaps using adjacent writes
+	for (guint i = 1; i < n; i += 2)
+	{
+		j_object_write(object, buffer + i * 8, 8, i * 8, &nbytes, batch);
+	}
+
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+	g_assert_cmpuint(nbytes, ==, n * 4);
+
+	for (guint i = 0; i < n; i++)
+	{
+		j_object_read(object, buffer2 + i * 8, 8, i * 8, &nbytes, batch);
+	}
+
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+	g_assert_cmpuint(nbytes, ==, n * 8);
+	g_assert_cmpmem(buffer, n * 8, buffer2, n * 8);
+
+	j_object_delete(object, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+	J_TEST_TRAP_END;
+}
+
 static void
 test_object_status(void)
 {
@@ -255,12 +325,151 @@ test_object_sync(void)
 	J_TEST_TRAP_END;
 }
 
+static void
+test_object_copy(void)
+{
+	g_autoptr(JBatch) batch = NULL;
+	g_autoptr(JObject) object = NULL;
+	g_autoptr(JObject) destination = NULL;
+	g_autofree gchar* buffer = NULL;
+	g_autofree gchar* copy = NULL;
+	guint64 nbytes = 0;
+	guint64 size = 0;
+	gint64 modification_time = 0;
+	gboolean ret;
+
+	J_TEST_TRAP_START;
+	batch = j_batch_new_for_template(J_SEMANTICS_TEMPLATE_DEFAULT);
+	buffer = g_malloc(42);
+	copy = g_malloc0(42);
+
+	for (guint i = 0; i < 42; i++)
+	{
+		buffer[i] = i;
+	}
+
+	object = j_object_new("test", "test-object-copy");
+	g_assert_true(object != NULL);
+	destination = j_object_new("test", "test-object-copy-destination");
+	g_assert_true(destination != NULL);
+
+	j_object_create(object, batch);
+	j_object_write(object, buffer, 42, 0, &nbytes, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+	g_assert_cmpuint(nbytes, ==, 42);
+
+	j_object_copy(object, destination, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+
+	j_object_status(destination, &modification_time, &size, batch);
+	j_object_read(destination, copy, 42, 0, &nbytes, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+	g_assert_cmpuint(size, ==, 42);
+	g_assert_cmpuint(nbytes, ==, 42);
+	g_assert_cmpmem(buffer, 42, copy, 42);
+
+	// Copying an object onto itself is not allowed
+	j_object_copy(object, object, batch);
+	ret = j_batch_execute(batch);
+	g_assert_false(ret);
+
+	j_object_delete(object, batch);
+	j_object_delete(destination, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+	J_TEST_TRAP_END;
+}
+
+static void
+test_object_punch_extents(void)
+{
+	g_autoptr(JBatch) batch = NULL;
+	g_autoptr(JObject) object = NULL;
+	g_autoptr(GArray) extents = NULL;
+	g_autofree gchar* buffer = NULL;
+	guint64 const length = 3 * 1024 * 1024;
+	guint64 extents_length = 0;
+	guint64 nbytes = 0;
+	gboolean ret;
+
+	J_TEST_TRAP_START;
+	batch = j_batch_new_for_template(J_SEMANTICS_TEMPLATE_DEFAULT);
+	buffer = g_malloc(length);
+	extents = g_array_new(FALSE, FALSE, sizeof(JObjectExtent));
+
+	memset(buffer, 42, length);
+
+	object = j_object_new("test", "test-object-punch-extents");
+	g_assert_true(object != NULL);
+
+	j_object_create(object, batch);
+	j_object_write(object, buffer, length, 0, &nbytes, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+	g_assert_cmpuint(nbytes, ==, length);
+
+	// Punch the middle MiB, which has to read as zeros while the size stays the same
+	j_object_punch(object, 1024 * 1024, 1024 * 1024, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+
+	nbytes = 0;
+	j_object_read(object, buffer, length, 0, &nbytes, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+	g_assert_cmpuint(nbytes, ==, length);
+	g_assert_cmpint(buffer[0], ==, 42);
+	g_assert_cmpint(buffer[1024 * 1024], ==, 0);
+	g_assert_cmpint(buffer[2 * 1024 * 1024 - 1], ==, 0);
+	g_assert_cmpint(buffer[length - 1], ==, 42);
+
+	// Reading only the hole must not return stale data either
+	memset(buffer, 42, length);
+	nbytes = 0;
+	j_object_read(object, buffer, 1024 * 1024, 1024 * 1024, &nbytes, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+	g_assert_cmpuint(nbytes, ==, 1024 * 1024);
+
+	for (guint64 i = 0; i < 1024 * 1024; i++)
+	{
+		g_assert_cmpint(buffer[i], ==, 0);
+	}
+
+	// Backends without support for holes report all data
+	j_object_get_extents(object, length, 0, extents, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+	g_assert_cmpuint(extents->len, >, 0);
+
+	for (guint i = 0; i < extents->len; i++)
+	{
+		JObjectExtent* extent = &g_array_index(extents, JObjectExtent, i);
+
+		g_assert_cmpuint(extent->offset + extent->length, <=, length);
+		extents_length += extent->length;
+	}
+
+	g_assert_cmpuint(extents_length, >=, 2 * 1024 * 1024);
+
+	j_object_delete(object, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+	J_TEST_TRAP_END;
+}
+
 void
 test_object_object(void)
 {
 	g_test_add_func("/object/object/new_free", test_object_new_free);
 	g_test_add_func("/object/object/create_delete", test_object_create_delete);
 	g_test_add_func("/object/object/read_write", test_object_read_write);
+	g_test_add_func("/object/object/read_write_strided", test_object_read_write_strided);
 	g_test_add_func("/object/object/status", test_object_status);
 	g_test_add_func("/object/object/sync", test_object_sync);
+	g_test_add_func("/object/object/copy", test_object_copy);
+	g_test_add_func("/object/object/punch_extents", test_object_punch_extents);
 }
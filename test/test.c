@@ -44,6 +44,7 @@ main(int argc, char** argv)
 	test_core_background_operation();
 	test_core_batch();
 	test_core_cache();
+	test_core_compression();
 	test_core_configuration();
 	test_core_credentials();
 	test_core_dir_iterator();
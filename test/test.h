@@ -39,6 +39,7 @@
 void test_core_background_operation(void);
 void test_core_batch(void);
 void test_core_cache(void);
+void test_core_compression(void);
 void test_core_configuration(void);
 void test_core_credentials(void);
 void test_core_dir_iterator(void);
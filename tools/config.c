@@ -38,11 +38,20 @@ static gchar const* opt_kv_backend = NULL;
 static gchar const* opt_kv_path = NULL;
 static gchar const* opt_db_backend = NULL;
 static gchar const* opt_db_path = NULL;
+static gchar const* opt_network_transport = "tcp";
+static gchar const* opt_network_provider = NULL;
+static gchar const* opt_network_compression = "none";
+static gboolean opt_network_shared_memory = TRUE;
+static gchar const* opt_network_socket = NULL;
 static gint64 opt_max_operation_size = 0;
 static gint64 opt_max_inject_size = 0;
 static gint opt_port = 0;
 static gint opt_max_connections = 0;
 static gint64 opt_stripe_size = 0;
+static gboolean opt_multiplexing = FALSE;
+static gchar const* opt_placement = "modulo";
+static gchar const* opt_weights_object = NULL;
+static gchar const* opt_weights_kv = NULL;
 
 static gchar**
 string_split(gchar const* string)
@@ -62,6 +71,24 @@ string_split(gchar const* string)
 	return arr;
 }
 
+static gint*
+weights_split(gchar const* string, gsize* len)
+{
+	g_auto(GStrv) arr = NULL;
+	gint* weights;
+
+	arr = string_split(string);
+	*len = g_strv_length(arr);
+	weights = g_new(gint, *len);
+
+	for (gsize i = 0; i < *len; i++)
+	{
+		weights[i] = g_ascii_strtoll(arr[i], NULL, 10);
+	}
+
+	return weights;
+}
+
 static gboolean
 read_config(gchar* path)
 {
@@ -110,15 +137,50 @@ write_config(gchar* path)
 	g_key_file_set_integer(key_file, "core", "port", opt_port);
 	g_key_file_set_integer(key_file, "clients", "max-connections", opt_max_connections);
 	g_key_file_set_int64(key_file, "clients", "stripe-size", opt_stripe_size);
+	g_key_file_set_boolean(key_file, "clients", "multiplexing", opt_multiplexing);
+	g_key_file_set_string(key_file, "clients", "placement", opt_placement);
 	g_key_file_set_string_list(key_file, "servers", "object", (gchar const* const*)servers_object, g_strv_length(servers_object));
 	g_key_file_set_string_list(key_file, "servers", "kv", (gchar const* const*)servers_kv, g_strv_length(servers_kv));
 	g_key_file_set_string_list(key_file, "servers", "db", (gchar const* const*)servers_db, g_strv_length(servers_db));
+
+	if (opt_weights_object != NULL)
+	{
+		g_autofree gint* weights = NULL;
+		gsize len;
+
+		weights = weights_split(opt_weights_object, &len);
+		g_key_file_set_integer_list(key_file, "servers", "object-weights", weights, len);
+	}
+
+	if (opt_weights_kv != NULL)
+	{
+		g_autofree gint* weights = NULL;
+		gsize len;
+
+		weights = weights_split(opt_weights_kv, &len);
+		g_key_file_set_integer_list(key_file, "servers", "kv-weights", weights, len);
+	}
+
 	g_key_file_set_string(key_file, "object", "backend", opt_object_backend);
 	g_key_file_set_string(key_file, "object", "path", opt_object_path);
 	g_key_file_set_string(key_file, "kv", "backend", opt_kv_backend);
 	g_key_file_set_string(key_file, "kv", "path", opt_kv_path);
 	g_key_file_set_string(key_file, "db", "backend", opt_db_backend);
 	g_key_file_set_string(key_file, "db", "path", opt_db_path);
+	g_key_file_set_string(key_file, "network", "transport", opt_network_transport);
+	g_key_file_set_string(key_file, "network", "compression", opt_network_compression);
+	g_key_file_set_boolean(key_file, "network", "shared-memory", opt_network_shared_memory);
+
+	if (opt_network_socket != NULL)
+	{
+		g_key_file_set_string(key_file, "network", "socket", opt_network_socket);
+	}
+
+	if (opt_network_provider != NULL)
+	{
+		g_key_file_set_string(key_file, "network", "provider", opt_network_provider);
+	}
+
 	key_file_data = g_key_file_to_data(key_file, &key_file_data_len, NULL);
 
 	if (path != NULL)
@@ -157,17 +219,26 @@ main(gint argc, gchar** argv)
 		{ "object-servers", 0, 0, G_OPTION_ARG_STRING, &opt_servers_object, "Object servers to use", "host1,host2:port" },
 		{ "kv-servers", 0, 0, G_OPTION_ARG_STRING, &opt_servers_kv, "Key-value servers to use", "host1,host2:port" },
 		{ "db-servers", 0, 0, G_OPTION_ARG_STRING, &opt_servers_db, "Database servers to use", "host1,host2:port" },
+		{ "object-weights", 0, 0, G_OPTION_ARG_STRING, &opt_weights_object, "Weights of the object servers when using ring placement", "1,2" },
+		{ "kv-weights", 0, 0, G_OPTION_ARG_STRING, &opt_weights_kv, "Weights of the key-value servers when using ring placement", "1,2" },
 		{ "object-backend", 0, 0, G_OPTION_ARG_STRING, &opt_object_backend, "Object backend to use", "posix|null|gio|…" },
 		{ "object-path", 0, 0, G_OPTION_ARG_STRING, &opt_object_path, "Object path to use", "/path/to/storage" },
 		{ "kv-backend", 0, 0, G_OPTION_ARG_STRING, &opt_kv_backend, "Key-value backend to use", "posix|null|gio|…" },
 		{ "kv-path", 0, 0, G_OPTION_ARG_STRING, &opt_kv_path, "Key-value path to use", "/path/to/storage" },
 		{ "db-backend", 0, 0, G_OPTION_ARG_STRING, &opt_db_backend, "Database backend to use", "sqlite|null|…" },
 		{ "db-path", 0, 0, G_OPTION_ARG_STRING, &opt_db_path, "Database path to use", "/path/to/storage" },
+		{ "network-transport", 0, 0, G_OPTION_ARG_STRING, &opt_network_transport, "Network transport to use", "tcp|libfabric" },
+		{ "network-provider", 0, 0, G_OPTION_ARG_STRING, &opt_network_provider, "libfabric provider to use", "tcp|sockets|verbs|…" },
+		{ "network-compression", 0, 0, G_OPTION_ARG_STRING, &opt_network_compression, "Compression codec to request", "none|lz4|zstd" },
+		{ "network-no-shared-memory", 0, G_OPTION_FLAG_REVERSE, G_OPTION_ARG_NONE, &opt_network_shared_memory, "Do not use shared memory for local servers", NULL },
+		{ "network-socket", 0, 0, G_OPTION_ARG_STRING, &opt_network_socket, "Unix domain socket to use for local servers", "/run/julea/{PORT}.socket" },
 		{ "max-operation-size", 0, 0, G_OPTION_ARG_INT64, &opt_max_operation_size, "Maximum size of an operation", "0" },
 		{ "max-inject-size", 0, 0, G_OPTION_ARG_INT64, &opt_max_inject_size, "Maximum inject size", "0" },
 		{ "port", 0, 0, G_OPTION_ARG_INT, &opt_port, "Default network port", "0" },
 		{ "max-connections", 0, 0, G_OPTION_ARG_INT, &opt_max_connections, "Maximum number of connections", "0" },
 		{ "stripe-size", 0, 0, G_OPTION_ARG_INT64, &opt_stripe_size, "Default stripe size", "0" },
+		{ "multiplexing", 0, 0, G_OPTION_ARG_NONE, &opt_multiplexing, "Share one connection per server among all threads", NULL },
+		{ "placement", 0, 0, G_OPTION_ARG_STRING, &opt_placement, "Placement of objects and key-value pairs on servers", "modulo|ring" },
 		{ NULL, 0, 0, 0, NULL, NULL, NULL }
 	};
 
@@ -192,6 +263,9 @@ main(gint argc, gchar** argv)
 	    || (opt_read && (opt_servers_object != NULL || opt_servers_kv != NULL || opt_servers_db != NULL || opt_object_backend != NULL || opt_object_path != NULL || opt_kv_backend != NULL || opt_kv_path != NULL || opt_db_backend != NULL || opt_db_path != NULL))
 	    || (opt_read && !opt_user && !opt_system)
 	    || (!opt_read && (opt_servers_object == NULL || opt_servers_kv == NULL || opt_servers_db == NULL || opt_object_backend == NULL || opt_object_path == NULL || opt_kv_backend == NULL || opt_kv_path == NULL || opt_db_backend == NULL || opt_db_path == NULL))
+	    || (g_strcmp0(opt_network_transport, "tcp") != 0 && g_strcmp0(opt_network_transport, "libfabric") != 0)
+	    || (g_strcmp0(opt_network_compression, "none") != 0 && g_strcmp0(opt_network_compression, "lz4") != 0 && g_strcmp0(opt_network_compression, "zstd") != 0)
+	    || (g_strcmp0(opt_placement, "modulo") != 0 && g_strcmp0(opt_placement, "ring") != 0)
 	    || opt_max_operation_size < 0
 	    || opt_max_inject_size < 0
 	    || opt_max_connections < 0
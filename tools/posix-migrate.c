@@ -0,0 +1,255 @@
+/*
+ * JULEA - Flexible storage framework
+ * Copyright (C) 2026 Michael Kuhn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Converts the storage of the posix object backend between the flat and the hashed layout.
+ * The server must not be running while the storage is converted.
+ */
+
+#include <julea-config.h>
+
+#include <glib.h>
+#include <glib/gstdio.h>
+
+#include <locale.h>
+#include <string.h>
+
+#include <julea.h>
+
+static gchar const* opt_path = NULL;
+static gboolean opt_reverse = FALSE;
+static gboolean opt_dry_run = FALSE;
+
+/**
+ * Returns the subdirectory of a name when using the hashed layout.
+ * This has to match the posix backend.
+ **/
+static gchar*
+hashed_dir(gchar const* name)
+{
+	// FNV-1a
+	guint32 hash = 2166136261U;
+
+	for (gchar const* c = name; *c != '\0'; c++)
+	{
+		hash ^= (guchar)*c;
+		hash *= 16777619U;
+	}
+
+	return g_strdup_printf("%02x/%02x", hash & 0xff, (hash >> 8) & 0xff);
+}
+
+/**
+ * Checks whether a path below a namespace already uses the hashed layout.
+ **/
+static gboolean
+is_hashed(gchar const* path)
+{
+	g_autofree gchar* dir = NULL;
+
+	if (strlen(path) < 7 || path[2] != '/' || path[5] != '/')
+	{
+		return FALSE;
+	}
+
+	dir = hashed_dir(path + 6);
+
+	return (strncmp(path, dir, 5) == 0);
+}
+
+/**
+ * Removes empty directories between path and root.
+ **/
+static void
+remove_empty_parents(gchar const* root, gchar const* path)
+{
+	g_autofree gchar* parent = NULL;
+
+	parent = g_path_get_dirname(path);
+
+	while (strlen(parent) > strlen(root) && g_rmdir(parent) == 0)
+	{
+		gchar* tmp;
+
+		tmp = g_path_get_dirname(parent);
+		g_free(parent);
+		parent = tmp;
+	}
+}
+
+static gboolean
+migrate_namespace(gchar const* namespace, guint64* count)
+{
+	g_autoptr(GPtrArray) paths = NULL;
+	g_autofree gchar* namespace_path = NULL;
+	JDirIterator* iterator;
+	gboolean ret = TRUE;
+
+	namespace_path = g_build_filename(opt_path, namespace, NULL);
+
+	if ((iterator = j_dir_iterator_new(namespace_path)) == NULL)
+	{
+		return FALSE;
+	}
+
+	paths = g_ptr_array_new_with_free_func(g_free);
+
+	// Collect all paths first, renaming files while iterating could return them twice
+	while (j_dir_iterator_next(iterator))
+	{
+		gchar const* path;
+
+		path = j_dir_iterator_get(iterator);
+
+		if (is_hashed(path) == opt_reverse)
+		{
+			g_ptr_array_add(paths, g_strdup(path));
+		}
+	}
+
+	j_dir_iterator_free(iterator);
+
+	for (guint i = 0; i < paths->len; i++)
+	{
+		gchar const* path = g_ptr_array_index(paths, i);
+		g_autofree gchar* old_path = NULL;
+		g_autofree gchar* new_path = NULL;
+		g_autofree gchar* new_parent = NULL;
+
+		old_path = g_build_filename(namespace_path, path, NULL);
+
+		if (opt_reverse)
+		{
+			new_path = g_build_filename(namespace_path, path + 6, NULL);
+		}
+		else
+		{
+			g_autofree gchar* dir = NULL;
+
+			dir = hashed_dir(path);
+			new_path = g_build_filename(namespace_path, dir, path, NULL);
+		}
+
+		if (opt_dry_run)
+		{
+			g_print("%s -> %s\n", old_path, new_path);
+			continue;
+		}
+
+		new_parent = g_path_get_dirname(new_path);
+		g_mkdir_with_parents(new_parent, 0700);
+
+		if (g_rename(old_path, new_path) != 0)
+		{
+			g_printerr("Could not move %s to %s.\n", old_path, new_path);
+			ret = FALSE;
+			continue;
+		}
+
+		remove_empty_parents(namespace_path, old_path);
+
+		(*count)++;
+	}
+
+	return ret;
+}
+
+gint
+main(gint argc, gchar** argv)
+{
+	GError* error = NULL;
+	g_autoptr(GOptionContext) context = NULL;
+	GDir* dir;
+	gchar const* namespace;
+	gboolean ret = TRUE;
+	guint64 count = 0;
+
+	GOptionEntry entries[] = {
+		{ "path", 0, 0, G_OPTION_ARG_STRING, &opt_path, "Storage path of the posix backend", "/var/storage/posix" },
+		{ "reverse", 0, 0, G_OPTION_ARG_NONE, &opt_reverse, "Convert from the hashed to the flat layout", NULL },
+		{ "dry-run", 0, 0, G_OPTION_ARG_NONE, &opt_dry_run, "Only print what would be moved", NULL },
+		{ NULL, 0, 0, 0, NULL, NULL, NULL }
+	};
+
+	// Explicitly enable UTF-8 since functions such as g_format_size might return UTF-8 characters.
+	setlocale(LC_ALL, "C.UTF-8");
+
+	context = g_option_context_new(NULL);
+	g_option_context_add_main_entries(context, entries, NULL);
+
+	if (!g_option_context_parse(context, &argc, &argv, &error))
+	{
+		if (error)
+		{
+			g_printerr("%s\n", error->message);
+			g_error_free(error);
+		}
+
+		return 1;
+	}
+
+	if (opt_path == NULL)
+	{
+		g_autofree gchar* help = NULL;
+
+		help = g_option_context_get_help(context, TRUE, NULL);
+
+		g_print("%s", help);
+
+		return 1;
+	}
+
+	// Backend options such as direct: are not part of the storage path
+	while (g_str_has_prefix(opt_path, "direct:") || g_str_has_prefix(opt_path, "hashed:") || g_str_has_prefix(opt_path, "indexed:"))
+	{
+		opt_path = strchr(opt_path, ':') + 1;
+	}
+
+	if ((dir = g_dir_open(opt_path, 0, &error)) == NULL)
+	{
+		g_printerr("%s\n", error->message);
+		g_error_free(error);
+
+		return 1;
+	}
+
+	// Each top-level directory is a namespace
+	while ((namespace = g_dir_read_name(dir)) != NULL)
+	{
+		g_autofree gchar* namespace_path = NULL;
+
+		namespace_path = g_build_filename(opt_path, namespace, NULL);
+
+		// Skip the index, which does not depend on the layout
+		if (namespace[0] == '.' || !g_file_test(namespace_path, G_FILE_TEST_IS_DIR))
+		{
+			continue;
+		}
+
+		ret = migrate_namespace(namespace, &count) && ret;
+	}
+
+	g_dir_close(dir);
+
+	if (!opt_dry_run)
+	{
+		g_print("Moved %" G_GUINT64_FORMAT " objects.\n", count);
+	}
+
+	return (ret) ? 0 : 1;
+}
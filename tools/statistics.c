@@ -49,6 +49,8 @@ print_statistics(JStatistics* statistics)
 	g_print("  %s written\n", size_written);
 	g_print("  %s received\n", size_received);
 	g_print("  %s sent\n", size_sent);
+	g_print("  %" G_GUINT64_FORMAT " opens saved\n", j_statistics_get(statistics, J_STATISTICS_OPENS_SAVED));
+	g_print("  %" G_GUINT64_FORMAT " closes saved\n", j_statistics_get(statistics, J_STATISTICS_CLOSES_SAVED));
 
 	g_free(size_read);
 	g_free(size_written);
@@ -125,6 +127,14 @@ main(int argc, char** argv)
 		j_statistics_add(statistics, J_STATISTICS_BYTES_SENT, value);
 		j_statistics_add(statistics_total, J_STATISTICS_BYTES_SENT, value);
 
+		value = j_message_get_8(reply);
+		j_statistics_add(statistics, J_STATISTICS_OPENS_SAVED, value);
+		j_statistics_add(statistics_total, J_STATISTICS_OPENS_SAVED, value);
+
+		value = j_message_get_8(reply);
+		j_statistics_add(statistics, J_STATISTICS_CLOSES_SAVED, value);
+		j_statistics_add(statistics_total, J_STATISTICS_CLOSES_SAVED, value);
+
 		g_print("Data server %d\n", i);
 		print_statistics(statistics);
 